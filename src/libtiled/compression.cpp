@@ -35,6 +35,7 @@
 #endif
 
 #include <QByteArray>
+#include <QChar>
 #include <QDebug>
 
 #ifdef Z_PREFIX
@@ -169,3 +170,177 @@ QByteArray Tiled::compress(const QByteArray &data, CompressionMethod method)
     out.resize(outLength);
     return out;
 }
+
+namespace {
+
+inline uint charCode(char c) { return static_cast<uchar>(c); }
+inline uint charCode(QChar c) { return c.unicode(); }
+
+inline int base64Value(uint c)
+{
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A';
+    if (c >= 'a' && c <= 'z')
+        return c - 'a' + 26;
+    if (c >= '0' && c <= '9')
+        return c - '0' + 52;
+    if (c == '+')
+        return 62;
+    if (c == '/')
+        return 63;
+    return -1;
+}
+
+/**
+ * Incrementally decodes base64 text. Stops at the first padding character.
+ */
+template<typename Char>
+class Base64Decoder
+{
+public:
+    Base64Decoder(const Char *text, int length)
+        : mText(text)
+        , mEnd(text + length)
+        , mBuffer(0)
+        , mBits(0)
+    {}
+
+    /**
+     * Decodes up to \a size bytes into \a out. Returns the number of bytes
+     * written, which is only less than \a size at the end of the text.
+     */
+    int decode(char *out, int size)
+    {
+        int written = 0;
+
+        while (written < size && mText != mEnd) {
+            const uint c = charCode(*mText);
+            if (c == '=') {
+                mText = mEnd;
+                break;
+            }
+
+            ++mText;
+
+            const int value = base64Value(c);
+            if (value == -1)
+                continue;
+
+            mBuffer = (mBuffer << 6) | value;
+            mBits += 6;
+
+            if (mBits >= 8) {
+                mBits -= 8;
+                out[written++] = static_cast<char>(mBuffer >> mBits);
+                mBuffer &= (1 << mBits) - 1;
+            }
+        }
+
+        return written;
+    }
+
+    /**
+     * Returns whether the remaining text contains any more data.
+     */
+    bool atEnd()
+    {
+        char c;
+        return decode(&c, 1) == 0;
+    }
+
+private:
+    const Char *mText;
+    const Char *mEnd;
+    uint mBuffer;
+    int mBits;
+};
+
+template<typename Char>
+bool decodeBase64Impl(const Char *text, int length, bool compressed,
+                      char *out, int outSize)
+{
+    Base64Decoder<Char> decoder(text, length);
+
+    if (!compressed) {
+        return decoder.decode(out, outSize) == outSize &&
+                decoder.atEnd();
+    }
+
+    z_stream strm;
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    strm.next_in = Z_NULL;
+    strm.avail_in = 0;
+    strm.next_out = (Bytef *) out;
+    strm.avail_out = outSize;
+
+    int ret = inflateInit2(&strm, 15 + 32);
+
+    if (ret != Z_OK) {
+        logZlibError(ret);
+        return false;
+    }
+
+    // Decode the text in blocks small enough to stay in the cache
+    char block[16384];
+
+    do {
+        if (strm.avail_in == 0) {
+            const int decoded = decoder.decode(block, sizeof(block));
+            if (decoded == 0)
+                break;  // Premature end of data
+
+            strm.next_in = (Bytef *) block;
+            strm.avail_in = decoded;
+        }
+
+        ret = inflate(&strm, Z_NO_FLUSH);
+
+        switch (ret) {
+            case Z_NEED_DICT:
+            case Z_STREAM_ERROR:
+                ret = Z_DATA_ERROR;
+            case Z_DATA_ERROR:
+            case Z_MEM_ERROR:
+                inflateEnd(&strm);
+                logZlibError(ret);
+                return false;
+            case Z_BUF_ERROR:
+                // No progress possible while there is still input, so the
+                // data is larger than expected
+                if (strm.avail_in != 0) {
+                    inflateEnd(&strm);
+                    return false;
+                }
+                break;
+        }
+    }
+    while (ret != Z_STREAM_END);
+
+    const bool complete = ret == Z_STREAM_END &&
+            strm.avail_out == 0 &&
+            strm.avail_in == 0 &&
+            decoder.atEnd();
+
+    inflateEnd(&strm);
+
+    if (!complete && ret == Z_STREAM_END)
+        logZlibError(Z_DATA_ERROR);
+
+    return complete;
+}
+
+} // anonymous namespace
+
+bool Tiled::decodeBase64(const char *text, int length, bool compressed,
+                         char *out, int outSize)
+{
+    return decodeBase64Impl(text, length, compressed, out, outSize);
+}
+
+bool Tiled::decodeBase64(const QChar *text, int length, bool compressed,
+                         char *out, int outSize)
+{
+    return decodeBase64Impl(text, length, compressed, out, outSize);
+}
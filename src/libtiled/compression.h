@@ -32,6 +32,7 @@
 #include "tiled_global.h"
 
 class QByteArray;
+class QChar;
 
 namespace Tiled {
 
@@ -67,6 +68,33 @@ QByteArray TILEDSHARED_EXPORT decompress(const QByteArray &data,
 QByteArray TILEDSHARED_EXPORT compress(const QByteArray &data,
                                        CompressionMethod method = Zlib);
 
+/**
+ * Decodes base64 encoded \a text, optionally decompressing the decoded data,
+ * straight into the \a out buffer. The text is decoded in fixed-size blocks
+ * that are passed to zlib as they become available, so no intermediate copy
+ * of the whole decoded or compressed data is made.
+ *
+ * Whitespace and other characters that are not part of the base64 alphabet
+ * are ignored.
+ *
+ * @param text       the base64 encoded text
+ * @param length     the number of characters in \a text
+ * @param compressed whether the decoded data is zlib or gzip compressed
+ * @param out        the buffer receiving the decoded data
+ * @param outSize    the expected size of the decoded data in bytes
+ * @return whether decoding succeeded and produced exactly \a outSize bytes
+ */
+bool TILEDSHARED_EXPORT decodeBase64(const char *text, int length,
+                                     bool compressed,
+                                     char *out, int outSize);
+
+/**
+ * \overload
+ */
+bool TILEDSHARED_EXPORT decodeBase64(const QChar *text, int length,
+                                     bool compressed,
+                                     char *out, int outSize);
+
 } // namespace Tiled
 
 #endif // COMPRESSION_H
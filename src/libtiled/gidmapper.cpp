@@ -38,17 +38,84 @@ const int FlippedHorizontallyFlag   = 0x80000000;
 const int FlippedVerticallyFlag     = 0x40000000;
 const int FlippedAntiDiagonallyFlag = 0x20000000;
 
+const unsigned FlagsMask = FlippedHorizontallyFlag |
+                           FlippedVerticallyFlag |
+                           FlippedAntiDiagonallyFlag;
+
+// Limits the memory used by the gid to tile table, which could otherwise
+// become large when there are big gaps between the first gids
+const int MaxTableSize = 1 << 20;
+
 GidMapper::GidMapper()
+    : mFirstTableGid(0)
 {
 }
 
 GidMapper::GidMapper(const QList<Tileset *> &tilesets)
+    : mFirstTableGid(0)
 {
     unsigned firstGid = 1;
     foreach (Tileset *tileset, tilesets) {
-        insert(firstGid, tileset);
+        mFirstGidToTileset.insert(firstGid, tileset);
         firstGid += tileset->tileCount();
     }
+
+    updateLookupTables();
+}
+
+void GidMapper::insert(unsigned firstGid, Tileset *tileset)
+{
+    mFirstGidToTileset.insert(firstGid, tileset);
+    updateLookupTables();
+}
+
+void GidMapper::clear()
+{
+    mFirstGidToTileset.clear();
+    mTilesetColumnCounts.clear();
+    mTilesetFirstGids.clear();
+    mGidToTile.clear();
+    mFirstTableGid = 0;
+}
+
+/**
+ * Returns the tile matched by the given \a gid, which should have its flags
+ * cleared and should not be 0. Uses the lookup table when possible.
+ */
+inline Tile *GidMapper::tileForGid(unsigned gid, bool &ok) const
+{
+    const unsigned index = gid - mFirstTableGid;
+    if (index < unsigned(mGidToTile.size())) {
+        ok = true;
+        return mGidToTile.at(index);
+    }
+
+    // Find the tileset containing this tile
+    QMap<unsigned, Tileset*>::const_iterator i = mFirstGidToTileset.upperBound(gid);
+    if (i == mFirstGidToTileset.begin()) {
+        // No tilesets, or the gid lies before the first tileset
+        ok = false;
+        return 0;
+    }
+
+    --i; // Navigate one tileset back since upper bound finds the next
+    int tileId = gid - i.key();
+    const Tileset *tileset = i.value();
+
+    ok = true;
+
+    if (!tileset)
+        return 0;
+
+    const int columnCount = mTilesetColumnCounts.value(tileset);
+    if (columnCount > 0 && columnCount != tileset->columnCount()) {
+        // Correct tile index for changes in image width
+        const int row = tileId / columnCount;
+        const int column = tileId % columnCount;
+        tileId = row * tileset->columnCount() + column;
+    }
+
+    return tileset->tileAt(tileId);
 }
 
 Cell GidMapper::gidToCell(unsigned gid, bool &ok) const
@@ -61,37 +128,12 @@ Cell GidMapper::gidToCell(unsigned gid, bool &ok) const
     result.flippedAntiDiagonally = (gid & FlippedAntiDiagonallyFlag);
 
     // Clear the flags
-    gid &= ~(FlippedHorizontallyFlag |
-             FlippedVerticallyFlag |
-             FlippedAntiDiagonallyFlag);
+    gid &= ~FlagsMask;
 
-    if (gid == 0) {
+    if (gid == 0)
         ok = true;
-    } else if (isEmpty()) {
-        ok = false;
-    } else {
-        // Find the tileset containing this tile
-        QMap<unsigned, Tileset*>::const_iterator i = mFirstGidToTileset.upperBound(gid);
-        --i; // Navigate one tileset back since upper bound finds the next
-        int tileId = gid - i.key();
-        const Tileset *tileset = i.value();
-
-        if (tileset) {
-            const int columnCount = mTilesetColumnCounts.value(tileset);
-            if (columnCount > 0 && columnCount != tileset->columnCount()) {
-                // Correct tile index for changes in image width
-                const int row = tileId / columnCount;
-                const int column = tileId % columnCount;
-                tileId = row * tileset->columnCount() + column;
-            }
-
-            result.tile = tileset->tileAt(tileId);
-        } else {
-            result.tile = 0;
-        }
-
-        ok = true;
-    }
+    else
+        result.tile = tileForGid(gid, ok);
 
     return result;
 }
@@ -101,18 +143,14 @@ unsigned GidMapper::cellToGid(const Cell &cell) const
     if (cell.isEmpty())
         return 0;
 
-    const Tileset *tileset = cell.tile->tileset();
-
     // Find the first GID for the tileset
-    QMap<unsigned, Tileset*>::const_iterator i = mFirstGidToTileset.begin();
-    QMap<unsigned, Tileset*>::const_iterator i_end = mFirstGidToTileset.end();
-    while (i != i_end && i.value() != tileset)
-        ++i;
+    QHash<const Tileset*, unsigned>::const_iterator i =
+            mTilesetFirstGids.find(cell.tile->tileset());
 
-    if (i == i_end) // tileset not found
+    if (i == mTilesetFirstGids.end()) // tileset not found
         return 0;
 
-    unsigned gid = i.key() + cell.tile->id();
+    unsigned gid = i.value() + cell.tile->id();
     if (cell.flippedHorizontally)
         gid |= FlippedHorizontallyFlag;
     if (cell.flippedVertically)
@@ -123,10 +161,82 @@ unsigned GidMapper::cellToGid(const Cell &cell) const
     return gid;
 }
 
+int GidMapper::gidsToCells(const unsigned *gids, Cell *cells, int count) const
+{
+    for (int i = 0; i < count; ++i) {
+        const unsigned gid = gids[i];
+        Cell &cell = cells[i];
+
+        cell.flippedHorizontally = (gid & FlippedHorizontallyFlag);
+        cell.flippedVertically = (gid & FlippedVerticallyFlag);
+        cell.flippedAntiDiagonally = (gid & FlippedAntiDiagonallyFlag);
+
+        const unsigned tileGid = gid & ~FlagsMask;
+        if (tileGid == 0) {
+            cell.tile = 0;
+        } else {
+            bool ok;
+            cell.tile = tileForGid(tileGid, ok);
+            if (!ok)
+                return i;
+        }
+    }
+
+    return count;
+}
+
+void GidMapper::cellsToGids(const Cell *cells, unsigned *gids, int count) const
+{
+    for (int i = 0; i < count; ++i)
+        gids[i] = cellToGid(cells[i]);
+}
+
 void GidMapper::setTilesetWidth(const Tileset *tileset, int width)
 {
     if (tileset->tileWidth() == 0)
         return;
 
     mTilesetColumnCounts.insert(tileset, tileset->columnCountForWidth(width));
+    updateLookupTables();
+}
+
+/**
+ * Rebuilds the tileset to first gid map and the gid to tile table. The
+ * table covers all gids from the first tileset up to the last tile of the
+ * last tileset. Gids outside of it fall back to searching the tileset map.
+ */
+void GidMapper::updateLookupTables()
+{
+    mTilesetFirstGids.clear();
+    mGidToTile.clear();
+    mFirstTableGid = 0;
+
+    if (mFirstGidToTileset.isEmpty())
+        return;
+
+    QMap<unsigned, Tileset*>::const_iterator it = mFirstGidToTileset.constEnd();
+    while (it != mFirstGidToTileset.constBegin()) {
+        --it;
+        // Iterating backwards makes the lowest first gid win for tilesets
+        // that were inserted more than once
+        if (it.value())
+            mTilesetFirstGids.insert(it.value(), it.key());
+    }
+
+    const unsigned firstGid = mFirstGidToTileset.constBegin().key();
+    const Tileset *lastTileset = (mFirstGidToTileset.constEnd() - 1).value();
+    const unsigned lastGid = (mFirstGidToTileset.constEnd() - 1).key()
+            + (lastTileset ? lastTileset->tileCount() : 0);
+
+    if (lastGid - firstGid > unsigned(MaxTableSize))
+        return;
+
+    QVector<Tile*> table(lastGid - firstGid);
+    for (unsigned gid = firstGid; gid < lastGid; ++gid) {
+        bool ok;
+        table[gid - firstGid] = tileForGid(gid, ok);
+    }
+
+    mGidToTile = table;
+    mFirstTableGid = firstGid;
 }
@@ -31,12 +31,17 @@
 
 #include "tilelayer.h"
 
+#include <QHash>
 #include <QMap>
+#include <QVector>
 
 namespace Tiled {
 
 /**
  * A class that maps cells to global IDs (gids) and back.
+ *
+ * Lookup tables are kept up to date as tilesets are inserted, so that both
+ * directions take constant time. All const functions are thread-safe.
  */
 class TILEDSHARED_EXPORT GidMapper
 {
@@ -55,13 +60,12 @@ public:
     /**
      * Insert the given \a tileset with \a firstGid as its first global ID.
      */
-    void insert(unsigned firstGid, Tileset *tileset)
-    { mFirstGidToTileset.insert(firstGid, tileset); }
+    void insert(unsigned firstGid, Tileset *tileset);
 
     /**
      * Clears the gid mapper, so that it can be reused.
      */
-    void clear() { mFirstGidToTileset.clear(); }
+    void clear();
 
     /**
      * Returns true when no tilesets are known to this gid mapper.
@@ -80,6 +84,21 @@ public:
      */
     unsigned cellToGid(const Cell &cell) const;
 
+    /**
+     * Converts \a count global tile IDs to cells. Meant to be used for whole
+     * rows or layers at once.
+     *
+     * @return the number of converted cells, which is less than \a count
+     *         when <code>gids[returnValue]</code> could not be converted
+     */
+    int gidsToCells(const unsigned *gids, Cell *cells, int count) const;
+
+    /**
+     * Converts \a count cells to global tile IDs. Cells with an unknown
+     * tileset are converted to 0, like in cellToGid().
+     */
+    void cellsToGids(const Cell *cells, unsigned *gids, int count) const;
+
     /**
      * This sets the original tileset width. In case the image size has
      * changed, the tile indexes will be adjusted automatically when using
@@ -88,8 +107,15 @@ public:
     void setTilesetWidth(const Tileset *tileset, int width);
 
 private:
+    Tile *tileForGid(unsigned gid, bool &ok) const;
+    void updateLookupTables();
+
     QMap<unsigned, Tileset*> mFirstGidToTileset;
     QMap<const Tileset*, int> mTilesetColumnCounts;
+
+    QHash<const Tileset*, unsigned> mTilesetFirstGids;
+    QVector<Tile*> mGidToTile;  // Indexed by gid - mFirstTableGid
+    unsigned mFirstTableGid;
 };
 
 } // namespace Tiled
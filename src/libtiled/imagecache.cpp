@@ -0,0 +1,119 @@
+/*
+ * imagecache.cpp
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "imagecache.h"
+
+#include <QCache>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+
+using namespace Tiled;
+
+namespace {
+
+struct CachedImage
+{
+    QImage image;
+    qint64 size;
+    QDateTime lastModified;
+};
+
+QMutex cacheMutex;
+QCache<QString, CachedImage> cache(256 * 1024);
+
+} // anonymous namespace
+
+QImage ImageCache::loadImage(const QString &fileName)
+{
+    const QFileInfo fileInfo(fileName);
+    const QString canonicalPath = fileInfo.canonicalFilePath();
+    if (canonicalPath.isEmpty())
+        return QImage(); // The file doesn't exist
+
+    // The modification time may have a resolution of only a second, so the
+    // size helps to notice files that were changed shortly after loading
+    const qint64 size = fileInfo.size();
+    const QDateTime lastModified = fileInfo.lastModified();
+
+    {
+        QMutexLocker locker(&cacheMutex);
+        if (CachedImage *cached = cache.object(canonicalPath))
+            if (cached->size == size && cached->lastModified == lastModified)
+                return cached->image;
+    }
+
+    // Decode without holding the lock, so other images can be loaded
+    // meanwhile
+    const QImage image(canonicalPath);
+    if (image.isNull())
+        return image;
+
+    CachedImage *cached = new CachedImage;
+    cached->image = image;
+    cached->size = size;
+    cached->lastModified = lastModified;
+
+    QMutexLocker locker(&cacheMutex);
+    cache.insert(canonicalPath, cached, qMax(1, image.byteCount() / 1024));
+
+    return image;
+}
+
+void ImageCache::remove(const QString &fileName)
+{
+    const QFileInfo fileInfo(fileName);
+    QString canonicalPath = fileInfo.canonicalFilePath();
+
+    // Removed files no longer have a canonical path
+    if (canonicalPath.isEmpty())
+        canonicalPath = QDir::cleanPath(fileInfo.absoluteFilePath());
+
+    QMutexLocker locker(&cacheMutex);
+    cache.remove(canonicalPath);
+}
+
+void ImageCache::clear()
+{
+    QMutexLocker locker(&cacheMutex);
+    cache.clear();
+}
+
+void ImageCache::setMaxCost(int kilobytes)
+{
+    QMutexLocker locker(&cacheMutex);
+    cache.setMaxCost(kilobytes);
+}
+
+int ImageCache::maxCost()
+{
+    QMutexLocker locker(&cacheMutex);
+    return cache.maxCost();
+}
@@ -0,0 +1,97 @@
+/*
+ * imagecache.h
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TILED_IMAGECACHE_H
+#define TILED_IMAGECACHE_H
+
+#include "tiled_global.h"
+
+#include <QImage>
+#include <QString>
+
+namespace Tiled {
+
+/**
+ * A process-wide cache of decoded images, so that an image referenced by
+ * many maps or tilesets only needs to be decoded once.
+ *
+ * Images are identified by their canonical file path, file size and last
+ * modification time, so a changed file is decoded again. Since QImage is
+ * implicitly shared, the cached image data is shared with everybody that
+ * loaded it and remains valid when the cache drops its reference.
+ *
+ * Users that convert the image to a QPixmap don't share its data, so the
+ * cached copy only pays off while the image may be loaded again. Such users
+ * should remove() the image once they no longer need it, like the
+ * TilesetManager does when the last tileset using an image is deleted.
+ *
+ * The cache is bounded by memory rather than holding each image for as long
+ * as a tileset refers to it. Tilesets keep their image as a QPixmap, so
+ * holding the decoded image for their whole lifetime would keep a second
+ * copy of every tileset image in memory.
+ *
+ * All functions are thread-safe.
+ */
+class TILEDSHARED_EXPORT ImageCache
+{
+public:
+    /**
+     * Returns the image stored in the file \a fileName, decoding it only
+     * when it isn't in the cache yet or when the file has changed. Returns a
+     * null image when the file could not be read.
+     */
+    static QImage loadImage(const QString &fileName);
+
+    /**
+     * Removes the image stored in the file \a fileName from the cache.
+     */
+    static void remove(const QString &fileName);
+
+    /**
+     * Removes all images from the cache.
+     */
+    static void clear();
+
+    /**
+     * Sets the maximum amount of memory in kilobytes used by the cached
+     * images. When exceeded, the least recently used images are removed.
+     * Images larger than this are not cached at all.
+     *
+     * Defaults to 256 MB, which fits a few 4096x4096 atlases at 32 bits per
+     * pixel (64 MB each).
+     */
+    static void setMaxCost(int kilobytes);
+    static int maxCost();
+
+private:
+    ImageCache();
+};
+
+} // namespace Tiled
+
+#endif // TILED_IMAGECACHE_H
@@ -70,7 +70,7 @@ QRectF IsometricRenderer::boundingRect(const MapObject *object) const
     if (!object->cell().isEmpty()) {
         const QPointF bottomCenter = pixelToScreenCoords(object->position());
         const Tile *tile = object->cell().tile;
-        const QSize imgSize = tile->image().size();
+        const QSize imgSize = tile->size();
         const QPoint tileOffset = tile->tileset()->tileOffset();
         return QRectF(bottomCenter.x() + tileOffset.x() - imgSize.width() / 2,
                       bottomCenter.y() + tileOffset.y() - imgSize.height(),
@@ -223,23 +223,44 @@ void IsometricRenderer::drawTileLayer(QPainter *painter,
 
     CellRenderer renderer(painter);
 
+    const int layerWidth = layer->width();
+    const int layerHeight = layer->height();
+
     for (int y = startPos.y(); y - tileHeight < rect.bottom();
          y += tileHeight / 2)
     {
-        QPoint columnItr = rowItr;
-
-        for (int x = startPos.x(); x < rect.right(); x += tileWidth) {
-            if (layer->contains(columnItr)) {
-                const Cell &cell = layer->cellAt(columnItr);
-                if (!cell.isEmpty()) {
-                    renderer.render(cell, QPointF(x, y),
-                                    CellRenderer::BottomLeft);
-                }
+        const int startX = startPos.x();
+        const int columns = startX < rect.right()
+                ? (rect.right() - startX + tileWidth - 1) / tileWidth
+                : 0;
+
+        /* Along a row, each column increases the x and decreases the y tile
+         * coordinate. Clip the columns to the span that lies within the
+         * layer, instead of checking each of them.
+         */
+        const int first = qMax(qMax(0, -rowItr.x()),
+                               rowItr.y() - layerHeight + 1);
+        const int last = qMin(qMin(columns, layerWidth - rowItr.x()),
+                              rowItr.y() + 1);
+
+        for (int column = first; column < last;) {
+            const int cellX = rowItr.x() + column;
+            const int cellY = rowItr.y() - column;
+
+            if (!layer->isChunkAllocated(cellX, cellY)) {
+                // Skip to where the row leaves this empty chunk
+                column += qMin(TileLayer::ChunkSize - (cellX & TileLayer::ChunkMask),
+                               (cellY & TileLayer::ChunkMask) + 1);
+                continue;
+            }
+
+            const Cell &cell = layer->cellAt(cellX, cellY);
+            if (!cell.isEmpty()) {
+                renderer.render(cell, QPointF(startX + column * tileWidth, y),
+                                CellRenderer::BottomLeft);
             }
 
-            // Advance to the next column
-            ++columnItr.rx();
-            --columnItr.ry();
+            ++column;
         }
 
         // Advance to the next row
@@ -21,6 +21,10 @@ win32 {
     LIBS += -lz
 }
 
+greaterThan(QT_MAJOR_VERSION, 4) {
+    QT += concurrent
+}
+
 DEFINES += QT_NO_CAST_FROM_ASCII \
     QT_NO_CAST_TO_ASCII
 DEFINES += TILED_LIBRARY
@@ -28,6 +32,7 @@ contains(QT_CONFIG, reduce_exports): CONFIG += hide_symbols
 
 SOURCES += compression.cpp \
     gidmapper.cpp \
+    imagecache.cpp \
     imagelayer.cpp \
     isometricrenderer.cpp \
     layer.cpp \
@@ -45,6 +50,7 @@ SOURCES += compression.cpp \
     tileset.cpp
 HEADERS += compression.h \
     gidmapper.h \
+    imagecache.h \
     imagelayer.h \
     isometricrenderer.h \
     layer.h \
@@ -32,6 +32,7 @@
 #define MAPOBJECT_H
 
 #include "object.h"
+#include "objectgroup.h"
 #include "tiled.h"
 #include "tilelayer.h"
 
@@ -105,7 +106,7 @@ public:
     /**
      * Sets the position of this object.
      */
-    void setPosition(const QPointF &pos) { mPos = pos; }
+    void setPosition(const QPointF &pos) { mPos = pos; boundsChanged(); }
 
     /**
      * Returns the x position of this object.
@@ -115,7 +116,7 @@ public:
     /**
      * Sets the x position of this object.
      */
-    void setX(qreal x) { mPos.setX(x); }
+    void setX(qreal x) { mPos.setX(x); boundsChanged(); }
 
     /**
      * Returns the y position of this object.
@@ -125,7 +126,7 @@ public:
     /**
      * Sets the x position of this object.
      */
-    void setY(qreal y) { mPos.setY(y); }
+    void setY(qreal y) { mPos.setY(y); boundsChanged(); }
 
     /**
      * Returns the size of this object.
@@ -135,7 +136,7 @@ public:
     /**
      * Sets the size of this object.
      */
-    void setSize(const QSizeF &size) { mSize = size; }
+    void setSize(const QSizeF &size) { mSize = size; boundsChanged(); }
 
     void setSize(qreal width, qreal height)
     { setSize(QSizeF(width, height)); }
@@ -148,7 +149,7 @@ public:
     /**
      * Sets the width of this object.
      */
-    void setWidth(qreal width) { mSize.setWidth(width); }
+    void setWidth(qreal width) { mSize.setWidth(width); boundsChanged(); }
 
     /**
      * Returns the height of this object.
@@ -158,7 +159,7 @@ public:
     /**
      * Sets the height of this object.
      */
-    void setHeight(qreal height) { mSize.setHeight(height); }
+    void setHeight(qreal height) { mSize.setHeight(height); boundsChanged(); }
 
     /**
      * Sets the polygon associated with this object. The polygon is only used
@@ -166,7 +167,8 @@ public:
      *
      * \sa setShape()
      */
-    void setPolygon(const QPolygonF &polygon) { mPolygon = polygon; }
+    void setPolygon(const QPolygonF &polygon)
+    { mPolygon = polygon; boundsChanged(); }
 
     /**
      * Returns the polygon associated with this object. Returns an empty
@@ -195,7 +197,7 @@ public:
      *
      * \warning The object shape is ignored for tile objects!
      */
-    void setCell(const Cell &cell) { mCell = cell; }
+    void setCell(const Cell &cell) { mCell = cell; boundsChanged(); }
 
     /**
      * Returns the tile associated with this object.
@@ -217,7 +219,8 @@ public:
     /**
      * Sets the rotation of the object
      */
-    void setRotation(qreal rotation) { mRotation = rotation; }
+    void setRotation(qreal rotation)
+    { mRotation = rotation; boundsChanged(); }
 
     /**
      * Returns the rotation of the object.
@@ -240,6 +243,16 @@ public:
     MapObject *clone() const;
 
 private:
+    /**
+     * Lets the object group know that the area covered by this object may
+     * have changed, so that it can keep its spatial index up to date.
+     */
+    void boundsChanged()
+    {
+        if (mObjectGroup)
+            mObjectGroup->markObjectBoundsDirty(this);
+    }
+
     QString mName;
     QString mType;
     QPointF mPos;
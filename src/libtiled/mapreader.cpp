@@ -32,6 +32,7 @@
 
 #include "compression.h"
 #include "gidmapper.h"
+#include "imagecache.h"
 #include "imagelayer.h"
 #include "objectgroup.h"
 #include "map.h"
@@ -45,9 +46,17 @@
 #include <QDebug>
 #include <QDir>
 #include <QFileInfo>
+#include <QImageReader>
+#include <QThreadPool>
 #include <QVector>
 #include <QXmlStreamReader>
 
+#if QT_VERSION >= 0x050000
+#include <QtConcurrent/QtConcurrentMap>
+#else
+#include <QtCore/QtConcurrentMap>
+#endif
+
 using namespace Tiled;
 using namespace Tiled::Internal;
 
@@ -64,7 +73,11 @@ public:
     MapReaderPrivate(MapReader *mapReader):
         p(mapReader),
         mMap(0),
-        mReadingExternalTileset(false)
+        mReadingExternalTileset(false),
+        mParallelLayerDecoding(false),
+        mTilesetImageLoadingDeferred(false),
+        mPixmapCreationDeferred(false),
+        mLayerCount(0)
     {}
 
     Map *readMap(QIODevice *device, const QString &path);
@@ -78,6 +91,7 @@ private:
     void readUnknownElement();
 
     Map *readMap();
+    bool reportProgress();
 
     Tileset *readTileset();
     void readTilesetTile(Tileset *tileset);
@@ -85,12 +99,59 @@ private:
     void readTilesetTerrainTypes(Tileset *tileset);
     QImage readImage();
 
+    /**
+     * An image read while the creation of pixmaps is deferred, along with
+     * where its pixmap needs to go. See MapReader::createDeferredPixmaps().
+     */
+    struct DeferredImage
+    {
+        Tileset *tileset;
+        int tileId;             // -1 for the tileset image
+        ImageLayer *imageLayer;
+        QImage image;
+        QString source;
+    };
+
+    void deferImage(Tileset *tileset, int tileId, ImageLayer *imageLayer,
+                    const QImage &image, const QString &source);
+
+    /**
+     * The encoded data of a tile layer, captured while parsing so that it can
+     * be decoded later on a worker thread.
+     */
+    struct PendingLayerData
+    {
+        TileLayer *tileLayer;
+        const GidMapper *gidMapper;
+        QString encoding;
+        QString compression;
+        QByteArray binaryData;
+        QString csvData;
+        QString error;
+    };
+
     TileLayer *readLayer();
     void readLayerData(TileLayer *tileLayer);
-    void decodeBinaryLayerData(TileLayer *tileLayer,
-                               const QStringRef &text,
-                               const QStringRef &compression);
-    void decodeCSVLayerData(TileLayer *tileLayer, const QString &text);
+    void decodePendingLayerData();
+
+    static void decodeLayerData(PendingLayerData &pending);
+    static QString decodeBinaryLayerData(TileLayer *tileLayer,
+                                         const GidMapper &gidMapper,
+                                         const QByteArray &latin1Text,
+                                         const QString &compression);
+    static QString decodeBinaryLayerData(TileLayer *tileLayer,
+                                         const GidMapper &gidMapper,
+                                         const QStringRef &text,
+                                         const QString &compression);
+    static QString setLayerGids(TileLayer *tileLayer,
+                                const GidMapper &gidMapper,
+                                const QByteArray &gids);
+    static QString setLayerRow(TileLayer *tileLayer, int y,
+                               const GidMapper &gidMapper,
+                               const unsigned *gids, Cell *cells, int count);
+    static QString decodeCSVLayerData(TileLayer *tileLayer,
+                                      const GidMapper &gidMapper,
+                                      const QString &text);
 
     /**
      * Returns the cell for the given global tile ID. Errors are raised with
@@ -102,6 +163,19 @@ private:
      */
     Cell cellForGid(unsigned gid);
 
+    /**
+     * Returns the cell for the given global tile ID. Does not touch the
+     * QXmlStreamReader, so that it can be used from worker threads.
+     *
+     * @param gid       the global tile ID
+     * @param gidMapper the gid mapper used to look up the tile
+     * @param error     set to the error message when the gid is invalid
+     * @return the cell data associated with the given global tile ID, or an
+     *         empty cell if not found
+     */
+    static Cell cellForGid(unsigned gid, const GidMapper &gidMapper,
+                           QString *error);
+
     ImageLayer *readImageLayer();
     void readImageLayerImage(ImageLayer *imageLayer);
 
@@ -121,6 +195,12 @@ private:
     QList<Tileset*> mCreatedTilesets;
     GidMapper mGidMapper;
     bool mReadingExternalTileset;
+    bool mParallelLayerDecoding;
+    bool mTilesetImageLoadingDeferred;
+    bool mPixmapCreationDeferred;
+    QList<PendingLayerData> mPendingLayerData;
+    QList<DeferredImage> mDeferredImages;
+    int mLayerCount;
 
     QXmlStreamReader xml;
 };
@@ -132,6 +212,8 @@ Map *MapReaderPrivate::readMap(QIODevice *device, const QString &path)
 {
     mError.clear();
     mPath = path;
+    mDeferredImages.clear();
+    mLayerCount = 0;
     Map *map = 0;
 
     xml.setDevice(device);
@@ -150,6 +232,7 @@ Tileset *MapReaderPrivate::readTileset(QIODevice *device, const QString &path)
 {
     mError.clear();
     mPath = path;
+    mDeferredImages.clear();
     Tileset *tileset = 0;
     mReadingExternalTileset = true;
 
@@ -234,26 +317,42 @@ Map *MapReaderPrivate::readMap()
     if (!bgColorString.isEmpty())
         mMap->setBackgroundColor(QColor(bgColorString.toString()));
 
+    // The layers are only added to the map once their data has been decoded,
+    // since adding cells to a layer that is part of a map isn't thread-safe.
+    QList<Layer*> layers;
+
     while (xml.readNextStartElement()) {
         if (xml.name() == QLatin1String("properties"))
             mMap->mergeProperties(readProperties());
         else if (xml.name() == QLatin1String("tileset"))
             mMap->addTileset(readTileset());
         else if (xml.name() == QLatin1String("layer"))
-            mMap->addLayer(readLayer());
+            layers.append(readLayer());
         else if (xml.name() == QLatin1String("objectgroup"))
-            mMap->addLayer(readObjectGroup());
+            layers.append(readObjectGroup());
         else if (xml.name() == QLatin1String("imagelayer"))
-            mMap->addLayer(readImageLayer());
+            layers.append(readImageLayer());
         else
             readUnknownElement();
+
+        mLayerCount = layers.size();
+
+        if (!xml.hasError())
+            reportProgress();
     }
 
+    decodePendingLayerData();
+
+    foreach (Layer *layer, layers)
+        if (layer)
+            mMap->addLayer(layer);
+
     // Clean up in case of error
     if (xml.hasError()) {
         // The tilesets are not owned by the map
         qDeleteAll(mCreatedTilesets);
         mCreatedTilesets.clear();
+        mDeferredImages.clear();
 
         delete mMap;
         mMap = 0;
@@ -262,6 +361,24 @@ Map *MapReaderPrivate::readMap()
     return mMap;
 }
 
+/**
+ * Reports the progress of reading the map. Raises an error and returns false
+ * when loading was cancelled.
+ */
+bool MapReaderPrivate::reportProgress()
+{
+    const QIODevice *device = xml.device();
+    if (!device)
+        return true;
+
+    if (p->reportProgress(device->pos(), device->size(), mLayerCount))
+        return true;
+
+    mError = tr("Loading was cancelled.");
+    xml.raiseError(mError);
+    return false;
+}
+
 Tileset *MapReaderPrivate::readTileset()
 {
     Q_ASSERT(xml.isStartElement() && xml.name() == QLatin1String("tileset"));
@@ -392,7 +509,12 @@ void MapReaderPrivate::readTilesetTile(Tileset *tileset)
             QString source = xml.attributes().value(QLatin1String("source")).toString();
             if (!source.isEmpty())
                 source = p->resolveReference(source, mPath);
-            tileset->setTileImage(id, QPixmap::fromImage(readImage()), source);
+
+            const QImage image = readImage();
+            if (mPixmapCreationDeferred)
+                deferImage(tileset, id, 0, image, source);
+            else
+                tileset->setTileImage(id, QPixmap::fromImage(image), source);
         } else if (xml.name() == QLatin1String("objectgroup")) {
             tile->setObjectGroup(readObjectGroup());
         } else if (xml.name() == QLatin1String("animation")) {
@@ -445,10 +567,40 @@ void MapReaderPrivate::readTilesetImage(Tileset *tileset)
     const int width = atts.value(QLatin1String("width")).toString().toInt();
     mGidMapper.setTilesetWidth(tileset, width);
 
-    if (!tileset->loadFromImage(readImage(), source))
+    if (mTilesetImageLoadingDeferred && !source.isEmpty()) {
+        // Only read the size, the image itself is loaded later
+        const QSize size = QImageReader(source).size();
+        if (tileset->setPendingImage(size, source)) {
+            xml.skipCurrentElement();
+            return;
+        }
+    }
+
+    const QImage image = readImage();
+    bool loaded;
+
+    if (mPixmapCreationDeferred) {
+        // Set up the tiles already, the pixmap is created later
+        loaded = tileset->setPendingImage(image.size(), source);
+        if (loaded)
+            deferImage(tileset, -1, 0, image, source);
+    } else {
+        loaded = tileset->loadFromImage(image, source);
+    }
+
+    if (!loaded)
         xml.raiseError(tr("Error loading tileset image:\n'%1'").arg(source));
 }
 
+void MapReaderPrivate::deferImage(Tileset *tileset, int tileId,
+                                  ImageLayer *imageLayer,
+                                  const QImage &image, const QString &source)
+{
+    const DeferredImage deferred = { tileset, tileId, imageLayer,
+                                     image, source };
+    mDeferredImages.append(deferred);
+}
+
 QImage MapReaderPrivate::readImage()
 {
     Q_ASSERT(xml.isStartElement() && xml.name() == QLatin1String("image"));
@@ -597,6 +749,10 @@ void MapReaderPrivate::readLayerData(TileLayer *tileLayer)
                 if (x >= tileLayer->width()) {
                     x = 0;
                     y++;
+
+                    // Allow cancelling while reading large layers
+                    if (y % 64 == 0)
+                        reportProgress();
                 }
 
                 xml.skipCurrentElement();
@@ -604,107 +760,277 @@ void MapReaderPrivate::readLayerData(TileLayer *tileLayer)
                 readUnknownElement();
             }
         } else if (xml.isCharacters() && !xml.isWhitespace()) {
-            if (encoding == QLatin1String("base64")) {
-                decodeBinaryLayerData(tileLayer,
-                                      xml.text(),
-                                      compression);
-            } else if (encoding == QLatin1String("csv")) {
-                decodeCSVLayerData(tileLayer, xml.text().toString());
-            } else {
+            if (encoding != QLatin1String("base64") &&
+                    encoding != QLatin1String("csv")) {
                 xml.raiseError(tr("Unknown encoding: %1")
                                .arg(encoding.toString()));
                 continue;
             }
+
+            if (!mParallelLayerDecoding &&
+                    encoding == QLatin1String("base64")) {
+                // Decode straight from the text held by the XML reader
+                const QString error =
+                        decodeBinaryLayerData(tileLayer, mGidMapper,
+                                              xml.text(),
+                                              compression.toString());
+                if (!error.isEmpty())
+                    xml.raiseError(error);
+                continue;
+            }
+
+            PendingLayerData pending;
+            pending.tileLayer = tileLayer;
+            pending.gidMapper = &mGidMapper;
+            pending.encoding = encoding.toString();
+            pending.compression = compression.toString();
+
+            if (encoding == QLatin1String("base64")) {
+#if QT_VERSION < 0x040800
+                const QStringRef text = xml.text();
+                const QString textData = QString::fromRawData(text.unicode(),
+                                                              text.size());
+                pending.binaryData = textData.toLatin1();
+#else
+                pending.binaryData = xml.text().toLatin1();
+#endif
+            } else {
+                pending.csvData = xml.text().toString();
+            }
+
+            if (mParallelLayerDecoding) {
+                mPendingLayerData.append(pending);
+            } else {
+                decodeLayerData(pending);
+                if (!pending.error.isEmpty())
+                    xml.raiseError(pending.error);
+            }
         }
     }
 }
 
-void MapReaderPrivate::decodeBinaryLayerData(TileLayer *tileLayer,
-                                             const QStringRef &text,
-                                             const QStringRef &compression)
+/**
+ * Decodes the layer data collected while parsing, using the global thread
+ * pool. Raises the first error encountered, in document order.
+ *
+ * The layers are decoded in batches, so that loading can be cancelled in
+ * between.
+ */
+void MapReaderPrivate::decodePendingLayerData()
 {
-#if QT_VERSION < 0x040800
-    const QString textData = QString::fromRawData(text.unicode(), text.size());
-    const QByteArray latin1Text = textData.toLatin1();
-#else
-    const QByteArray latin1Text = text.toLatin1();
-#endif
-    QByteArray tileData = QByteArray::fromBase64(latin1Text);
+    const int count = mPendingLayerData.size();
+    const int batchSize =
+            qMax(1, QThreadPool::globalInstance()->maxThreadCount() * 2);
+
+    for (int i = 0; i < count && !xml.hasError(); i += batchSize) {
+        if (i > 0 && !reportProgress())
+            break;
+
+        const QList<PendingLayerData>::iterator begin =
+                mPendingLayerData.begin() + i;
+        const QList<PendingLayerData>::iterator end =
+                mPendingLayerData.begin() + qMin(i + batchSize, count);
+
+        QtConcurrent::blockingMap(begin, end,
+                                  &MapReaderPrivate::decodeLayerData);
+    }
+
+    foreach (const PendingLayerData &pending, mPendingLayerData) {
+        if (!pending.error.isEmpty() && !xml.hasError())
+            xml.raiseError(pending.error);
+    }
+
+    mPendingLayerData.clear();
+}
+
+void MapReaderPrivate::decodeLayerData(PendingLayerData &pending)
+{
+    if (pending.encoding == QLatin1String("base64")) {
+        pending.error = decodeBinaryLayerData(pending.tileLayer,
+                                              *pending.gidMapper,
+                                              pending.binaryData,
+                                              pending.compression);
+        pending.binaryData.clear();
+    } else {
+        pending.error = decodeCSVLayerData(pending.tileLayer,
+                                           *pending.gidMapper,
+                                           pending.csvData);
+        pending.csvData.clear();
+    }
+}
+
+static bool isCompressed(const QString &compression, bool *supported)
+{
+    if (compression == QLatin1String("zlib") ||
+            compression == QLatin1String("gzip")) {
+        *supported = true;
+        return true;
+    }
+
+    *supported = compression.isEmpty();
+    return false;
+}
+
+QString MapReaderPrivate::decodeBinaryLayerData(TileLayer *tileLayer,
+                                                const GidMapper &gidMapper,
+                                                const QByteArray &latin1Text,
+                                                const QString &compression)
+{
+    bool supported;
+    const bool compressed = isCompressed(compression, &supported);
+    if (!supported)
+        return tr("Compression method '%1' not supported").arg(compression);
+
     const int size = (tileLayer->width() * tileLayer->height()) * 4;
+    QByteArray gids;
+    gids.resize(size);
 
-    if (compression == QLatin1String("zlib")
-        || compression == QLatin1String("gzip")) {
-        tileData = decompress(tileData, size);
-    } else if (!compression.isEmpty()) {
-        xml.raiseError(tr("Compression method '%1' not supported")
-                       .arg(compression.toString()));
-        return;
+    if (!decodeBase64(latin1Text.constData(), latin1Text.size(), compressed,
+                      gids.data(), size)) {
+        return tr("Corrupt layer data for layer '%1'").arg(tileLayer->name());
     }
 
-    if (size != tileData.length()) {
-        xml.raiseError(tr("Corrupt layer data for layer '%1'")
-                       .arg(tileLayer->name()));
-        return;
+    return setLayerGids(tileLayer, gidMapper, gids);
+}
+
+QString MapReaderPrivate::decodeBinaryLayerData(TileLayer *tileLayer,
+                                                const GidMapper &gidMapper,
+                                                const QStringRef &text,
+                                                const QString &compression)
+{
+    bool supported;
+    const bool compressed = isCompressed(compression, &supported);
+    if (!supported)
+        return tr("Compression method '%1' not supported").arg(compression);
+
+    const int size = (tileLayer->width() * tileLayer->height()) * 4;
+    QByteArray gids;
+    gids.resize(size);
+
+    if (!decodeBase64(text.unicode(), text.size(), compressed,
+                      gids.data(), size)) {
+        return tr("Corrupt layer data for layer '%1'").arg(tileLayer->name());
     }
 
+    return setLayerGids(tileLayer, gidMapper, gids);
+}
+
+/**
+ * Sets the cells of the given tile layer from the little-endian global tile
+ * IDs in \a gids.
+ */
+QString MapReaderPrivate::setLayerGids(TileLayer *tileLayer,
+                                       const GidMapper &gidMapper,
+                                       const QByteArray &gids)
+{
     const unsigned char *data =
-            reinterpret_cast<const unsigned char*>(tileData.constData());
-    int x = 0;
-    int y = 0;
+            reinterpret_cast<const unsigned char*>(gids.constData());
+    const int width = tileLayer->width();
+    const int count = qMin(gids.size() / 4, width * tileLayer->height());
+
+    QVector<unsigned> rowGids(width);
+    QVector<Cell> rowCells(width);
+
+    // The gids are converted to cells a row at a time
+    for (int start = 0, y = 0; start < count; start += width, ++y) {
+        const int rowCount = qMin(width, count - start);
+
+        for (int x = 0; x < rowCount; ++x) {
+            const int i = (start + x) * 4;
+            rowGids[x] = data[i] |
+                         data[i + 1] << 8 |
+                         data[i + 2] << 16 |
+                         data[i + 3] << 24;
+        }
 
-    for (int i = 0; i < size - 3; i += 4) {
-        const unsigned gid = data[i] |
-                             data[i + 1] << 8 |
-                             data[i + 2] << 16 |
-                             data[i + 3] << 24;
+        const QString error = setLayerRow(tileLayer, y, gidMapper,
+                                          rowGids.constData(),
+                                          rowCells.data(), rowCount);
+        if (!error.isEmpty())
+            return error;
+    }
 
-        tileLayer->setCell(x, y, cellForGid(gid));
+    return QString();
+}
 
-        x++;
-        if (x == tileLayer->width()) {
-            x = 0;
-            y++;
-        }
+/**
+ * Sets the first \a count cells of row \a y of the given tile layer from the
+ * global tile IDs in \a gids, using \a cells as buffer.
+ */
+QString MapReaderPrivate::setLayerRow(TileLayer *tileLayer, int y,
+                                      const GidMapper &gidMapper,
+                                      const unsigned *gids, Cell *cells,
+                                      int count)
+{
+    const int converted = gidMapper.gidsToCells(gids, cells, count);
+    if (converted < count) {
+        QString error;
+        cellForGid(gids[converted], gidMapper, &error);
+        return error;
     }
+
+    for (int x = 0; x < count; ++x)
+        tileLayer->setCell(x, y, cells[x]);
+
+    return QString();
 }
 
-void MapReaderPrivate::decodeCSVLayerData(TileLayer *tileLayer, const QString &text)
+QString MapReaderPrivate::decodeCSVLayerData(TileLayer *tileLayer,
+                                             const GidMapper &gidMapper,
+                                             const QString &text)
 {
     QString trimText = text.trimmed();
     QStringList tiles = trimText.split(QLatin1Char(','));
 
-    if (tiles.length() != tileLayer->width() * tileLayer->height()) {
-        xml.raiseError(tr("Corrupt layer data for layer '%1'")
-                       .arg(tileLayer->name()));
-        return;
-    }
+    if (tiles.length() != tileLayer->width() * tileLayer->height())
+        return tr("Corrupt layer data for layer '%1'").arg(tileLayer->name());
+
+    const int width = tileLayer->width();
+    QVector<unsigned> rowGids(width);
+    QVector<Cell> rowCells(width);
 
     for (int y = 0; y < tileLayer->height(); y++) {
-        for (int x = 0; x < tileLayer->width(); x++) {
+        for (int x = 0; x < width; x++) {
             bool conversionOk;
-            const unsigned gid = tiles.at(y * tileLayer->width() + x)
-                    .toUInt(&conversionOk);
+            rowGids[x] = tiles.at(y * width + x).toUInt(&conversionOk);
             if (!conversionOk) {
-                xml.raiseError(
-                        tr("Unable to parse tile at (%1,%2) on layer '%3'")
-                               .arg(x + 1).arg(y + 1).arg(tileLayer->name()));
-                return;
+                return tr("Unable to parse tile at (%1,%2) on layer '%3'")
+                        .arg(x + 1).arg(y + 1).arg(tileLayer->name());
             }
-            tileLayer->setCell(x, y, cellForGid(gid));
         }
+
+        const QString error = setLayerRow(tileLayer, y, gidMapper,
+                                          rowGids.constData(),
+                                          rowCells.data(), width);
+        if (!error.isEmpty())
+            return error;
     }
+
+    return QString();
 }
 
 Cell MapReaderPrivate::cellForGid(unsigned gid)
+{
+    QString error;
+    const Cell result = cellForGid(gid, mGidMapper, &error);
+
+    if (!error.isEmpty())
+        xml.raiseError(error);
+
+    return result;
+}
+
+Cell MapReaderPrivate::cellForGid(unsigned gid, const GidMapper &gidMapper,
+                                  QString *error)
 {
     bool ok;
-    const Cell result = mGidMapper.gidToCell(gid, ok);
+    const Cell result = gidMapper.gidToCell(gid, ok);
 
     if (!ok) {
-        if (mGidMapper.isEmpty())
-            xml.raiseError(tr("Tile used but no tilesets specified"));
+        if (gidMapper.isEmpty())
+            *error = tr("Tile used but no tilesets specified");
         else
-            xml.raiseError(tr("Invalid tile: %1").arg(gid));
+            *error = tr("Invalid tile: %1").arg(gid);
     }
 
     return result;
@@ -794,7 +1120,9 @@ void MapReaderPrivate::readImageLayerImage(ImageLayer *imageLayer)
     source = p->resolveReference(source, mPath);
 
     const QImage imageLayerImage = p->readExternalImage(source);
-    if (!imageLayer->loadFromImage(imageLayerImage, source))
+    if (mPixmapCreationDeferred && !imageLayerImage.isNull())
+        deferImage(0, -1, imageLayer, imageLayerImage, source);
+    else if (!imageLayer->loadFromImage(imageLayerImage, source))
         xml.raiseError(tr("Error loading image layer image:\n'%1'").arg(source));
 
     xml.skipCurrentElement();
@@ -998,6 +1326,55 @@ QString MapReader::errorString() const
     return d->errorString();
 }
 
+void MapReader::setParallelLayerDecoding(bool enabled)
+{
+    d->mParallelLayerDecoding = enabled;
+}
+
+bool MapReader::isParallelLayerDecodingEnabled() const
+{
+    return d->mParallelLayerDecoding;
+}
+
+void MapReader::setTilesetImageLoadingDeferred(bool deferred)
+{
+    d->mTilesetImageLoadingDeferred = deferred;
+}
+
+bool MapReader::isTilesetImageLoadingDeferred() const
+{
+    return d->mTilesetImageLoadingDeferred;
+}
+
+void MapReader::setPixmapCreationDeferred(bool deferred)
+{
+    d->mPixmapCreationDeferred = deferred;
+}
+
+bool MapReader::isPixmapCreationDeferred() const
+{
+    return d->mPixmapCreationDeferred;
+}
+
+void MapReader::createDeferredPixmaps()
+{
+    foreach (const MapReaderPrivate::DeferredImage &deferred,
+             d->mDeferredImages) {
+        if (deferred.imageLayer) {
+            deferred.imageLayer->loadFromImage(deferred.image,
+                                               deferred.source);
+        } else if (deferred.tileId == -1) {
+            deferred.tileset->loadFromImage(deferred.image, deferred.source);
+        } else {
+            deferred.tileset->setTileImage(deferred.tileId,
+                                           QPixmap::fromImage(deferred.image),
+                                           deferred.source);
+        }
+    }
+
+    d->mDeferredImages.clear();
+}
+
 QString MapReader::resolveReference(const QString &reference,
                                     const QString &mapPath)
 {
@@ -1009,19 +1386,32 @@ QString MapReader::resolveReference(const QString &reference,
 
 QImage MapReader::readExternalImage(const QString &source)
 {
-    return QImage(source);
+    return ImageCache::loadImage(source);
 }
 
 Tileset *MapReader::readExternalTileset(const QString &source,
                                         QString *error)
 {
     MapReader reader;
+    reader.setTilesetImageLoadingDeferred(d->mTilesetImageLoadingDeferred);
+    reader.setPixmapCreationDeferred(d->mPixmapCreationDeferred);
 
     Tileset *tileset = reader.readTileset(source);
-    if (!tileset)
+    if (!tileset) {
         *error = reader.errorString();
-    else
+    } else {
         d->mCreatedTilesets.append(tileset);
+        d->mDeferredImages.append(reader.d->mDeferredImages);
+    }
 
     return tileset;
 }
+
+bool MapReader::reportProgress(qint64 bytesRead, qint64 bytesTotal,
+                               int layerCount)
+{
+    Q_UNUSED(bytesRead)
+    Q_UNUSED(bytesTotal)
+    Q_UNUSED(layerCount)
+    return true;
+}
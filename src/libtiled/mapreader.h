@@ -95,6 +95,53 @@ public:
      */
     QString errorString() const;
 
+    /**
+     * Sets whether the tile layer data is decoded in parallel. When enabled,
+     * parsing the map only collects the encoded data of each tile layer. The
+     * decoding, decompression and tile lookups then run for all layers at
+     * once on the global thread pool, before readMap() returns.
+     *
+     * Disabled by default.
+     */
+    void setParallelLayerDecoding(bool enabled);
+    bool isParallelLayerDecodingEnabled() const;
+
+    /**
+     * Sets whether loading of external tileset images is deferred. When
+     * enabled, only the size of each tileset image is read from its header
+     * and the tilesets are set up using Tileset::setPendingImage(). The
+     * images then need to be loaded by the caller, for example on a worker
+     * thread. Images whose size can't be determined up front are still
+     * loaded immediately, as are embedded images.
+     *
+     * Note that readExternalImage() is not called for deferred images.
+     *
+     * Disabled by default.
+     */
+    void setTilesetImageLoadingDeferred(bool deferred);
+    bool isTilesetImageLoadingDeferred() const;
+
+    /**
+     * Sets whether the creation of pixmaps is deferred. Since pixmaps can
+     * generally only be created on the GUI thread, this allows maps to be
+     * read on a worker thread. The images of tilesets, tiles and image layers
+     * are then kept as QImage until createDeferredPixmaps() is called.
+     *
+     * The tiles of a tileset image already have their final size, but tiles
+     * with their own image only get their size once the pixmaps are created.
+     *
+     * Disabled by default.
+     */
+    void setPixmapCreationDeferred(bool deferred);
+    bool isPixmapCreationDeferred() const;
+
+    /**
+     * Creates the pixmaps that were deferred while reading the last map or
+     * tileset. Needs to be called on the GUI thread, before the map or
+     * tileset is used.
+     */
+    void createDeferredPixmaps();
+
 protected:
     /**
      * Called for each \a reference to an external file. Should return the path
@@ -106,6 +153,8 @@ protected:
 
     /**
      * Called when an external image is encountered while a tileset is loaded.
+     * The default implementation loads the image through the ImageCache, so
+     * that images shared by several maps are only decoded once.
      */
     virtual QImage readExternalImage(const QString &source);
 
@@ -119,6 +168,19 @@ protected:
     virtual Tileset *readExternalTileset(const QString &source,
                                          QString *error);
 
+    /**
+     * Called after each top-level element of a map has been read, as well
+     * as regularly while reading and decoding the tile layer data.
+     * \a bytesRead is the position in the device that is being read and
+     * \a bytesTotal its size. \a layerCount is the number of layers read
+     * so far.
+     *
+     * Return false to cancel loading, in which case readMap() returns 0. The
+     * default implementation just returns true.
+     */
+    virtual bool reportProgress(qint64 bytesRead, qint64 bytesTotal,
+                                int layerCount);
+
 private:
     friend class Internal::MapReaderPrivate;
     Internal::MapReaderPrivate *d;
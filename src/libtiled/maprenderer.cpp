@@ -93,7 +93,7 @@ static bool hasOpenGLEngine(const QPainter *painter)
 
 CellRenderer::CellRenderer(QPainter *painter)
     : mPainter(painter)
-    , mTile(0)
+    , mImage(0)
     , mIsOpenGL(hasOpenGLEngine(painter))
 {
 }
@@ -102,26 +102,33 @@ CellRenderer::CellRenderer(QPainter *painter)
  * Renders a \a cell with the given \a origin at \a pos, taking into account
  * the flipping and tile offset.
  *
- * For performance reasons, the actual drawing is delayed until a different
- * kind of tile has to be drawn. For this reason it is necessary to call
- * flush when finished doing drawCell calls. This function is also called by
- * the destructor so usually an explicit call it not needed.
+ * For performance reasons, the actual drawing is delayed until a tile from a
+ * different image has to be drawn. Since the tiles of a tileset based on a
+ * single image all refer to that image, consecutive cells from the same
+ * tileset are drawn in one go. For this reason it is necessary to call flush
+ * when finished doing drawCell calls. This function is also called by the
+ * destructor so usually an explicit call it not needed.
  */
 void CellRenderer::render(const Cell &cell, const QPointF &pos, Origin origin)
 {
-    if (mTile != cell.tile)
+    const Tile *tile = cell.tile->currentFrameTile();
+    if (!tile)
+        return;
+
+    const QPixmap &image = tile->sourceImage();
+    if (mImage != &image)
         flush();
 
-    const QPixmap &image = cell.tile->currentFrameImage();
-    const QSizeF size = image.size();
+    const QRect &imageRect = tile->imageRect();
+    const QSizeF size = imageRect.size();
     const QPoint offset = cell.tile->tileset()->tileOffset();
     const QPointF sizeHalf = QPointF(size.width() / 2, size.height() / 2);
 
     QPainter::PixmapFragment fragment;
     fragment.x = pos.x() + offset.x() + sizeHalf.x();
     fragment.y = pos.y() + offset.y() + sizeHalf.y() - size.height();
-    fragment.sourceLeft = 0;
-    fragment.sourceTop = 0;
+    fragment.sourceLeft = imageRect.x();
+    fragment.sourceTop = imageRect.y();
     fragment.width = size.width();
     fragment.height = size.height();
     fragment.scaleX = cell.flippedHorizontally ? -1 : 1;
@@ -132,6 +139,16 @@ void CellRenderer::render(const Cell &cell, const QPointF &pos, Origin origin)
     if (origin == BottomCenter)
         fragment.x -= sizeHalf.x();
 
+    // Draw a placeholder while the tileset image is still being loaded
+    if (image.isNull()) {
+        flush();
+        mPainter->fillRect(QRectF(fragment.x - sizeHalf.x(),
+                                  fragment.y - sizeHalf.y(),
+                                  size.width(), size.height()),
+                           QColor(128, 128, 128, 96));
+        return;
+    }
+
     if (cell.flippedAntiDiagonally) {
         fragment.rotation = 90;
         fragment.scaleX *= -1;
@@ -145,7 +162,7 @@ void CellRenderer::render(const Cell &cell, const QPointF &pos, Origin origin)
     }
 
     if (mIsOpenGL || (fragment.scaleX > 0 && fragment.scaleY > 0)) {
-        mTile = cell.tile;
+        mImage = &image;
         mFragments.append(fragment);
         return;
     }
@@ -163,7 +180,7 @@ void CellRenderer::render(const Cell &cell, const QPointF &pos, Origin origin)
 
     const QRectF target(fragment.width * -0.5, fragment.height * -0.5,
                         fragment.width, fragment.height);
-    const QRectF source(0, 0, fragment.width, fragment.height);
+    const QRectF source(imageRect);
 
     mPainter->setTransform(transform);
     mPainter->drawPixmap(target, image, source);
@@ -175,13 +192,13 @@ void CellRenderer::render(const Cell &cell, const QPointF &pos, Origin origin)
  */
 void CellRenderer::flush()
 {
-    if (!mTile)
+    if (!mImage)
         return;
 
     mPainter->drawPixmapFragments(mFragments.constData(),
                                   mFragments.size(),
-                                  mTile->currentFrameImage());
+                                  *mImage);
 
-    mTile = 0;
+    mImage = 0;
     mFragments.resize(0);
 }
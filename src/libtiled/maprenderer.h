@@ -264,7 +264,7 @@ public:
 
 private:
     QPainter * const mPainter;
-    Tile *mTile;
+    const QPixmap *mImage;
     QVector<QPainter::PixmapFragment> mFragments;
     const bool mIsOpenGL;
 };
@@ -44,8 +44,15 @@
 #include <QCoreApplication>
 #include <QBuffer>
 #include <QDir>
+#include <QFuture>
 #include <QXmlStreamWriter>
 
+#if QT_VERSION >= 0x050000
+#include <QtConcurrent/QtConcurrentRun>
+#else
+#include <QtCore/QtConcurrentRun>
+#endif
+
 using namespace Tiled;
 using namespace Tiled::Internal;
 
@@ -71,8 +78,17 @@ public:
     Map::LayerDataFormat mLayerDataFormat;
     Map::RenderOrder mMapRenderOrder;
     bool mDtdEnabled;
+    bool mParallelLayerEncoding;
+
+    static QByteArray encodeLayerData(const TileLayer *tileLayer,
+                                      const GidMapper &gidMapper,
+                                      Map::LayerDataFormat format);
 
 private:
+    static void readRowGids(const TileLayer *tileLayer, int y,
+                            const GidMapper &gidMapper,
+                            Cell *cells, unsigned *gids);
+
     void writeMap(QXmlStreamWriter &w, const Map *map);
     void writeTileset(QXmlStreamWriter &w, const Tileset *tileset,
                       unsigned firstGid);
@@ -87,6 +103,37 @@ private:
     QDir mMapDir;     // The directory in which the map is being saved
     GidMapper mGidMapper;
     bool mUseAbsolutePaths;
+
+    // Tile layer data being encoded on the global thread pool, in the order
+    // in which the tile layers are written. Each future is dropped once its
+    // layer has been written, which releases the encoded data.
+    QList<const TileLayer*> mEncodedLayers;
+    QList<QFuture<QByteArray> > mEncodedLayerData;
+    int mNextEncodedLayer;
+};
+
+/**
+ * Encodes the data of a tile layer, for use with QtConcurrent::run.
+ */
+class LayerDataEncoder
+{
+public:
+    typedef QByteArray result_type;
+
+    LayerDataEncoder(const GidMapper &gidMapper, Map::LayerDataFormat format)
+        : mGidMapper(gidMapper)
+        , mFormat(format)
+    {}
+
+    QByteArray operator()(const TileLayer *tileLayer) const
+    {
+        return MapWriterPrivate::encodeLayerData(tileLayer, mGidMapper,
+                                                 mFormat);
+    }
+
+private:
+    const GidMapper &mGidMapper;
+    Map::LayerDataFormat mFormat;
 };
 
 } // namespace Internal
@@ -96,7 +143,9 @@ private:
 MapWriterPrivate::MapWriterPrivate()
     : mLayerDataFormat(Map::Base64Zlib)
     , mDtdEnabled(false)
+    , mParallelLayerEncoding(false)
     , mUseAbsolutePaths(false)
+    , mNextEncodedLayer(0)
 {
 }
 
@@ -190,6 +239,21 @@ void MapWriterPrivate::writeMap(QXmlStreamWriter &w, const Map *map)
         firstGid += tileset->tileCount();
     }
 
+    // Start encoding the tile layer data in the background, so that it can
+    // be written out in order while the remaining layers are still encoding
+    if (mParallelLayerEncoding && mLayerDataFormat != Map::XML) {
+        const LayerDataEncoder encoder(mGidMapper, mLayerDataFormat);
+
+        foreach (const Layer *layer, map->layers()) {
+            if (layer->layerType() == Layer::TileLayerType) {
+                const TileLayer *tileLayer = static_cast<const TileLayer*>(layer);
+                mEncodedLayers.append(tileLayer);
+                mEncodedLayerData.append(QtConcurrent::run(encoder, tileLayer));
+            }
+        }
+        mNextEncodedLayer = 0;
+    }
+
     foreach (const Layer *layer, map->layers()) {
         const Layer::TypeFlag type = layer->layerType();
         if (type == Layer::TileLayerType)
@@ -200,6 +264,9 @@ void MapWriterPrivate::writeMap(QXmlStreamWriter &w, const Map *map)
             writeImageLayer(w, static_cast<const ImageLayer*>(layer));
     }
 
+    mEncodedLayerData.clear();
+    mEncodedLayers.clear();
+
     w.writeEndElement();
 }
 
@@ -409,48 +476,105 @@ void MapWriterPrivate::writeTileLayer(QXmlStreamWriter &w,
                 w.writeEndElement();
             }
         }
-    } else if (mLayerDataFormat == Map::CSV) {
-        QString tileData;
+    } else {
+        QByteArray tileData;
+        if (mNextEncodedLayer < mEncodedLayers.size()) {
+            Q_ASSERT(mEncodedLayers.at(mNextEncodedLayer) == tileLayer);
+            QFuture<QByteArray> &future = mEncodedLayerData[mNextEncodedLayer++];
+            tileData = future.result();
+            future = QFuture<QByteArray>();
+        } else {
+            tileData = encodeLayerData(tileLayer, mGidMapper,
+                                       mLayerDataFormat);
+        }
 
-        for (int y = 0; y < tileLayer->height(); ++y) {
-            for (int x = 0; x < tileLayer->width(); ++x) {
-                const unsigned gid = mGidMapper.cellToGid(tileLayer->cellAt(x, y));
-                tileData.append(QString::number(gid));
-                if (x != tileLayer->width() - 1
-                    || y != tileLayer->height() - 1)
-                    tileData.append(QLatin1String(","));
-            }
-            tileData.append(QLatin1String("\n"));
+        // The encoded data consists only of ASCII characters that need no
+        // escaping, and the writer uses UTF-8. Since the writer passes on
+        // everything to the device right away, the data can be written to
+        // the device directly once the start tag has been closed by writing
+        // the leading whitespace, rather than converting it to a QString.
+        Q_ASSERT(w.device());
+
+        if (mLayerDataFormat == Map::CSV) {
+            w.writeCharacters(QLatin1String("\n"));
+            w.device()->write(tileData);
+        } else {
+            w.writeCharacters(QLatin1String("\n   "));
+            w.device()->write(tileData);
+            w.writeCharacters(QLatin1String("\n  "));
         }
+    }
 
-        w.writeCharacters(QLatin1String("\n"));
-        w.writeCharacters(tileData);
-    } else {
-        QByteArray tileData;
-        tileData.reserve(tileLayer->height() * tileLayer->width() * 4);
+    w.writeEndElement(); // </data>
+    w.writeEndElement(); // </layer>
+}
+
+/**
+ * Looks up the global tile IDs of row \a y of the given \a tileLayer. The
+ * \a cells and \a gids buffers need room for a row of the layer.
+ */
+void MapWriterPrivate::readRowGids(const TileLayer *tileLayer, int y,
+                                   const GidMapper &gidMapper,
+                                   Cell *cells, unsigned *gids)
+{
+    const int width = tileLayer->width();
+    for (int x = 0; x < width; ++x)
+        cells[x] = tileLayer->cellAt(x, y);
+
+    gidMapper.cellsToGids(cells, gids, width);
+}
+
+/**
+ * Returns the CSV or base64 encoded data of the given \a tileLayer, as it
+ * is written within the data element. Only uses thread-safe functions, so
+ * that it can run on multiple layers at once.
+ */
+QByteArray MapWriterPrivate::encodeLayerData(const TileLayer *tileLayer,
+                                             const GidMapper &gidMapper,
+                                             Map::LayerDataFormat format)
+{
+    QByteArray tileData;
 
+    const int width = tileLayer->width();
+    QVector<Cell> rowCells(width);
+    QVector<unsigned> rowGids(width);
+
+    if (format == Map::CSV) {
         for (int y = 0; y < tileLayer->height(); ++y) {
-            for (int x = 0; x < tileLayer->width(); ++x) {
-                const unsigned gid = mGidMapper.cellToGid(tileLayer->cellAt(x, y));
-                tileData.append((char) (gid));
-                tileData.append((char) (gid >> 8));
-                tileData.append((char) (gid >> 16));
-                tileData.append((char) (gid >> 24));
+            readRowGids(tileLayer, y, gidMapper,
+                        rowCells.data(), rowGids.data());
+
+            for (int x = 0; x < width; ++x) {
+                tileData.append(QByteArray::number(rowGids.at(x)));
+                if (x != width - 1 || y != tileLayer->height() - 1)
+                    tileData.append(',');
             }
+            tileData.append('\n');
         }
 
-        if (mLayerDataFormat == Map::Base64Gzip)
-            tileData = compress(tileData, Gzip);
-        else if (mLayerDataFormat == Map::Base64Zlib)
-            tileData = compress(tileData, Zlib);
+        return tileData;
+    }
+
+    tileData.reserve(tileLayer->height() * width * 4);
 
-        w.writeCharacters(QLatin1String("\n   "));
-        w.writeCharacters(QString::fromLatin1(tileData.toBase64()));
-        w.writeCharacters(QLatin1String("\n  "));
+    for (int y = 0; y < tileLayer->height(); ++y) {
+        readRowGids(tileLayer, y, gidMapper, rowCells.data(), rowGids.data());
+
+        for (int x = 0; x < width; ++x) {
+            const unsigned gid = rowGids.at(x);
+            tileData.append((char) (gid));
+            tileData.append((char) (gid >> 8));
+            tileData.append((char) (gid >> 16));
+            tileData.append((char) (gid >> 24));
+        }
     }
 
-    w.writeEndElement(); // </data>
-    w.writeEndElement(); // </layer>
+    if (format == Map::Base64Gzip)
+        tileData = compress(tileData, Gzip);
+    else if (format == Map::Base64Zlib)
+        tileData = compress(tileData, Zlib);
+
+    return tileData.toBase64();
 }
 
 void MapWriterPrivate::writeLayerAttributes(QXmlStreamWriter &w,
@@ -705,3 +829,13 @@ bool MapWriter::isDtdEnabled() const
 {
     return d->mDtdEnabled;
 }
+
+void MapWriter::setParallelLayerEncoding(bool enabled)
+{
+    d->mParallelLayerEncoding = enabled;
+}
+
+bool MapWriter::isParallelLayerEncodingEnabled() const
+{
+    return d->mParallelLayerEncoding;
+}
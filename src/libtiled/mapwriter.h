@@ -116,6 +116,18 @@ public:
     void setDtdEnabled(bool enabled);
     bool isDtdEnabled() const;
 
+    /**
+     * Sets whether the tile layer data is encoded in parallel. When enabled,
+     * the CSV or base64 data of all tile layers is encoded and compressed on
+     * the global thread pool, while the layers are written out in order as
+     * their data becomes available. The output is the same as when this is
+     * disabled.
+     *
+     * Disabled by default.
+     */
+    void setParallelLayerEncoding(bool enabled);
+    bool isParallelLayerEncodingEnabled() const;
+
 private:
     Internal::MapWriterPrivate *d;
 };
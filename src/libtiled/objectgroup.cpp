@@ -35,13 +35,103 @@
 #include "tile.h"
 #include "tileset.h"
 
+#include <QTransform>
+#include <QtCore/qmath.h>
+
 #include <cmath>
 
 using namespace Tiled;
 
+/**
+ * The size of the cells of the spatial index grid, in pixels.
+ */
+static const qreal IndexCellSize = 256;
+
+/**
+ * Objects covering more grid cells than this are not put in the grid.
+ */
+static const int MaxIndexCellsPerObject = 64;
+
+static inline quint64 indexCellKey(int x, int y)
+{
+    return (quint64(quint32(x)) << 32) | quint32(y);
+}
+
+/**
+ * Returns whether the two rectangles overlap, including the case where they
+ * only touch or where either of them is empty.
+ */
+static inline bool overlaps(const QRectF &a, const QRectF &b)
+{
+    return a.left() <= b.right() && b.left() <= a.right() &&
+            a.top() <= b.bottom() && b.top() <= a.bottom();
+}
+
+/**
+ * Returns the smallest rectangle containing both \a a and \a b. Unlike
+ * QRectF::united(), empty rectangles are not ignored.
+ */
+static QRectF enclosingRect(const QRectF &a, const QRectF &b)
+{
+    QRectF r;
+    r.setLeft(qMin(a.left(), b.left()));
+    r.setTop(qMin(a.top(), b.top()));
+    r.setRight(qMax(a.right(), b.right()));
+    r.setBottom(qMax(a.bottom(), b.bottom()));
+    return r;
+}
+
+/**
+ * Returns a rectangle, in pixel coordinates, that encloses everything the
+ * given \a object may cover.
+ */
+static QRectF indexBounds(const MapObject *object)
+{
+    QRectF shapeRect(QPointF(), object->size());
+
+    if (!object->polygon().isEmpty())
+        shapeRect = enclosingRect(shapeRect, object->polygon().boundingRect());
+
+    if (const Tile *tile = object->cell().tile) {
+        const QPoint offset = tile->tileset()->tileOffset();
+        const QRectF tileRect(offset.x(), offset.y() - tile->height(),
+                              tile->width(), tile->height());
+        shapeRect = enclosingRect(shapeRect, tileRect);
+    }
+
+    if (object->rotation() != 0) {
+        QTransform transform;
+        transform.rotate(object->rotation());
+        shapeRect = transform.mapRect(shapeRect);
+    }
+
+    return enclosingRect(shapeRect.translated(object->position()),
+                         object->bounds());
+}
+
+namespace {
+
+/**
+ * Sorts objects by their index in the object group.
+ */
+struct ObjectOrderLessThan
+{
+    explicit ObjectOrderLessThan(const QHash<const MapObject*, int> &order)
+        : mOrder(order)
+    {}
+
+    bool operator()(const MapObject *a, const MapObject *b) const
+    { return mOrder.value(a) < mOrder.value(b); }
+
+    const QHash<const MapObject*, int> &mOrder;
+};
+
+} // anonymous namespace
+
 ObjectGroup::ObjectGroup()
     : Layer(ObjectGroupType, QString(), 0, 0, 0, 0)
     , mDrawOrder(TopDownOrder)
+    , mObjectOrderDirty(false)
 {
 }
 
@@ -49,6 +139,7 @@ ObjectGroup::ObjectGroup(const QString &name,
                          int x, int y, int width, int height)
     : Layer(ObjectGroupType, name, x, y, width, height)
     , mDrawOrder(TopDownOrder)
+    , mObjectOrderDirty(false)
 {
 }
 
@@ -61,12 +152,18 @@ void ObjectGroup::addObject(MapObject *object)
 {
     mObjects.append(object);
     object->setObjectGroup(this);
+    objectAdded(object);
+
+    if (!mObjectOrderDirty)
+        mObjectOrder.insert(object, mObjects.size() - 1);
 }
 
 void ObjectGroup::insertObject(int index, MapObject *object)
 {
     mObjects.insert(index, object);
     object->setObjectGroup(this);
+    objectAdded(object);
+    mObjectOrderDirty = true;
 }
 
 int ObjectGroup::removeObject(MapObject *object)
@@ -76,6 +173,7 @@ int ObjectGroup::removeObject(MapObject *object)
 
     mObjects.removeAt(index);
     object->setObjectGroup(0);
+    objectRemoved(object);
     return index;
 }
 
@@ -83,6 +181,7 @@ void ObjectGroup::removeObjectAt(int index)
 {
     MapObject *object = mObjects.takeAt(index);
     object->setObjectGroup(0);
+    objectRemoved(object);
 }
 
 void ObjectGroup::moveObjects(int from, int to, int count)
@@ -105,6 +204,8 @@ void ObjectGroup::moveObjects(int from, int to, int count)
 
     for (int i = 0; i < count; ++i)
         mObjects.insert(to + i, movingObjects.at(i));
+
+    mObjectOrderDirty = true;
 }
 
 QRectF ObjectGroup::objectsBoundingRect() const
@@ -115,6 +216,154 @@ QRectF ObjectGroup::objectsBoundingRect() const
     return boundingRect;
 }
 
+QList<MapObject*> ObjectGroup::objectsIntersecting(const QRectF &rect) const
+{
+    updateIndex();
+
+    const QRectF r = rect.normalized();
+    QList<MapObject*> result;
+
+    const int startX = qFloor(r.left() / IndexCellSize);
+    const int startY = qFloor(r.top() / IndexCellSize);
+    const int endX = qFloor(r.right() / IndexCellSize);
+    const int endY = qFloor(r.bottom() / IndexCellSize);
+    const qreal cellCount = qreal(endX - startX + 1) * (endY - startY + 1);
+
+    // For large areas it is cheaper to just check every object
+    if (cellCount >= mObjects.size()) {
+        foreach (MapObject *object, mObjects)
+            if (overlaps(mIndexedBounds.value(object), r))
+                result.append(object);
+        return result;
+    }
+
+    QSet<MapObject*> found;
+
+    for (int y = startY; y <= endY; ++y) {
+        for (int x = startX; x <= endX; ++x) {
+            QHash<quint64, QList<MapObject*> >::const_iterator it =
+                    mIndexCells.constFind(indexCellKey(x, y));
+            if (it == mIndexCells.constEnd())
+                continue;
+
+            foreach (MapObject *object, it.value())
+                if (!found.contains(object) &&
+                        overlaps(mIndexedBounds.value(object), r))
+                    found.insert(object);
+        }
+    }
+
+    foreach (MapObject *object, mLargeObjects)
+        if (overlaps(mIndexedBounds.value(object), r))
+            found.insert(object);
+
+    if (found.isEmpty())
+        return result;
+
+    if (mObjectOrderDirty) {
+        mObjectOrder.clear();
+        mObjectOrder.reserve(mObjects.size());
+        for (int i = 0; i < mObjects.size(); ++i)
+            mObjectOrder.insert(mObjects.at(i), i);
+        mObjectOrderDirty = false;
+    }
+
+    result = found.toList();
+    qSort(result.begin(), result.end(), ObjectOrderLessThan(mObjectOrder));
+    return result;
+}
+
+QList<MapObject*> ObjectGroup::objectsAt(const QPointF &pos) const
+{
+    return objectsIntersecting(QRectF(pos, QSizeF(0, 0)));
+}
+
+void ObjectGroup::markObjectBoundsDirty(MapObject *object)
+{
+    mDirtyObjects.insert(object);
+}
+
+/**
+ * Brings the spatial index up to date for the objects that were added or
+ * changed since it was last used.
+ */
+void ObjectGroup::updateIndex() const
+{
+    if (mDirtyObjects.isEmpty())
+        return;
+
+    foreach (MapObject *object, mDirtyObjects) {
+        unindexObject(object);
+        indexObject(object);
+    }
+
+    mDirtyObjects.clear();
+}
+
+void ObjectGroup::indexObject(MapObject *object) const
+{
+    const QRectF bounds = indexBounds(object);
+    mIndexedBounds.insert(object, bounds);
+
+    const int startX = qFloor(bounds.left() / IndexCellSize);
+    const int startY = qFloor(bounds.top() / IndexCellSize);
+    const int endX = qFloor(bounds.right() / IndexCellSize);
+    const int endY = qFloor(bounds.bottom() / IndexCellSize);
+
+    if (qreal(endX - startX + 1) * (endY - startY + 1) > MaxIndexCellsPerObject) {
+        mLargeObjects.insert(object);
+        return;
+    }
+
+    for (int y = startY; y <= endY; ++y)
+        for (int x = startX; x <= endX; ++x)
+            mIndexCells[indexCellKey(x, y)].append(object);
+}
+
+/**
+ * Removes the given \a object from the spatial index. This only relies on
+ * the bounds stored in the index, so the object may already have changed.
+ */
+void ObjectGroup::unindexObject(MapObject *object) const
+{
+    QHash<MapObject*, QRectF>::iterator it = mIndexedBounds.find(object);
+    if (it == mIndexedBounds.end())
+        return;
+
+    const QRectF bounds = it.value();
+    mIndexedBounds.erase(it);
+
+    if (mLargeObjects.remove(object))
+        return;
+
+    const int startX = qFloor(bounds.left() / IndexCellSize);
+    const int startY = qFloor(bounds.top() / IndexCellSize);
+    const int endX = qFloor(bounds.right() / IndexCellSize);
+    const int endY = qFloor(bounds.bottom() / IndexCellSize);
+
+    for (int y = startY; y <= endY; ++y) {
+        for (int x = startX; x <= endX; ++x) {
+            const quint64 key = indexCellKey(x, y);
+            QList<MapObject*> &objects = mIndexCells[key];
+            objects.removeOne(object);
+            if (objects.isEmpty())
+                mIndexCells.remove(key);
+        }
+    }
+}
+
+void ObjectGroup::objectAdded(MapObject *object)
+{
+    mDirtyObjects.insert(object);
+}
+
+void ObjectGroup::objectRemoved(MapObject *object)
+{
+    mDirtyObjects.remove(object);
+    unindexObject(object);
+    mObjectOrderDirty = true;
+}
+
 bool ObjectGroup::isEmpty() const
 {
     return mObjects.isEmpty();
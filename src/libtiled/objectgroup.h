@@ -36,8 +36,11 @@
 #include "layer.h"
 
 #include <QColor>
+#include <QHash>
 #include <QList>
 #include <QMetaType>
+#include <QRectF>
+#include <QSet>
 
 namespace Tiled {
 
@@ -134,6 +137,33 @@ public:
      */
     QRectF objectsBoundingRect() const;
 
+    /**
+     * Returns the objects that may intersect the given \a rect, in pixel
+     * coordinates. The objects are returned in the order in which they are
+     * stored in this group.
+     *
+     * The test is done against a rectangle that encloses the bounds of each
+     * object as well as its polygon, tile image and rotation. Callers that
+     * need an exact answer should further check the returned objects. Objects
+     * without size are included when they lie within or on the border of the
+     * rect.
+     */
+    QList<MapObject*> objectsIntersecting(const QRectF &rect) const;
+
+    /**
+     * Returns the objects that may cover the given \a pos, in pixel
+     * coordinates. The same considerations as for objectsIntersecting()
+     * apply.
+     */
+    QList<MapObject*> objectsAt(const QPointF &pos) const;
+
+    /**
+     * Marks the area covered by the given \a object as changed. This is
+     * called by MapObject when its position, size, polygon, tile or rotation
+     * changes.
+     */
+    void markObjectBoundsDirty(MapObject *object);
+
     /**
      * Returns whether this object group contains any objects.
      */
@@ -182,9 +212,28 @@ protected:
     ObjectGroup *initializeClone(ObjectGroup *clone) const;
 
 private:
+    void updateIndex() const;
+    void indexObject(MapObject *object) const;
+    void unindexObject(MapObject *object) const;
+    void objectAdded(MapObject *object);
+    void objectRemoved(MapObject *object);
+
     QList<MapObject*> mObjects;
     QColor mColor;
     DrawOrder mDrawOrder;
+
+    /**
+     * The spatial index is a uniform grid over pixel coordinates. Objects
+     * that would span too many grid cells are kept aside in mLargeObjects.
+     * It is updated lazily for the objects in mDirtyObjects.
+     */
+    mutable QHash<quint64, QList<MapObject*> > mIndexCells;
+    mutable QHash<MapObject*, QRectF> mIndexedBounds;
+    mutable QSet<MapObject*> mLargeObjects;
+    mutable QSet<MapObject*> mDirtyObjects;
+
+    mutable QHash<const MapObject*, int> mObjectOrder;
+    mutable bool mObjectOrderDirty;
 };
 
 
@@ -64,7 +64,7 @@ QRectF OrthogonalRenderer::boundingRect(const MapObject *object) const
     if (!object->cell().isEmpty()) {
         const QPointF bottomLeft = bounds.topLeft();
         const Tile *tile = object->cell().tile;
-        const QSize imgSize = tile->image().size();
+        const QSize imgSize = tile->size();
         const QPoint tileOffset = tile->tileset()->tileOffset();
         boundingRect = QRectF(bottomLeft.x() + tileOffset.x(),
                               bottomLeft.y() + tileOffset.y() - imgSize.height(),
@@ -308,7 +308,7 @@ void OrthogonalRenderer::drawMapObject(QPainter *painter,
                                      CellRenderer::BottomLeft);
 
         if (testFlag(ShowTileObjectOutlines)) {
-            const QRect rect = cell.tile->image().rect();
+            const QRect rect(QPoint(), cell.tile->size());
             QPen pen(Qt::SolidLine);
             pen.setCosmetic(true);
             painter->setPen(pen);
@@ -174,12 +174,22 @@ void StaggeredRenderer::drawTileLayer(QPainter *painter,
         if ((startTile.y() + layer->y()) % 2)
             rowPos.rx() += tileWidth / 2;
 
-        for (; rowPos.x() < rect.right() && rowTile.x() < layer->width(); rowTile.rx()++) {
+        while (rowPos.x() < rect.right() && rowTile.x() < layer->width()) {
+            if (!layer->isChunkAllocated(rowTile.x(), rowTile.y())) {
+                // Skip to the start of the next chunk
+                const int skip = TileLayer::ChunkSize -
+                        (rowTile.x() & TileLayer::ChunkMask);
+                rowTile.rx() += skip;
+                rowPos.rx() += skip * tileWidth;
+                continue;
+            }
+
             const Cell &cell = layer->cellAt(rowTile);
 
             if (!cell.isEmpty())
                 renderer.render(cell, rowPos, CellRenderer::BottomLeft);
 
+            rowTile.rx()++;
             rowPos.rx() += tileWidth;
         }
 
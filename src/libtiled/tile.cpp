@@ -31,6 +31,9 @@
 #include "objectgroup.h"
 #include "tileset.h"
 
+#include <QMutex>
+#include <QMutexLocker>
+
 using namespace Tiled;
 
 Tile::Tile(const QPixmap &image, int id, Tileset *tileset):
@@ -38,6 +41,8 @@ Tile::Tile(const QPixmap &image, int id, Tileset *tileset):
     mId(id),
     mTileset(tileset),
     mImage(image),
+    mImageRect(image.rect()),
+    mInTilesetImage(false),
     mTerrain(-1),
     mTerrainProbability(-1.f),
     mObjectGroup(0),
@@ -51,6 +56,8 @@ Tile::Tile(const QPixmap &image, const QString &imageSource,
     mId(id),
     mTileset(tileset),
     mImage(image),
+    mImageRect(image.rect()),
+    mInTilesetImage(false),
     mImageSource(imageSource),
     mTerrain(-1),
     mTerrainProbability(-1.f),
@@ -64,17 +71,66 @@ Tile::~Tile()
     delete mObjectGroup;
 }
 
+/**
+ * Guards the images that are copied out of the tileset image on demand, since
+ * tiles are also looked at by the threads that load and write maps.
+ */
+Q_GLOBAL_STATIC(QMutex, tileImageMutex)
+
+const QPixmap &Tile::image() const
+{
+    if (mInTilesetImage) {
+        QMutexLocker locker(tileImageMutex());
+        if (mImage.isNull())
+            mImage = mTileset->image().copy(mImageRect);
+    }
+
+    return mImage;
+}
+
+void Tile::setImage(const QPixmap &image)
+{
+    mImage = image;
+    mImageRect = image.rect();
+    mInTilesetImage = false;
+}
+
+const QPixmap &Tile::sourceImage() const
+{
+    return mInTilesetImage ? mTileset->image() : mImage;
+}
+
+/**
+ * Makes this tile refer to the given \a rect of the tileset image.
+ */
+void Tile::setTilesetImageRect(const QRect &rect)
+{
+    QMutexLocker locker(tileImageMutex());
+    mImage = QPixmap();
+    mImageRect = rect;
+    mInTilesetImage = true;
+}
+
 /**
  * Returns the image for rendering this tile, taking into account tile
  * animations.
  */
 const QPixmap &Tile::currentFrameImage() const
+{
+    return currentFrameTile()->image();
+}
+
+/**
+ * Returns the tile to render in place of this tile, taking into account tile
+ * animations.
+ */
+const Tile *Tile::currentFrameTile() const
 {
     if (isAnimated()) {
         const Frame &frame = mFrames.at(mCurrentFrameIndex);
-        return mTileset->tileAt(frame.tileId)->image();
+        return mTileset->tileAt(frame.tileId);
     } else {
-        return mImage;
+        return this;
     }
 }
 
@@ -131,6 +187,7 @@ void Tile::setFrames(const QVector<Frame> &frames)
     mFrames = frames;
     mCurrentFrameIndex = 0;
     mUnusedTime = 0;
+    mTileset->markAnimatedTilesDirty();
 }
 
 /**
@@ -80,15 +80,34 @@ public:
 
     /**
      * Returns the image of this tile.
+     *
+     * When this tile is part of a tileset image, its image is copied out of
+     * the tileset image the first time it is requested. For drawing, prefer
+     * using sourceImage() and imageRect() instead. The copy is made while
+     * holding a lock, so this function may be called from multiple threads.
      */
-    const QPixmap &image() const { return mImage; }
+    const QPixmap &image() const;
 
     const QPixmap &currentFrameImage() const;
 
+    const Tile *currentFrameTile() const;
+
+    /**
+     * Sets the image of this tile. The tile no longer refers to the tileset
+     * image after this.
+     */
+    void setImage(const QPixmap &image);
+
     /**
-     * Sets the image of this tile.
+     * Returns the image that contains this tile. This is the tileset image
+     * when the tile is part of it, or the image of this tile otherwise.
      */
-    void setImage(const QPixmap &image) { mImage = image; }
+    const QPixmap &sourceImage() const;
+
+    /**
+     * Returns the part of sourceImage() that makes up this tile.
+     */
+    const QRect &imageRect() const { return mImageRect; }
 
     /**
      * Returns the file name of the external image that represents this tile.
@@ -103,17 +122,17 @@ public:
     /**
      * Returns the width of this tile.
      */
-    int width() const { return mImage.width(); }
+    int width() const { return mImageRect.width(); }
 
     /**
      * Returns the height of this tile.
      */
-    int height() const { return mImage.height(); }
+    int height() const { return mImageRect.height(); }
 
     /**
      * Returns the size of this tile.
      */
-    QSize size() const { return mImage.size(); }
+    QSize size() const { return mImageRect.size(); }
 
     /**
      * Returns the Terrain of a given corner.
@@ -162,9 +181,13 @@ public:
     bool advanceAnimation(int ms);
 
 private:
+    void setTilesetImageRect(const QRect &rect);
+
     int mId;
     Tileset *mTileset;
-    QPixmap mImage;
+    mutable QPixmap mImage;
+    QRect mImageRect;
+    bool mInTilesetImage;
     QString mImageSource;
     unsigned mTerrain;
     float mTerrainProbability;
@@ -174,7 +197,7 @@ private:
     int mCurrentFrameIndex;
     int mUnusedTime;
 
-    friend class Tileset; // To allow changing the tile id
+    friend class Tileset; // To allow changing the tile id and image rect
 };
 
 /**
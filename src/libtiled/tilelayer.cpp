@@ -33,15 +33,26 @@
 #include "tile.h"
 #include "tileset.h"
 
+#include <QMutex>
+#include <QMutexLocker>
+
 using namespace Tiled;
 
 TileLayer::TileLayer(const QString &name, int x, int y, int width, int height):
     Layer(TileLayerType, name, x, y, width, height),
     mMaxTileSize(0, 0),
-    mGrid(width * height)
+    mTiles(1),
+    mCellLoader(0)
 {
     Q_ASSERT(width >= 0);
     Q_ASSERT(height >= 0);
+
+    resetChunks(width, height);
+}
+
+TileLayer::~TileLayer()
+{
+    delete mCellLoader.fetchAndStoreOrdered(0);
 }
 
 static QSize maxSize(const QSize &a,
@@ -60,6 +71,229 @@ static QMargins maxMargins(const QMargins &a,
                     qMax(a.bottom(), b.bottom()));
 }
 
+typedef QVector<QVector<quint32> > Chunks;
+
+static inline int chunkCount(int size)
+{
+    return (size + TileLayer::ChunkMask) >> TileLayer::ChunkBits;
+}
+
+static inline int indexInChunk(int x, int y)
+{
+    return (x & TileLayer::ChunkMask) +
+            ((y & TileLayer::ChunkMask) << TileLayer::ChunkBits);
+}
+
+static inline quint32 packedAt(const Chunks &chunks, int columns, int x, int y)
+{
+    const QVector<quint32> &cells = chunks.at((x >> TileLayer::ChunkBits) +
+                                              (y >> TileLayer::ChunkBits) * columns);
+    return cells.isEmpty() ? 0 : cells.at(indexInChunk(x, y));
+}
+
+/**
+ * Returns a writable reference to the packed cell at the given coordinates,
+ * allocating the chunk containing it when necessary.
+ */
+static quint32 &writableCell(Chunks &chunks, int columns, int x, int y)
+{
+    QVector<quint32> &cells = chunks[(x >> TileLayer::ChunkBits) +
+                                     (y >> TileLayer::ChunkBits) * columns];
+    if (cells.isEmpty())
+        cells.fill(0, TileLayer::ChunkSize * TileLayer::ChunkSize);
+    return cells[indexInChunk(x, y)];
+}
+
+static bool isEmptyChunk(const QVector<quint32> &cells)
+{
+    for (int i = 0, i_end = cells.size(); i < i_end; ++i)
+        if (cells.at(i) != 0)
+            return false;
+
+    return true;
+}
+
+/**
+ * Drops the storage of the chunks within \a rect (in chunk coordinates) that
+ * no longer contain any tiles.
+ */
+static void releaseEmptyChunks(Chunks &chunks, int columns, const QRect &rect)
+{
+    for (int chunkY = rect.top(); chunkY <= rect.bottom(); ++chunkY) {
+        for (int chunkX = rect.left(); chunkX <= rect.right(); ++chunkX) {
+            const int index = chunkX + chunkY * columns;
+            const QVector<quint32> &cells = chunks.at(index);
+            if (!cells.isEmpty() && isEmptyChunk(cells))
+                chunks[index].clear();
+        }
+    }
+}
+
+/**
+ * Returns the given area in cell coordinates as an area in chunk coordinates.
+ */
+static QRect chunkArea(const QRect &rect)
+{
+    return QRect(QPoint(rect.left() >> TileLayer::ChunkBits,
+                        rect.top() >> TileLayer::ChunkBits),
+                 QPoint(rect.right() >> TileLayer::ChunkBits,
+                        rect.bottom() >> TileLayer::ChunkBits));
+}
+
+void TileLayer::resetChunks(int width, int height)
+{
+    mChunkColumns = chunkCount(width);
+    mChunkRows = chunkCount(height);
+    mChunks = Chunks(mChunkColumns * mChunkRows);
+}
+
+bool TileLayer::chunkRowAllocated(int chunkY) const
+{
+    for (int chunkX = 0; chunkX < mChunkColumns; ++chunkX)
+        if (!chunk(chunkX, chunkY).isEmpty())
+            return true;
+
+    return false;
+}
+
+void TileLayer::setCellLoader(TileLayerCellLoader *loader)
+{
+    delete mCellLoader.fetchAndStoreOrdered(0);
+
+    resetChunks(mWidth, mHeight);
+    mTiles = QVector<TileEntry>(1);
+    mTileIndices.clear();
+    mMaxTileSize = QSize(0, 0);
+    mOffsetMargins = QMargins();
+
+    // Assume any tile may be used, in any orientation
+    foreach (Tileset *tileset, loader->tilesets()) {
+        foreach (Tile *tile, tileset->tiles()) {
+            Cell cell(tile);
+            updateMaxTileSize(cell);
+            cell.flippedAntiDiagonally = true;
+            updateMaxTileSize(cell);
+        }
+    }
+
+    mCellLoader.fetchAndStoreOrdered(loader);
+
+    if (mMap)
+        mMap->adjustDrawMargins(drawMargins());
+}
+
+// Recursive, since loading the cells of one layer may involve another layer
+Q_GLOBAL_STATIC_WITH_ARGS(QMutex, cellLoaderMutex, (QMutex::Recursive))
+
+void TileLayer::runCellLoader() const
+{
+    QMutexLocker locker(cellLoaderMutex());
+
+    // The cells may have been loaded by another thread in the meantime
+#if QT_VERSION >= 0x050000
+    TileLayerCellLoader *loader = mCellLoader.load();
+#else
+    TileLayerCellLoader *loader = mCellLoader;
+#endif
+    if (!loader)
+        return;
+
+    TileLayer loaded(QString(), 0, 0, mWidth, mHeight);
+    loader->loadCells(&loaded);
+
+    // The estimated draw margins are kept, since the map may rely on them
+    TileLayer *self = const_cast<TileLayer*>(this);
+    self->mChunks = loaded.mChunks;
+    self->mTiles = loaded.mTiles;
+    self->mTileIndices = loaded.mTileIndices;
+
+    // Only mark the cells as loaded once they are all in place
+    self->mCellLoader.fetchAndStoreOrdered(0);
+    delete loader;
+}
+
+/**
+ * Returns the packed representation of the given \a cell, adding its tile
+ * to the tile table of this layer when necessary.
+ */
+quint32 TileLayer::pack(const Cell &cell)
+{
+    quint32 value = 0;
+
+    if (cell.tile) {
+        QHash<Tile*, quint32>::const_iterator it =
+                mTileIndices.constFind(cell.tile);
+
+        Tileset *tileset = cell.tile->tileset();
+        const int id = cell.tile->id();
+
+        if (it != mTileIndices.constEnd()) {
+            value = it.value();
+
+            // The entry may have been left behind by a deleted tile that
+            // happened to live at the same address
+            const TileEntry &entry = mTiles.at(value);
+            if (entry.tileset != tileset || entry.id != id)
+                mTiles[value] = TileEntry(cell.tile, tileset, id);
+        } else {
+            value = mTiles.size();
+            Q_ASSERT(value <= TileIndexMask);
+            mTiles.append(TileEntry(cell.tile, tileset, id));
+            mTileIndices.insert(cell.tile, value);
+        }
+    }
+
+    if (cell.flippedHorizontally)
+        value |= FlippedHorizontallyFlag;
+    if (cell.flippedVertically)
+        value |= FlippedVerticallyFlag;
+    if (cell.flippedAntiDiagonally)
+        value |= FlippedAntiDiagonallyFlag;
+
+    return value;
+}
+
+/**
+ * Returns for each entry in the tile table whether it refers to a tile from
+ * the given \a tileset. Returns an empty vector when there are no such tiles.
+ *
+ * The tiles themselves are not accessed, since entries that are no longer
+ * used by any cell may refer to deleted tiles.
+ */
+QVector<bool> TileLayer::tilesFromTileset(const Tileset *tileset) const
+{
+    const QVector<TileEntry> &tiles = mTiles;
+    QVector<bool> matches;
+
+    for (int i = 1, i_end = tiles.size(); i < i_end; ++i) {
+        const TileEntry &entry = tiles.at(i);
+        if (entry.tile && entry.tileset == tileset) {
+            if (matches.isEmpty())
+                matches.fill(false, tiles.size());
+            matches[i] = true;
+        }
+    }
+
+    return matches;
+}
+
+void TileLayer::updateMaxTileSize(const Cell &cell)
+{
+    QSize size = cell.tile->size();
+
+    if (cell.flippedAntiDiagonally)
+        size.transpose();
+
+    const QPoint offset = cell.tile->tileset()->tileOffset();
+
+    mMaxTileSize = maxSize(size, mMaxTileSize);
+    mOffsetMargins = maxMargins(QMargins(-offset.x(),
+                                         -offset.y(),
+                                         offset.x(),
+                                         offset.y()),
+                                mOffsetMargins);
+}
+
 /**
  * Recomputes the draw margins. Needed after the tile offset of a tileset
  * has changed for example.
@@ -68,63 +302,120 @@ static QMargins maxMargins(const QMargins &a,
  */
 void TileLayer::recomputeDrawMargins()
 {
-    QSize maxTileSize(0, 0);
-    QMargins offsetMargins;
+    loadCells();
+
+    mMaxTileSize = QSize(0, 0);
+    mOffsetMargins = QMargins();
 
-    for (int i = 0, i_end = mGrid.size(); i < i_end; ++i) {
-        const Cell &cell = mGrid.at(i);
-        if (const Tile *tile = cell.tile) {
-            QSize size = tile->size();
+    // Each tile only needs to be looked at once, plus once more when it is
+    // also used flipped anti-diagonally
+    const quint32 mask = TileIndexMask | FlippedAntiDiagonallyFlag;
+    QSet<quint32> seen;
 
-            if (cell.flippedAntiDiagonally)
-                size.transpose();
+    for (int i = 0, i_end = mChunks.size(); i < i_end; ++i) {
+        const QVector<quint32> &cells = mChunks.at(i);
+        for (int j = 0, j_end = cells.size(); j < j_end; ++j) {
+            const quint32 value = cells.at(j) & mask;
+            if ((value & TileIndexMask) == 0 || seen.contains(value))
+                continue;
 
-            const QPoint offset = tile->tileset()->tileOffset();
+            seen.insert(value);
 
-            maxTileSize = maxSize(size, maxTileSize);
-            offsetMargins = maxMargins(QMargins(-offset.x(),
-                                                 -offset.y(),
-                                                 offset.x(),
-                                                 offset.y()),
-                                        offsetMargins);
+            const Cell cell = unpack(value);
+            if (cell.tile)
+                updateMaxTileSize(cell);
         }
     }
 
-    mMaxTileSize = maxTileSize;
-    mOffsetMargins = offsetMargins;
-
     if (mMap)
         mMap->adjustDrawMargins(drawMargins());
 }
 
+QRegion TileLayer::region() const
+{
+    loadCells();
+
+    QRegion region;
+
+    for (int chunkY = 0; chunkY < mChunkRows; ++chunkY) {
+        if (!chunkRowAllocated(chunkY))
+            continue;
+
+        const int startY = chunkY << ChunkBits;
+        const int endY = qMin(startY + ChunkSize, mHeight);
+
+        for (int y = startY; y < endY; ++y) {
+            int rangeStart = -1;
+
+            for (int chunkX = 0; chunkX < mChunkColumns; ++chunkX) {
+                const QVector<quint32> &cells = chunk(chunkX, chunkY);
+                const int startX = chunkX << ChunkBits;
+                const int endX = qMin(startX + ChunkSize, mWidth);
+
+                if (cells.isEmpty()) {
+                    if (rangeStart != -1) {
+                        region += QRect(rangeStart + mX, y + mY,
+                                        startX - rangeStart, 1);
+                        rangeStart = -1;
+                    }
+                    continue;
+                }
+
+                const quint32 *row = cells.constData() +
+                        ((y & ChunkMask) << ChunkBits);
+
+                for (int x = startX; x < endX; ++x) {
+                    if (mTiles.at(row[x - startX] & TileIndexMask).tile) {
+                        if (rangeStart == -1)
+                            rangeStart = x;
+                    } else if (rangeStart != -1) {
+                        region += QRect(rangeStart + mX, y + mY,
+                                        x - rangeStart, 1);
+                        rangeStart = -1;
+                    }
+                }
+            }
+
+            if (rangeStart != -1)
+                region += QRect(rangeStart + mX, y + mY,
+                                mWidth - rangeStart, 1);
+        }
+    }
+
+    return region;
+}
+
 void TileLayer::setCell(int x, int y, const Cell &cell)
 {
     Q_ASSERT(contains(x, y));
 
-    if (cell.tile) {
-        QSize size = cell.tile->size();
+    loadCells();
 
-        if (cell.flippedAntiDiagonally)
-            size.transpose();
+    QVector<quint32> &cells = mChunks[(x >> ChunkBits) +
+                                      (y >> ChunkBits) * mChunkColumns];
 
-        const QPoint offset = cell.tile->tileset()->tileOffset();
+    if (cells.isEmpty()) {
+        // No need to allocate a chunk to store an empty cell
+        if (cell == Cell())
+            return;
 
-        mMaxTileSize = maxSize(size, mMaxTileSize);
-        mOffsetMargins = maxMargins(QMargins(-offset.x(),
-                                             -offset.y(),
-                                             offset.x(),
-                                             offset.y()),
-                                    mOffsetMargins);
+        cells.fill(0, ChunkSize * ChunkSize);
+    }
+
+    if (cell.tile) {
+        updateMaxTileSize(cell);
 
         if (mMap)
             mMap->adjustDrawMargins(drawMargins());
     }
 
-    mGrid[x + y * mWidth] = cell;
+    cells[indexInChunk(x, y)] = pack(cell);
 }
 
 TileLayer *TileLayer::copy(const QRegion &region) const
 {
+    loadCells();
+
     const QRegion area = region.intersected(QRect(0, 0, width(), height()));
     const QRect bounds = region.boundingRect();
     const QRect areaBounds = area.boundingRect();
@@ -135,28 +426,65 @@ TileLayer *TileLayer::copy(const QRegion &region) const
                                       0, 0,
                                       bounds.width(), bounds.height());
 
-    foreach (const QRect &rect, area.rects())
-        for (int x = rect.left(); x <= rect.right(); ++x)
-            for (int y = rect.top(); y <= rect.bottom(); ++y)
-                copied->setCell(x - areaBounds.x() + offsetX,
-                                y - areaBounds.y() + offsetY,
-                                cellAt(x, y));
+    // Sharing the tile table allows copying the packed cells as-is
+    copied->mTiles = mTiles;
+    copied->mTileIndices = mTileIndices;
+
+    foreach (const QRect &rect, area.rects()) {
+        const QRect chunks = chunkArea(rect);
+
+        for (int chunkY = chunks.top(); chunkY <= chunks.bottom(); ++chunkY) {
+            for (int chunkX = chunks.left(); chunkX <= chunks.right(); ++chunkX) {
+                const QVector<quint32> &cells = chunk(chunkX, chunkY);
+                if (cells.isEmpty())
+                    continue;
+
+                const QRect r = rect & chunkRect(chunkX, chunkY);
+
+                for (int y = r.top(); y <= r.bottom(); ++y) {
+                    for (int x = r.left(); x <= r.right(); ++x) {
+                        const quint32 value = cells.at(indexInChunk(x, y));
+                        if (value != 0)
+                            writableCell(copied->mChunks, copied->mChunkColumns,
+                                         x - areaBounds.x() + offsetX,
+                                         y - areaBounds.y() + offsetY) = value;
+                    }
+                }
+            }
+        }
+    }
 
+    copied->recomputeDrawMargins();
     return copied;
 }
 
 void TileLayer::merge(const QPoint &pos, const TileLayer *layer)
 {
+    layer->loadCells();
+
     // Determine the overlapping area
     QRect area = QRect(pos, QSize(layer->width(), layer->height()));
     area &= QRect(0, 0, width(), height());
 
-    for (int y = area.top(); y <= area.bottom(); ++y) {
-        for (int x = area.left(); x <= area.right(); ++x) {
-            const Cell &cell = layer->cellAt(x - area.left(),
-                                             y - area.top());
-            if (!cell.isEmpty())
-                setCell(x, y, cell);
+    // Only the allocated chunks of the merged layer can have an effect
+    for (int chunkY = 0; chunkY < layer->mChunkRows; ++chunkY) {
+        for (int chunkX = 0; chunkX < layer->mChunkColumns; ++chunkX) {
+            const QVector<quint32> &cells = layer->chunk(chunkX, chunkY);
+            if (cells.isEmpty())
+                continue;
+
+            const QRect r = layer->chunkRect(chunkX, chunkY).translated(pos)
+                    & area;
+
+            for (int y = r.top(); y <= r.bottom(); ++y) {
+                for (int x = r.left(); x <= r.right(); ++x) {
+                    const Cell cell = layer->unpack(
+                                cells.at(indexInChunk(x - pos.x(),
+                                                      y - pos.y())));
+                    if (!cell.isEmpty())
+                        setCell(x, y, cell);
+                }
+            }
         }
     }
 }
@@ -179,35 +507,65 @@ void TileLayer::setCells(int x, int y, TileLayer *layer,
 
 void TileLayer::erase(const QRegion &area)
 {
-    const Cell emptyCell;
-    foreach (const QRect &rect, area.rects())
-        for (int x = rect.left(); x <= rect.right(); ++x)
-            for (int y = rect.top(); y <= rect.bottom(); ++y)
-                setCell(x, y, emptyCell);
+    loadCells();
+
+    const QRegion clipped = area & QRect(0, 0, mWidth, mHeight);
+
+    foreach (const QRect &rect, clipped.rects()) {
+        const QRect chunks = chunkArea(rect);
+
+        for (int chunkY = chunks.top(); chunkY <= chunks.bottom(); ++chunkY) {
+            for (int chunkX = chunks.left(); chunkX <= chunks.right(); ++chunkX) {
+                if (chunk(chunkX, chunkY).isEmpty())
+                    continue;
+
+                QVector<quint32> &cells = mChunks[chunkX + chunkY * mChunkColumns];
+                const QRect r = rect & chunkRect(chunkX, chunkY);
+
+                for (int y = r.top(); y <= r.bottom(); ++y)
+                    for (int x = r.left(); x <= r.right(); ++x)
+                        cells[indexInChunk(x, y)] = 0;
+            }
+        }
+    }
+
+    if (!clipped.isEmpty())
+        releaseEmptyChunks(mChunks, mChunkColumns,
+                           chunkArea(clipped.boundingRect()));
 }
 
 void TileLayer::flip(FlipDirection direction)
 {
-    QVector<Cell> newGrid(mWidth * mHeight);
-
     Q_ASSERT(direction == FlipHorizontally || direction == FlipVertically);
 
-    for (int y = 0; y < mHeight; ++y) {
-        for (int x = 0; x < mWidth; ++x) {
-            Cell &dest = newGrid[x + y * mWidth];
-            if (direction == FlipHorizontally) {
-                const Cell &source = cellAt(mWidth - x - 1, y);
-                dest = source;
-                dest.flippedHorizontally = !source.flippedHorizontally;
-            } else if (direction == FlipVertically) {
-                const Cell &source = cellAt(x, mHeight - y - 1);
-                dest = source;
-                dest.flippedVertically = !source.flippedVertically;
+    loadCells();
+
+    const Chunks oldChunks = mChunks;
+    resetChunks(mWidth, mHeight);
+
+    for (int i = 0, i_end = oldChunks.size(); i < i_end; ++i) {
+        const QVector<quint32> &cells = oldChunks.at(i);
+        if (cells.isEmpty())
+            continue;
+
+        const QRect r = chunkRect(i % mChunkColumns, i / mChunkColumns);
+
+        for (int y = r.top(); y <= r.bottom(); ++y) {
+            for (int x = r.left(); x <= r.right(); ++x) {
+                const quint32 source = cells.at(indexInChunk(x, y));
+                if (source == 0)
+                    continue;
+
+                if (direction == FlipHorizontally) {
+                    writableCell(mChunks, mChunkColumns, mWidth - x - 1, y) =
+                            source ^ FlippedHorizontallyFlag;
+                } else if (direction == FlipVertically) {
+                    writableCell(mChunks, mChunkColumns, x, mHeight - y - 1) =
+                            source ^ FlippedVerticallyFlag;
+                }
             }
         }
     }
-
-    mGrid = newGrid;
 }
 
 void TileLayer::rotate(RotateDirection direction)
@@ -218,30 +576,46 @@ void TileLayer::rotate(RotateDirection direction)
     const char (&rotateMask)[8] =
             (direction == RotateRight) ? rotateRightMask : rotateLeftMask;
 
-    int newWidth = mHeight;
-    int newHeight = mWidth;
-    QVector<Cell> newGrid(newWidth * newHeight);
-
-    for (int y = 0; y < mHeight; ++y) {
-        for (int x = 0; x < mWidth; ++x) {
-            const Cell &source = cellAt(x, y);
-            Cell dest = source;
-
-            unsigned char mask =
-                    (dest.flippedHorizontally << 2) |
-                    (dest.flippedVertically << 1) |
-                    (dest.flippedAntiDiagonally << 0);
+    loadCells();
 
-            mask = rotateMask[mask];
+    const int oldWidth = mWidth;
+    const int oldHeight = mHeight;
+    const int oldColumns = mChunkColumns;
+    const Chunks oldChunks = mChunks;
 
-            dest.flippedHorizontally = (mask & 4) != 0;
-            dest.flippedVertically = (mask & 2) != 0;
-            dest.flippedAntiDiagonally = (mask & 1) != 0;
-
-            if (direction == RotateRight)
-                newGrid[x * newWidth + (mHeight - y - 1)] = dest;
-            else
-                newGrid[(mWidth - x - 1) * newWidth + y] = dest;
+    int newWidth = mHeight;
+    int newHeight = mWidth;
+    resetChunks(newWidth, newHeight);
+
+    for (int i = 0, i_end = oldChunks.size(); i < i_end; ++i) {
+        const QVector<quint32> &cells = oldChunks.at(i);
+        if (cells.isEmpty())
+            continue;
+
+        const QRect r = QRect((i % oldColumns) << ChunkBits,
+                              (i / oldColumns) << ChunkBits,
+                              ChunkSize, ChunkSize)
+                & QRect(0, 0, oldWidth, oldHeight);
+
+        for (int y = r.top(); y <= r.bottom(); ++y) {
+            for (int x = r.left(); x <= r.right(); ++x) {
+                const quint32 source = cells.at(indexInChunk(x, y));
+                if (source == 0)
+                    continue;
+
+                // The flags are stored in the top three bits, in the same
+                // order as used by the rotation masks
+                const unsigned char mask = rotateMask[source >> 29];
+                const quint32 dest = (source & TileIndexMask) |
+                        (quint32(mask) << 29);
+
+                if (direction == RotateRight)
+                    writableCell(mChunks, mChunkColumns,
+                                 oldHeight - y - 1, x) = dest;
+                else
+                    writableCell(mChunks, mChunkColumns,
+                                 y, oldWidth - x - 1) = dest;
+            }
         }
     }
 
@@ -250,47 +624,95 @@ void TileLayer::rotate(RotateDirection direction)
 
     mWidth = newWidth;
     mHeight = newHeight;
-    mGrid = newGrid;
 }
 
 
 QSet<Tileset*> TileLayer::usedTilesets() const
 {
+    loadCells();
+
     QSet<Tileset*> tilesets;
+    QVector<bool> used(mTiles.size(), false);
+
+    for (int i = 0, i_end = mChunks.size(); i < i_end; ++i) {
+        const QVector<quint32> &cells = mChunks.at(i);
+        for (int j = 0, j_end = cells.size(); j < j_end; ++j)
+            used[cells.at(j) & TileIndexMask] = true;
+    }
 
-    for (int i = 0, i_end = mGrid.size(); i < i_end; ++i)
-        if (const Tile *tile = mGrid.at(i).tile)
-            tilesets.insert(tile->tileset());
+    for (int i = 1, i_end = mTiles.size(); i < i_end; ++i)
+        if (used.at(i) && mTiles.at(i).tile)
+            tilesets.insert(mTiles.at(i).tileset);
 
     return tilesets;
 }
 
 bool TileLayer::referencesTileset(const Tileset *tileset) const
 {
-    for (int i = 0, i_end = mGrid.size(); i < i_end; ++i) {
-        const Tile *tile = mGrid.at(i).tile;
-        if (tile && tile->tileset() == tileset)
-            return true;
+    loadCells();
+
+    const QVector<bool> matches = tilesFromTileset(tileset);
+    if (matches.isEmpty())
+        return false;
+
+    for (int i = 0, i_end = mChunks.size(); i < i_end; ++i) {
+        const QVector<quint32> &cells = mChunks.at(i);
+        for (int j = 0, j_end = cells.size(); j < j_end; ++j)
+            if (matches.at(cells.at(j) & TileIndexMask))
+                return true;
     }
     return false;
 }
 
 void TileLayer::removeReferencesToTileset(Tileset *tileset)
 {
-    for (int i = 0, i_end = mGrid.size(); i < i_end; ++i) {
-        const Tile *tile = mGrid.at(i).tile;
-        if (tile && tile->tileset() == tileset)
-            mGrid.replace(i, Cell());
+    loadCells();
+
+    const QVector<bool> matches = tilesFromTileset(tileset);
+    if (matches.isEmpty())
+        return;
+
+    for (int i = 0, i_end = mChunks.size(); i < i_end; ++i) {
+        if (mChunks.at(i).isEmpty())
+            continue;
+
+        QVector<quint32> &cells = mChunks[i];
+        for (int j = 0, j_end = cells.size(); j < j_end; ++j)
+            if (matches.at(cells.at(j) & TileIndexMask))
+                cells[j] = 0;
+
+        if (isEmptyChunk(cells))
+            cells.clear();
+    }
+
+    for (int i = 1, i_end = mTiles.size(); i < i_end; ++i) {
+        if (matches.at(i)) {
+            mTileIndices.remove(mTiles.at(i).tile);
+            mTiles[i] = TileEntry();
+        }
     }
 }
 
 void TileLayer::replaceReferencesToTileset(Tileset *oldTileset,
                                            Tileset *newTileset)
 {
-    for (int i = 0, i_end = mGrid.size(); i < i_end; ++i) {
-        const Tile *tile = mGrid.at(i).tile;
-        if (tile && tile->tileset() == oldTileset)
-            mGrid[i].tile = newTileset->tileAt(tile->id());
+    loadCells();
+
+    // Only the tile table needs to be updated
+    for (int i = 1, i_end = mTiles.size(); i < i_end; ++i) {
+        const TileEntry entry = mTiles.at(i);
+        if (entry.tile && entry.tileset == oldTileset) {
+            Tile *newTile = newTileset->tileAt(entry.id);
+
+            mTileIndices.remove(entry.tile);
+            if (newTile && !mTileIndices.contains(newTile))
+                mTileIndices.insert(newTile, i);
+
+            if (newTile)
+                mTiles[i] = TileEntry(newTile, newTileset, entry.id);
+            else
+                mTiles[i] = TileEntry();
+        }
     }
 }
 
@@ -299,22 +721,38 @@ void TileLayer::resize(const QSize &size, const QPoint &offset)
     if (this->size() == size && offset.isNull())
         return;
 
-    QVector<Cell> newGrid(size.width() * size.height());
+    loadCells();
+
+    const int oldWidth = mWidth;
+    const int oldHeight = mHeight;
+    const int oldColumns = mChunkColumns;
+    const Chunks oldChunks = mChunks;
+
+    resetChunks(size.width(), size.height());
 
     // Copy over the preserved part
-    const int startX = qMax(0, -offset.x());
-    const int startY = qMax(0, -offset.y());
-    const int endX = qMin(mWidth, size.width() - offset.x());
-    const int endY = qMin(mHeight, size.height() - offset.y());
-
-    for (int y = startY; y < endY; ++y) {
-        for (int x = startX; x < endX; ++x) {
-            const int index = x + offset.x() + (y + offset.y()) * size.width();
-            newGrid[index] = cellAt(x, y);
+    const QRect preserved = QRect(0, 0, oldWidth, oldHeight) &
+            QRect(-offset.x(), -offset.y(), size.width(), size.height());
+
+    for (int i = 0, i_end = oldChunks.size(); i < i_end; ++i) {
+        const QVector<quint32> &cells = oldChunks.at(i);
+        if (cells.isEmpty())
+            continue;
+
+        const QRect r = QRect((i % oldColumns) << ChunkBits,
+                              (i / oldColumns) << ChunkBits,
+                              ChunkSize, ChunkSize) & preserved;
+
+        for (int y = r.top(); y <= r.bottom(); ++y) {
+            for (int x = r.left(); x <= r.right(); ++x) {
+                const quint32 value = cells.at(indexInChunk(x, y));
+                if (value != 0)
+                    writableCell(mChunks, mChunkColumns,
+                                 x + offset.x(), y + offset.y()) = value;
+            }
         }
     }
 
-    mGrid = newGrid;
     setSize(size);
 }
 
@@ -322,13 +760,18 @@ void TileLayer::offset(const QPoint &offset,
                        const QRect &bounds,
                        bool wrapX, bool wrapY)
 {
-    QVector<Cell> newGrid(mWidth * mHeight);
+    loadCells();
+
+    const Chunks oldChunks = mChunks;
+    resetChunks(mWidth, mHeight);
 
     for (int y = 0; y < mHeight; ++y) {
         for (int x = 0; x < mWidth; ++x) {
             // Skip out of bounds tiles
             if (!bounds.contains(x, y)) {
-                newGrid[x + y * mWidth] = cellAt(x, y);
+                const quint32 value = packedAt(oldChunks, mChunkColumns, x, y);
+                if (value != 0)
+                    writableCell(mChunks, mChunkColumns, x, y) = value;
                 continue;
             }
 
@@ -353,14 +796,14 @@ void TileLayer::offset(const QPoint &offset,
             }
 
             // Set the new tile
-            if (contains(oldX, oldY) && bounds.contains(oldX, oldY))
-                newGrid[x + y * mWidth] = cellAt(oldX, oldY);
-            else
-                newGrid[x + y * mWidth] = Cell();
+            if (contains(oldX, oldY) && bounds.contains(oldX, oldY)) {
+                const quint32 value = packedAt(oldChunks, mChunkColumns,
+                                               oldX, oldY);
+                if (value != 0)
+                    writableCell(mChunks, mChunkColumns, x, y) = value;
+            }
         }
     }
-
-    mGrid = newGrid;
 }
 
 bool TileLayer::canMergeWith(Layer *other) const
@@ -384,6 +827,9 @@ Layer *TileLayer::mergedWith(Layer *other) const
 
 QRegion TileLayer::computeDiffRegion(const TileLayer *other) const
 {
+    loadCells();
+    other->loadCells();
+
     QRegion ret;
 
     const int dx = other->x() - mX;
@@ -391,18 +837,56 @@ QRegion TileLayer::computeDiffRegion(const TileLayer *other) const
     QRect r = QRect(0, 0, width(), height());
     r &= QRect(dx, dy, other->width(), other->height());
 
+    // When both layers share their tile table, equal packed values are known
+    // to represent equal cells
+    const bool sameTable = mTiles.constData() == other->mTiles.constData();
+
     for (int y = r.top(); y <= r.bottom(); ++y) {
-        for (int x = r.left(); x <= r.right(); ++x) {
-            if (cellAt(x, y) != other->cellAt(x - dx, y - dy)) {
-                const int rangeStart = x;
-                while (x <= r.right() &&
-                       cellAt(x, y) != other->cellAt(x - dx, y - dy)) {
-                    ++x;
+        const int chunkY = y >> ChunkBits;
+        const int otherChunkY = (y - dy) >> ChunkBits;
+        int rangeStart = -1;
+
+        for (int x = r.left(); x <= r.right();) {
+            // Determine the run of cells that lies within a single chunk of
+            // both layers, so that runs of unallocated chunks can be skipped
+            const int runEnd = qMin(qMin((x | ChunkMask) + 1,
+                                         ((x - dx) | ChunkMask) + 1 + dx),
+                                    r.right() + 1);
+
+            const QVector<quint32> &cells = chunk(x >> ChunkBits, chunkY);
+            const QVector<quint32> &otherCells =
+                    other->chunk((x - dx) >> ChunkBits, otherChunkY);
+
+            if (cells.isEmpty() && otherCells.isEmpty()) {
+                if (rangeStart != -1) {
+                    ret += QRect(rangeStart, y, x - rangeStart, 1);
+                    rangeStart = -1;
+                }
+                x = runEnd;
+                continue;
+            }
+
+            for (; x < runEnd; ++x) {
+                const quint32 a = cells.isEmpty() ?
+                            0 : cells.at(indexInChunk(x, y));
+                const quint32 b = otherCells.isEmpty() ?
+                            0 : otherCells.at(indexInChunk(x - dx, y - dy));
+
+                const bool different = (sameTable && a == b) ?
+                            false : unpack(a) != other->unpack(b);
+
+                if (different) {
+                    if (rangeStart == -1)
+                        rangeStart = x;
+                } else if (rangeStart != -1) {
+                    ret += QRect(rangeStart, y, x - rangeStart, 1);
+                    rangeStart = -1;
                 }
-                const int rangeEnd = x;
-                ret += QRect(rangeStart, y, rangeEnd - rangeStart, 1);
             }
         }
+
+        if (rangeStart != -1)
+            ret += QRect(rangeStart, y, r.right() + 1 - rangeStart, 1);
     }
 
     return ret;
@@ -410,13 +894,31 @@ QRegion TileLayer::computeDiffRegion(const TileLayer *other) const
 
 bool TileLayer::isEmpty() const
 {
-    for (int i = 0, i_end = mGrid.size(); i < i_end; ++i)
-        if (!mGrid.at(i).isEmpty())
-            return false;
+    loadCells();
+
+    for (int i = 0, i_end = mChunks.size(); i < i_end; ++i) {
+        const QVector<quint32> &cells = mChunks.at(i);
+        for (int j = 0, j_end = cells.size(); j < j_end; ++j)
+            if (mTiles.at(cells.at(j) & TileIndexMask).tile)
+                return false;
+    }
 
     return true;
 }
 
+int TileLayer::allocatedChunkCount() const
+{
+    loadCells();
+
+    int count = 0;
+
+    for (int i = 0, i_end = mChunks.size(); i < i_end; ++i)
+        if (!mChunks.at(i).isEmpty())
+            ++count;
+
+    return count;
+}
+
 /**
  * Returns a duplicate of this TileLayer.
  *
@@ -429,8 +931,14 @@ Layer *TileLayer::clone() const
 
 TileLayer *TileLayer::initializeClone(TileLayer *clone) const
 {
+    loadCells();
+
     Layer::initializeClone(clone);
-    clone->mGrid = mGrid;
+    clone->mChunkColumns = mChunkColumns;
+    clone->mChunkRows = mChunkRows;
+    clone->mChunks = mChunks;
+    clone->mTiles = mTiles;
+    clone->mTileIndices = mTileIndices;
     clone->mMaxTileSize = mMaxTileSize;
     clone->mOffsetMargins = mOffsetMargins;
     return clone;
@@ -35,6 +35,9 @@
 #include "layer.h"
 #include "tiled.h"
 
+#include <QAtomicPointer>
+#include <QHash>
+#include <QList>
 #include <QMargins>
 #include <QString>
 #include <QVector>
@@ -42,6 +45,7 @@
 namespace Tiled {
 
 class Tile;
+class TileLayer;
 class Tileset;
 
 /**
@@ -88,21 +92,100 @@ public:
     bool flippedAntiDiagonally;
 };
 
+/**
+ * Provides the cells of a tile layer the first time they are needed. This
+ * allows readers to defer decoding the layer data until a layer is actually
+ * used.
+ *
+ * \sa TileLayer::setCellLoader()
+ */
+class TILEDSHARED_EXPORT TileLayerCellLoader
+{
+public:
+    virtual ~TileLayerCellLoader() {}
+
+    /**
+     * Returns the tilesets the loaded cells may refer to. Used to estimate
+     * the draw margins of the layer before its cells are loaded.
+     */
+    virtual QList<Tileset*> tilesets() const = 0;
+
+    /**
+     * Sets the cells of \a layer, which is an empty layer of the same size
+     * as the layer the cells are loaded for.
+     */
+    virtual void loadCells(TileLayer *layer) = 0;
+};
+
 /**
  * A tile layer is a grid of cells. Each cell refers to a specific tile, and
  * stores how the tile is flipped.
  *
+ * The cells are stored in square chunks that are only allocated once a
+ * non-empty cell is placed in them. This keeps the memory use and the time
+ * needed to scan the layer proportional to the painted area rather than the
+ * size of the layer.
+ *
+ * Within a chunk, each cell is packed into 32 bits: an index into the tile
+ * table of this layer and the flipping flags. The Cell instances returned by
+ * cellAt() are unpacked on the fly.
+ *
  * Coordinates and regions passed to function parameters are in local
  * coordinates and do not take into account the position of the layer.
  */
 class TILEDSHARED_EXPORT TileLayer : public Layer
 {
 public:
+    enum {
+        ChunkBits = 4,
+        ChunkSize = 1 << ChunkBits,
+        ChunkMask = ChunkSize - 1
+    };
+
     /**
      * Constructor.
      */
     TileLayer(const QString &name, int x, int y, int width, int height);
 
+    ~TileLayer();
+
+    /**
+     * Sets the \a loader that provides the cells of this layer. The cells
+     * are loaded the first time they are accessed, after which the loader is
+     * deleted. Any cells already set on this layer are replaced.
+     *
+     * Until then, the draw margins of this layer are estimated from all
+     * tiles of the tilesets used by the loader, so they are reported
+     * correctly without loading the cells.
+     *
+     * Loading is thread-safe, so a layer may be accessed from several
+     * threads at once without being loaded first.
+     */
+    void setCellLoader(TileLayerCellLoader *loader);
+
+    /**
+     * Returns whether this layer has a cell loader that has not yet loaded
+     * its cells.
+     */
+    bool hasPendingCells() const
+    {
+#if QT_VERSION >= 0x050000
+        return mCellLoader.loadAcquire() != 0;
+#else
+        return mCellLoader != 0;
+#endif
+    }
+
+    /**
+     * Makes sure the cells of this layer are loaded. There is no need to
+     * call this function, since all functions accessing the cells do so.
+     */
+    void loadCells() const
+    {
+        if (hasPendingCells())
+            runCellLoader();
+    }
+
     /**
      * Returns the maximum tile size of this layer.
      */
@@ -149,12 +232,34 @@ public:
      * Returns a read-only reference to the cell at the given coordinates. The
      * coordinates have to be within this layer.
      */
-    const Cell &cellAt(int x, int y) const
-    { return mGrid.at(x + y * mWidth); }
+    Cell cellAt(int x, int y) const
+    {
+        loadCells();
+
+        const QVector<quint32> &chunk = mChunks.at((x >> ChunkBits) +
+                                                   (y >> ChunkBits) * mChunkColumns);
+        if (chunk.isEmpty())
+            return Cell();
+        return unpack(chunk.at((x & ChunkMask) + ((y & ChunkMask) << ChunkBits)));
+    }
 
-    const Cell &cellAt(const QPoint &point) const
+    Cell cellAt(const QPoint &point) const
     { return cellAt(point.x(), point.y()); }
 
+    /**
+     * Returns whether storage is allocated for the chunk containing the cell
+     * at the given coordinates. When it isn't, all cells in the chunk are
+     * empty, which allows renderers to skip them. The coordinates have to be
+     * within this layer.
+     */
+    bool isChunkAllocated(int x, int y) const
+    {
+        loadCells();
+
+        return !mChunks.at((x >> ChunkBits) +
+                           (y >> ChunkBits) * mChunkColumns).isEmpty();
+    }
+
     /**
      * Sets the cell at the given coordinates.
      */
@@ -264,36 +369,149 @@ public:
      */
     bool isEmpty() const;
 
+    /**
+     * Returns the number of chunks that currently have storage allocated.
+     */
+    int allocatedChunkCount() const;
+
     virtual Layer *clone() const;
 
 protected:
     TileLayer *initializeClone(TileLayer *clone) const;
 
 private:
+    static const quint32 FlippedHorizontallyFlag   = 0x80000000;
+    static const quint32 FlippedVerticallyFlag     = 0x40000000;
+    static const quint32 FlippedAntiDiagonallyFlag = 0x20000000;
+    static const quint32 TileIndexMask             = 0x1FFFFFFF;
+
+    /**
+     * Returns the cell represented by the given packed value.
+     */
+    Cell unpack(quint32 value) const
+    {
+        Cell cell(mTiles.at(value & TileIndexMask).tile);
+        cell.flippedHorizontally = (value & FlippedHorizontallyFlag) != 0;
+        cell.flippedVertically = (value & FlippedVerticallyFlag) != 0;
+        cell.flippedAntiDiagonally = (value & FlippedAntiDiagonallyFlag) != 0;
+        return cell;
+    }
+
+    quint32 pack(const Cell &cell);
+    QVector<bool> tilesFromTileset(const Tileset *tileset) const;
+
+    void runCellLoader() const;
+
+    /**
+     * Returns the packed cells of the chunk at the given chunk coordinates.
+     * Returns an empty vector when the chunk has not been allocated.
+     */
+    const QVector<quint32> &chunk(int chunkX, int chunkY) const
+    { return mChunks.at(chunkX + chunkY * mChunkColumns); }
+
+    /**
+     * Returns the bounds of the chunk at the given chunk coordinates, clipped
+     * to the size of this layer.
+     */
+    QRect chunkRect(int chunkX, int chunkY) const
+    {
+        return QRect(chunkX << ChunkBits, chunkY << ChunkBits,
+                     ChunkSize, ChunkSize) & QRect(0, 0, mWidth, mHeight);
+    }
+
+    bool chunkRowAllocated(int chunkY) const;
+    void resetChunks(int width, int height);
+    void updateMaxTileSize(const Cell &cell);
+
     QSize mMaxTileSize;
     QMargins mOffsetMargins;
-    QVector<Cell> mGrid;
+    int mChunkColumns;
+    int mChunkRows;
+    QVector<QVector<quint32> > mChunks;
+
+    /**
+     * An entry of the tile table. Besides the tile, it stores the tileset
+     * and ID of the tile, since entries are not removed when the cells
+     * referring to them are cleared and the tile may have been deleted.
+     */
+    struct TileEntry
+    {
+        TileEntry() : tile(0), tileset(0), id(-1) {}
+        TileEntry(Tile *tile, Tileset *tileset, int id)
+            : tile(tile), tileset(tileset), id(id) {}
+
+        Tile *tile;
+        Tileset *tileset;
+        int id;
+    };
+
+    /**
+     * The tiles referred to by the packed cells. Index 0 is always null, so
+     * that a zeroed chunk contains only empty cells.
+     */
+    QVector<TileEntry> mTiles;
+    QHash<Tile*, quint32> mTileIndices;
+
+    QAtomicPointer<TileLayerCellLoader> mCellLoader;
 };
 
 
 template<typename Condition>
 QRegion TileLayer::region(Condition condition) const
 {
+    loadCells();
+
     QRegion region;
 
-    for (int y = 0; y < mHeight; ++y) {
-        for (int x = 0; x < mWidth; ++x) {
-            if (condition(cellAt(x, y))) {
-                const int rangeStart = x;
-                for (++x; x <= mWidth; ++x) {
-                    if (x == mWidth || !condition(cellAt(x, y))) {
-                        const int rangeEnd = x;
+    // When empty cells match the condition, unallocated chunks can't be
+    // skipped and every cell needs to be looked at.
+    const bool matchesEmpty = condition(Cell());
+
+    for (int chunkY = 0; chunkY < mChunkRows; ++chunkY) {
+        if (!matchesEmpty && !chunkRowAllocated(chunkY))
+            continue;
+
+        const int startY = chunkY << ChunkBits;
+        const int endY = qMin(startY + ChunkSize, mHeight);
+
+        for (int y = startY; y < endY; ++y) {
+            int rangeStart = -1;
+
+            for (int chunkX = 0; chunkX < mChunkColumns; ++chunkX) {
+                const QVector<quint32> &cells = chunk(chunkX, chunkY);
+                const int startX = chunkX << ChunkBits;
+                const int endX = qMin(startX + ChunkSize, mWidth);
+
+                if (cells.isEmpty()) {
+                    if (matchesEmpty) {
+                        if (rangeStart == -1)
+                            rangeStart = startX;
+                    } else if (rangeStart != -1) {
+                        region += QRect(rangeStart + mX, y + mY,
+                                        startX - rangeStart, 1);
+                        rangeStart = -1;
+                    }
+                    continue;
+                }
+
+                const quint32 *row = cells.constData() +
+                        ((y & ChunkMask) << ChunkBits);
+
+                for (int x = startX; x < endX; ++x) {
+                    if (condition(unpack(row[x - startX]))) {
+                        if (rangeStart == -1)
+                            rangeStart = x;
+                    } else if (rangeStart != -1) {
                         region += QRect(rangeStart + mX, y + mY,
-                                        rangeEnd - rangeStart, 1);
-                        break;
+                                        x - rangeStart, 1);
+                        rangeStart = -1;
                     }
                 }
             }
+
+            if (rangeStart != -1)
+                region += QRect(rangeStart + mX, y + mY,
+                                mWidth - rangeStart, 1);
         }
     }
 
@@ -303,21 +521,28 @@ QRegion TileLayer::region(Condition condition) const
 template<typename Condition>
 bool TileLayer::hasCell(Condition condition) const
 {
-    for (int i = 0, i_end = mGrid.size(); i < i_end; ++i)
-        if (condition(mGrid.at(i)))
-            return true;
+    loadCells();
 
-    return false;
-}
+    if (condition(Cell())) {
+        for (int y = 0; y < mHeight; ++y)
+            for (int x = 0; x < mWidth; ++x)
+                if (condition(cellAt(x, y)))
+                    return true;
 
+        return false;
+    }
 
-static inline bool cellInUse(const Cell &cell) { return !cell.isEmpty(); }
+    for (int i = 0, i_end = mChunks.size(); i < i_end; ++i) {
+        const QVector<quint32> &cells = mChunks.at(i);
+        for (int j = 0, j_end = cells.size(); j < j_end; ++j)
+            if (condition(unpack(cells.at(j))))
+                return true;
+    }
 
-inline QRegion TileLayer::region() const
-{
-    return region(cellInUse);
+    return false;
 }
 
+
 } // namespace Tiled
 
 #endif // TILELAYER_H
@@ -33,6 +33,8 @@
 
 #include <QBitmap>
 
+#include <climits>
+
 using namespace Tiled;
 
 Tileset::~Tileset()
@@ -53,44 +55,16 @@ bool Tileset::loadFromImage(const QImage &image, const QString &fileName)
     if (image.isNull())
         return false;
 
-    const int stopWidth = image.width() - mTileWidth;
-    const int stopHeight = image.height() - mTileHeight;
-
-    int oldTilesetSize = mTiles.size();
-    int tileNum = 0;
-
-    for (int y = mMargin; y <= stopHeight; y += mTileHeight + mTileSpacing) {
-        for (int x = mMargin; x <= stopWidth; x += mTileWidth + mTileSpacing) {
-            const QImage tileImage = image.copy(x, y, mTileWidth, mTileHeight);
-            QPixmap tilePixmap = QPixmap::fromImage(tileImage);
-
-            if (mTransparentColor.isValid()) {
-                const QImage mask =
-                        tileImage.createMaskFromColor(mTransparentColor.rgb());
-                tilePixmap.setMask(QBitmap::fromImage(mask));
-            }
-
-            if (tileNum < oldTilesetSize) {
-                mTiles.at(tileNum)->setImage(tilePixmap);
-            } else {
-                mTiles.append(new Tile(tilePixmap, tileNum, this));
-            }
-            ++tileNum;
-        }
-    }
-
-    // Blank out any remaining tiles to avoid confusion
-    while (tileNum < oldTilesetSize) {
-        QPixmap tilePixmap = QPixmap(mTileWidth, mTileHeight);
-        tilePixmap.fill();
-        mTiles.at(tileNum)->setImage(tilePixmap);
-        ++tileNum;
+    // The whole image is kept, with the tiles referring to parts of it
+    mImage = QPixmap::fromImage(image);
+    if (mTransparentColor.isValid()) {
+        const QImage mask = image.createMaskFromColor(mTransparentColor.rgb());
+        mImage.setMask(QBitmap::fromImage(mask));
     }
 
-    mImageWidth = image.width();
-    mImageHeight = image.height();
-    mColumnCount = columnCountForWidth(mImageWidth);
+    setTilesFromImageSize(image.size());
     mImageSource = fileName;
+    mImagePending = false;
     return true;
 }
 
@@ -99,6 +73,20 @@ bool Tileset::loadFromImage(const QString &fileName)
     return loadFromImage(QImage(fileName), fileName);
 }
 
+bool Tileset::setPendingImage(const QSize &size, const QString &fileName)
+{
+    Q_ASSERT(mTileWidth > 0 && mTileHeight > 0);
+
+    if (size.isEmpty())
+        return false;
+
+    mImage = QPixmap();
+    setTilesFromImageSize(size);
+    mImageSource = fileName;
+    mImagePending = true;
+    return true;
+}
+
 Tileset *Tileset::findSimilarTileset(const QList<Tileset*> &tilesets) const
 {
     foreach (Tileset *candidate, tilesets) {
@@ -146,7 +134,7 @@ void Tileset::insertTerrain(int index, Terrain *terrain)
         }
     }
 
-    mTerrainDistancesDirty = true;
+    markTerrainDistancesDirty();
 }
 
 Terrain *Tileset::takeTerrainAt(int index)
@@ -168,7 +156,7 @@ Terrain *Tileset::takeTerrainAt(int index)
         }
     }
 
-    mTerrainDistancesDirty = true;
+    markTerrainDistancesDirty();
 
     return terrain;
 }
@@ -191,6 +179,74 @@ int Tileset::terrainTransitionPenalty(int terrainType0, int terrainType1)
     return mTerrainTypes.at(terrainType0)->transitionDistance(terrainType1);
 }
 
+const QList<Tile*> &Tileset::animatedTiles()
+{
+    if (mAnimatedTilesDirty) {
+        mAnimatedTiles.clear();
+        foreach (Tile *tile, mTiles)
+            if (tile->isAnimated())
+                mAnimatedTiles.append(tile);
+        mAnimatedTilesDirty = false;
+    }
+    return mAnimatedTiles;
+}
+
+QList<Tile*> Tileset::bestTerrainMatches(unsigned terrain,
+                                         unsigned considerationMask)
+{
+    if (mTerrainIndexDirty) {
+        mTilesByMaskedTerrain.clear();
+        mBestTerrainMatches.clear();
+        mTerrainIndexDirty = false;
+    }
+
+    const quint64 key = quint64(considerationMask) << 32 | terrain;
+    QHash<quint64, QList<Tile*> >::const_iterator it =
+            mBestTerrainMatches.find(key);
+    if (it != mBestTerrainMatches.end())
+        return it.value();
+
+    // Group the tiles by their masked terrain, once for each mask
+    if (!mTilesByMaskedTerrain.contains(considerationMask)) {
+        QHash<unsigned, QList<Tile*> > &tilesByTerrain =
+                mTilesByMaskedTerrain[considerationMask];
+        foreach (Tile *t, mTiles)
+            tilesByTerrain[t->terrain() & considerationMask].append(t);
+    }
+
+    const QList<Tile*> candidates =
+            mTilesByMaskedTerrain.value(considerationMask).value(
+                terrain & considerationMask);
+
+    QList<Tile*> matches;
+    int penalty = INT_MAX;
+
+    foreach (Tile *t, candidates) {
+        // calculate the tile transition penalty based on shortest distance to target terrain type
+        int tr = terrainTransitionPenalty(t->terrain() >> 24, terrain >> 24);
+        int tl = terrainTransitionPenalty((t->terrain() >> 16) & 0xFF, (terrain >> 16) & 0xFF);
+        int br = terrainTransitionPenalty((t->terrain() >> 8) & 0xFF, (terrain >> 8) & 0xFF);
+        int bl = terrainTransitionPenalty(t->terrain() & 0xFF, terrain & 0xFF);
+
+        // if there is no path to the destination terrain, this isn't a useful transition
+        if (tr < 0 || tl < 0 || br < 0 || bl < 0)
+            continue;
+
+        // add tile to the candidate list
+        int transitionPenalty = tr + tl + br + bl;
+        if (transitionPenalty <= penalty) {
+            if (transitionPenalty < penalty)
+                matches.clear();
+            penalty = transitionPenalty;
+
+            matches.push_back(t);
+        }
+    }
+
+    mBestTerrainMatches.insert(key, matches);
+    return matches;
+}
+
 void Tileset::recalculateTerrainDistances()
 {
     // some fancy macros which can search for a value in each byte of a word simultaneously
@@ -280,6 +336,7 @@ Tile *Tileset::addTile(const QPixmap &image, const QString &source)
 {
     Tile *newTile = new Tile(image, source, tileCount(), this);
     mTiles.append(newTile);
+    mTerrainIndexDirty = true;
     if (mTileHeight < image.height())
         mTileHeight = image.height();
     if (mTileWidth < image.width())
@@ -298,6 +355,8 @@ void Tileset::insertTiles(int index, const QList<Tile *> &tiles)
         mTiles.at(i)->mId += count;
 
     updateTileSize();
+    markTerrainDistancesDirty();
+    markAnimatedTilesDirty();
 }
 
 void Tileset::removeTiles(int index, int count)
@@ -312,6 +371,8 @@ void Tileset::removeTiles(int index, int count)
         (*last)->mId -= count;
 
     updateTileSize();
+    markTerrainDistancesDirty();
+    markAnimatedTilesDirty();
 }
 
 void Tileset::setTileImage(int id, const QPixmap &image,
@@ -325,7 +386,7 @@ void Tileset::setTileImage(int id, const QPixmap &image,
     if (!tile)
         return;
 
-    const QSize previousImageSize = tile->image().size();
+    const QSize previousImageSize = tile->size();
     const QSize newImageSize = image.size();
 
     tile->setImage(image);
@@ -347,6 +408,47 @@ void Tileset::setTileImage(int id, const QPixmap &image,
     }
 }
 
+/**
+ * Creates or updates the tiles to refer to their part of a tileset image of
+ * the given \a size.
+ */
+void Tileset::setTilesFromImageSize(const QSize &size)
+{
+    const int stopWidth = size.width() - mTileWidth;
+    const int stopHeight = size.height() - mTileHeight;
+
+    int oldTilesetSize = mTiles.size();
+    int tileNum = 0;
+
+    for (int y = mMargin; y <= stopHeight; y += mTileHeight + mTileSpacing) {
+        for (int x = mMargin; x <= stopWidth; x += mTileWidth + mTileSpacing) {
+            const QRect tileRect(x, y, mTileWidth, mTileHeight);
+
+            if (tileNum < oldTilesetSize) {
+                mTiles.at(tileNum)->setTilesetImageRect(tileRect);
+            } else {
+                Tile *tile = new Tile(QPixmap(), tileNum, this);
+                tile->setTilesetImageRect(tileRect);
+                mTiles.append(tile);
+            }
+            ++tileNum;
+        }
+    }
+
+    // Blank out any remaining tiles to avoid confusion
+    while (tileNum < oldTilesetSize) {
+        QPixmap tilePixmap = QPixmap(mTileWidth, mTileHeight);
+        tilePixmap.fill();
+        mTiles.at(tileNum)->setImage(tilePixmap);
+        ++tileNum;
+    }
+
+    mImageWidth = size.width();
+    mImageHeight = size.height();
+    mColumnCount = columnCountForWidth(mImageWidth);
+    mTerrainIndexDirty = true;
+}
+
 void Tileset::updateTileSize()
 {
     int maxWidth = 0;
@@ -33,6 +33,7 @@
 #include "object.h"
 
 #include <QColor>
+#include <QHash>
 #include <QList>
 #include <QVector>
 #include <QPoint>
@@ -77,7 +78,10 @@ public:
         mImageWidth(0),
         mImageHeight(0),
         mColumnCount(0),
-        mTerrainDistancesDirty(false)
+        mImagePending(false),
+        mTerrainDistancesDirty(false),
+        mTerrainIndexDirty(false),
+        mAnimatedTilesDirty(false)
     {
         Q_ASSERT(tileSpacing >= 0);
         Q_ASSERT(margin >= 0);
@@ -162,6 +166,12 @@ public:
      */
     Tile *tileAt(int id) const;
 
+    /**
+     * Returns the tileset image, when this tileset is based on a single
+     * image. The tiles refer to parts of this image.
+     */
+    const QPixmap &image() const { return mImage; }
+
     /**
      * Returns the number of tiles in this tileset.
      */
@@ -215,6 +225,26 @@ public:
      */
     bool loadFromImage(const QString &fileName);
 
+    /**
+     * Sets up the tiles of this tileset for an image of the given \a size,
+     * without loading the image yet. The tiles have their final size, but no
+     * image data until loadFromImage() is called. This allows the image to
+     * be decoded in the background.
+     *
+     * @param size     the size of the tileset image
+     * @param fileName the file name of the image, which will be remembered
+     *                 as the image source of this tileset.
+     * @return <code>true</code> if the size is valid, otherwise returns
+     *         <code>false</code>
+     */
+    bool setPendingImage(const QSize &size, const QString &fileName);
+
+    /**
+     * Returns whether the tileset image still needs to be loaded. See
+     * setPendingImage().
+     */
+    bool isImagePending() const { return mImagePending; }
+
     /**
      * This checks if there is a similar tileset in the given list.
      * It is needed for replacing this tileset by its similar copy.
@@ -282,6 +312,18 @@ public:
      */
     int terrainTransitionPenalty(int terrainType0, int terrainType1);
 
+    /**
+     * Returns the tiles that match \a terrain in the corners selected by
+     * \a considerationMask, and that have the lowest total transition penalty
+     * to \a terrain over all four corners. Tiles with a corner from which
+     * there is no transition to \a terrain are never returned.
+     *
+     * The tiles are returned in tileset order. The results are cached until
+     * the tiles or their terrain information change.
+     */
+    QList<Tile*> bestTerrainMatches(unsigned terrain,
+                                    unsigned considerationMask);
+
     /**
      * Adds a new tile to the end of the tileset.
      */
@@ -299,7 +341,21 @@ public:
     /**
      * Used by the Tile class when its terrain information changes.
      */
-    void markTerrainDistancesDirty() { mTerrainDistancesDirty = true; }
+    void markTerrainDistancesDirty()
+    {
+        mTerrainDistancesDirty = true;
+        mTerrainIndexDirty = true;
+    }
+
+    /**
+     * Returns the tiles of this tileset that have animation frames.
+     */
+    const QList<Tile*> &animatedTiles();
+
+    /**
+     * Used by the Tile class when its animation frames change.
+     */
+    void markAnimatedTilesDirty() { mAnimatedTilesDirty = true; }
 
 private:
     /**
@@ -307,6 +363,8 @@ private:
      */
     void updateTileSize();
 
+    void setTilesFromImageSize(const QSize &size);
+
     /**
      * Calculates the transition distance matrix for all terrain types.
      */
@@ -315,6 +373,7 @@ private:
     QString mName;
     QString mFileName;
     QString mImageSource;
+    QPixmap mImage;
     QColor mTransparentColor;
     int mTileWidth;
     int mTileHeight;
@@ -324,9 +383,22 @@ private:
     int mImageWidth;
     int mImageHeight;
     int mColumnCount;
+    bool mImagePending;
     QList<Tile*> mTiles;
     QList<Terrain*> mTerrainTypes;
     bool mTerrainDistancesDirty;
+
+    /**
+     * The tiles by their terrain masked with a consideration mask, for each
+     * of the used masks. Together with the results of bestTerrainMatches()
+     * this is cleared when mTerrainIndexDirty is set.
+     */
+    QHash<unsigned, QHash<unsigned, QList<Tile*> > > mTilesByMaskedTerrain;
+    QHash<quint64, QList<Tile*> > mBestTerrainMatches;
+    bool mTerrainIndexDirty;
+
+    QList<Tile*> mAnimatedTiles;
+    bool mAnimatedTilesDirty;
 };
 
 } // namespace Tiled
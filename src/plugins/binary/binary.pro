@@ -0,0 +1,13 @@
+include(../plugin.pri)
+
+DEFINES += BINARY_LIBRARY
+
+SOURCES += binaryplugin.cpp \
+    binarymapreader.cpp \
+    binarymapwriter.cpp
+
+HEADERS += binaryplugin.h \
+    binary_global.h \
+    binarymapformat.h \
+    binarymapreader.h \
+    binarymapwriter.h
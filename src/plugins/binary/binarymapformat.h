@@ -0,0 +1,108 @@
+/*
+ * Binary Map Format Tiled Plugin
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BINARYMAPFORMAT_H
+#define BINARYMAPFORMAT_H
+
+#include <QtCore/qglobal.h>
+
+namespace Binary {
+
+/**
+ * Constants of the binary map format.
+ *
+ * A binary map file consists of a table section followed by a data section.
+ * All numbers are stored in little-endian byte order. Strings are stored as
+ * a quint32 byte count followed by UTF-8 data, and properties as a quint32
+ * count followed by name and value strings. Colors are stored as a quint8
+ * that is 1 when the color is set, followed by a quint32 ARGB value.
+ *
+ * The table section starts with the header:
+ *
+ *   char[4]  magic ("TMBF")
+ *   quint32  version
+ *   quint64  offset of the data section
+ *   quint8   orientation, quint8 render order, quint16 reserved
+ *   qint32   width, height, tile width, tile height
+ *   color    background color
+ *   properties
+ *
+ * It is followed by a quint32 tileset count and the tileset table. Each
+ * entry holds the quint32 first global tile ID, a quint8 tileset kind and
+ * a string. For external tilesets, the string is the path to the TSX file
+ * relative to the map. Embedded tilesets are stored as a complete TSX
+ * document, so they keep all of their tile properties, terrains and
+ * animations.
+ *
+ * Then follows a quint32 layer count and the layer table. Each layer starts
+ * with a quint8 layer type, its name, its qint32 x, y, width and height, a
+ * float opacity, a quint8 visibility flag and its properties.
+ *
+ * Tile layers continue with a quint8 compression method, the quint32 number
+ * of rows per chunk and the quint32 number of chunks, followed by a quint64
+ * offset and a quint32 size for each chunk. The offsets are relative to the
+ * start of the data section. Each chunk holds the quint32 global tile IDs
+ * (including the flip flags) of its rows, optionally zlib compressed, and
+ * starts on a 4-byte boundary so that uncompressed chunks can be used in
+ * place when the file is memory mapped.
+ *
+ * Object groups continue with their color, a quint8 draw order and the
+ * object table: a quint32 object count followed by the name, the type, the
+ * quint32 global tile ID, the double x, y, width, height and rotation, a
+ * quint8 visibility flag, a quint8 shape, a quint32 point count followed by
+ * the double x and y of each point, and the properties of each object.
+ *
+ * Image layers continue with the image path relative to the map and the
+ * transparent color.
+ */
+namespace Format {
+
+static const char Magic[4] = { 'T', 'M', 'B', 'F' };
+
+enum {
+    Version = 1,
+
+    /** Offset of the data section offset in the header. */
+    DataOffsetPosition = 8,
+
+    /** The number of tile layer rows stored in each chunk. */
+    ChunkRows = 64
+};
+
+enum TilesetKind {
+    ExternalTileset = 0,
+    EmbeddedTileset = 1
+};
+
+enum LayerType {
+    TileLayerType = 1,
+    ObjectGroupType = 2,
+    ImageLayerType = 3
+};
+
+enum Compression {
+    NoCompression = 0,
+    ZlibCompression = 1
+};
+
+} // namespace Format
+} // namespace Binary
+
+#endif // BINARYMAPFORMAT_H
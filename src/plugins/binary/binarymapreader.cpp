@@ -0,0 +1,744 @@
+/*
+ * Binary Map Format Tiled Plugin
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "binarymapreader.h"
+
+#include "binarymapformat.h"
+
+#include "compression.h"
+#include "imagelayer.h"
+#include "map.h"
+#include "mapobject.h"
+#include "mapreader.h"
+#include "objectgroup.h"
+#include "properties.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QBuffer>
+#include <QColor>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QScopedPointer>
+#include <QtEndian>
+
+#include <climits>
+#include <cstring>
+
+using namespace Tiled;
+using namespace Binary;
+
+namespace Binary {
+
+/**
+ * The contents of a binary map file. It is shared by the tile layers that
+ * have not been loaded yet, so that the file stays mapped until the last of
+ * them is loaded.
+ */
+class MapData
+{
+public:
+    explicit MapData(const QString &fileName)
+        : mFile(fileName)
+        , mMapped(0)
+    {}
+
+    ~MapData()
+    {
+        if (mMapped)
+            mFile.unmap(mMapped);
+    }
+
+    bool open()
+    {
+        if (!mFile.open(QIODevice::ReadOnly))
+            return false;
+
+        mMapped = mFile.map(0, mFile.size());
+        if (!mMapped) {
+            // Not all files can be memory mapped, so fall back to reading it
+            mContents = mFile.readAll();
+            mFile.close();
+        }
+
+        return true;
+    }
+
+    const uchar *data() const
+    {
+        if (mMapped)
+            return mMapped;
+        return reinterpret_cast<const uchar*>(mContents.constData());
+    }
+
+    qint64 size() const
+    {
+        return mMapped ? mFile.size() : mContents.size();
+    }
+
+private:
+    QFile mFile;
+    uchar *mMapped;
+    QByteArray mContents;
+};
+
+} // namespace Binary
+
+namespace {
+
+struct Chunk
+{
+    quint64 offset;     // Relative to the start of the data section
+    quint32 size;
+};
+
+/**
+ * The chunk table of a tile layer, checked against the size of the file.
+ */
+struct TileLayerData
+{
+    QString layerName;
+    quint8 compression;
+    int chunkRows;
+    QVector<Chunk> chunks;
+};
+
+QString corruptLayerDataError(const QString &layerName)
+{
+    return QCoreApplication::translate("BinaryMapReader",
+                                       "Corrupt layer data for layer '%1'")
+            .arg(layerName);
+}
+
+/**
+ * Decodes the chunks of \a layerData into \a tileLayer. The \a data points
+ * to the start of the data section.
+ *
+ * Returns false and sets \a error when the data turns out to be corrupt.
+ */
+bool decodeTileLayerData(const uchar *data,
+                         const TileLayerData &layerData,
+                         const GidMapper &gidMapper,
+                         TileLayer *tileLayer,
+                         QString &error)
+{
+    const int width = tileLayer->width();
+    const int height = tileLayer->height();
+
+    QVector<unsigned> rowGids(width);
+    QVector<Cell> rowCells(width);
+
+    for (int i = 0; i < layerData.chunks.size(); ++i) {
+        const Chunk &chunk = layerData.chunks.at(i);
+        const int startY = i * layerData.chunkRows;
+        const int endY = qMin<qint64>(qint64(startY) + layerData.chunkRows,
+                                      height);
+        const int expectedSize = (endY - startY) * width * 4;
+
+        const uchar *gids = data + chunk.offset;
+        QByteArray decompressed;
+
+        if (layerData.compression == Format::ZlibCompression) {
+            const QByteArray compressed =
+                    QByteArray::fromRawData(reinterpret_cast<const char*>(gids),
+                                            chunk.size);
+            decompressed = decompress(compressed, expectedSize);
+            gids = reinterpret_cast<const uchar*>(decompressed.constData());
+
+            if (decompressed.size() != expectedSize) {
+                error = corruptLayerDataError(layerData.layerName);
+                return false;
+            }
+        }
+
+        for (int y = startY; y < endY; ++y) {
+            for (int x = 0; x < width; ++x, gids += 4)
+                rowGids[x] = qFromLittleEndian<quint32>(gids);
+
+            const int converted = gidMapper.gidsToCells(rowGids.constData(),
+                                                        rowCells.data(),
+                                                        width);
+            if (converted < width) {
+                error = QCoreApplication::translate("BinaryMapReader",
+                                                    "Invalid tile: %1")
+                        .arg(rowGids.at(converted));
+                return false;
+            }
+
+            for (int x = 0; x < width; ++x)
+                if (!rowCells.at(x).isEmpty())
+                    tileLayer->setCell(x, y, rowCells.at(x));
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Decodes the data of a tile layer the first time the layer is accessed.
+ */
+class TileLayerDataLoader : public TileLayerCellLoader
+{
+public:
+    TileLayerDataLoader(const QSharedPointer<MapData> &mapData,
+                        qint64 dataOffset,
+                        const TileLayerData &layerData,
+                        const GidMapper &gidMapper,
+                        const QList<Tileset*> &tilesets)
+        : mMapData(mapData)
+        , mDataOffset(dataOffset)
+        , mLayerData(layerData)
+        , mGidMapper(gidMapper)
+        , mTilesets(tilesets)
+    {}
+
+    QList<Tileset*> tilesets() const
+    {
+        return mTilesets;
+    }
+
+    void loadCells(TileLayer *layer)
+    {
+        QString error;
+        if (!decodeTileLayerData(mMapData->data() + mDataOffset, mLayerData,
+                                 mGidMapper, layer, error)) {
+            qWarning("%s", qPrintable(error));
+        }
+    }
+
+private:
+    QSharedPointer<MapData> mMapData;
+    qint64 mDataOffset;
+    TileLayerData mLayerData;
+    GidMapper mGidMapper;
+    QList<Tileset*> mTilesets;
+};
+
+} // anonymous namespace
+
+BinaryMapReader::BinaryMapReader()
+    : mLazyLoadingEnabled(true)
+    , mData(0)
+    , mSize(0)
+    , mPosition(0)
+    , mDataOffset(0)
+    , mUncompressedLayers(false)
+{
+}
+
+BinaryMapReader::~BinaryMapReader()
+{
+}
+
+Map *BinaryMapReader::read(const QString &fileName)
+{
+    QSharedPointer<MapData> mapData(new MapData(fileName));
+    if (!mapData->open()) {
+        mError = tr("Could not open file for reading.");
+        return 0;
+    }
+
+    // Tile layers that are loaded lazily keep a reference to the file
+    if (mLazyLoadingEnabled)
+        mMapData = mapData;
+
+    Map *map = read(mapData->data(), mapData->size(),
+                    QFileInfo(fileName).dir());
+
+    mMapData.clear();
+    return map;
+}
+
+Map *BinaryMapReader::read(const uchar *data, qint64 size,
+                           const QDir &mapDir)
+{
+    mData = data;
+    mSize = size;
+    mPosition = 0;
+    mDataOffset = 0;
+    mMapDir = mapDir;
+    mTilesets.clear();
+    mGidMapper.clear();
+    mUncompressedLayers = false;
+    mError.clear();
+
+    Map *map = readMap();
+
+    mData = 0;
+    mSize = 0;
+    return map;
+}
+
+Map *BinaryMapReader::readMap()
+{
+    const uchar *magic = take(sizeof(Format::Magic));
+    if (!magic || std::memcmp(magic, Format::Magic, sizeof(Format::Magic))) {
+        mError = tr("Not a binary map file.");
+        return 0;
+    }
+
+    const quint32 version = readUInt32();
+    if (!atError() && (version == 0 || version > Format::Version)) {
+        mError = tr("Unsupported binary map version: %1").arg(version);
+        return 0;
+    }
+
+    const quint64 dataOffset = readUInt64();
+    const int orientation = readUInt8();
+    const int renderOrder = readUInt8();
+    readUInt16(); // reserved
+    const int width = readInt32();
+    const int height = readInt32();
+    const int tileWidth = readInt32();
+    const int tileHeight = readInt32();
+
+    if (atError())
+        return 0;
+
+    if (width < 0 || height < 0 || tileWidth < 0 || tileHeight < 0 ||
+            dataOffset > quint64(mSize)) {
+        mError = tr("Corrupt binary map file.");
+        return 0;
+    }
+    mDataOffset = dataOffset;
+
+    if (orientation < Map::Orthogonal || orientation > Map::Staggered) {
+        mError = tr("Unsupported map orientation: \"%1\"").arg(orientation);
+        return 0;
+    }
+
+    typedef QScopedPointer<Map> MapPtr;
+    MapPtr map(new Map(Map::Orientation(orientation),
+                       width, height, tileWidth, tileHeight));
+    map->setRenderOrder(Map::RenderOrder(renderOrder & 3));
+    map->setBackgroundColor(readColor());
+    map->setProperties(readProperties());
+
+    const quint32 tilesetCount = readUInt32();
+    for (quint32 i = 0; i < tilesetCount && !atError(); ++i) {
+        if (Tileset *tileset = readTileset())
+            map->addTileset(tileset);
+    }
+
+    const quint32 layerCount = readUInt32();
+    for (quint32 i = 0; i < layerCount && !atError(); ++i) {
+        if (Layer *layer = readLayer())
+            map->addLayer(layer);
+    }
+
+    if (atError()) {
+        qDeleteAll(map->tilesets());
+        return 0;
+    }
+
+    // Remember whether the layer data was compressed, for when the map is
+    // saved again
+    if (map->tileLayerCount() > 0)
+        map->setLayerDataFormat(mUncompressedLayers ? Map::Base64
+                                                    : Map::Base64Zlib);
+
+    return map.take();
+}
+
+Tileset *BinaryMapReader::readTileset()
+{
+    const quint32 firstGid = readUInt32();
+    const quint8 kind = readUInt8();
+    QByteArray bytes = readBytes();
+
+    if (atError())
+        return 0;
+
+    if (firstGid == 0) {
+        mError = tr("Corrupt binary map file.");
+        return 0;
+    }
+
+    MapReader reader;
+    Tileset *tileset = 0;
+
+    switch (kind) {
+    case Format::ExternalTileset: {
+        const QString source = QString::fromUtf8(bytes.constData(),
+                                                 bytes.size());
+        const QString fileName =
+                QDir::cleanPath(mMapDir.absoluteFilePath(source));
+
+        tileset = reader.readTileset(fileName);
+        if (!tileset) {
+            mError = tr("Error while loading tileset '%1': %2")
+                    .arg(fileName, reader.errorString());
+        }
+        break;
+    }
+    case Format::EmbeddedTileset: {
+        QBuffer buffer(&bytes);
+        buffer.open(QIODevice::ReadOnly);
+
+        tileset = reader.readTileset(&buffer, mMapDir.path());
+        if (!tileset)
+            mError = reader.errorString();
+        break;
+    }
+    default:
+        mError = tr("Corrupt binary map file.");
+        break;
+    }
+
+    if (tileset) {
+        mTilesets.append(tileset);
+        mGidMapper.insert(firstGid, tileset);
+    }
+
+    return tileset;
+}
+
+Layer *BinaryMapReader::readLayer()
+{
+    const quint8 type = readUInt8();
+    const QString name = readString();
+    const int x = readInt32();
+    const int y = readInt32();
+    const int width = readInt32();
+    const int height = readInt32();
+    const float opacity = readFloat();
+    const bool visible = readUInt8();
+    const Properties properties = readProperties();
+
+    if (atError())
+        return 0;
+
+    if (width < 0 || height < 0) {
+        mError = tr("Corrupt binary map file.");
+        return 0;
+    }
+
+    typedef QScopedPointer<Layer> LayerPtr;
+    LayerPtr layer;
+    bool ok = false;
+
+    switch (type) {
+    case Format::TileLayerType: {
+        TileLayer *tileLayer = new TileLayer(name, x, y, width, height);
+        layer.reset(tileLayer);
+        ok = readTileLayerData(tileLayer);
+        break;
+    }
+    case Format::ObjectGroupType: {
+        ObjectGroup *objectGroup = new ObjectGroup(name, x, y, width, height);
+        layer.reset(objectGroup);
+        ok = readObjects(objectGroup);
+        break;
+    }
+    case Format::ImageLayerType: {
+        ImageLayer *imageLayer = new ImageLayer(name, x, y, width, height);
+        layer.reset(imageLayer);
+        ok = readImageLayerImage(imageLayer);
+        break;
+    }
+    default:
+        mError = tr("Corrupt binary map file.");
+        return 0;
+    }
+
+    if (!ok)
+        return 0;
+
+    layer->setOpacity(opacity);
+    layer->setVisible(visible);
+    layer->setProperties(properties);
+
+    return layer.take();
+}
+
+bool BinaryMapReader::readTileLayerData(TileLayer *tileLayer)
+{
+    TileLayerData layerData;
+    layerData.layerName = tileLayer->name();
+    layerData.compression = readUInt8();
+    const quint32 chunkRows = readUInt32();
+    const quint32 chunkCount = readUInt32();
+
+    if (atError())
+        return false;
+
+    if (layerData.compression != Format::NoCompression &&
+            layerData.compression != Format::ZlibCompression) {
+        mError = tr("Compression method '%1' not supported")
+                .arg(int(layerData.compression));
+        return false;
+    }
+
+    const int width = tileLayer->width();
+    const int height = tileLayer->height();
+
+    if (chunkRows == 0 || chunkRows > INT_MAX ||
+            chunkCount != (quint64(height) + chunkRows - 1) / chunkRows) {
+        mError = corruptLayerDataError(tileLayer->name());
+        return false;
+    }
+
+    layerData.chunkRows = chunkRows;
+    layerData.chunks.reserve(chunkCount);
+
+    const quint64 dataSize = mSize - mDataOffset;
+
+    for (quint32 i = 0; i < chunkCount; ++i) {
+        Chunk chunk;
+        chunk.offset = readUInt64();
+        chunk.size = readUInt32();
+
+        if (atError())
+            return false;
+
+        const qint64 startY = qint64(i) * chunkRows;
+        const qint64 endY = qMin<qint64>(startY + chunkRows, height);
+        const qint64 expectedSize = (endY - startY) * width * 4;
+
+        if (chunk.offset > dataSize || chunk.size > dataSize - chunk.offset ||
+                expectedSize > INT_MAX) {
+            mError = corruptLayerDataError(tileLayer->name());
+            return false;
+        }
+
+        if (layerData.compression == Format::NoCompression &&
+                chunk.size != expectedSize) {
+            mError = corruptLayerDataError(tileLayer->name());
+            return false;
+        }
+
+        layerData.chunks.append(chunk);
+    }
+
+    if (layerData.compression == Format::NoCompression)
+        mUncompressedLayers = true;
+
+    if (mMapData) {
+        tileLayer->setCellLoader(new TileLayerDataLoader(mMapData,
+                                                         mDataOffset,
+                                                         layerData,
+                                                         mGidMapper,
+                                                         mTilesets));
+        return true;
+    }
+
+    return decodeTileLayerData(mData + mDataOffset, layerData, mGidMapper,
+                               tileLayer, mError);
+}
+
+bool BinaryMapReader::readObjects(ObjectGroup *objectGroup)
+{
+    objectGroup->setColor(readColor());
+
+    const quint8 drawOrder = readUInt8();
+    if (drawOrder != ObjectGroup::TopDownOrder &&
+            drawOrder != ObjectGroup::IndexOrder && !atError()) {
+        mError = tr("Invalid draw order: %1").arg(int(drawOrder));
+        return false;
+    }
+    objectGroup->setDrawOrder(ObjectGroup::DrawOrder(drawOrder));
+
+    const quint32 objectCount = readUInt32();
+    for (quint32 i = 0; i < objectCount && !atError(); ++i) {
+        const QString name = readString();
+        const QString type = readString();
+        const unsigned gid = readUInt32();
+        const qreal x = readDouble();
+        const qreal y = readDouble();
+        const qreal width = readDouble();
+        const qreal height = readDouble();
+        const qreal rotation = readDouble();
+        const bool visible = readUInt8();
+        const quint8 shape = readUInt8();
+
+        const quint32 pointCount = readUInt32();
+        QPolygonF polygon;
+        for (quint32 j = 0; j < pointCount && !atError(); ++j) {
+            const qreal pointX = readDouble();
+            const qreal pointY = readDouble();
+            polygon.append(QPointF(pointX, pointY));
+        }
+
+        const Properties properties = readProperties();
+
+        if (atError())
+            break;
+
+        if (shape > MapObject::Ellipse) {
+            mError = tr("Corrupt binary map file.");
+            return false;
+        }
+
+        MapObject *object = new MapObject(name, type,
+                                          QPointF(x, y),
+                                          QSizeF(width, height));
+        object->setRotation(rotation);
+        object->setVisible(visible);
+        object->setShape(MapObject::Shape(shape));
+        object->setPolygon(polygon);
+        object->setProperties(properties);
+
+        if (gid) {
+            bool ok;
+            object->setCell(mGidMapper.gidToCell(gid, ok));
+            if (!ok) {
+                delete object;
+                mError = tr("Invalid tile: %1").arg(gid);
+                return false;
+            }
+        }
+
+        objectGroup->addObject(object);
+    }
+
+    return !atError();
+}
+
+bool BinaryMapReader::readImageLayerImage(ImageLayer *imageLayer)
+{
+    const QString source = readString();
+    const QColor transparentColor = readColor();
+
+    if (atError())
+        return false;
+
+    imageLayer->setTransparentColor(transparentColor);
+
+    if (source.isEmpty())
+        return true;
+
+    const QString fileName = QDir::cleanPath(mMapDir.absoluteFilePath(source));
+    if (!imageLayer->loadFromImage(QImage(fileName), fileName)) {
+        mError = tr("Error loading image layer image:\n'%1'").arg(fileName);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Returns a pointer to the next \a size bytes and moves past them, or
+ * returns 0 and sets an error when the file is too short.
+ */
+const uchar *BinaryMapReader::take(qint64 size)
+{
+    if (atError())
+        return 0;
+
+    if (size < 0 || size > mSize - mPosition) {
+        mError = tr("Unexpected end of file.");
+        return 0;
+    }
+
+    const uchar *data = mData + mPosition;
+    mPosition += size;
+    return data;
+}
+
+quint8 BinaryMapReader::readUInt8()
+{
+    const uchar *data = take(1);
+    return data ? *data : 0;
+}
+
+quint16 BinaryMapReader::readUInt16()
+{
+    const uchar *data = take(2);
+    return data ? qFromLittleEndian<quint16>(data) : 0;
+}
+
+quint32 BinaryMapReader::readUInt32()
+{
+    const uchar *data = take(4);
+    return data ? qFromLittleEndian<quint32>(data) : 0;
+}
+
+quint64 BinaryMapReader::readUInt64()
+{
+    const uchar *data = take(8);
+    return data ? qFromLittleEndian<quint64>(data) : 0;
+}
+
+qint32 BinaryMapReader::readInt32()
+{
+    return qint32(readUInt32());
+}
+
+float BinaryMapReader::readFloat()
+{
+    const quint32 bits = readUInt32();
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+double BinaryMapReader::readDouble()
+{
+    const quint64 bits = readUInt64();
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * Returns the next byte array. The returned array refers to the data of the
+ * file, so it is only valid while reading.
+ */
+QByteArray BinaryMapReader::readBytes()
+{
+    const quint32 size = readUInt32();
+    const uchar *data = take(size);
+    if (!data)
+        return QByteArray();
+
+    return QByteArray::fromRawData(reinterpret_cast<const char*>(data), size);
+}
+
+QString BinaryMapReader::readString()
+{
+    const quint32 size = readUInt32();
+    const uchar *data = take(size);
+    if (!data)
+        return QString();
+
+    return QString::fromUtf8(reinterpret_cast<const char*>(data), size);
+}
+
+QColor BinaryMapReader::readColor()
+{
+    const bool valid = readUInt8();
+    const QRgb rgba = readUInt32();
+    return valid ? QColor::fromRgba(rgba) : QColor();
+}
+
+Properties BinaryMapReader::readProperties()
+{
+    Properties properties;
+
+    const quint32 count = readUInt32();
+    for (quint32 i = 0; i < count && !atError(); ++i) {
+        const QString name = readString();
+        const QString value = readString();
+        properties.insert(name, value);
+    }
+
+    return properties;
+}
@@ -0,0 +1,140 @@
+/*
+ * Binary Map Format Tiled Plugin
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BINARYMAPREADER_H
+#define BINARYMAPREADER_H
+
+#include "gidmapper.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QList>
+#include <QSharedPointer>
+
+class QColor;
+
+namespace Tiled {
+class ImageLayer;
+class Layer;
+class Map;
+class ObjectGroup;
+class Properties;
+class TileLayer;
+class Tileset;
+}
+
+namespace Binary {
+
+class MapData;
+
+/**
+ * Reads a map in the binary map format. See binarymapformat.h for a
+ * description of the format.
+ *
+ * Files are memory mapped when possible. The tables are parsed first, after
+ * which the data of each tile layer is decoded straight from the mapped
+ * memory, without making a copy of uncompressed chunks.
+ *
+ * When reading from a file, tile layers are loaded lazily by default. Only
+ * their chunk tables are checked while reading, and their data is decoded
+ * the first time a layer is accessed. The file stays mapped until all tile
+ * layers have been loaded, so it should not be modified in the meantime.
+ */
+class BinaryMapReader
+{
+    Q_DECLARE_TR_FUNCTIONS(BinaryMapReader)
+
+public:
+    BinaryMapReader();
+    ~BinaryMapReader();
+
+    /**
+     * Sets whether the data of tile layers is only decoded once a layer is
+     * first accessed. Only applies when reading from a file.
+     *
+     * Since errors can't be reported at that point anymore, a tile layer
+     * with corrupt data is left partially empty and a warning is printed.
+     *
+     * Enabled by default.
+     */
+    void setLazyLoadingEnabled(bool enabled) { mLazyLoadingEnabled = enabled; }
+    bool isLazyLoadingEnabled() const { return mLazyLoadingEnabled; }
+
+    /**
+     * Reads the map from the given \a fileName.
+     *
+     * Returns 0 and sets errorString() when reading failed.
+     */
+    Tiled::Map *read(const QString &fileName);
+
+    /**
+     * Reads the map from the \a size bytes at \a data. The \a mapDir is used
+     * to resolve references to external files.
+     *
+     * Returns 0 and sets errorString() when reading failed.
+     */
+    Tiled::Map *read(const uchar *data, qint64 size, const QDir &mapDir);
+
+    /**
+     * Returns the last error, if any.
+     */
+    QString errorString() const { return mError; }
+
+private:
+    Tiled::Map *readMap();
+    Tiled::Tileset *readTileset();
+    Tiled::Layer *readLayer();
+    bool readTileLayerData(Tiled::TileLayer *tileLayer);
+    bool readObjects(Tiled::ObjectGroup *objectGroup);
+    bool readImageLayerImage(Tiled::ImageLayer *imageLayer);
+
+    const uchar *take(qint64 size);
+    quint8 readUInt8();
+    quint16 readUInt16();
+    quint32 readUInt32();
+    quint64 readUInt64();
+    qint32 readInt32();
+    float readFloat();
+    double readDouble();
+    QByteArray readBytes();
+    QString readString();
+    QColor readColor();
+    Tiled::Properties readProperties();
+
+    bool atError() const { return !mError.isEmpty(); }
+
+    bool mLazyLoadingEnabled;
+    QSharedPointer<MapData> mMapData;
+
+    const uchar *mData;
+    qint64 mSize;
+    qint64 mPosition;
+    qint64 mDataOffset;
+
+    QDir mMapDir;
+    QList<Tiled::Tileset*> mTilesets;
+    Tiled::GidMapper mGidMapper;
+    bool mUncompressedLayers;
+    QString mError;
+};
+
+} // namespace Binary
+
+#endif // BINARYMAPREADER_H
@@ -0,0 +1,328 @@
+/*
+ * Binary Map Format Tiled Plugin
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "binarymapwriter.h"
+
+#include "binarymapformat.h"
+
+#include "compression.h"
+#include "imagelayer.h"
+#include "map.h"
+#include "mapobject.h"
+#include "mapwriter.h"
+#include "objectgroup.h"
+#include "properties.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QBuffer>
+#include <QColor>
+#include <QIODevice>
+#include <QtEndian>
+
+#include <cstring>
+
+using namespace Tiled;
+using namespace Binary;
+
+/**
+ * Pads the given \a bytes with zeroes up to a multiple of \a alignment.
+ */
+static void alignTo(QByteArray &bytes, int alignment)
+{
+    const int remainder = bytes.size() % alignment;
+    if (remainder)
+        bytes.append(QByteArray(alignment - remainder, '\0'));
+}
+
+BinaryMapWriter::BinaryMapWriter()
+    : mCompressionEnabled(true)
+{
+}
+
+bool BinaryMapWriter::write(const Map *map, QIODevice *device,
+                            const QDir &mapDir)
+{
+    mMapDir = mapDir;
+    mGidMapper.clear();
+    mTables.clear();
+    mData.clear();
+    mError.clear();
+
+    mTables.append(Format::Magic, sizeof(Format::Magic));
+    writeUInt32(Format::Version);
+    writeUInt64(0); // Offset of the data section, filled in below
+    writeUInt8(map->orientation());
+    writeUInt8(map->renderOrder());
+    writeUInt16(0);
+    writeInt32(map->width());
+    writeInt32(map->height());
+    writeInt32(map->tileWidth());
+    writeInt32(map->tileHeight());
+    writeColor(map->backgroundColor());
+    writeProperties(map->properties());
+
+    writeUInt32(map->tilesetCount());
+    unsigned firstGid = 1;
+    foreach (Tileset *tileset, map->tilesets()) {
+        writeTileset(tileset, firstGid);
+        mGidMapper.insert(firstGid, tileset);
+        firstGid += tileset->tileCount();
+    }
+
+    writeUInt32(map->layerCount());
+    foreach (const Layer *layer, map->layers())
+        writeLayer(layer);
+
+    // Let the data section start on a 16-byte boundary
+    alignTo(mTables, 16);
+    qToLittleEndian<quint64>(mTables.size(),
+                             reinterpret_cast<uchar*>(mTables.data() +
+                                                      Format::DataOffsetPosition));
+
+    if (device->write(mTables) != mTables.size() ||
+            device->write(mData) != mData.size()) {
+        mError = tr("Error while writing file:\n%1").arg(device->errorString());
+        return false;
+    }
+
+    mTables.clear();
+    mData.clear();
+    return true;
+}
+
+void BinaryMapWriter::writeTileset(const Tileset *tileset, unsigned firstGid)
+{
+    writeUInt32(firstGid);
+
+    if (tileset->isExternal()) {
+        writeUInt8(Format::ExternalTileset);
+        writeString(mMapDir.relativeFilePath(tileset->fileName()));
+        return;
+    }
+
+    // Embedded tilesets are stored as TSX, so that no tileset information
+    // is lost and the map reader can be used for loading them again.
+    QByteArray tsx;
+    QBuffer buffer(&tsx);
+    buffer.open(QIODevice::WriteOnly);
+
+    MapWriter writer;
+    writer.setDtdEnabled(false);
+    writer.writeTileset(tileset, &buffer, mMapDir.path());
+
+    writeUInt8(Format::EmbeddedTileset);
+    writeBytes(tsx);
+}
+
+void BinaryMapWriter::writeLayer(const Layer *layer)
+{
+    switch (layer->layerType()) {
+    case Layer::TileLayerType:
+        writeUInt8(Format::TileLayerType);
+        break;
+    case Layer::ObjectGroupType:
+        writeUInt8(Format::ObjectGroupType);
+        break;
+    case Layer::ImageLayerType:
+        writeUInt8(Format::ImageLayerType);
+        break;
+    }
+
+    writeString(layer->name());
+    writeInt32(layer->x());
+    writeInt32(layer->y());
+    writeInt32(layer->width());
+    writeInt32(layer->height());
+    writeFloat(layer->opacity());
+    writeUInt8(layer->isVisible());
+    writeProperties(layer->properties());
+
+    switch (layer->layerType()) {
+    case Layer::TileLayerType:
+        writeTileLayer(static_cast<const TileLayer*>(layer));
+        break;
+    case Layer::ObjectGroupType:
+        writeObjectGroup(static_cast<const ObjectGroup*>(layer));
+        break;
+    case Layer::ImageLayerType:
+        writeImageLayer(static_cast<const ImageLayer*>(layer));
+        break;
+    }
+}
+
+void BinaryMapWriter::writeTileLayer(const TileLayer *tileLayer)
+{
+    const int width = tileLayer->width();
+    const int height = tileLayer->height();
+    const int chunkCount = (height + Format::ChunkRows - 1) / Format::ChunkRows;
+
+    writeUInt8(mCompressionEnabled ? Format::ZlibCompression
+                                   : Format::NoCompression);
+    writeUInt32(Format::ChunkRows);
+    writeUInt32(chunkCount);
+
+    QByteArray chunk;
+    QVector<Cell> rowCells(width);
+    QVector<unsigned> rowGids(width);
+
+    for (int i = 0; i < chunkCount; ++i) {
+        const int startY = i * Format::ChunkRows;
+        const int endY = qMin(startY + Format::ChunkRows, height);
+
+        chunk.resize((endY - startY) * width * 4);
+        uchar *gids = reinterpret_cast<uchar*>(chunk.data());
+
+        for (int y = startY; y < endY; ++y) {
+            for (int x = 0; x < width; ++x)
+                rowCells[x] = tileLayer->cellAt(x, y);
+
+            mGidMapper.cellsToGids(rowCells.constData(), rowGids.data(), width);
+
+            for (int x = 0; x < width; ++x) {
+                qToLittleEndian<quint32>(rowGids.at(x), gids);
+                gids += 4;
+            }
+        }
+
+        alignTo(mData, 4);
+        writeUInt64(mData.size());
+
+        if (mCompressionEnabled) {
+            const QByteArray compressed = compress(chunk, Zlib);
+            writeUInt32(compressed.size());
+            mData.append(compressed);
+        } else {
+            writeUInt32(chunk.size());
+            mData.append(chunk);
+        }
+    }
+}
+
+void BinaryMapWriter::writeObjectGroup(const ObjectGroup *objectGroup)
+{
+    writeColor(objectGroup->color());
+    writeUInt8(objectGroup->drawOrder());
+
+    writeUInt32(objectGroup->objectCount());
+    foreach (const MapObject *object, objectGroup->objects()) {
+        writeString(object->name());
+        writeString(object->type());
+        writeUInt32(mGidMapper.cellToGid(object->cell()));
+        writeDouble(object->x());
+        writeDouble(object->y());
+        writeDouble(object->width());
+        writeDouble(object->height());
+        writeDouble(object->rotation());
+        writeUInt8(object->isVisible());
+        writeUInt8(object->shape());
+
+        const QPolygonF &polygon = object->polygon();
+        writeUInt32(polygon.size());
+        foreach (const QPointF &point, polygon) {
+            writeDouble(point.x());
+            writeDouble(point.y());
+        }
+
+        writeProperties(object->properties());
+    }
+}
+
+void BinaryMapWriter::writeImageLayer(const ImageLayer *imageLayer)
+{
+    const QString &imageSource = imageLayer->imageSource();
+    writeString(imageSource.isEmpty() ? QString()
+                                      : mMapDir.relativeFilePath(imageSource));
+    writeColor(imageLayer->transparentColor());
+}
+
+void BinaryMapWriter::writeUInt8(quint8 value)
+{
+    mTables.append(char(value));
+}
+
+void BinaryMapWriter::writeUInt16(quint16 value)
+{
+    uchar bytes[2];
+    qToLittleEndian<quint16>(value, bytes);
+    mTables.append(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+}
+
+void BinaryMapWriter::writeUInt32(quint32 value)
+{
+    uchar bytes[4];
+    qToLittleEndian<quint32>(value, bytes);
+    mTables.append(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+}
+
+void BinaryMapWriter::writeUInt64(quint64 value)
+{
+    uchar bytes[8];
+    qToLittleEndian<quint64>(value, bytes);
+    mTables.append(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+}
+
+void BinaryMapWriter::writeInt32(qint32 value)
+{
+    writeUInt32(quint32(value));
+}
+
+void BinaryMapWriter::writeFloat(float value)
+{
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    writeUInt32(bits);
+}
+
+void BinaryMapWriter::writeDouble(double value)
+{
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    writeUInt64(bits);
+}
+
+void BinaryMapWriter::writeBytes(const QByteArray &bytes)
+{
+    writeUInt32(bytes.size());
+    mTables.append(bytes);
+}
+
+void BinaryMapWriter::writeString(const QString &string)
+{
+    writeBytes(string.toUtf8());
+}
+
+void BinaryMapWriter::writeColor(const QColor &color)
+{
+    writeUInt8(color.isValid());
+    writeUInt32(color.isValid() ? color.rgba() : 0);
+}
+
+void BinaryMapWriter::writeProperties(const Properties &properties)
+{
+    writeUInt32(properties.size());
+
+    Properties::const_iterator it = properties.constBegin();
+    Properties::const_iterator it_end = properties.constEnd();
+    for (; it != it_end; ++it) {
+        writeString(it.key());
+        writeString(it.value());
+    }
+}
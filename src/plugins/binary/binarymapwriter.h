@@ -0,0 +1,107 @@
+/*
+ * Binary Map Format Tiled Plugin
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BINARYMAPWRITER_H
+#define BINARYMAPWRITER_H
+
+#include "gidmapper.h"
+
+#include <QCoreApplication>
+#include <QDir>
+
+class QColor;
+class QIODevice;
+
+namespace Tiled {
+class ImageLayer;
+class Layer;
+class Map;
+class ObjectGroup;
+class Properties;
+class TileLayer;
+class Tileset;
+}
+
+namespace Binary {
+
+/**
+ * Writes a map in the binary map format. See binarymapformat.h for a
+ * description of the format.
+ */
+class BinaryMapWriter
+{
+    Q_DECLARE_TR_FUNCTIONS(BinaryMapWriter)
+
+public:
+    BinaryMapWriter();
+
+    /**
+     * Sets whether the chunks of tile layer data are zlib compressed.
+     * Uncompressed chunks can be used in place when the file is memory
+     * mapped, so they load faster at the cost of a larger file.
+     *
+     * Enabled by default.
+     */
+    void setCompressionEnabled(bool enabled) { mCompressionEnabled = enabled; }
+    bool isCompressionEnabled() const { return mCompressionEnabled; }
+
+    /**
+     * Writes the given \a map to the \a device. The \a mapDir is used to
+     * store references to external files relative to the map.
+     *
+     * Returns false and sets errorString() when writing failed.
+     */
+    bool write(const Tiled::Map *map, QIODevice *device, const QDir &mapDir);
+
+    /**
+     * Returns the last error, if any.
+     */
+    QString errorString() const { return mError; }
+
+private:
+    void writeTileset(const Tiled::Tileset *tileset, unsigned firstGid);
+    void writeLayer(const Tiled::Layer *layer);
+    void writeTileLayer(const Tiled::TileLayer *tileLayer);
+    void writeObjectGroup(const Tiled::ObjectGroup *objectGroup);
+    void writeImageLayer(const Tiled::ImageLayer *imageLayer);
+
+    void writeUInt8(quint8 value);
+    void writeUInt16(quint16 value);
+    void writeUInt32(quint32 value);
+    void writeUInt64(quint64 value);
+    void writeInt32(qint32 value);
+    void writeFloat(float value);
+    void writeDouble(double value);
+    void writeBytes(const QByteArray &bytes);
+    void writeString(const QString &string);
+    void writeColor(const QColor &color);
+    void writeProperties(const Tiled::Properties &properties);
+
+    bool mCompressionEnabled;
+    QDir mMapDir;
+    Tiled::GidMapper mGidMapper;
+    QByteArray mTables;
+    QByteArray mData;
+    QString mError;
+};
+
+} // namespace Binary
+
+#endif // BINARYMAPWRITER_H
@@ -0,0 +1,106 @@
+/*
+ * Binary Map Format Tiled Plugin
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "binaryplugin.h"
+
+#include "binarymapformat.h"
+#include "binarymapreader.h"
+#include "binarymapwriter.h"
+
+#include "map.h"
+#include "tilelayer.h"
+
+#include <QFile>
+#include <QFileInfo>
+
+#include <cstring>
+
+using namespace Binary;
+
+BinaryPlugin::BinaryPlugin()
+{
+}
+
+Tiled::Map *BinaryPlugin::read(const QString &fileName)
+{
+    BinaryMapReader reader;
+    Tiled::Map *map = reader.read(fileName);
+
+    if (!map)
+        mError = reader.errorString();
+
+    return map;
+}
+
+bool BinaryPlugin::supportsFile(const QString &fileName) const
+{
+    if (!fileName.endsWith(QLatin1String(".tmb"), Qt::CaseInsensitive))
+        return false;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    char magic[sizeof(Format::Magic)];
+    return file.read(magic, sizeof(magic)) == sizeof(magic) &&
+            std::memcmp(magic, Format::Magic, sizeof(magic)) == 0;
+}
+
+bool BinaryPlugin::write(const Tiled::Map *map, const QString &fileName)
+{
+    // Lazily loaded tile layers may still refer to the file being replaced
+    foreach (const Tiled::Layer *layer, map->layers())
+        if (layer->isTileLayer())
+            static_cast<const Tiled::TileLayer*>(layer)->loadCells();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        mError = tr("Could not open file for writing.");
+        return false;
+    }
+
+    // Like for TMX files, the layer data format of the map determines
+    // whether the tile layer data is compressed
+    const Tiled::Map::LayerDataFormat format = map->layerDataFormat();
+
+    BinaryMapWriter writer;
+    writer.setCompressionEnabled(format == Tiled::Map::Base64Gzip ||
+                                 format == Tiled::Map::Base64Zlib);
+    if (!writer.write(map, &file, QFileInfo(fileName).dir())) {
+        mError = writer.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+QString BinaryPlugin::nameFilter() const
+{
+    return tr("Tiled binary map files (*.tmb)");
+}
+
+QString BinaryPlugin::errorString() const
+{
+    return mError;
+}
+
+#if QT_VERSION < 0x050000
+Q_EXPORT_PLUGIN2(Binary, BinaryPlugin)
+#endif
@@ -3,12 +3,14 @@ include(../plugin.pri)
 DEFINES += JSON_LIBRARY
 
 SOURCES += jsonplugin.cpp \
+    jsonstream.cpp \
     qjsonparser/json.cpp \
     varianttomapconverter.cpp \
     maptovariantconverter.cpp
 
 HEADERS += jsonplugin.h \
     json_global.h \
+    jsonstream.h \
     qjsonparser/json.h \
     varianttomapconverter.h \
     maptovariantconverter.h
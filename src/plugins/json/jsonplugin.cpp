@@ -21,6 +21,7 @@
 
 #include "jsonplugin.h"
 
+#include "jsonstream.h"
 #include "maptovariantconverter.h"
 #include "varianttomapconverter.h"
 
@@ -28,7 +29,8 @@
 
 #include <QFile>
 #include <QFileInfo>
-#include <QTextStream>
+
+#include <climits>
 
 using namespace Json;
 
@@ -36,33 +38,147 @@ JsonPlugin::JsonPlugin()
 {
 }
 
+/**
+ * Reads a layer, reading the tile layer data straight into a GidArray.
+ */
+static bool readLayer(JsonStreamReader &reader, QVariant &layer)
+{
+    if (!reader.readStartObject())
+        return false;
+
+    QVariantMap layerVariantMap;
+    QString key;
+    while (reader.readNextKey(key)) {
+        QVariant value;
+        if (key == QLatin1String("data") && reader.isArrayNext()) {
+            GidArray gidArray;
+            if (!reader.readGidArray(gidArray))
+                return false;
+            value = QVariant::fromValue(gidArray);
+        } else if (!reader.readValue(value)) {
+            return false;
+        }
+        layerVariantMap.insert(key, value);
+    }
+    if (reader.atError())
+        return false;
+
+    layer = layerVariantMap;
+    return true;
+}
+
+/**
+ * Reads the map from the stream. All values are read as QVariants, except
+ * for the tile layer data.
+ */
+static bool readMap(JsonStreamReader &reader, QVariant &map)
+{
+    if (!reader.readStartObject())
+        return false;
+
+    QVariantMap mapVariantMap;
+    QString key;
+    while (reader.readNextKey(key)) {
+        QVariant value;
+        if (key == QLatin1String("layers") && reader.isArrayNext()) {
+            reader.readStartArray();
+
+            QVariantList layers;
+            while (reader.hasNextElement()) {
+                QVariant layer;
+                if (!readLayer(reader, layer))
+                    return false;
+                layers.append(layer);
+            }
+            if (reader.atError())
+                return false;
+
+            value = layers;
+        } else if (!reader.readValue(value)) {
+            return false;
+        }
+        mapVariantMap.insert(key, value);
+    }
+    if (reader.atError())
+        return false;
+
+    map = mapVariantMap;
+    return reader.readEndOfDocument();
+}
+
+/**
+ * Returns whether the JSON \a data is in UTF-16 or UTF-32, judging by the
+ * byte order mark or the pattern of nulls in the first bytes.
+ */
+static bool isWideEncoding(const char *data, int size)
+{
+    if (size < 2)
+        return false;
+    if ((data[0] == '\xFE' && data[1] == '\xFF') ||
+            (data[0] == '\xFF' && data[1] == '\xFE'))
+        return true;
+    return data[0] == 0 || data[1] == 0;
+}
+
 Tiled::Map *JsonPlugin::read(const QString &fileName)
 {
     QFile file(fileName);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    if (!file.open(QIODevice::ReadOnly)) {
         mError = tr("Could not open file for reading.");
         return 0;
     }
 
-    JsonReader reader;
-    QByteArray contents = file.readAll();
-    if (fileName.endsWith(".js") && contents.size() > 0 && contents[0] != '{') {
+    // Parse straight from the mapped file when possible
+    QByteArray contents;
+    const char *data = 0;
+    int size = 0;
+
+    if (file.size() <= INT_MAX) {
+        if (const uchar *mapped = file.map(0, file.size())) {
+            data = reinterpret_cast<const char*>(mapped);
+            size = int(file.size());
+        }
+    }
+    if (!data) {
+        contents = file.readAll();
+        data = contents.constData();
+        size = contents.size();
+    }
+
+    if (fileName.endsWith(".js") && size > 0 && data[0] != '{') {
         // Scan past JSONP prefix; look for an open curly at the start of the line
-        int i = contents.indexOf(QLatin1String("\n{"));
+        const QByteArray raw = QByteArray::fromRawData(data, size);
+        int i = raw.indexOf("\n{");
         if (i > 0) {
-            contents.remove(0, i);
-            contents = contents.trimmed(); // potential trailing whitespace
-            if (contents.endsWith(';')) contents.chop(1);
-            if (contents.endsWith(')')) contents.chop(1);
+            data += i;
+            size -= i;
+
+            // Trim potential trailing whitespace, semicolon and parenthesis
+            while (size > 0 && QChar::fromLatin1(data[size - 1]).isSpace())
+                --size;
+            if (size > 0 && data[size - 1] == ';') --size;
+            if (size > 0 && data[size - 1] == ')') --size;
         }
     }
-    reader.parse(contents);
 
-    const QVariant variant = reader.result();
+    QVariant variant;
 
-    if (!variant.isValid()) {
-        mError = tr("Error parsing file.");
-        return 0;
+    if (isWideEncoding(data, size)) {
+        // Let the bundled parser take care of the text conversion
+        JsonReader reader;
+        reader.parse(QByteArray(data, size));
+        variant = reader.result();
+
+        if (!variant.isValid()) {
+            mError = tr("Error parsing file.");
+            return 0;
+        }
+    } else {
+        JsonStreamReader reader(data, size);
+        if (!readMap(reader, variant)) {
+            mError = tr("Error parsing file:\n%1").arg(reader.errorString());
+            return 0;
+        }
     }
 
     VariantToMapConverter converter;
@@ -85,34 +201,33 @@ bool JsonPlugin::write(const Tiled::Map *map, const QString &fileName)
     MapToVariantConverter converter;
     QVariant variant = converter.toVariant(map, QFileInfo(fileName).dir());
 
-    JsonWriter writer;
+    JsonStreamWriter writer(&file);
     writer.setAutoFormatting(true);
 
-    if (!writer.stringify(variant)) {
-        // This can only happen due to coding error
-        mError = writer.errorString();
-        return false;
-    }
-
-    QTextStream out(&file);
     bool isJsFile = fileName.endsWith(".js");
     if (isJsFile) {
         // Trim and escape name
         JsonWriter nameWriter;
         QString baseName = QFileInfo(fileName).baseName();
         nameWriter.stringify(baseName);
-        out << "(function(name,data){\n if(typeof onTileMapLoaded === 'undefined') {\n";
-        out << "  if(typeof TileMaps === 'undefined') TileMaps = {};\n";
-        out << "  TileMaps[name] = data;\n";
-        out << " } else {\n";
-        out << "  onTileMapLoaded(name,data);\n";
-        out << " }})(" << nameWriter.result() << ",\n";
+        writer.writeRaw("(function(name,data){\n if(typeof onTileMapLoaded === 'undefined') {\n");
+        writer.writeRaw("  if(typeof TileMaps === 'undefined') TileMaps = {};\n");
+        writer.writeRaw("  TileMaps[name] = data;\n");
+        writer.writeRaw(" } else {\n");
+        writer.writeRaw("  onTileMapLoaded(name,data);\n");
+        writer.writeRaw(" }})(" + nameWriter.result().toLatin1() + ",\n");
     }
-    out << writer.result();
+
+    if (!writer.write(variant)) {
+        // This can only happen due to coding error
+        mError = writer.errorString();
+        return false;
+    }
+
     if (isJsFile) {
-        out << ");";
+        writer.writeRaw(");");
     }
-    out.flush();
+    writer.flush();
 
     if (file.error() != QFile::NoError) {
         mError = tr("Error while writing file:\n%1").arg(file.errorString());
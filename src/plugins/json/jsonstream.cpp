@@ -0,0 +1,595 @@
+/*
+ * JSON Tiled Plugin
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "jsonstream.h"
+
+#include <QIODevice>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace Json;
+
+// Guards against running out of stack space on malicious input
+static const int MaxDepth = 512;
+
+// The amount of output collected before it is written to the device
+static const int WriteBufferSize = 64 * 1024;
+
+static inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+JsonStreamReader::JsonStreamReader(const char *data, int size)
+    : mBegin(data)
+    , mPos(data)
+    , mEnd(data + size)
+{
+    // Skip the UTF-8 byte order mark
+    if (size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+        mPos += 3;
+}
+
+bool JsonStreamReader::isArrayNext()
+{
+    skipWhitespace();
+    return mPos < mEnd && *mPos == '[';
+}
+
+bool JsonStreamReader::readStartObject()
+{
+    skipWhitespace();
+    if (mPos == mEnd || *mPos != '{')
+        return setError(tr("Expected an object"));
+
+    ++mPos;
+    mFirstElement.append(true);
+    return true;
+}
+
+bool JsonStreamReader::readNextKey(QString &key)
+{
+    if (!readSeparator('}'))
+        return false;
+
+    skipWhitespace();
+    if (!readString(key))
+        return false;
+
+    skipWhitespace();
+    if (mPos == mEnd || *mPos != ':')
+        return setError(tr("Expected ':'"));
+
+    ++mPos;
+    return true;
+}
+
+bool JsonStreamReader::readStartArray()
+{
+    skipWhitespace();
+    if (mPos == mEnd || *mPos != '[')
+        return setError(tr("Expected an array"));
+
+    ++mPos;
+    mFirstElement.append(true);
+    return true;
+}
+
+bool JsonStreamReader::hasNextElement()
+{
+    return readSeparator(']');
+}
+
+bool JsonStreamReader::readValue(QVariant &value)
+{
+    if (mFirstElement.size() > MaxDepth)
+        return setError(tr("Document is nested too deeply"));
+
+    skipWhitespace();
+    if (mPos == mEnd)
+        return setError(tr("Unexpected end of file"));
+
+    switch (*mPos) {
+    case '{': {
+        readStartObject();
+
+        QVariantMap map;
+        QString key;
+        while (readNextKey(key)) {
+            QVariant memberValue;
+            if (!readValue(memberValue))
+                return false;
+            map.insert(key, memberValue);
+        }
+        if (atError())
+            return false;
+
+        value = map;
+        return true;
+    }
+    case '[': {
+        readStartArray();
+
+        QVariantList list;
+        while (hasNextElement()) {
+            QVariant element;
+            if (!readValue(element))
+                return false;
+            list.append(element);
+        }
+        if (atError())
+            return false;
+
+        value = list;
+        return true;
+    }
+    case '"': {
+        QString string;
+        if (!readString(string))
+            return false;
+        value = string;
+        return true;
+    }
+    case 't':
+        value = true;
+        return readLiteral("true");
+    case 'f':
+        value = false;
+        return readLiteral("false");
+    case 'n':
+        value = QVariant();
+        return readLiteral("null");
+    default:
+        if (*mPos == '-' || isDigit(*mPos))
+            return readNumber(value);
+    }
+
+    return setError(tr("Unexpected character '%1'").arg(QLatin1Char(*mPos)));
+}
+
+bool JsonStreamReader::readGidArray(GidArray &array)
+{
+    if (!readStartArray())
+        return false;
+
+    QVector<unsigned> &gids = array.gids;
+    gids.clear();
+
+    while (hasNextElement()) {
+        skipWhitespace();
+
+        const char *start = mPos;
+        quint64 gid = 0;
+        while (mPos < mEnd && isDigit(*mPos)) {
+            gid = gid * 10 + (*mPos - '0');
+            if (gid > 0xFFFFFFFFu)
+                return setError(tr("Invalid tile ID"));
+            ++mPos;
+        }
+
+        if (mPos < mEnd && (*mPos == '.' || *mPos == 'e' || *mPos == 'E')) {
+            // Not a plain integer, but it may still represent one
+            mPos = start;
+            QVariant number;
+            if (!readNumber(number))
+                return false;
+
+            const double value = number.toDouble();
+            if (value < 0 || value > 0xFFFFFFFFu || value != std::floor(value))
+                return setError(tr("Invalid tile ID"));
+
+            gid = quint64(value);
+        } else if (mPos == start) {
+            return setError(tr("Expected a tile ID"));
+        }
+
+        gids.append(unsigned(gid));
+    }
+
+    return !atError();
+}
+
+bool JsonStreamReader::readEndOfDocument()
+{
+    skipWhitespace();
+    if (mPos != mEnd)
+        return setError(tr("Unexpected data after the document"));
+    return true;
+}
+
+void JsonStreamReader::skipWhitespace()
+{
+    while (mPos < mEnd && (*mPos == ' ' || *mPos == '\n' ||
+                           *mPos == '\r' || *mPos == '\t'))
+        ++mPos;
+}
+
+/**
+ * Reads the separator before the next member or element of the current
+ * object or array. Returns false when instead the \a end character was
+ * found, or on error.
+ */
+bool JsonStreamReader::readSeparator(char end)
+{
+    Q_ASSERT(!mFirstElement.isEmpty());
+
+    skipWhitespace();
+    if (mPos == mEnd)
+        return setError(tr("Unexpected end of file"));
+
+    if (*mPos == end) {
+        ++mPos;
+        mFirstElement.removeLast();
+        return false;
+    }
+
+    if (mFirstElement.last()) {
+        mFirstElement.last() = false;
+    } else {
+        if (*mPos != ',')
+            return setError(tr("Expected ',' or '%1'").arg(QLatin1Char(end)));
+        ++mPos;
+    }
+
+    return true;
+}
+
+bool JsonStreamReader::readString(QString &string)
+{
+    if (mPos == mEnd || *mPos != '"')
+        return setError(tr("Expected a string"));
+
+    ++mPos;
+    string.clear();
+
+    const char *start = mPos;
+    forever {
+        while (mPos < mEnd && *mPos != '"' && *mPos != '\\')
+            ++mPos;
+
+        if (mPos == mEnd)
+            return setError(tr("Unterminated string"));
+
+        if (mPos != start)
+            string += QString::fromUtf8(start, mPos - start);
+
+        if (*mPos == '"') {
+            ++mPos;
+            return true;
+        }
+
+        // Handle the escape sequence
+        if (++mPos == mEnd)
+            return setError(tr("Unterminated string"));
+
+        switch (*mPos++) {
+        case '"':   string += QLatin1Char('"'); break;
+        case '\\':  string += QLatin1Char('\\'); break;
+        case '/':   string += QLatin1Char('/'); break;
+        case 'b':   string += QLatin1Char('\b'); break;
+        case 'f':   string += QLatin1Char('\f'); break;
+        case 'n':   string += QLatin1Char('\n'); break;
+        case 'r':   string += QLatin1Char('\r'); break;
+        case 't':   string += QLatin1Char('\t'); break;
+        case 'u': {
+            bool ok = mEnd - mPos >= 4;
+            ushort code = 0;
+            if (ok)
+                code = QByteArray(mPos, 4).toUShort(&ok, 16);
+            if (!ok)
+                return setError(tr("Invalid unicode escape sequence"));
+
+            // Surrogate pairs end up as two consecutive UTF-16 code units
+            string += QChar(code);
+            mPos += 4;
+            break;
+        }
+        default:
+            return setError(tr("Invalid escape sequence"));
+        }
+
+        start = mPos;
+    }
+}
+
+bool JsonStreamReader::readNumber(QVariant &value)
+{
+    const char *start = mPos;
+    bool isDouble = false;
+
+    if (mPos < mEnd && *mPos == '-')
+        ++mPos;
+
+    while (mPos < mEnd) {
+        const char c = *mPos;
+        if (c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-')
+            isDouble = true;
+        else if (!isDigit(c))
+            break;
+        ++mPos;
+    }
+
+    const QByteArray number(start, mPos - start);
+    bool ok;
+
+    if (!isDouble) {
+        const qlonglong integer = number.toLongLong(&ok);
+        if (ok) {
+            value = integer;
+            return true;
+        }
+    }
+
+    const double real = number.toDouble(&ok);
+    if (!ok)
+        return setError(tr("Invalid number"));
+
+    value = real;
+    return true;
+}
+
+bool JsonStreamReader::readLiteral(const char *literal)
+{
+    const int length = int(std::strlen(literal));
+    if (mEnd - mPos < length || std::memcmp(mPos, literal, length) != 0)
+        return setError(tr("Invalid literal"));
+
+    mPos += length;
+    return true;
+}
+
+/**
+ * Sets the error \a message, along with the line at which it occurred.
+ * Only the first error is kept. Always returns false.
+ */
+bool JsonStreamReader::setError(const QString &message)
+{
+    if (mError.isEmpty()) {
+        const int line = 1 + int(std::count(mBegin, mPos, '\n'));
+        mError = tr("%1 at line %2").arg(message).arg(line);
+    }
+    return false;
+}
+
+
+JsonStreamWriter::JsonStreamWriter(QIODevice *device)
+    : mDevice(device)
+    , mAutoFormatting(false)
+{
+}
+
+bool JsonStreamWriter::write(const QVariant &variant)
+{
+    mError.clear();
+
+    // Check the whole variant up front, since by the time an unsupported
+    // value is reached a part of the output may have been flushed already
+    if (!checkVariant(variant))
+        return false;
+
+    writeVariant(variant, 0);
+    return true;
+}
+
+void JsonStreamWriter::writeRaw(const QByteArray &data)
+{
+    mBuffer += data;
+    if (mBuffer.size() >= WriteBufferSize)
+        flush();
+}
+
+void JsonStreamWriter::flush()
+{
+    if (mBuffer.isEmpty())
+        return;
+
+    mDevice->write(mBuffer);
+    mBuffer.truncate(0);
+}
+
+/**
+ * Returns whether the \a variant can be written. When it can't, a
+ * description of each unsupported value is added to the error string.
+ */
+bool JsonStreamWriter::checkVariant(const QVariant &variant)
+{
+    switch (variant.type()) {
+    case QVariant::List:
+    case QVariant::StringList: {
+        bool ok = true;
+        foreach (const QVariant &element, variant.toList())
+            ok &= checkVariant(element);
+        return ok;
+    }
+    case QVariant::Map: {
+        bool ok = true;
+        const QVariantMap map = variant.toMap();
+        QVariantMap::const_iterator it = map.constBegin();
+        QVariantMap::const_iterator it_end = map.constEnd();
+        for (; it != it_end; ++it)
+            ok &= checkVariant(it.value());
+        return ok;
+    }
+    case QVariant::String:
+    case QVariant::ByteArray:
+    case QVariant::Double:
+    case QVariant::Bool:
+    case QVariant::Invalid:
+    case QVariant::ULongLong:
+    case QVariant::LongLong:
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::Char:
+        return true;
+    default:
+        break;
+    }
+
+    if ((int)variant.type() == (int)QMetaType::Float ||
+            variant.userType() == qMetaTypeId<GidArray>() ||
+            variant.canConvert<qlonglong>() ||
+            variant.canConvert<QString>())
+        return true;
+
+    if (!mError.isEmpty())
+        mError += QLatin1Char('\n');
+    mError += QString::fromLatin1("Unsupported type %1 (id: %2)")
+            .arg(QString::fromUtf8(variant.typeName()))
+            .arg(variant.userType());
+    return false;
+}
+
+/**
+ * Writes the \a variant, formatted the same way as JsonWriter::stringify.
+ * The variant is expected to have passed checkVariant().
+ */
+void JsonStreamWriter::writeVariant(const QVariant &variant, int depth)
+{
+    if (mBuffer.size() >= WriteBufferSize)
+        flush();
+
+    if (variant.userType() == qMetaTypeId<GidArray>()) {
+        const QVector<unsigned> gids = variant.value<GidArray>().gids;
+        mBuffer += '[';
+        for (int i = 0; i < gids.size(); ++i) {
+            if (i != 0) {
+                mBuffer += ',';
+                if (mAutoFormatting)
+                    mBuffer += ' ';
+            }
+            mBuffer += QByteArray::number(gids.at(i));
+
+            if (mBuffer.size() >= WriteBufferSize)
+                flush();
+        }
+        mBuffer += ']';
+    } else if (variant.type() == QVariant::List || variant.type() == QVariant::StringList) {
+        const QVariantList list = variant.toList();
+        mBuffer += '[';
+        for (int i = 0; i < list.size(); ++i) {
+            if (i != 0) {
+                mBuffer += ',';
+                if (mAutoFormatting)
+                    mBuffer += ' ';
+            }
+            writeVariant(list.at(i), depth + 1);
+        }
+        mBuffer += ']';
+    } else if (variant.type() == QVariant::Map) {
+        const QVariantMap map = variant.toMap();
+        if (mAutoFormatting && depth != 0) {
+            mBuffer += '\n';
+            writeIndent(depth);
+            mBuffer += "{\n";
+        } else {
+            mBuffer += '{';
+        }
+        QVariantMap::const_iterator it = map.constBegin();
+        QVariantMap::const_iterator it_end = map.constEnd();
+        for (; it != it_end; ++it) {
+            if (it != map.constBegin()) {
+                mBuffer += ',';
+                if (mAutoFormatting)
+                    mBuffer += '\n';
+            }
+            if (mAutoFormatting) {
+                writeIndent(depth);
+                mBuffer += ' ';
+            }
+            writeString(it.key());
+            mBuffer += ':';
+            writeVariant(it.value(), depth + 1);
+        }
+        if (mAutoFormatting) {
+            mBuffer += '\n';
+            writeIndent(depth);
+        }
+        mBuffer += '}';
+    } else if (variant.type() == QVariant::String || variant.type() == QVariant::ByteArray) {
+        writeString(variant.toString());
+    } else if (variant.type() == QVariant::Double || (int)variant.type() == (int)QMetaType::Float) {
+        const double d = variant.toDouble();
+        if (qIsFinite(d))
+            mBuffer += QByteArray::number(d, 'g', 15);
+        else
+            mBuffer += "null";
+    } else if (variant.type() == QVariant::Bool) {
+        mBuffer += variant.toBool() ? "true" : "false";
+    } else if (variant.type() == QVariant::Invalid) {
+        mBuffer += "null";
+    } else if (variant.type() == QVariant::ULongLong) {
+        mBuffer += QByteArray::number(variant.toULongLong());
+    } else if (variant.type() == QVariant::LongLong) {
+        mBuffer += QByteArray::number(variant.toLongLong());
+    } else if (variant.type() == QVariant::Int) {
+        mBuffer += QByteArray::number(variant.toInt());
+    } else if (variant.type() == QVariant::UInt) {
+        mBuffer += QByteArray::number(variant.toUInt());
+    } else if (variant.type() == QVariant::Char) {
+        writeString(QString(variant.toChar()));
+    } else if (variant.canConvert<qlonglong>()) {
+        mBuffer += QByteArray::number(variant.toLongLong());
+    } else {
+        Q_ASSERT(variant.canConvert<QString>());
+        writeString(variant.toString());
+    }
+}
+
+/**
+ * Writes the \a string in quotes, escaped the same way as by JsonWriter.
+ * Non-ASCII characters are escaped as well, so the output is plain ASCII.
+ */
+void JsonStreamWriter::writeString(const QString &string)
+{
+    mBuffer += '"';
+
+    const QChar *c = string.constData();
+    const QChar *end = c + string.length();
+    for (; c != end; ++c) {
+        const ushort u = c->unicode();
+        switch (u) {
+        case '\b':  mBuffer += "\\b"; break;
+        case '\f':  mBuffer += "\\f"; break;
+        case '\n':  mBuffer += "\\n"; break;
+        case '\r':  mBuffer += "\\r"; break;
+        case '\t':  mBuffer += "\\t"; break;
+        case '"':   mBuffer += "\\\""; break;
+        case '\\':  mBuffer += "\\\\"; break;
+        case '/':   mBuffer += "\\/"; break;
+        default:
+            if (u > 127) {
+                mBuffer += "\\u";
+                mBuffer += QByteArray::number(u, 16).rightJustified(4, '0');
+            } else {
+                mBuffer += char(u);
+            }
+        }
+    }
+
+    mBuffer += '"';
+}
+
+void JsonStreamWriter::writeIndent(int depth)
+{
+    for (int i = 0; i < depth; ++i)
+        mBuffer += "    ";
+}
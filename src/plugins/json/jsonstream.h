@@ -0,0 +1,172 @@
+/*
+ * JSON Tiled Plugin
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JSONSTREAM_H
+#define JSONSTREAM_H
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QMetaType>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+class QIODevice;
+
+namespace Json {
+
+/**
+ * An array of global tile IDs. Used to pass the data of a tile layer between
+ * the streaming reader or writer and the map converters, without boxing
+ * each tile in a QVariant.
+ */
+struct GidArray
+{
+    QVector<unsigned> gids;
+};
+
+/**
+ * A pull-based reader for UTF-8 encoded JSON. The caller walks through the
+ * document by asking for the next key or array element, and decides for
+ * each value whether to read it as a QVariant or, in case of large arrays
+ * of tile IDs, straight into a GidArray.
+ *
+ * When any function returns false, check atError() to tell the end of an
+ * object or array apart from a parse error.
+ */
+class JsonStreamReader
+{
+    Q_DECLARE_TR_FUNCTIONS(JsonStreamReader)
+
+public:
+    JsonStreamReader(const char *data, int size);
+
+    bool atError() const { return !mError.isEmpty(); }
+    QString errorString() const { return mError; }
+
+    /**
+     * Returns whether the next value is an array, without reading it.
+     */
+    bool isArrayNext();
+
+    /**
+     * Reads the start of an object. Use readNextKey() to go through its
+     * members.
+     */
+    bool readStartObject();
+
+    /**
+     * Reads the key of the next member of the current object into \a key.
+     * The value has to be read next. Returns false at the end of the object.
+     */
+    bool readNextKey(QString &key);
+
+    /**
+     * Reads the start of an array. Use hasNextElement() to go through its
+     * elements.
+     */
+    bool readStartArray();
+
+    /**
+     * Returns whether there is another element in the current array, which
+     * then has to be read next. Returns false at the end of the array.
+     */
+    bool hasNextElement();
+
+    /**
+     * Reads the next value, converting JSON types to QVariant types in the
+     * same way as JsonReader.
+     */
+    bool readValue(QVariant &value);
+
+    /**
+     * Reads an array of unsigned 32-bit integers, like the data of a tile
+     * layer, into \a array.
+     */
+    bool readGidArray(GidArray &array);
+
+    /**
+     * Makes sure nothing but whitespace follows the parsed document.
+     */
+    bool readEndOfDocument();
+
+private:
+    void skipWhitespace();
+    bool readSeparator(char end);
+    bool readString(QString &string);
+    bool readNumber(QVariant &value);
+    bool readLiteral(const char *literal);
+    bool setError(const QString &message);
+
+    const char *mBegin;
+    const char *mPos;
+    const char *mEnd;
+    QVector<bool> mFirstElement;    // One entry per open object or array
+    QString mError;
+};
+
+/**
+ * Writes a QVariant as JSON straight to a device, producing the same output
+ * as JsonWriter. Besides the types supported by JsonWriter, it writes a
+ * GidArray as an array of numbers.
+ */
+class JsonStreamWriter
+{
+public:
+    explicit JsonStreamWriter(QIODevice *device);
+
+    void setAutoFormatting(bool enable) { mAutoFormatting = enable; }
+    bool autoFormatting() const { return mAutoFormatting; }
+
+    /**
+     * Writes the given \a variant. Returns false when it contains
+     * unsupported types, in which case nothing is written.
+     */
+    bool write(const QVariant &variant);
+
+    /**
+     * Writes raw bytes, for example to wrap the JSON in a JavaScript file.
+     */
+    void writeRaw(const QByteArray &data);
+
+    /**
+     * Writes any buffered data to the device.
+     */
+    void flush();
+
+    QString errorString() const { return mError; }
+
+private:
+    bool checkVariant(const QVariant &variant);
+    void writeVariant(const QVariant &variant, int depth);
+    void writeString(const QString &string);
+    void writeIndent(int depth);
+
+    QIODevice *mDevice;
+    QByteArray mBuffer;
+    bool mAutoFormatting;
+    QString mError;
+};
+
+} // namespace Json
+
+Q_DECLARE_METATYPE(Json::GidArray)
+
+#endif // JSONSTREAM_H
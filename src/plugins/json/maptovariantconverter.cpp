@@ -22,6 +22,7 @@
 #include "maptovariantconverter.h"
 
 #include "imagelayer.h"
+#include "jsonstream.h"
 #include "map.h"
 #include "mapobject.h"
 #include "objectgroup.h"
@@ -199,12 +200,22 @@ QVariant MapToVariantConverter::toVariant(const TileLayer *tileLayer) const
 
     addLayerAttributes(tileLayerVariant, tileLayer);
 
-    QVariantList tileVariants;
-    for (int y = 0; y < tileLayer->height(); ++y)
-        for (int x = 0; x < tileLayer->width(); ++x)
-            tileVariants << mGidMapper.cellToGid(tileLayer->cellAt(x, y));
+    const int width = tileLayer->width();
+    const int height = tileLayer->height();
 
-    tileLayerVariant["data"] = tileVariants;
+    GidArray gidArray;
+    gidArray.gids.resize(width * height);
+    QVector<Cell> rowCells(width);
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x)
+            rowCells[x] = tileLayer->cellAt(x, y);
+
+        mGidMapper.cellsToGids(rowCells.constData(),
+                               gidArray.gids.data() + y * width, width);
+    }
+
+    tileLayerVariant["data"] = QVariant::fromValue(gidArray);
     return tileLayerVariant;
 }
 
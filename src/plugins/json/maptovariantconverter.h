@@ -31,7 +31,7 @@ namespace Json {
 
 /**
  * Converts Map instances to QVariant. Meant to be used together with
- * JsonWriter.
+ * JsonStreamWriter, since the tile layer data is stored as GidArray.
  */
 class MapToVariantConverter
 {
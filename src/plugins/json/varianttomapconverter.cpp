@@ -22,6 +22,7 @@
 #include "varianttomapconverter.h"
 
 #include "imagelayer.h"
+#include "jsonstream.h"
 #include "map.h"
 #include "mapobject.h"
 #include "objectgroup.h"
@@ -264,9 +265,38 @@ TileLayer *VariantToMapConverter::toTileLayer(const QVariantMap &variantMap)
     const QString name = variantMap["name"].toString();
     const int width = variantMap["width"].toInt();
     const int height = variantMap["height"].toInt();
-    const QVariantList dataVariantList = variantMap["data"].toList();
+    const QVariant dataVariant = variantMap["data"];
 
-    if (dataVariantList.size() != width * height) {
+    GidArray gidArray;
+
+    if (dataVariant.userType() == qMetaTypeId<GidArray>()) {
+        // Read by the streaming reader
+        gidArray = dataVariant.value<GidArray>();
+    } else {
+        const QVariantList dataVariantList = dataVariant.toList();
+        if (dataVariantList.size() != width * height) {
+            mError = tr("Corrupt layer data for layer '%1'").arg(name);
+            return 0;
+        }
+
+        gidArray.gids.reserve(dataVariantList.size());
+
+        bool ok;
+        foreach (const QVariant &gidVariant, dataVariantList) {
+            const unsigned gid = gidVariant.toUInt(&ok);
+            if (!ok) {
+                const int index = gidArray.gids.size();
+                mError = tr("Unable to parse tile at (%1,%2) on layer '%3'")
+                        .arg(index % width).arg(index / width).arg(name);
+                return 0;
+            }
+            gidArray.gids.append(gid);
+        }
+    }
+
+    const QVector<unsigned> &gids = gidArray.gids;
+
+    if (gids.size() != width * height) {
         mError = tr("Corrupt layer data for layer '%1'").arg(name);
         return 0;
     }
@@ -283,27 +313,19 @@ TileLayer *VariantToMapConverter::toTileLayer(const QVariantMap &variantMap)
     tileLayer->setOpacity(opacity);
     tileLayer->setVisible(visible);
 
-    int x = 0;
-    int y = 0;
-    bool ok;
+    QVector<Cell> rowCells(width);
 
-    foreach (const QVariant &gidVariant, dataVariantList) {
-        const unsigned gid = gidVariant.toUInt(&ok);
-        if (!ok) {
-            mError = tr("Unable to parse tile at (%1,%2) on layer '%3'")
-                    .arg(x).arg(y).arg(tileLayer->name());
+    for (int y = 0; y < height; ++y) {
+        const unsigned *rowGids = gids.constData() + y * width;
+        const int converted = mGidMapper.gidsToCells(rowGids, rowCells.data(),
+                                                     width);
+        if (converted < width) {
+            mError = tr("Invalid tile: %1").arg(rowGids[converted]);
             return 0;
         }
 
-        const Cell cell = mGidMapper.gidToCell(gid, ok);
-
-        tileLayer->setCell(x, y, cell);
-
-        x++;
-        if (x >= tileLayer->width()) {
-            x = 0;
-            y++;
-        }
+        for (int x = 0; x < width; ++x)
+            tileLayer->setCell(x, y, rowCells.at(x));
     }
 
     return tileLayer.take();
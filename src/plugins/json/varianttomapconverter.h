@@ -40,7 +40,8 @@ namespace Json {
 
 /**
  * Converts a QVariant to a Map instance. Meant to be used together with
- * JsonReader.
+ * JsonStreamReader or JsonReader. The tile layer data can be either a
+ * GidArray or a list of numbers.
  */
 class VariantToMapConverter
 {
@@ -107,11 +107,8 @@ ObjectGroup *AbstractObjectTool::currentObjectGroup() const
 
 MapObjectItem *AbstractObjectTool::topMostObjectItemAt(QPointF pos) const
 {
-    foreach (QGraphicsItem *item, mMapScene->items(pos)) {
-        if (MapObjectItem *objectItem = dynamic_cast<MapObjectItem*>(item))
-            return objectItem;
-    }
-    return 0;
+    const QList<MapObjectItem*> items = mMapScene->objectItemsAt(pos);
+    return items.isEmpty() ? 0 : items.first();
 }
 
 void AbstractObjectTool::duplicateObjects()
@@ -30,10 +30,12 @@ namespace Internal {
 AddRemoveLayer::AddRemoveLayer(MapDocument *mapDocument,
                                int index,
                                Layer *layer)
-    : mMapDocument(mapDocument)
+    : MemoryConsumingCommand(mapDocument)
+    , mMapDocument(mapDocument)
     , mLayer(layer)
     , mIndex(index)
 {
+    updateMemoryUsage();
 }
 
 AddRemoveLayer::~AddRemoveLayer()
@@ -47,6 +49,7 @@ void AddRemoveLayer::addLayer()
 
     mMapDocument->layerModel()->insertLayer(mIndex, mLayer);
     mLayer = 0;
+    updateMemoryUsage();
 
     // Insertion below or at the current layer increases current layer index
     if (mIndex <= currentLayer)
@@ -58,11 +61,17 @@ void AddRemoveLayer::removeLayer()
     const int currentLayer = mMapDocument->currentLayerIndex();
 
     mLayer = mMapDocument->layerModel()->takeLayerAt(mIndex);
+    updateMemoryUsage();
 
     // Removal below the current layer decreases the current layer index
     if (mIndex < currentLayer)
         mMapDocument->setCurrentLayerIndex(currentLayer - 1);
 }
 
+qint64 AddRemoveLayer::computeMemoryUsage() const
+{
+    return sizeof(*this) + (mLayer ? layerMemoryUsage(mLayer) : 0);
+}
+
 } // namespace Internal
 } // namespace Tiled
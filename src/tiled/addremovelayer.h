@@ -21,6 +21,8 @@
 #ifndef ADDREMOVELAYER_H
 #define ADDREMOVELAYER_H
 
+#include "undocommands.h"
+
 #include <QCoreApplication>
 #include <QUndoCommand>
 
@@ -35,7 +37,7 @@ class MapDocument;
 /**
  * Abstract base class for AddLayer and RemoveLayer.
  */
-class AddRemoveLayer : public QUndoCommand
+class AddRemoveLayer : public QUndoCommand, public MemoryConsumingCommand
 {
 public:
     AddRemoveLayer(MapDocument *mapDocument, int index, Layer *layer);
@@ -46,6 +48,8 @@ protected:
     void addLayer();
     void removeLayer();
 
+    qint64 computeMemoryUsage() const;
+
 private:
     MapDocument *mMapDocument;
     Layer *mLayer;
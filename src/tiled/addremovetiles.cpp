@@ -20,6 +20,7 @@
 
 #include "addremovetiles.h"
 
+#include "clipboardmanager.h"
 #include "mapdocument.h"
 #include "tile.h"
 #include "tileset.h"
@@ -59,6 +60,9 @@ void AddRemoveTiles::removeTiles()
     mTiles = mTileset->tiles().mid(mIndex, mCount);
     mTileset->removeTiles(mIndex, mCount);
     mMapDocument->emitTilesetChanged(mTileset);
+
+    // The tiles are deleted along with this command
+    ClipboardManager::instance()->tilesRemoved(mTiles);
 }
 
 
@@ -40,9 +40,72 @@
 
 #include <QDebug>
 
+#if QT_VERSION >= 0x050000
+#include <QtConcurrent/QtConcurrentMap>
+#else
+#include <QtCore/QtConcurrentMap>
+#endif
+
+#include <algorithm>
+
 using namespace Tiled;
 using namespace Tiled::Internal;
 
+namespace Tiled {
+
+static inline uint qHash(const Cell &cell)
+{
+    return ::qHash(cell.tile)
+            ^ (uint(cell.flippedHorizontally) << 31)
+            ^ (uint(cell.flippedVertically) << 30)
+            ^ (uint(cell.flippedAntiDiagonally) << 29);
+}
+
+namespace Internal {
+
+/**
+ * The offsets at which a rule matches within one rect of the automapped
+ * region.
+ */
+class RuleMatches
+{
+public:
+    RuleMatches() : ruleIndex(-1) {}
+    RuleMatches(int ruleIndex, const QRect &where)
+        : ruleIndex(ruleIndex)
+        , where(where)
+    {}
+
+    int ruleIndex;
+    QRect where;
+    QVector<QPoint> offsets;
+};
+
+/**
+ * Finds the matches of a rule, used with QtConcurrent::blockingMap().
+ */
+class RuleMatcher
+{
+public:
+    typedef void result_type;
+
+    explicit RuleMatcher(const AutoMapper *autoMapper)
+        : mAutoMapper(autoMapper)
+    {}
+
+    void operator()(RuleMatches &matches) const
+    {
+        matches.offsets = mAutoMapper->findMatches(matches.ruleIndex,
+                                                   matches.where);
+    }
+
+private:
+    const AutoMapper *mAutoMapper;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
 /*
  * About the order of the methods in this file.
  * The Automapper class has 3 bigger public functions, that is
@@ -58,6 +121,9 @@ AutoMapper::AutoMapper(MapDocument *workingDocument, Map *rules,
     , mMapRules(rules)
     , mLayerInputRegions(0)
     , mLayerOutputRegions(0)
+    , mRulesCompiled(false)
+    , mRulesWriteSetLayers(false)
+    , mParallelMatching(false)
     , mRulePath(rulePath)
     , mDeleteTiles(false)
     , mAutoMappingRadius(0)
@@ -341,6 +407,9 @@ bool AutoMapper::prepareAutoMap()
     if (!setupTilesets(mMapRules, mMapWork))
         return false;
 
+    if (!mRulesCompiled)
+        compileRules();
+
     return true;
 }
 
@@ -436,6 +505,10 @@ bool AutoMapper::setupTilesets(Map *src, Map *dst)
         }
         src->replaceTileset(tileset, replacement);
 
+        // The compiled rules refer to the tiles of the replaced tileset
+        if (src == mMapRules)
+            mRulesCompiled = false;
+
         tilesetManager->addReference(replacement);
         tilesetManager->removeReference(tileset);
     }
@@ -477,18 +550,69 @@ void AutoMapper::autoMap(QRegion *where)
         }
     }
 
+    Q_ASSERT(mRulesCompiled);
+    setupCellPositions(*where);
+
     // Increase the given region where the next automapper should work.
     // This needs to be done, so you can rely on the order of the rules at all
     // locations
     QRegion ret;
-    foreach (const QRect &rect, where->rects())
-        for (int i = 0; i < mRulesInput.size(); ++i) {
-            // at the moment the parallel execution does not work yet
-            // TODO: make multithreading available!
-            // either by dividing the rules or the region to multiple threads
-            ret = ret.united(applyRule(i, rect));
-        }
+    if (mParallelMatching && !mRulesWriteSetLayers && !mLayerList.isEmpty()) {
+        // Finding the matches only reads the set layers, which are not
+        // changed by applying the rules. So the matches of all rules can be
+        // found in parallel, after which they are applied in the same order
+        // as below.
+        QList<RuleMatches> pending;
+        foreach (const QRect &rect, where->rects())
+            for (int i = 0; i < mRulesInput.size(); ++i)
+                pending.append(RuleMatches(i, rect));
+
+        QtConcurrent::blockingMap(pending, RuleMatcher(this));
+
+        foreach (const RuleMatches &matches, pending)
+            ret = ret.united(applyMatches(matches.ruleIndex, matches.offsets));
+    } else {
+        foreach (const QRect &rect, where->rects())
+            for (int i = 0; i < mRulesInput.size(); ++i)
+                ret = ret.united(applyRule(i, rect));
+    }
     *where = where->united(ret);
+
+    mCellPositions.clear();
+}
+
+void AutoMapper::setupCellPositions(const QRegion &where)
+{
+    mCellPositions.clear();
+
+    // Rules are tried at all offsets where they overlap the given region, so
+    // they may look at cells up to twice their size away from it.
+    const int w = mMaxRuleSize.width();
+    const int h = mMaxRuleSize.height();
+    const QRect area = where.boundingRect().adjusted(-2 * w, -2 * h,
+                                                      2 * w, 2 * h);
+
+    QHash<QString, QSet<Cell> >::const_iterator it = mIndexedCells.begin();
+    for (; it != mIndexedCells.end(); ++it) {
+        const int index = mMapWork->indexOfLayer(it.key(),
+                                                 Layer::TileLayerType);
+        if (index == -1)
+            continue;
+
+        const QSet<Cell> &cells = it.value();
+        const TileLayer *setLayer = mMapWork->layerAt(index)->asTileLayer();
+        const QRect rect = area & QRect(0, 0,
+                                        setLayer->width(), setLayer->height());
+
+        CellPositions &positions = mCellPositions[setLayer];
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            for (int x = rect.left(); x <= rect.right(); ++x) {
+                const Cell cell = setLayer->cellAt(x, y);
+                if (!cell.isEmpty() && cells.contains(cell))
+                    positions[cell].append(QPoint(x, y));
+            }
+        }
+    }
 }
 
 const QRegion AutoMapper::getSetLayersRegion()
@@ -504,22 +628,57 @@ const QRegion AutoMapper::getSetLayersRegion()
     return result;
 }
 
-static bool compareLayerTo(const TileLayer *setLayer,
-                           const QVector<TileLayer*> &listYes,
-                           const QVector<TileLayer*> &listNo,
-                           const QRegion &ruleRegion, const QPoint &offset);
+/**
+ * The set layers used by each of the input indexes of a rule, in the order
+ * of CompiledRule::indexes. A missing set layer is stored as 0.
+ */
+typedef QVector<QVector<const TileLayer*> > SetLayers;
 
-QRect AutoMapper::applyRule(const int ruleIndex, const QRect &where)
-{
-    QRect ret;
+/**
+ * Returns whether the set layers match any of the input indexes of \a rule
+ * when it is translated by \a offset.
+ */
+static bool ruleMatches(const CompiledRule &rule,
+                        const SetLayers &setLayers,
+                        const QPoint &offset);
 
-    if (mLayerList.isEmpty())
-        return ret;
+/**
+ * Collects the offsets within \a offsets at which \a rule may match, in the
+ * order in which applyRule() visits them.
+ *
+ * This is possible when each input index of the rule has a position which
+ * only allows specific cells on a set layer whose cell positions are known.
+ * The candidates are then taken from the positions of those cells.
+ *
+ * @return false when the candidates can not be found this way, in which
+ *         case all offsets need to be checked.
+ */
+static bool findCandidates(const CompiledRule &rule,
+                           const SetLayers &setLayers,
+                           const QHash<const TileLayer*, CellPositions> &cellPositions,
+                           const QRect &offsets,
+                           QVector<QPoint> &candidates);
 
-    const QRegion ruleInput = mRulesInput.at(ruleIndex);
-    const QRegion ruleOutput = mRulesOutput.at(ruleIndex);
-    QRect rbr = ruleInput.boundingRect();
+static SetLayers findSetLayers(const Map *map, const CompiledRule &rule)
+{
+    SetLayers setLayers;
+    foreach (const QVector<CompiledInputName> &index, rule.indexes) {
+        QVector<const TileLayer*> layers;
+        foreach (const CompiledInputName &input, index) {
+            const int i = map->indexOfLayer(input.name, Layer::TileLayerType);
+            layers.append(i == -1 ? 0 : map->layerAt(i)->asTileLayer());
+        }
+        setLayers.append(layers);
+    }
+    return setLayers;
+}
 
+/**
+ * Returns the offsets at which a rule with the input bounded by \a rbr is
+ * tried, for automapping the given rect.
+ */
+static QRect ruleOffsets(const QRect &rbr, const QRect &where)
+{
     // Since the rule itself is translated, we need to adjust the borders of the
     // loops. Decrease the size at all sides by one: There must be at least one
     // tile overlap to the rule.
@@ -529,6 +688,20 @@ QRect AutoMapper::applyRule(const int ruleIndex, const QRect &where)
     const int maxX = where.right() - rbr.left() + rbr.width() - 1;
     const int maxY = where.bottom() - rbr.top() + rbr.height() - 1;
 
+    return QRect(QPoint(minX, minY), QPoint(maxX, maxY));
+}
+
+QRect AutoMapper::applyRule(const int ruleIndex, const QRect &where)
+{
+    QRect ret;
+
+    if (mLayerList.isEmpty())
+        return ret;
+
+    const CompiledRule &rule = mCompiledRules.at(ruleIndex);
+    const QRect offsets = ruleOffsets(rule.bounds, where);
+    const SetLayers setLayers = findSetLayers(mMapWork, rule);
+
     // In this list of regions it is stored which parts or the map have already
     // been altered by exactly this rule. We store all the altered parts to
     // make sure there are no overlaps of the same rule applied to
@@ -538,80 +711,97 @@ QRect AutoMapper::applyRule(const int ruleIndex, const QRect &where)
         for (int i = 0; i < mMapWork->layerCount(); i++)
             appliedRegions.append(QRegion());
 
-    for (int y = minY; y <= maxY; ++y)
-    for (int x = minX; x <= maxX; ++x) {
-        bool anymatch = false;
-        foreach (const QString &index, mInputRules.indexes) {
-            const InputIndex &ii = mInputRules[index];
+    QVector<QPoint> candidates;
+    if (findCandidates(rule, setLayers, mCellPositions, offsets, candidates)) {
+        foreach (const QPoint &offset, candidates)
+            if (ruleMatches(rule, setLayers, offset))
+                applyRuleAt(ruleIndex, offset, appliedRegions, ret);
+    } else {
+        for (int y = offsets.top(); y <= offsets.bottom(); ++y)
+        for (int x = offsets.left(); x <= offsets.right(); ++x) {
+            const QPoint offset(x, y);
+            if (ruleMatches(rule, setLayers, offset))
+                applyRuleAt(ruleIndex, offset, appliedRegions, ret);
+        }
+    }
 
-            bool allLayerNamesMatch = true;
-            foreach (const QString &name, ii.names) {
-                const int i = mMapWork->indexOfLayer(name, Layer::TileLayerType);
-                if (i == -1) {
-                    allLayerNamesMatch = false;
-                } else {
-                    const TileLayer *setLayer = mMapWork->layerAt(i)->asTileLayer();
-                    allLayerNamesMatch &= compareLayerTo(setLayer,
-                                                         ii[name].listYes,
-                                                         ii[name].listNo,
-                                                         ruleInput,
-                                                         QPoint(x, y));
-                }
-            }
-            if (allLayerNamesMatch) {
-                anymatch = true;
-                break;
-            }
+    return ret;
+}
+
+QVector<QPoint> AutoMapper::findMatches(int ruleIndex,
+                                        const QRect &where) const
+{
+    QVector<QPoint> matches;
+
+    const CompiledRule &rule = mCompiledRules.at(ruleIndex);
+    const QRect offsets = ruleOffsets(rule.bounds, where);
+    const SetLayers setLayers = findSetLayers(mMapWork, rule);
+
+    QVector<QPoint> candidates;
+    if (findCandidates(rule, setLayers, mCellPositions, offsets, candidates)) {
+        foreach (const QPoint &offset, candidates)
+            if (ruleMatches(rule, setLayers, offset))
+                matches.append(offset);
+    } else {
+        for (int y = offsets.top(); y <= offsets.bottom(); ++y)
+        for (int x = offsets.left(); x <= offsets.right(); ++x) {
+            const QPoint offset(x, y);
+            if (ruleMatches(rule, setLayers, offset))
+                matches.append(offset);
         }
+    }
 
-        if (anymatch) {
-            int r = 0;
-            // choose by chance which group of rule_layers should be used:
-            if (mLayerList.size() > 1)
-                r = qrand() % mLayerList.size();
+    return matches;
+}
 
-            if (!mNoOverlappingRules) {
-                copyMapRegion(ruleOutput, QPoint(x, y), mLayerList.at(r));
-                ret = ret.united(rbr.translated(QPoint(x, y)));
-                continue;
-            }
+QRect AutoMapper::applyMatches(int ruleIndex, const QVector<QPoint> &matches)
+{
+    QRect ret;
 
-            bool missmatch = false;
-            RuleOutput *translationTable = mLayerList.at(r);
-            QList<Layer*> layers = translationTable->keys();
+    if (mLayerList.isEmpty())
+        return ret;
 
-            // check if there are no overlaps within this rule.
-            QVector<QRegion> ruleRegionInLayer;
-            for (int i = 0; i < layers.size(); ++i) {
-                Layer *layer = layers.at(i);
+    // see applyRule()
+    QList<QRegion> appliedRegions;
+    if (mNoOverlappingRules)
+        for (int i = 0; i < mMapWork->layerCount(); i++)
+            appliedRegions.append(QRegion());
 
-                QRegion appliedPlace;
-                TileLayer *tileLayer = layer->asTileLayer();
-                if (tileLayer)
-                    appliedPlace = tileLayer->region();
-                else
-                    appliedPlace = tileRegionOfObjectGroup(layer->asObjectGroup());
+    foreach (const QPoint &offset, matches)
+        applyRuleAt(ruleIndex, offset, appliedRegions, ret);
 
-                ruleRegionInLayer.append(appliedPlace.intersected(ruleOutput));
-                if (appliedRegions.at(i).intersects(
-                            ruleRegionInLayer[i].translated(x, y))) {
-                    missmatch = true;
-                    break;
-                }
-            }
-            if (missmatch)
-                continue;
+    return ret;
+}
 
-            copyMapRegion(ruleOutput, QPoint(x, y), mLayerList.at(r));
-            ret = ret.united(rbr.translated(QPoint(x, y)));
-            for (int i = 0; i < translationTable->size(); ++i) {
-                appliedRegions[i] +=
-                        ruleRegionInLayer[i].translated(x, y);
-            }
-        }
+void AutoMapper::applyRuleAt(int ruleIndex, const QPoint &offset,
+                             QList<QRegion> &appliedRegions, QRect &ret)
+{
+    const QRegion &ruleOutput = mRulesOutput.at(ruleIndex);
+    const CompiledRule &rule = mCompiledRules.at(ruleIndex);
+
+    int r = 0;
+    // choose by chance which group of rule_layers should be used:
+    if (mLayerList.size() > 1)
+        r = qrand() % mLayerList.size();
+
+    if (!mNoOverlappingRules) {
+        copyMapRegion(ruleOutput, offset, mLayerList.at(r));
+        ret = ret.united(rule.bounds.translated(offset));
+        return;
     }
 
-    return ret;
+    // check if there are no overlaps within this rule.
+    const QVector<QRegion> &ruleRegionInLayer = rule.outputRegions.at(r);
+    for (int i = 0; i < ruleRegionInLayer.size(); ++i) {
+        if (appliedRegions.at(i).intersects(
+                    ruleRegionInLayer.at(i).translated(offset)))
+            return;
+    }
+
+    copyMapRegion(ruleOutput, offset, mLayerList.at(r));
+    ret = ret.united(rule.bounds.translated(offset));
+    for (int i = 0; i < ruleRegionInLayer.size(); ++i)
+        appliedRegions[i] += ruleRegionInLayer.at(i).translated(offset);
 }
 
 /**
@@ -639,13 +829,14 @@ static QVector<Cell> cellsInRegion(const QVector<TileLayer*> &list,
 /**
  * This function is one of the core functions for understanding the
  * automapping.
- * In this function a certain region (of the set layer) is compared to
- * several other layers (ruleSet and ruleNotSet).
+ * In this function the conditions a rule puts on a set layer are compiled
+ * from several other layers (ruleSet and ruleNotSet), so that they can
+ * quickly be checked for each offset by inputMatches().
  * This comparision will determine if a rule of automapping matches,
  * so if this rule is applied at this region given
  * by a QRegion and Offset given by a QPoint.
  *
- * This compares the tile layer setLayer to several others given
+ * The conditions compare the tile layer setLayer to several others given
  * in the QList listYes (ruleSet) and OList listNo (ruleNotSet).
  * The tile layer setLayer is examined at QRegion ruleRegion + offset
  * The tile layers within listYes and listNo are examined at QRegion ruleRegion.
@@ -693,99 +884,302 @@ static QVector<Cell> cellsInRegion(const QVector<TileLayer*> &list,
  *      It was not added to the case, when having only listNo layers to
  *      avoid total symmetrie between those lists.
  *
- * If all positions are considered good, return true.
- * return false otherwise.
- *
- * @return bool, if the tile layer matches the given list of layers.
+ * If all positions are considered good, the set layer matches.
+ * Positions at which any tile is considered good are left out of the
+ * compiled conditions, apart from needing to be within the set layer.
  */
-static bool compareLayerTo(const TileLayer *setLayer,
-                           const QVector<TileLayer*> &listYes,
-                           const QVector<TileLayer*> &listNo,
-                           const QRegion &ruleRegion, const QPoint &offset)
+static CompiledInputName compileInputName(const QString &name,
+                                          const InputIndexName &lists,
+                                          const QRegion &ruleRegion)
 {
-    if (listYes.isEmpty() && listNo.isEmpty())
-        return false;
+    const QVector<TileLayer*> &listYes = lists.listYes;
+    const QVector<TileLayer*> &listNo = lists.listNo;
+
+    CompiledInputName compiled;
+    compiled.name = name;
 
+    if (listYes.isEmpty() && listNo.isEmpty()) {
+        compiled.neverMatches = true;
+        return compiled;
+    }
+
+    // this is only used in the case where only listYes has layers
+    // it is needed for the exception mentioned above
     QVector<Cell> cells;
-    if (listYes.isEmpty())
-        cells = cellsInRegion(listNo, ruleRegion);
     if (listNo.isEmpty())
         cells = cellsInRegion(listYes, ruleRegion);
 
     foreach (const QRect &rect, ruleRegion.rects()) {
         for (int x = rect.left(); x <= rect.right(); ++x) {
             for (int y = rect.top(); y <= rect.bottom(); ++y) {
-                // this is only used in the case where only one list has layers
-                // it is needed for the exception mentioned above
-                bool ruleDefinedListYes = false;
+                CellCondition condition;
+                condition.pos = QPoint(x, y);
 
-                bool matchListYes = false;
-                bool matchListNo  = false;
+                foreach (const TileLayer *comparedTileLayer, listYes) {
+                    if (!comparedTileLayer->contains(x, y)) {
+                        compiled.neverMatches = true;
+                        return compiled;
+                    }
+
+                    const Cell c2 = comparedTileLayer->cellAt(x, y);
+                    if (!c2.isEmpty() && !condition.allowed.contains(c2))
+                        condition.allowed.append(c2);
+                }
+                foreach (const TileLayer *comparedTileLayer, listNo) {
+                    if (!comparedTileLayer->contains(x, y)) {
+                        compiled.neverMatches = true;
+                        return compiled;
+                    }
+
+                    const Cell c2 = comparedTileLayer->cellAt(x, y);
+                    if (!c2.isEmpty() && !condition.forbidden.contains(c2))
+                        condition.forbidden.append(c2);
+                }
 
-                if (!setLayer->contains(x + offset.x(), y + offset.y()))
-                    return false;
+                // when there is no tile at all in the listYes layers,
+                // consider all tiles valid, or all tiles except the used
+                // ones when there are only listYes layers.
+                condition.anyAllowed = condition.allowed.isEmpty();
+                if (listNo.isEmpty() && condition.anyAllowed)
+                    condition.forbidden = cells;
 
-                const Cell &c1 = setLayer->cellAt(x + offset.x(),
-                                                  y + offset.y());
+                if (!condition.anyAllowed || !condition.forbidden.isEmpty())
+                    compiled.conditions.append(condition);
+            }
+        }
+    }
 
-                // ruleDefined will be set when there is a tile in at least
-                // one layer. if there is a tile in at least one layer, only
-                // the given tiles in the different listYes layers are valid.
-                // if there is given no tile at all in the listYes layers,
-                // consider all tiles valid.
+    return compiled;
+}
 
-                foreach (const TileLayer *comparedTileLayer, listYes) {
+/**
+ * Returns whether the conditions of \a input are fulfilled by \a setLayer,
+ * when the rule with the input region made up of \a rects is translated by
+ * \a offset.
+ */
+static bool inputMatches(const CompiledInputName &input,
+                         const TileLayer *setLayer,
+                         const QVector<QRect> &rects, const QPoint &offset)
+{
+    if (input.neverMatches)
+        return false;
 
-                    if (!comparedTileLayer->contains(x, y))
-                        return false;
+    // all positions of the rule need to be within the set layer
+    const QRect setLayerRect(0, 0, setLayer->width(), setLayer->height());
+    foreach (const QRect &rect, rects)
+        if (!setLayerRect.contains(rect.translated(offset)))
+            return false;
 
-                    const Cell &c2 = comparedTileLayer->cellAt(x, y);
-                    if (!c2.isEmpty())
-                        ruleDefinedListYes = true;
+    foreach (const CellCondition &condition, input.conditions) {
+        const Cell c1 = setLayer->cellAt(condition.pos + offset);
 
-                    if (!c2.isEmpty() && c1 == c2)
-                        matchListYes = true;
-                }
-                foreach (const TileLayer *comparedTileLayer, listNo) {
+        if (!condition.anyAllowed && !condition.allowed.contains(c1))
+            return false;
+        if (condition.forbidden.contains(c1))
+            return false;
+    }
+
+    return true;
+}
+
+static bool ruleMatches(const CompiledRule &rule,
+                        const SetLayers &setLayers,
+                        const QPoint &offset)
+{
+    for (int i = 0; i < rule.indexes.size(); ++i) {
+        const QVector<CompiledInputName> &index = rule.indexes.at(i);
+
+        bool allLayerNamesMatch = true;
+        for (int j = 0; j < index.size() && allLayerNamesMatch; ++j) {
+            const TileLayer *setLayer = setLayers.at(i).at(j);
+            allLayerNamesMatch = setLayer && inputMatches(index.at(j),
+                                                          setLayer,
+                                                          rule.rects,
+                                                          offset);
+        }
+        if (allLayerNamesMatch)
+            return true;
+    }
+    return false;
+}
+
+static bool scanOrder(const QPoint &a, const QPoint &b)
+{
+    return a.y() < b.y() || (a.y() == b.y() && a.x() < b.x());
+}
+
+static bool findCandidates(const CompiledRule &rule,
+                           const SetLayers &setLayers,
+                           const QHash<const TileLayer*, CellPositions> &cellPositions,
+                           const QRect &offsets,
+                           QVector<QPoint> &candidates)
+{
+    if (!rule.usesCandidates)
+        return false;
 
-                    if (!comparedTileLayer->contains(x, y))
-                        return false;
+    for (int i = 0; i < rule.indexes.size(); ++i) {
+        const QVector<CompiledInputName> &index = rule.indexes.at(i);
 
-                    const Cell &c2 = comparedTileLayer->cellAt(x, y);
+        // Pick the condition with the fewest matching cells in the set layer
+        const CellCondition *anchor = 0;
+        const CellPositions *anchorPositions = 0;
+        int anchorCount = 0;
+        bool canMatch = true;
 
-                    if (!c2.isEmpty() && c1 == c2)
-                        matchListNo = true;
-                }
+        for (int j = 0; j < index.size() && canMatch; ++j) {
+            const TileLayer *setLayer = setLayers.at(i).at(j);
+            if (!setLayer || index.at(j).neverMatches) {
+                canMatch = false;
+                break;
+            }
 
-                // when there are only layers in the listNo
-                // check only if these layers are unmatched
-                // no need to check explicitly the exception in this case.
-                if (listYes.isEmpty()) {
-                    if (matchListNo)
-                        return false;
-                    else
-                        continue;
+            QHash<const TileLayer*, CellPositions>::const_iterator it =
+                    cellPositions.find(setLayer);
+            if (it == cellPositions.end())
+                continue;
+
+            const CellPositions &positions = it.value();
+            const QVector<CellCondition> &conditions = index.at(j).conditions;
+            for (int k = 0; k < conditions.size(); ++k) {
+                const CellCondition &condition = conditions.at(k);
+                if (condition.anyAllowed)
+                    continue;
+
+                int count = 0;
+                foreach (const Cell &cell, condition.allowed)
+                    count += positions.value(cell).size();
+
+                if (!anchor || count < anchorCount) {
+                    anchor = &condition;
+                    anchorPositions = &positions;
+                    anchorCount = count;
                 }
-                // when there are only layers in the listYes
-                // check if these layers are matched, or if the exception works
-                if (listNo.isEmpty()) {
-                    if (matchListYes)
-                        continue;
-                    if (!ruleDefinedListYes && !cells.contains(c1))
+            }
+        }
+
+        if (!canMatch)
+            continue;
+        if (!anchor)
+            return false;
+
+        foreach (const Cell &cell, anchor->allowed) {
+            const QVector<QPoint> positions = anchorPositions->value(cell);
+            foreach (const QPoint &pos, positions) {
+                const QPoint offset = pos - anchor->pos;
+                if (offsets.contains(offset))
+                    candidates.append(offset);
+            }
+        }
+    }
+
+    qSort(candidates.begin(), candidates.end(), scanOrder);
+    candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                     candidates.end());
+    return true;
+}
+
+void AutoMapper::compileRules()
+{
+    mCompiledRules.clear();
+    mIndexedCells.clear();
+    mMaxRuleSize = QSize(0, 0);
+
+    // Set layers that are also written to may change while the rules are
+    // applied, so the positions of their cells can not be looked up.
+    mIndexableSetLayers = mInputRules.names;
+    mRulesWriteSetLayers = false;
+    QHash<Layer*, QRegion> outputLayerRegions;
+    foreach (const RuleOutput *translationTable, mLayerList) {
+        foreach (Layer *layer, translationTable->keys()) {
+            if (outputLayerRegions.contains(layer))
+                continue;
+
+            TileLayer *tileLayer = layer->asTileLayer();
+            if (tileLayer) {
+                QString name = layer->name();
+                const int pos = name.indexOf(QLatin1Char('_')) + 1;
+                name = name.right(name.length() - pos);
+                if (mIndexableSetLayers.remove(name))
+                    mRulesWriteSetLayers = true;
+
+                outputLayerRegions.insert(layer, tileLayer->region());
+            } else {
+                outputLayerRegions.insert(layer, tileRegionOfObjectGroup(
+                                              layer->asObjectGroup()));
+            }
+        }
+    }
+
+    for (int i = 0; i < mRulesInput.size(); ++i) {
+        const QRegion &ruleInput = mRulesInput.at(i);
+        const QRegion &ruleOutput = mRulesOutput.at(i);
+
+        CompiledRule rule;
+        rule.bounds = ruleInput.boundingRect();
+        rule.rects = ruleInput.rects();
+        mMaxRuleSize = mMaxRuleSize.expandedTo(rule.bounds.size());
+
+        foreach (const QString &index, mInputRules.indexes) {
+            const InputIndex &ii = mInputRules[index];
+
+            QVector<CompiledInputName> names;
+            foreach (const QString &name, ii.names)
+                names.append(compileInputName(name, ii[name], ruleInput));
+            rule.indexes.append(names);
+        }
+
+        // Candidates can be looked up when each input index that may match
+        // has a condition on an indexable set layer
+        rule.usesCandidates = true;
+        foreach (const QVector<CompiledInputName> &names, rule.indexes) {
+            bool hasAnchor = false;
+            bool neverMatches = false;
+            foreach (const CompiledInputName &input, names) {
+                neverMatches |= input.neverMatches;
+                if (!mIndexableSetLayers.contains(input.name))
+                    continue;
+                foreach (const CellCondition &condition, input.conditions)
+                    hasAnchor |= !condition.anyAllowed;
+            }
+            if (!hasAnchor && !neverMatches)
+                rule.usesCandidates = false;
+        }
+
+        // Any of the conditions may be chosen as anchor, so the positions of
+        // all their allowed cells are needed
+        if (rule.usesCandidates) {
+            foreach (const QVector<CompiledInputName> &names, rule.indexes) {
+                foreach (const CompiledInputName &input, names) {
+                    if (!mIndexableSetLayers.contains(input.name))
                         continue;
-                    return false;
+
+                    foreach (const CellCondition &condition, input.conditions) {
+                        if (condition.anyAllowed)
+                            continue;
+
+                        QSet<Cell> &cells = mIndexedCells[input.name];
+                        foreach (const Cell &cell, condition.allowed)
+                            cells.insert(cell);
+                    }
                 }
+            }
+        }
 
-                // there are layers in both lists:
-                // no need to consider ruleDefinedListXXX
-                if ((matchListYes || !ruleDefinedListYes) && !matchListNo)
-                    continue;
-                else
-                    return false;
+        if (mNoOverlappingRules) {
+            foreach (const RuleOutput *translationTable, mLayerList) {
+                QVector<QRegion> regions;
+                foreach (Layer *layer, translationTable->keys()) {
+                    const QRegion &appliedPlace = outputLayerRegions[layer];
+                    regions.append(appliedPlace.intersected(ruleOutput));
+                }
+                rule.outputRegions.append(regions);
             }
         }
+
+        mCompiledRules.append(rule);
     }
-    return true;
+
+    mRulesCompiled = true;
 }
 
 void AutoMapper::copyMapRegion(const QRegion &region, QPoint offset,
@@ -921,6 +1315,9 @@ void AutoMapper::cleanUpRulesMap()
     cleanUpRuleMapLayers();
     mRulesInput.clear();
     mRulesOutput.clear();
+    mCompiledRules.clear();
+    mIndexedCells.clear();
+    mRulesCompiled = false;
 }
 
 void AutoMapper::cleanUpRuleMapLayers()
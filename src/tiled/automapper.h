@@ -21,6 +21,9 @@
 #ifndef AUTOMAPPER_H
 #define AUTOMAPPER_H
 
+#include "tilelayer.h"
+
+#include <QHash>
 #include <QMap>
 #include <QList>
 
@@ -69,6 +72,85 @@ public:
     QString index;
 };
 
+/**
+ * A single position of a rule input, compiled from the listYes and listNo
+ * layers of one input layer name.
+ *
+ * The cell found in the set layer at \a pos (translated by the offset of the
+ * match) needs to be one of \a allowed, unless \a anyAllowed is set. It may
+ * never be one of \a forbidden.
+ */
+class CellCondition
+{
+public:
+    CellCondition() : anyAllowed(true) {}
+
+    QPoint pos;
+    bool anyAllowed;
+    QVector<Cell> allowed;
+    QVector<Cell> forbidden;
+};
+
+/**
+ * The conditions one rule puts on the set layer with the given \a name.
+ */
+class CompiledInputName
+{
+public:
+    CompiledInputName() : neverMatches(false) {}
+
+    QString name;
+    bool neverMatches;
+    QVector<CellCondition> conditions;
+};
+
+/**
+ * A rule compiled from the rules map. This is what applyRule() works with,
+ * so the input layers do not need to be looked at for every position that is
+ * checked.
+ */
+class CompiledRule
+{
+public:
+    CompiledRule() : usesCandidates(false) {}
+
+    /**
+     * The bounding rect of the input region of the rule.
+     */
+    QRect bounds;
+
+    /**
+     * The rects making up the input region of the rule. All of them need to
+     * be within the set layers for the rule to match.
+     */
+    QVector<QRect> rects;
+
+    /**
+     * Whether the offsets at which the rule may match are looked up from the
+     * cell positions, rather than found by trying all offsets. Set when each
+     * input index has a condition on a set layer that is indexed.
+     */
+    bool usesCandidates;
+
+    /**
+     * One entry per input index. A rule matches when all names of at least
+     * one of the indexes match.
+     */
+    QVector<QVector<CompiledInputName> > indexes;
+
+    /**
+     * For each translation table in mLayerList, the part of the output
+     * region actually covered by each of its layers. Only used when
+     * mNoOverlappingRules is set.
+     */
+    QVector<QVector<QRegion> > outputRegions;
+};
+
+/**
+ * The positions of all cells of a set layer, looked up by cell.
+ */
+typedef QHash<Cell, QVector<QPoint> > CellPositions;
+
 
 /**
  * This class does all the work for the automapping feature.
@@ -141,7 +223,17 @@ public:
      */
     QString warningString() const { return mWarning; }
 
+    /**
+     * Sets whether the matches of all rules may be found in parallel before
+     * applying them. This is only done when no rule writes to a layer that
+     * is used as input, so the result is the same as without it.
+     */
+    void setParallelMatching(bool enabled) { mParallelMatching = enabled; }
+    bool isParallelMatchingEnabled() const { return mParallelMatching; }
+
 private:
+    friend class RuleMatcher;
+
     /**
      * Reads the map properties of the rulesmap.
      * @return returns true when anything is ok, false when errors occured.
@@ -184,6 +276,19 @@ private:
      */
     bool setupTilesets(Map *src, Map *dst);
 
+    /**
+     * Compiles the rules found by setupRuleList() into mCompiledRules.
+     * Needs to be done after setupTilesets(), since that may replace the
+     * tilesets used by the rules map.
+     */
+    void compileRules();
+
+    /**
+     * Fills mCellPositions with the positions of the cells listed in
+     * mIndexedCells, within the area around \a where that rules may look at.
+     */
+    void setupCellPositions(const QRegion &where);
+
     /**
      * Returns the conjunction of of all regions of all setlayers
      */
@@ -237,6 +342,28 @@ private:
      */
     QRect applyRule(const int ruleIndex, const QRect &where);
 
+    /**
+     * Copies the output of the rule at \a ruleIndex to \a offset, unless
+     * this would overlap an earlier application of the same rule while
+     * mNoOverlappingRules is set. Used by applyRule().
+     */
+    void applyRuleAt(int ruleIndex, const QPoint &offset,
+                     QList<QRegion> &appliedRegions, QRect &ret);
+
+    /**
+     * Returns the offsets at which the rule at \a ruleIndex matches within
+     * \a where, in the order in which they are applied. Only reads the
+     * working map, so it may be called from multiple threads.
+     */
+    QVector<QPoint> findMatches(int ruleIndex, const QRect &where) const;
+
+    /**
+     * Applies the rule at \a ruleIndex at each of the given \a matches, as
+     * found by findMatches().
+     * @return the rectangle where the rule actually got applied
+     */
+    QRect applyMatches(int ruleIndex, const QVector<QPoint> &matches);
+
     /**
      * Cleans up the data structes filled by setupRuleMapLayers(),
      * so the next rule can be processed.
@@ -329,6 +456,44 @@ private:
      */
     QList<RuleOutput*> mLayerList;
 
+    /**
+     * The rules from mRulesInput, mRulesOutput and mInputRules, compiled by
+     * compileRules(). Valid while mRulesCompiled is set.
+     */
+    QVector<CompiledRule> mCompiledRules;
+    bool mRulesCompiled;
+
+    /**
+     * The names of the set layers which are not written to by any rule, so
+     * their cell positions stay valid during autoMap().
+     */
+    QSet<QString> mIndexableSetLayers;
+
+    /**
+     * The cells that rules using candidate lookup look for, per set layer
+     * name. Only the positions of these cells are stored in mCellPositions.
+     */
+    QHash<QString, QSet<Cell> > mIndexedCells;
+
+    /**
+     * Whether any rule writes to a set layer, in which case applying a rule
+     * may change where rules match.
+     */
+    bool mRulesWriteSetLayers;
+
+    bool mParallelMatching;
+
+    /**
+     * The size of the largest input region of any rule.
+     */
+    QSize mMaxRuleSize;
+
+    /**
+     * Where each of the cells in mIndexedCells can be found in the set
+     * layers. Only valid during autoMap().
+     */
+    QHash<const TileLayer*, CellPositions> mCellPositions;
+
     /**
      * store the name of the processed rules file, to have detailed
      * error messages available
@@ -31,6 +31,7 @@ using namespace Tiled::Internal;
 AutoMapperWrapper::AutoMapperWrapper(MapDocument *mapDocument,
                                      QVector<AutoMapper*> autoMapper,
                                      QRegion *where)
+    : MemoryConsumingCommand(mapDocument)
 {
     mMapDocument = mapDocument;
     Map *map = mMapDocument->map();
@@ -85,6 +86,8 @@ AutoMapperWrapper::AutoMapperWrapper(MapDocument *mapDocument,
     foreach (AutoMapper *a, autoMapper) {
         a->cleanAll();
     }
+
+    updateMemoryUsage();
 }
 
 AutoMapperWrapper::~AutoMapperWrapper()
@@ -119,6 +122,16 @@ void AutoMapperWrapper::redo()
 
 }
 
+qint64 AutoMapperWrapper::computeMemoryUsage() const
+{
+    qint64 usage = sizeof(*this);
+    foreach (const TileLayer *layer, mLayersBefore)
+        usage += layerMemoryUsage(layer);
+    foreach (const TileLayer *layer, mLayersAfter)
+        usage += layerMemoryUsage(layer);
+    return usage;
+}
+
 void AutoMapperWrapper::patchLayer(int layerIndex, TileLayer *layer)
 {
     Map *map = mMapDocument->map();
@@ -22,6 +22,7 @@
 #define AUTOMAPPERWRAPPER_H
 
 #include "automapper.h"
+#include "undocommands.h"
 
 #include <QUndoCommand>
 #include <QVector>
@@ -39,7 +40,7 @@ class MapDocument;
  * This class will take a snapshot of the layers before and after the
  * automapping is done. In between instances of AutoMapper are doing the work.
  */
-class AutoMapperWrapper : public QUndoCommand
+class AutoMapperWrapper : public QUndoCommand, public MemoryConsumingCommand
 {
 public:
     AutoMapperWrapper(MapDocument *mapDocument, QVector<AutoMapper*> autoMapper,
@@ -49,6 +50,9 @@ public:
     void undo();
     void redo();
 
+protected:
+    qint64 computeMemoryUsage() const;
+
 private:
     void patchLayer(int layerIndex, TileLayer *layer);
 
@@ -30,6 +30,7 @@
 
 #include <QFileInfo>
 #include <QTextStream>
+#include <QThread>
 
 using namespace Tiled;
 using namespace Tiled::Internal;
@@ -173,6 +174,7 @@ bool AutomappingManager::loadFile(const QString &filePath)
 
             AutoMapper *autoMapper;
             autoMapper = new AutoMapper(mMapDocument, rules, rulePath);
+            autoMapper->setParallelMatching(QThread::idealThreadCount() > 1);
 
             mWarning += autoMapper->warningString();
             const QString error = autoMapper->errorString(); 
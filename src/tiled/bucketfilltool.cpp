@@ -98,8 +98,9 @@ void BucketFillTool::tilePositionChanged(const QPoint &tilePos)
 
     // Optimization: we don't need to recalculate the fill area
     // if the new mouse position is still over the filled region
-    // and the shift modifier hasn't changed.
-    if (!mFillRegion.contains(tilePos) || shiftPressed != mLastShiftStatus || mIsRandom) {
+    // and the shift modifier hasn't changed, since the cell under the mouse
+    // is then of the same kind as the one the region was computed for.
+    if (!mFillRegion.contains(tilePos) || shiftPressed != mLastShiftStatus) {
 
         // Clear overlay to make way for a new one
         clearOverlay();
@@ -145,19 +146,17 @@ void BucketFillTool::tilePositionChanged(const QPoint &tilePos)
                                      fillBounds.height());
     }
 
-    // Paint the new overlay
-    TilePainter tilePainter(mapDocument(), mFillOverlay);
-    if (!mIsRandom) {
-        if (fillRegionChanged)
+    if (fillRegionChanged) {
+        // Paint the new overlay
+        TilePainter tilePainter(mapDocument(), mFillOverlay);
+        if (!mIsRandom) {
             tilePainter.drawStamp(mStamp, mFillRegion);
-    } else {
-        TileLayer *stamp = getRandomTileLayer(mFillRegion);
-        tilePainter.drawStamp(stamp, mFillRegion);
-        delete stamp;
-        fillRegionChanged = true;
-    }
+        } else {
+            TileLayer *stamp = getRandomTileLayer(mFillRegion);
+            tilePainter.drawStamp(stamp, mFillRegion);
+            delete stamp;
+        }
 
-    if (fillRegionChanged) {
         // Update the brush item to draw the overlay
         brushItem()->setTileLayer(mFillOverlay);
     }
@@ -24,6 +24,8 @@
 #include "map.h"
 #include "mapdocument.h"
 #include "mapobject.h"
+#include "mapreader.h"
+#include "mapwriter.h"
 #include "maprenderer.h"
 #include "mapview.h"
 #include "objectgroup.h"
@@ -32,8 +34,11 @@
 #include "tmxmapwriter.h"
 #include "tile.h"
 #include "tilelayer.h"
+#include "tileset.h"
+#include "tilesetmanager.h"
 
 #include <QApplication>
+#include <QBuffer>
 #include <QClipboard>
 #include <QMimeData>
 #include <QSet>
@@ -44,6 +49,159 @@ static const char * const TMX_MIMETYPE = "text/tmx";
 using namespace Tiled;
 using namespace Tiled::Internal;
 
+namespace Tiled {
+namespace Internal {
+
+/**
+ * Keeps the copied map in memory, so that pasting within the application
+ * needs no serialization. The TMX representation is only written when
+ * another application asks for it.
+ *
+ * The tilesets used by the map are kept alive by adding a reference to them
+ * in the TilesetManager. The tiles are not, so the map is dropped when tiles
+ * it refers to are removed from their tileset.
+ */
+class MapMimeData : public QMimeData
+{
+public:
+    explicit MapMimeData(Map *map)
+        : mMap(map)
+    {
+        TilesetManager::instance()->addReferences(mMap->tilesets());
+    }
+
+    ~MapMimeData()
+    {
+        dropMap();
+    }
+
+    const Map *map() const { return mMap; }
+
+    /**
+     * Releases the map and its tilesets without writing the TMX data.
+     */
+    void dropMap()
+    {
+        if (!mMap)
+            return;
+
+        TilesetManager::instance()->removeReferences(mMap->tilesets());
+        delete mMap;
+        mMap = 0;
+    }
+
+    /**
+     * Writes the TMX data and releases the map and its tilesets. Needs to be
+     * called before the TilesetManager is deleted, since the clipboard data
+     * may outlive it.
+     */
+    void releaseMap()
+    {
+        if (!mMap)
+            return;
+
+        setData(QLatin1String(TMX_MIMETYPE), tmxData());
+        dropMap();
+    }
+
+    QStringList formats() const
+    {
+        if (mMap)
+            return QStringList(QLatin1String(TMX_MIMETYPE));
+        return QMimeData::formats();
+    }
+
+    bool hasFormat(const QString &mimeType) const
+    {
+        return formats().contains(mimeType);
+    }
+
+protected:
+    QVariant retrieveData(const QString &mimeType,
+                          QVariant::Type type) const
+    {
+        if (mMap && mimeType == QLatin1String(TMX_MIMETYPE))
+            return tmxData();
+        return QMimeData::retrieveData(mimeType, type);
+    }
+
+private:
+    QByteArray tmxData() const
+    {
+        if (mTmxData.isEmpty()) {
+            TmxMapWriter mapWriter;
+            mTmxData = mapWriter.toByteArray(mMap);
+        }
+        return mTmxData;
+    }
+
+    Map *mMap;
+    mutable QByteArray mTmxData;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+/**
+ * Creates a copy of the given \a map that shares its tilesets. Copying tile
+ * layers is cheap since their cells are implicitly shared.
+ */
+static Map *cloneMap(const Map *map)
+{
+    Map *clone = new Map(map->orientation(),
+                         map->width(), map->height(),
+                         map->tileWidth(), map->tileHeight());
+
+    clone->setRenderOrder(map->renderOrder());
+    clone->setBackgroundColor(map->backgroundColor());
+    clone->setProperties(map->properties());
+
+    foreach (Tileset *tileset, map->tilesets())
+        clone->addTileset(tileset);
+    foreach (const Layer *layer, map->layers())
+        clone->addLayer(layer->clone());
+
+    return clone;
+}
+
+/**
+ * Creates a copy of the given embedded \a tileset, by writing and reading it
+ * the way it is stored in a map.
+ */
+static Tileset *copyTileset(const Tileset *tileset)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+
+    MapWriter writer;
+    writer.writeTileset(tileset, &buffer);
+
+    buffer.seek(0);
+    MapReader reader;
+    return reader.readTileset(&buffer);
+}
+
+/**
+ * Returns whether any of the cells or objects of \a map refer to one of the
+ * given \a tiles.
+ */
+static bool usesTiles(const Map *map, const QSet<const Tile*> &tiles)
+{
+    foreach (const Layer *layer, map->layers()) {
+        if (const TileLayer *tileLayer = layer->asTileLayer()) {
+            for (int y = 0; y < tileLayer->height(); ++y)
+                for (int x = 0; x < tileLayer->width(); ++x)
+                    if (tiles.contains(tileLayer->cellAt(x, y).tile))
+                        return true;
+        } else if (const ObjectGroup *objectGroup = layer->asObjectGroup()) {
+            foreach (const MapObject *object, objectGroup->objects())
+                if (tiles.contains(object->cell().tile))
+                    return true;
+        }
+    }
+    return false;
+}
+
 ClipboardManager *ClipboardManager::mInstance = 0;
 
 ClipboardManager::ClipboardManager() :
@@ -55,6 +213,13 @@ ClipboardManager::ClipboardManager() :
     updateHasMap();
 }
 
+ClipboardManager::~ClipboardManager()
+{
+    // Let go of the tilesets while the TilesetManager still exists
+    if (mMapMimeData)
+        mMapMimeData->releaseMap();
+}
+
 ClipboardManager *ClipboardManager::instance()
 {
     if (!mInstance)
@@ -68,8 +233,27 @@ void ClipboardManager::deleteInstance()
     mInstance = 0;
 }
 
-Map *ClipboardManager::map() const
+Map *ClipboardManager::map(const Map *target) const
 {
+    // Skip serialization when the map was copied by this application
+    if (mMapMimeData && mMapMimeData->map() && mClipboard->ownsClipboard()) {
+        Map *map = cloneMap(mMapMimeData->map());
+
+        // Embedded tilesets belong to the map they are part of, so pasting
+        // them into another map needs a copy, like reading the TMX data
+        // would have created. External tilesets are shared anyway.
+        foreach (Tileset *tileset, map->tilesets()) {
+            if (!tileset->fileName().isEmpty())
+                continue;
+            if (target && target->tilesets().contains(tileset))
+                continue;
+            if (Tileset *copy = copyTileset(tileset))
+                map->replaceTileset(tileset, copy);
+        }
+
+        return map;
+    }
+
     const QMimeData *mimeData = mClipboard->mimeData();
     const QByteArray data = mimeData->data(QLatin1String(TMX_MIMETYPE));
     if (data.isEmpty())
@@ -79,14 +263,32 @@ Map *ClipboardManager::map() const
     return reader.fromByteArray(data);
 }
 
-void ClipboardManager::setMap(const Map *map)
+void ClipboardManager::tilesRemoved(const QList<Tile*> &tiles)
 {
-    TmxMapWriter mapWriter;
+    if (!mMapMimeData || !mMapMimeData->map())
+        return;
+
+    QSet<const Tile*> removedTiles;
+    foreach (const Tile *tile, tiles)
+        removedTiles.insert(tile);
 
-    QMimeData *mimeData = new QMimeData;
-    mimeData->setData(QLatin1String(TMX_MIMETYPE), mapWriter.toByteArray(map));
+    if (!usesTiles(mMapMimeData->map(), removedTiles))
+        return;
 
+    // The copied map can't be pasted or written without the removed tiles
+    if (mClipboard->ownsClipboard()) {
+        mClipboard->clear();
+    } else {
+        mMapMimeData->dropMap();
+        updateHasMap();
+    }
+}
+
+void ClipboardManager::setMap(const Map *map)
+{
+    MapMimeData *mimeData = new MapMimeData(cloneMap(map));
     mClipboard->setMimeData(mimeData);
+    mMapMimeData = mimeData;
 }
 
 void ClipboardManager::copySelection(const MapDocument *mapDocument)
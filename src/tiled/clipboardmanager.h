@@ -22,6 +22,7 @@
 #define CLIPBOARDMANAGER_H
 
 #include <QObject>
+#include <QPointer>
 
 class QClipboard;
 
@@ -29,10 +30,12 @@ namespace Tiled {
 
 class ObjectGroup;
 class Map;
+class Tile;
 
 namespace Internal {
 
 class MapDocument;
+class MapMimeData;
 class MapView;
 
 /**
@@ -62,14 +65,32 @@ public:
     /**
      * Retrieves the map from the clipboard. Returns 0 when there was no map or
      * loading failed.
+     *
+     * The map is meant to be pasted into \a target. Embedded tilesets that
+     * are not part of the target map are copied, so that the maps don't end
+     * up sharing them.
+     *
+     * The tilesets of the returned map may be shared with the clipboard and
+     * with open maps. Instead of deleting them, add and remove a reference
+     * through the TilesetManager.
      */
-    Map *map() const;
+    Map *map(const Map *target = 0) const;
 
     /**
-     * Sets the given map on the clipboard.
+     * Sets the given map on the clipboard. Within this application, the map
+     * is pasted without serialization. The TMX format is only produced when
+     * another application asks for it.
      */
     void setMap(const Map *map);
 
+    /**
+     * Should be called when the given \a tiles are removed from their
+     * tileset, while they still exist. Clears the clipboard when the map
+     * copied by this application refers to them, since the tiles may be
+     * deleted later.
+     */
+    void tilesRemoved(const QList<Tile*> &tiles);
+
     /**
      * Convenience method to copy the current selection to the clipboard.
      * Deals with either tile selection or object selection.
@@ -101,10 +122,12 @@ private slots:
 
 private:
     ClipboardManager();
+    ~ClipboardManager();
 
     Q_DISABLE_COPY(ClipboardManager)
 
     QClipboard *mClipboard;
+    QPointer<MapMimeData> mMapMimeData;
     bool mHasMap;
 
     static ClipboardManager *mInstance;
@@ -154,7 +154,7 @@ void DocumentManager::switchToRightDocument()
     switchToDocument((currentIndex + 1) % tabCount);
 }
 
-void DocumentManager::addDocument(MapDocument *mapDocument)
+void DocumentManager::addDocument(MapDocument *mapDocument, bool switchTo)
 {
     Q_ASSERT(mapDocument);
     Q_ASSERT(!mDocuments.contains(mapDocument));
@@ -175,8 +175,12 @@ void DocumentManager::addDocument(MapDocument *mapDocument)
     connect(mapDocument, SIGNAL(fileNameChanged()), SLOT(updateDocumentTab()));
     connect(mapDocument, SIGNAL(modifiedChanged()), SLOT(updateDocumentTab()));
 
-    switchToDocument(documentIndex);
-    centerViewOn(0, 0);
+    if (switchTo) {
+        switchToDocument(documentIndex);
+        centerViewOn(0, 0);
+    } else {
+        view->centerOn(mapDocument->renderer()->pixelToScreenCoords(0, 0));
+    }
 }
 
 void DocumentManager::closeCurrentDocument()
@@ -106,9 +106,10 @@ public:
     void switchToDocument(MapDocument *mapDocument);
 
     /**
-     * Adds the new or opened \a mapDocument to the document manager.
+     * Adds the new or opened \a mapDocument to the document manager. Unless
+     * \a switchTo is false, the document also becomes the current document.
      */
-    void addDocument(MapDocument *mapDocument);
+    void addDocument(MapDocument *mapDocument, bool switchTo = true);
 
     /**
      * Closes the current map document. Will not ask the user whether to save
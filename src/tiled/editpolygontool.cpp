@@ -420,10 +420,9 @@ void EditPolygonTool::updateSelection(const QPointF &pos,
         // Allow selecting some map objects only when there aren't any selected
         QSet<MapObjectItem*> selectedItems;
 
-        foreach (QGraphicsItem *item, mapScene()->items(rect)) {
-            MapObjectItem *mapObjectItem = dynamic_cast<MapObjectItem*>(item);
-            if (mapObjectItem)
-                selectedItems.insert(mapObjectItem);
+        foreach (MapObjectItem *mapObjectItem,
+                 mapScene()->objectItemsIntersecting(rect)) {
+            selectedItems.insert(mapObjectItem);
         }
 
 
@@ -31,7 +31,8 @@ using namespace Tiled::Internal;
 EraseTiles::EraseTiles(MapDocument *mapDocument,
                        TileLayer *tileLayer,
                        const QRegion &region)
-    : mMapDocument(mapDocument)
+    : MemoryConsumingCommand(mapDocument)
+    , mMapDocument(mapDocument)
     , mTileLayer(tileLayer)
     , mRegion(region)
     , mMergeable(false)
@@ -40,19 +41,20 @@ EraseTiles::EraseTiles(MapDocument *mapDocument,
 
     // Store the tiles that are to be erased
     const QRegion r = mRegion.translated(-mTileLayer->x(), -mTileLayer->y());
-    mErasedCells = mTileLayer->copy(r);
-}
+    mErasedCells.record(mTileLayer, r, mTileLayer->position());
 
-EraseTiles::~EraseTiles()
-{
-    delete mErasedCells;
+    updateMemoryUsage();
 }
 
 void EraseTiles::undo()
 {
     const QRect bounds = mRegion.boundingRect();
+    TileLayer *erased = mErasedCells.toTileLayer(bounds);
+
     TilePainter painter(mMapDocument, mTileLayer);
-    painter.drawCells(bounds.x(), bounds.y(), mErasedCells);
+    painter.drawCells(bounds.x(), bounds.y(), erased);
+
+    delete erased;
 }
 
 void EraseTiles::redo()
@@ -69,24 +71,26 @@ bool EraseTiles::mergeWith(const QUndoCommand *other)
           o->mMergeable))
         return false;
 
-    const QRegion combinedRegion = mRegion.united(o->mRegion);
-    if (mRegion != combinedRegion) {
-        const QRect bounds = mRegion.boundingRect();
-        const QRect combinedBounds = combinedRegion.boundingRect();
-
-        // Resize the erased tiles layer when necessary
-        if (bounds != combinedBounds) {
-            const QPoint shift = bounds.topLeft() - combinedBounds.topLeft();
-            mErasedCells->resize(combinedBounds.size(), shift);
-        }
-
-        // Copy the newly erased tiles over
-        const QRect otherBounds = o->mRegion.boundingRect();
-        const QPoint pos = otherBounds.topLeft() - combinedBounds.topLeft();
-        mErasedCells->merge(pos, o->mErasedCells);
-
-        mRegion = combinedRegion;
+    // Cells within our own region were already erased by this command
+    const QRegion newRegion = o->mRegion.subtracted(mRegion);
+    if (!newRegion.isEmpty()) {
+        mErasedCells.append(o->mErasedCells, newRegion);
+        mRegion = mRegion.united(o->mRegion);
+        updateMemoryUsage();
     }
 
     return true;
 }
+
+qint64 EraseTiles::computeMemoryUsage() const
+{
+    return sizeof(*this) +
+            mRegion.rectCount() * sizeof(QRect) +
+            mErasedCells.memoryUsage();
+}
+
+void EraseTiles::compress()
+{
+    mErasedCells.compress();
+    updateMemoryUsage();
+}
@@ -21,6 +21,7 @@
 #ifndef ERASETILES_H
 #define ERASETILES_H
 
+#include "tilelayerdelta.h"
 #include "undocommands.h"
 
 #include <QRegion>
@@ -35,14 +36,12 @@ namespace Internal {
 
 class MapDocument;
 
-class EraseTiles : public QUndoCommand
+class EraseTiles : public QUndoCommand, public MemoryConsumingCommand
 {
 public:
     EraseTiles(MapDocument *mapDocument,
                TileLayer *tileLayer,
                const QRegion &region);
-    ~EraseTiles();
-
     /**
      * Sets whether this undo command can be merged with an existing command.
      */
@@ -55,10 +54,16 @@ public:
     int id() const { return Cmd_EraseTiles; }
     bool mergeWith(const QUndoCommand *other);
 
+    // MemoryConsumingCommand
+    void compress();
+
+protected:
+    qint64 computeMemoryUsage() const;
+
 private:
     MapDocument *mMapDocument;
     TileLayer *mTileLayer;
-    TileLayer *mErasedCells;
+    TileLayerDelta mErasedCells;
     QRegion mRegion;
     bool mMergeable;
 };
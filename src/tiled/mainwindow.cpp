@@ -46,6 +46,7 @@
 #include "map.h"
 #include "mapdocument.h"
 #include "mapdocumentactionhandler.h"
+#include "maploader.h"
 #include "mapobject.h"
 #include "maprenderer.h"
 #include "mapsdock.h"
@@ -91,7 +92,9 @@
 #include <QCloseEvent>
 #include <QComboBox>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QMessageBox>
+#include <QProgressBar>
 #include <QScrollBar>
 #include <QSessionManager>
 #include <QTextStream>
@@ -126,6 +129,8 @@ MainWindow::MainWindow(QWidget *parent, Qt::WindowFlags flags)
     , mZoomable(0)
     , mZoomComboBox(new QComboBox)
     , mStatusInfoLabel(new QLabel)
+    , mLoadingProgressBar(new QProgressBar)
+    , mCancelLoadingButton(new QToolButton)
     , mAutomappingManager(new AutomappingManager(this))
     , mDocumentManager(DocumentManager::instance())
     , mQuickStampManager(new QuickStampManager(this))
@@ -418,6 +423,17 @@ MainWindow::MainWindow(QWidget *parent, Qt::WindowFlags flags)
             this, SLOT(updateStatusInfoLabel(QString)));
     statusBar()->addWidget(mCurrentLayerLabel);
 
+    mLoadingProgressBar->setMaximumWidth(200);
+    mLoadingProgressBar->setRange(0, 100);
+    mLoadingProgressBar->hide();
+    mCancelLoadingButton->setToolTip(tr("Cancel Loading"));
+    mCancelLoadingButton->setIcon(QIcon(QLatin1String(":images/16x16/window-close.png")));
+    mCancelLoadingButton->setAutoRaise(true);
+    mCancelLoadingButton->hide();
+    connect(mCancelLoadingButton, SIGNAL(clicked()), SLOT(cancelLoading()));
+    statusBar()->addPermanentWidget(mLoadingProgressBar);
+    statusBar()->addPermanentWidget(mCancelLoadingButton);
+
     // Add the 'Views and Toolbars' submenu. This needs to happen after all
     // the dock widgets and toolbars have been added to the main window.
     mViewsAndToolbarsMenu = new QAction(tr("Views and Toolbars"), this);
@@ -484,6 +500,10 @@ MainWindow::MainWindow(QWidget *parent, Qt::WindowFlags flags)
 
 MainWindow::~MainWindow()
 {
+    // Stop any maps still being loaded
+    qDeleteAll(mMapLoaders);
+    mMapLoaders.clear();
+
     mDocumentManager->closeAllDocuments();
 
     // This needs to happen before deleting the TilesetManager otherwise it may
@@ -493,12 +513,14 @@ MainWindow::~MainWindow()
     mTileCollisionEditor->setTile(0);
     mTileCollisionEditor->writeSettings();
 
+    // The clipboard may also hold references to tilesets
+    ClipboardManager::deleteInstance();
+
     TilesetManager::deleteInstance();
     DocumentManager::deleteInstance();
     Preferences::deleteInstance();
     LanguageManager::deleteInstance();
     PluginManager::deleteInstance();
-    ClipboardManager::deleteInstance();
 
     delete mUi;
 }
@@ -579,6 +601,11 @@ bool MainWindow::openFile(const QString &fileName,
     if (fileName.isEmpty())
         return false;
 
+    // The file asked for last is the one to switch to, rather than any map
+    // that was still loading or the one active in the previous session
+    mFileToActivate.clear();
+    mPendingActiveDocument.clear();
+
     // Select existing document if this file is already open
     int documentIndex = mDocumentManager->findDocument(fileName);
     if (documentIndex != -1) {
@@ -586,6 +613,12 @@ bool MainWindow::openFile(const QString &fileName,
         return true;
     }
 
+    // Switch to the map once loaded when it is already being loaded
+    if (MapLoader *loader = findMapLoader(fileName)) {
+        mFileToActivate = loader->fileName();
+        return true;
+    }
+
     TmxMapReader tmxMapReader;
 
     const PluginManager *pm = PluginManager::instance();
@@ -610,7 +643,13 @@ bool MainWindow::openFile(const QString &fileName,
                 writerPluginFileName = plugin->fileName;
         }
     } else {
-        mapReader = &tmxMapReader;
+        // Maps in the TMX format are loaded in the background. The reader
+        // plugins are not used from other threads, since they are shared.
+        if (!loadMap(fileName))
+            return false;
+
+        mFileToActivate = fileName;
+        return true;
     }
 
     Map *map = mapReader->read(fileName);
@@ -670,31 +709,194 @@ void MainWindow::openLastFiles()
         if (!(i < selectedLayer.size()))
             continue;
 
-        if (openFile(lastOpenFiles.at(i))) {
-            MapView *mapView = mDocumentManager->currentMapView();
+        const QString &fileName = lastOpenFiles.at(i);
 
-            // Restore camera to the previous position
-            qreal scale = mapScales.at(i).toDouble();
-            if (scale > 0)
-                mapView->zoomable()->setScale(scale);
+        MapViewState state;
+        state.scale = mapScales.at(i).toDouble();
+        state.scrollX = scrollX.at(i).toInt();
+        state.scrollY = scrollY.at(i).toInt();
+        state.layer = selectedLayer.at(i).toInt();
 
-            const int hor = scrollX.at(i).toInt();
-            const int ver = scrollY.at(i).toInt();
-            mapView->horizontalScrollBar()->setSliderPosition(hor);
-            mapView->verticalScrollBar()->setSliderPosition(ver);
+        if (!openFile(fileName))
+            continue;
+
+        // Maps that were still loading when the session was saved have no
+        // view state, see writeSettings()
+        if (state.scale <= 0)
+            continue;
 
-            int layer = selectedLayer.at(i).toInt();
-            if (layer > 0 && layer < mMapDocument->map()->layerCount())
-                mMapDocument->setCurrentLayerIndex(layer);
+        // Maps loaded in the background get their view restored once loaded
+        if (findMapLoader(fileName)) {
+            mPendingViewStates.insert(fileName, state);
+        } else {
+            const int documentIndex = mDocumentManager->findDocument(fileName);
+            if (documentIndex != -1) {
+                MapDocument *mapDocument =
+                        mDocumentManager->documents().at(documentIndex);
+                restoreViewState(mapDocument, state);
+            }
         }
     }
-    QString lastActiveDocument =
+
+    // The maps are activated below, once all of them have been loaded
+    mFileToActivate.clear();
+
+    mPendingActiveDocument =
             mSettings.value(QLatin1String("lastActive")).toString();
-    int documentIndex = mDocumentManager->findDocument(lastActiveDocument);
+    activatePendingDocument();
+
+    mSettings.endGroup();
+}
+
+/**
+ * Starts loading the TMX map with the given \a fileName in the background.
+ * Errors that can be detected up front are reported right away, in which
+ * case false is returned.
+ */
+bool MainWindow::loadMap(const QString &fileName)
+{
+    const QFileInfo fileInfo(fileName);
+    QString error;
+
+    if (!fileInfo.exists())
+        error = tr("File not found: %1").arg(fileName);
+    else if (!fileInfo.isReadable())
+        error = tr("Unable to read file: %1").arg(fileName);
+
+    if (!error.isEmpty()) {
+        QMessageBox::critical(this, tr("Error Opening Map"), error);
+        return false;
+    }
+
+    MapLoader *loader = new MapLoader(fileName, this);
+    connect(loader, SIGNAL(progressChanged(qint64,qint64,int)),
+            SLOT(updateLoadingProgress()));
+    connect(loader, SIGNAL(finished()), SLOT(mapLoaded()));
+
+    mMapLoaders.append(loader);
+    updateLoadingProgress();
+
+    loader->start();
+    return true;
+}
+
+MapLoader *MainWindow::findMapLoader(const QString &fileName) const
+{
+    const QString canonicalFilePath = QFileInfo(fileName).canonicalFilePath();
+    if (canonicalFilePath.isEmpty()) // file doesn't exist
+        return 0;
+
+    foreach (MapLoader *loader, mMapLoaders) {
+        QFileInfo fileInfo(loader->fileName());
+        if (fileInfo.canonicalFilePath() == canonicalFilePath)
+            return loader;
+    }
+
+    return 0;
+}
+
+/**
+ * Restores the view of the given \a mapDocument.
+ */
+void MainWindow::restoreViewState(MapDocument *mapDocument,
+                                  const MapViewState &state)
+{
+    MapView *mapView = mDocumentManager->viewForDocument(mapDocument);
+    if (!mapView)
+        return;
+
+    // Restore camera to the previous position
+    if (state.scale > 0)
+        mapView->zoomable()->setScale(state.scale);
+
+    mapView->horizontalScrollBar()->setSliderPosition(state.scrollX);
+    mapView->verticalScrollBar()->setSliderPosition(state.scrollY);
+
+    if (state.layer > 0 && state.layer < mapDocument->map()->layerCount())
+        mapDocument->setCurrentLayerIndex(state.layer);
+}
+
+/**
+ * Switches to the document that was active when Tiled was closed, once all
+ * the previously opened maps have been loaded.
+ */
+void MainWindow::activatePendingDocument()
+{
+    if (mPendingActiveDocument.isEmpty() || !mMapLoaders.isEmpty())
+        return;
+
+    int documentIndex = mDocumentManager->findDocument(mPendingActiveDocument);
     if (documentIndex != -1)
         mDocumentManager->switchToDocument(documentIndex);
 
-    mSettings.endGroup();
+    mPendingActiveDocument.clear();
+}
+
+void MainWindow::mapLoaded()
+{
+    MapLoader *loader = static_cast<MapLoader*>(sender());
+    mMapLoaders.removeOne(loader);
+    loader->deleteLater();
+    updateLoadingProgress();
+
+    const QString fileName = loader->fileName();
+    const bool restoreView = mPendingViewStates.contains(fileName);
+    const MapViewState state = mPendingViewStates.take(fileName);
+
+    // Only switch to the map when it is the file the user asked for last, so
+    // that maps loading in the background don't steal the focus
+    const bool switchTo = fileName == mFileToActivate;
+    if (switchTo)
+        mFileToActivate.clear();
+
+    if (Map *map = loader->takeMap()) {
+        MapDocument *mapDocument = new MapDocument(map, fileName);
+        addMapDocument(mapDocument, switchTo);
+        setRecentFile(fileName);
+
+        if (restoreView)
+            restoreViewState(mapDocument, state);
+    } else if (!loader->isCancelled()) {
+        QMessageBox::critical(this, tr("Error Opening Map"),
+                              loader->errorString());
+    }
+
+    activatePendingDocument();
+}
+
+void MainWindow::updateLoadingProgress()
+{
+    if (mMapLoaders.isEmpty()) {
+        mLoadingProgressBar->hide();
+        mCancelLoadingButton->hide();
+        return;
+    }
+
+    qint64 bytesRead = 0;
+    qint64 bytesTotal = 0;
+    int layerCount = 0;
+    QStringList fileNames;
+
+    foreach (const MapLoader *loader, mMapLoaders) {
+        bytesRead += loader->bytesRead();
+        bytesTotal += loader->bytesTotal();
+        layerCount += loader->layerCount();
+        fileNames.append(QFileInfo(loader->fileName()).fileName());
+    }
+
+    mLoadingProgressBar->setValue(bytesTotal > 0 ? int(bytesRead * 100 / bytesTotal)
+                                                 : 0);
+    mLoadingProgressBar->setFormat(tr("%p% (%n layer(s))", "", layerCount));
+    mLoadingProgressBar->setToolTip(tr("Loading %1")
+                                    .arg(fileNames.join(QLatin1String(", "))));
+    mLoadingProgressBar->show();
+    mCancelLoadingButton->show();
+}
+
+void MainWindow::cancelLoading()
+{
+    foreach (MapLoader *loader, mMapLoaders)
+        loader->cancel();
 }
 
 void MainWindow::openFile()
@@ -1015,20 +1217,21 @@ void MainWindow::paste()
         return;
 
     ClipboardManager *clipboardManager = ClipboardManager::instance();
-    QScopedPointer<Map> map(clipboardManager->map());
+    QScopedPointer<Map> map(clipboardManager->map(mMapDocument->map()));
     if (!map)
         return;
 
+    // The tilesets may be shared with the clipboard, so they are cleaned up
+    // by releasing our reference rather than by deleting them
+    TilesetManager *tilesetManager = TilesetManager::instance();
+    tilesetManager->addReferences(map->tilesets());
+
     // We can currently only handle maps with a single layer
     if (map->layerCount() != 1) {
-        // Need to clean up the tilesets since they didn't get an owner
-        qDeleteAll(map->tilesets());
+        tilesetManager->removeReferences(map->tilesets());
         return;
     }
 
-    TilesetManager *tilesetManager = TilesetManager::instance();
-    tilesetManager->addReferences(map->tilesets());
-
     mMapDocument->unifyTilesets(map.data());
     Layer *layer = map->layerAt(0);
 
@@ -1467,7 +1670,11 @@ void MainWindow::writeSettings()
     mSettings.endGroup();
 
     mSettings.beginGroup(QLatin1String("recentFiles"));
-    if (MapDocument *document = mDocumentManager->currentDocument())
+    if (!mFileToActivate.isEmpty())
+        mSettings.setValue(QLatin1String("lastActive"), mFileToActivate);
+    else if (!mPendingActiveDocument.isEmpty())
+        mSettings.setValue(QLatin1String("lastActive"), mPendingActiveDocument);
+    else if (MapDocument *document = mDocumentManager->currentDocument())
         mSettings.setValue(QLatin1String("lastActive"), document->fileName());
 
     QStringList fileList;
@@ -1488,6 +1695,24 @@ void MainWindow::writeSettings()
                        mapView->verticalScrollBar()->sliderPosition()));
         selectedLayer.append(QString::number(currentLayerIndex));
     }
+
+    // Remember the maps still being loaded as well. Unless their view state
+    // from the previous session is still pending, a scale of 0 marks them as
+    // having no view state.
+    foreach (const MapLoader *loader, mMapLoaders) {
+        if (loader->isCancelled())
+            continue;
+
+        const QString &fileName = loader->fileName();
+        const MapViewState state = mPendingViewStates.value(fileName);
+
+        fileList.append(fileName);
+        mapScales.append(QString::number(state.scale));
+        scrollX.append(QString::number(state.scrollX));
+        scrollY.append(QString::number(state.scrollY));
+        selectedLayer.append(QString::number(state.layer));
+    }
+
     mSettings.setValue(QLatin1String("lastOpenFiles"), fileList);
     mSettings.setValue(QLatin1String("mapScale"), mapScales);
     mSettings.setValue(QLatin1String("scrollX"), scrollX);
@@ -1523,11 +1748,11 @@ void MainWindow::updateWindowTitle()
     }
 }
 
-void MainWindow::addMapDocument(MapDocument *mapDocument)
+void MainWindow::addMapDocument(MapDocument *mapDocument, bool switchTo)
 {
-    mDocumentManager->addDocument(mapDocument);
+    mDocumentManager->addDocument(mapDocument, switchTo);
 
-    MapView *mapView = mDocumentManager->currentMapView();
+    MapView *mapView = mDocumentManager->viewForDocument(mapDocument);
     connect(mapView->zoomable(), SIGNAL(scaleChanged(qreal)),
             this, SLOT(updateZoomLabel()));
 }
@@ -1543,6 +1768,7 @@ void MainWindow::retranslateUi()
     updateWindowTitle();
 
     mRandomButton->setToolTip(tr("Random Mode"));
+    mCancelLoadingButton->setToolTip(tr("Cancel Loading"));
     mLayerMenu->setTitle(tr("&Layer"));
     mViewsAndToolbarsMenu->setText(tr("Views and Toolbars"));
     mShowTileAnimationEditor->setText(tr("Tile Animation Editor"));
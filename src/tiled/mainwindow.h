@@ -27,12 +27,14 @@
 #include "mapdocument.h"
 #include "consoledock.h"
 
+#include <QHash>
 #include <QMainWindow>
 #include <QSessionManager>
 #include <QSettings>
 
 class QComboBox;
 class QLabel;
+class QProgressBar;
 class QToolButton;
 
 namespace Ui {
@@ -53,6 +55,7 @@ class CommandButton;
 class DocumentManager;
 class LayerDock;
 class MapDocumentActionHandler;
+class MapLoader;
 class MapScene;
 class MapsDock;
 class MapView;
@@ -92,7 +95,15 @@ public:
      * When a \a reader is given, it is used to open the file. Otherwise, a
      * reader is searched using MapReaderInterface::supportsFile.
      *
-     * @return whether the file was succesfully opened
+     * TMX maps are loaded in the background, in which case the map is added
+     * once loading has finished. Only errors that can be detected up front,
+     * like a missing file, are reported right away. Other errors are
+     * reported once loading has failed.
+     *
+     * The map becomes the current document once loaded, unless another file
+     * was opened in the meantime.
+     *
+     * @return whether the file was succesfully opened, or started loading
      */
     bool openFile(const QString &fileName, MapReaderInterface *reader);
 
@@ -172,7 +183,29 @@ public slots:
     void onAnimationEditorClosed();
     void onCollisionEditorClosed();
 
+private slots:
+    void mapLoaded();
+    void updateLoadingProgress();
+    void cancelLoading();
+
 private:
+    /**
+     * The view settings of a map, restored when the map is reopened.
+     */
+    struct MapViewState
+    {
+        qreal scale;
+        int scrollX;
+        int scrollY;
+        int layer;
+    };
+
+    bool loadMap(const QString &fileName);
+    MapLoader *findMapLoader(const QString &fileName) const;
+    void restoreViewState(MapDocument *mapDocument,
+                          const MapViewState &state);
+    void activatePendingDocument();
+
     /**
       * Asks the user whether the given \a mapDocument should be saved, when
       * necessary. If it needs to ask, also makes sure that it is the current
@@ -203,7 +236,7 @@ private:
     void writeSettings();
     void readSettings();
 
-    void addMapDocument(MapDocument *mapDocument);
+    void addMapDocument(MapDocument *mapDocument, bool switchTo = true);
     QStringList recentFiles() const;
     QString fileDialogStartLocation() const;
 
@@ -228,6 +261,8 @@ private:
     Zoomable *mZoomable;
     QComboBox *mZoomComboBox;
     QLabel *mStatusInfoLabel;
+    QProgressBar *mLoadingProgressBar;
+    QToolButton *mCancelLoadingButton;
     QSettings mSettings;
     QToolButton *mRandomButton;
     CommandButton *mCommandButton;
@@ -250,6 +285,16 @@ private:
     DocumentManager *mDocumentManager;
     QuickStampManager *mQuickStampManager;
     ToolManager *mToolManager;
+
+    QList<MapLoader*> mMapLoaders;
+    QHash<QString, MapViewState> mPendingViewStates;
+    QString mPendingActiveDocument;
+
+    /**
+     * The map being loaded that becomes the current document once loaded.
+     * This is the file the user asked for last.
+     */
+    QString mFileToActivate;
 };
 
 } // namespace Internal
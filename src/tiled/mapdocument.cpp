@@ -41,6 +41,7 @@
 #include "orthogonalrenderer.h"
 #include "painttilelayer.h"
 #include "pluginmanager.h"
+#include "preferences.h"
 #include "resizemap.h"
 #include "resizetilelayer.h"
 #include "rotatemapobject.h"
@@ -52,6 +53,7 @@
 #include "tilesetmanager.h"
 #include "tileset.h"
 #include "tmxmapwriter.h"
+#include "undocommands.h"
 
 #include <QFileInfo>
 #include <QRect>
@@ -67,7 +69,9 @@ MapDocument::MapDocument(Map *map, const QString &fileName):
     mCurrentObject(map),
     mMapObjectModel(new MapObjectModel(this)),
     mTerrainModel(new TerrainModel(this, this)),
-    mUndoStack(new QUndoStack(this))
+    mUndoStack(new QUndoStack(this)),
+    mUndoMemoryUsage(0),
+    mCompressedUndoCommands(0)
 {
     switch (map->orientation()) {
     case Map::Isometric:
@@ -111,6 +115,10 @@ MapDocument::MapDocument(Map *map, const QString &fileName):
             SLOT(onTerrainRemoved(Terrain*)));
 
     connect(mUndoStack, SIGNAL(cleanChanged(bool)), SIGNAL(modifiedChanged()));
+    connect(mUndoStack, SIGNAL(indexChanged(int)),
+            SLOT(applyUndoMemoryBudget()));
+    connect(Preferences::instance(), SIGNAL(undoMemoryBudgetChanged(int)),
+            SLOT(applyUndoMemoryBudget()));
 
     // Register tileset references
     TilesetManager *tilesetManager = TilesetManager::instance();
@@ -119,6 +127,11 @@ MapDocument::MapDocument(Map *map, const QString &fileName):
 
 MapDocument::~MapDocument()
 {
+    // The undo commands report their memory usage to this document, so they
+    // need to be deleted while it is still intact
+    mUndoStack->disconnect(this);
+    delete mUndoStack;
+
     // Unregister tileset references
     TilesetManager *tilesetManager = TilesetManager::instance();
     tilesetManager->removeReferences(mMap->tilesets());
@@ -751,6 +764,31 @@ void MapDocument::onTerrainRemoved(Terrain *terrain)
         setCurrentObject(0);
 }
 
+/**
+ * Compresses the oldest commands on the undo stack until the memory used by
+ * the stack falls within the budget, or until no more commands can be
+ * compressed.
+ *
+ * The budget is not a hard limit. No commands are dropped, since QUndoStack
+ * can't remove its oldest commands. So when the compressed commands together
+ * still exceed the budget, the stack keeps growing.
+ */
+void MapDocument::applyUndoMemoryBudget()
+{
+    const qint64 megabyte = 1024 * 1024;
+    const qint64 budget = Preferences::instance()->undoMemoryBudget() * megabyte;
+
+    // Commands that were undone may get replaced. The most recent command is
+    // left alone, since it may still get merged.
+    const int last = mUndoStack->index() - 1;
+    mCompressedUndoCommands = qMin(mCompressedUndoCommands, qMax(last, 0));
+
+    while (mUndoMemoryUsage > budget && mCompressedUndoCommands < last) {
+        compressUndoCommand(mUndoStack->command(mCompressedUndoCommands));
+        ++mCompressedUndoCommands;
+    }
+}
+
 void MapDocument::deselectObjects(const QList<MapObject *> &objects)
 {
     // Unset the current object when it was part of this list of objects
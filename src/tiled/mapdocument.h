@@ -194,6 +194,20 @@ public:
      */
     QUndoStack *undoStack() const { return mUndoStack; }
 
+    /**
+     * Returns the approximate number of bytes used by the commands on the
+     * undo stack.
+     *
+     * \sa MemoryConsumingCommand
+     */
+    qint64 undoMemoryUsage() const { return mUndoMemoryUsage; }
+
+    /**
+     * Called by the undo commands when the amount of memory they use has
+     * changed by \a delta bytes.
+     */
+    void adjustUndoMemoryUsage(qint64 delta) { mUndoMemoryUsage += delta; }
+
     /**
      * Returns the selected area of tiles.
      */
@@ -372,6 +386,8 @@ private slots:
 
     void onTerrainRemoved(Terrain *terrain);
 
+    void applyUndoMemoryBudget();
+
 private:
     void setFileName(const QString &fileName);
     void deselectObjects(const QList<MapObject*> &objects);
@@ -397,6 +413,8 @@ private:
     MapObjectModel *mMapObjectModel;
     TerrainModel *mTerrainModel;
     QUndoStack *mUndoStack;
+    qint64 mUndoMemoryUsage;
+    int mCompressedUndoCommands;    /**< Commands compressed by the budget. */
 };
 
 /**
@@ -0,0 +1,206 @@
+/*
+ * maploader.cpp
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "maploader.h"
+
+#include "map.h"
+#include "mapreader.h"
+#include "tileset.h"
+#include "tilesetmanager.h"
+
+#include <QDir>
+#include <QMetaObject>
+
+#if QT_VERSION >= 0x050000
+#include <QtConcurrent/QtConcurrentRun>
+#else
+#include <QtCore/QtConcurrentRun>
+#endif
+
+namespace Tiled {
+namespace Internal {
+
+/**
+ * The reader used on the worker thread. Unlike the reader used by the
+ * TmxMapReader, it does not look up external tilesets in the TilesetManager,
+ * since the TilesetManager may only be used from the GUI thread. Instead the
+ * tilesets are shared after loading, see MapLoader::shareTilesets().
+ */
+class BackgroundMapReader : public MapReader
+{
+public:
+    explicit BackgroundMapReader(MapLoader *loader)
+        : mLoader(loader)
+    {
+        setTilesetImageLoadingDeferred(true);
+        setPixmapCreationDeferred(true);
+        setParallelLayerDecoding(true);
+    }
+
+protected:
+    /**
+     * Overridden to make sure the resolved reference is a clean path.
+     */
+    QString resolveReference(const QString &reference, const QString &mapPath)
+    {
+        QString resolved = MapReader::resolveReference(reference, mapPath);
+        return QDir::cleanPath(resolved);
+    }
+
+    /**
+     * Overridden to forward the progress to the GUI thread and to check
+     * whether loading was cancelled.
+     */
+    bool reportProgress(qint64 bytesRead, qint64 bytesTotal, int layerCount)
+    {
+        QMetaObject::invokeMethod(mLoader, "updateProgress",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(qint64, bytesRead),
+                                  Q_ARG(qint64, bytesTotal),
+                                  Q_ARG(int, layerCount));
+
+        return !mLoader->isCancelled();
+    }
+
+private:
+    MapLoader *mLoader;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+MapLoader::MapLoader(const QString &fileName, QObject *parent)
+    : QObject(parent)
+    , mFileName(fileName)
+    , mReader(new BackgroundMapReader(this))
+    , mCancelled(0)
+    , mBytesRead(0)
+    , mBytesTotal(0)
+    , mLayerCount(0)
+    , mMap(0)
+{
+    connect(&mWatcher, SIGNAL(finished()), SLOT(loadFinished()));
+}
+
+MapLoader::~MapLoader()
+{
+    cancel();
+    mWatcher.waitForFinished();
+
+    if (mMap) {
+        qDeleteAll(mMap->tilesets());
+        delete mMap;
+    }
+
+    delete mReader;
+}
+
+void MapLoader::start()
+{
+#if QT_VERSION >= 0x050000
+    mWatcher.setFuture(QtConcurrent::run(this, &MapLoader::load));
+#else
+    // Every tile holds a pixmap, even while its creation is deferred, and
+    // Qt 4 doesn't allow any pixmap outside of the GUI thread.
+    load();
+    QMetaObject::invokeMethod(this, "loadFinished", Qt::QueuedConnection);
+#endif
+}
+
+void MapLoader::cancel()
+{
+    mCancelled.fetchAndStoreOrdered(1);
+}
+
+bool MapLoader::isCancelled() const
+{
+#if QT_VERSION >= 0x050000
+    return mCancelled.load();
+#else
+    return mCancelled;
+#endif
+}
+
+Map *MapLoader::takeMap()
+{
+    Map *map = mMap;
+    mMap = 0;
+    return map;
+}
+
+/**
+ * Runs on the worker thread.
+ */
+void MapLoader::load()
+{
+    mMap = mReader->readMap(mFileName);
+    if (!mMap)
+        mError = mReader->errorString();
+}
+
+void MapLoader::updateProgress(qint64 bytesRead, qint64 bytesTotal,
+                               int layerCount)
+{
+    mBytesRead = bytesRead;
+    mBytesTotal = bytesTotal;
+    mLayerCount = layerCount;
+
+    emit progressChanged(bytesRead, bytesTotal, layerCount);
+}
+
+void MapLoader::loadFinished()
+{
+    if (mMap && isCancelled()) {
+        qDeleteAll(mMap->tilesets());
+        delete mMap;
+        mMap = 0;
+    }
+
+    if (mMap) {
+        // Pixmaps can only be created on the GUI thread
+        mReader->createDeferredPixmaps();
+        shareTilesets();
+    }
+
+    emit finished();
+}
+
+/**
+ * Replaces the external tilesets of the loaded map with the ones already
+ * loaded by the TilesetManager, the way the TmxMapReader does while reading.
+ */
+void MapLoader::shareTilesets()
+{
+    TilesetManager *manager = TilesetManager::instance();
+
+    foreach (Tileset *tileset, mMap->tilesets()) {
+        if (tileset->fileName().isEmpty())
+            continue;
+
+        Tileset *existing = manager->findTileset(tileset->fileName());
+        if (existing && existing != tileset) {
+            mMap->replaceTileset(tileset, existing);
+            delete tileset;
+        }
+    }
+}
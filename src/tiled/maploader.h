@@ -0,0 +1,128 @@
+/*
+ * maploader.h
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MAPLOADER_H
+#define MAPLOADER_H
+
+#include <QAtomicInt>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QString>
+
+namespace Tiled {
+
+class Map;
+class MapReader;
+
+namespace Internal {
+
+/**
+ * Loads a TMX map on the global thread pool, so that the user interface
+ * stays responsive while opening large maps.
+ *
+ * Progress is reported while the map is being parsed and loading can be
+ * cancelled at any time. The tileset images are not loaded by the map loader,
+ * they are loaded in the background by the TilesetManager once the map is
+ * handed to a MapDocument. Other images are read on the worker thread, but
+ * their pixmaps are only created on the GUI thread once loading has finished.
+ *
+ * Any number of map loaders can run at the same time.
+ */
+class MapLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    MapLoader(const QString &fileName, QObject *parent = 0);
+
+    /**
+     * Cancels loading and waits for the worker thread to finish. A map that
+     * was loaded but not taken is deleted.
+     */
+    ~MapLoader();
+
+    const QString &fileName() const { return mFileName; }
+
+    /**
+     * Starts loading the map. The finished() signal is emitted when done.
+     */
+    void start();
+
+    /**
+     * Requests loading to be cancelled. The finished() signal is still
+     * emitted, but no map will be available.
+     */
+    void cancel();
+
+    bool isCancelled() const;
+
+    qint64 bytesRead() const { return mBytesRead; }
+    qint64 bytesTotal() const { return mBytesTotal; }
+    int layerCount() const { return mLayerCount; }
+
+    /**
+     * Returns the loaded map and passes its ownership to the caller. Returns
+     * 0 when loading failed or was cancelled.
+     *
+     * The external tilesets of the map are shared with the tilesets already
+     * known by the TilesetManager, so the map can be passed to a MapDocument
+     * directly.
+     */
+    Map *takeMap();
+
+    /**
+     * Returns the error message when loading failed.
+     */
+    const QString &errorString() const { return mError; }
+
+signals:
+    /**
+     * Emitted regularly while the map is being parsed.
+     */
+    void progressChanged(qint64 bytesRead, qint64 bytesTotal, int layerCount);
+
+    void finished();
+
+private slots:
+    void updateProgress(qint64 bytesRead, qint64 bytesTotal, int layerCount);
+    void loadFinished();
+
+private:
+    void load();
+    void shareTilesets();
+
+    QString mFileName;
+    MapReader *mReader;
+    QFutureWatcher<void> mWatcher;
+    QAtomicInt mCancelled;
+
+    qint64 mBytesRead;
+    qint64 mBytesTotal;
+    int mLayerCount;
+
+    // Written by the worker thread, read once it has finished
+    Map *mMap;
+    QString mError;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // MAPLOADER_H
@@ -36,6 +36,7 @@
 #include "tilelayer.h"
 #include "tilelayeritem.h"
 #include "tileselectionitem.h"
+#include "tileset.h"
 #include "imagelayer.h"
 #include "imagelayeritem.h"
 #include "toolmanager.h"
@@ -62,15 +63,16 @@ MapScene::MapScene(QObject *parent):
     mUnderMouse(false),
     mCurrentModifiers(Qt::NoModifier),
     mDarkRectangle(new QGraphicsRectItem),
-    mDefaultBackgroundColor(Qt::darkGray)
+    mDefaultBackgroundColor(Qt::darkGray),
+    mAnimatedTileRegionsDirty(true)
 {
     setBackgroundBrush(mDefaultBackgroundColor);
 
     TilesetManager *tilesetManager = TilesetManager::instance();
     connect(tilesetManager, SIGNAL(tilesetChanged(Tileset*)),
             this, SLOT(tilesetChanged(Tileset*)));
-    connect(tilesetManager, SIGNAL(repaintTileset(Tileset*)),
-            this, SLOT(tilesetChanged(Tileset*)));
+    connect(tilesetManager, SIGNAL(repaintTiles(Tileset*,QList<Tile*>)),
+            this, SLOT(repaintTiles(Tileset*,QList<Tile*>)));
 
     Preferences *prefs = Preferences::instance();
     connect(prefs, SIGNAL(showGridChanged(bool)), SLOT(setGridVisible(bool)));
@@ -80,6 +82,8 @@ MapScene::MapScene(QObject *parent):
     connect(prefs, SIGNAL(highlightCurrentLayerChanged(bool)),
             SLOT(setHighlightCurrentLayer(bool)));
     connect(prefs, SIGNAL(gridColorChanged(QColor)), SLOT(update()));
+    connect(prefs, SIGNAL(tileLayerCacheEnabledChanged(bool)),
+            SLOT(tileLayerCacheEnabledChanged()));
     connect(prefs, SIGNAL(objectLineWidthChanged(qreal)),
             SLOT(setObjectLineWidth(qreal)));
 
@@ -125,6 +129,14 @@ void MapScene::setMapDocument(MapDocument *mapDocument)
                 this, SLOT(mapChanged()));
         connect(mMapDocument, SIGNAL(regionChanged(QRegion)),
                 this, SLOT(repaintRegion(QRegion)));
+        connect(mMapDocument, SIGNAL(regionChanged(QRegion)),
+                this, SLOT(updateAnimatedTileRegions(QRegion)));
+        connect(mMapDocument, SIGNAL(tileAnimationChanged(Tile*)),
+                this, SLOT(invalidateAnimatedTileRegions()));
+        connect(mMapDocument, SIGNAL(tilesetAdded(int,Tileset*)),
+                this, SLOT(invalidateAnimatedTileRegions()));
+        connect(mMapDocument, SIGNAL(tilesetRemoved(Tileset*)),
+                this, SLOT(invalidateAnimatedTileRegions()));
         connect(mMapDocument, SIGNAL(layerAdded(int)),
                 this, SLOT(layerAdded(int)));
         connect(mMapDocument, SIGNAL(layerRemoved(int)),
@@ -139,6 +151,8 @@ void MapScene::setMapDocument(MapDocument *mapDocument)
                 this, SLOT(currentLayerIndexChanged()));
         connect(mMapDocument, SIGNAL(tilesetTileOffsetChanged(Tileset*)),
                 this, SLOT(tilesetTileOffsetChanged(Tileset*)));
+        connect(mMapDocument, SIGNAL(tilesetChanged(Tileset*)),
+                this, SLOT(tilesetChanged(Tileset*)));
         connect(mMapDocument, SIGNAL(objectsInserted(ObjectGroup*,int,int)),
                 this, SLOT(objectsInserted(ObjectGroup*,int,int)));
         connect(mMapDocument, SIGNAL(objectsRemoved(QList<MapObject*>)),
@@ -171,10 +185,101 @@ void MapScene::setSelectedTool(AbstractTool *tool)
     mSelectedTool = tool;
 }
 
+QList<MapObjectItem*> MapScene::objectItemsIntersecting(const QRectF &rect) const
+{
+    QPainterPath path;
+    path.addRect(rect);
+
+    QList<MapObjectItem*> items;
+    foreach (MapObjectItem *item, objectItemCandidates(rect))
+        if (item->collidesWithPath(item->mapFromScene(path)))
+            items.append(item);
+    return items;
+}
+
+QList<MapObjectItem*> MapScene::objectItemsAt(const QPointF &pos) const
+{
+    QList<MapObjectItem*> items;
+    foreach (MapObjectItem *item, objectItemCandidates(QRectF(pos, QSizeF())))
+        if (item->contains(item->mapFromScene(pos)))
+            items.append(item);
+    return items;
+}
+
+int MapScene::visibleTileLayerCount() const
+{
+    int count = 0;
+    foreach (QGraphicsItem *item, mLayerItems)
+        if (item->isVisible() && dynamic_cast<TileLayerItem*>(item))
+            ++count;
+    return count;
+}
+
+static bool higherZValue(const MapObjectItem *a, const MapObjectItem *b)
+{
+    return a->zValue() > b->zValue();
+}
+
+/**
+ * Returns the items of the visible map objects that may intersect the given
+ * \a rect in scene coordinates, ordered from top to bottom.
+ */
+QList<MapObjectItem*> MapScene::objectItemCandidates(const QRectF &rect) const
+{
+    QList<MapObjectItem*> items;
+    if (!mMapDocument)
+        return items;
+
+    const Map *map = mMapDocument->map();
+    const MapRenderer *renderer = mMapDocument->renderer();
+
+    // Objects without size are displayed at a fixed size. On non-orthogonal
+    // maps, tile objects also cover more than their pixel bounds suggest.
+    qreal margin = 20;
+    if (map->orientation() != Map::Orthogonal) {
+        foreach (const Tileset *tileset, map->tilesets()) {
+            margin = qMax(margin, qreal(tileset->tileWidth() +
+                                        tileset->tileHeight()));
+        }
+    }
+
+    QPolygonF pixelArea;
+    pixelArea << renderer->screenToPixelCoords(rect.topLeft())
+              << renderer->screenToPixelCoords(rect.topRight())
+              << renderer->screenToPixelCoords(rect.bottomRight())
+              << renderer->screenToPixelCoords(rect.bottomLeft());
+    const QRectF pixelRect = pixelArea.boundingRect().adjusted(-margin,
+                                                               -margin,
+                                                               margin,
+                                                               margin);
+
+    for (int i = map->layerCount() - 1; i >= 0; --i) {
+        const ObjectGroup *objectGroup = map->layerAt(i)->asObjectGroup();
+        if (!objectGroup || !mLayerItems.at(i)->isVisible())
+            continue;
+
+        // Later objects are stacked above earlier ones with the same z value
+        const QList<MapObject*> objects =
+                objectGroup->objectsIntersecting(pixelRect);
+        QList<MapObjectItem*> layerItems;
+        for (int j = objects.size() - 1; j >= 0; --j) {
+            MapObjectItem *item = mObjectItems.value(objects.at(j));
+            if (item && item->isVisible())
+                layerItems.append(item);
+        }
+
+        qStableSort(layerItems.begin(), layerItems.end(), higherZValue);
+        items.append(layerItems);
+    }
+
+    return items;
+}
+
 void MapScene::refreshScene()
 {
     mLayerItems.clear();
     mObjectItems.clear();
+    mAnimatedTileRegionsDirty = true;
 
     removeItem(mDarkRectangle);
     clear();
@@ -278,17 +383,58 @@ void MapScene::updateCurrentLayerHighlight()
 
 void MapScene::repaintRegion(const QRegion &region)
 {
-    const MapRenderer *renderer = mMapDocument->renderer();
-    const QMargins margins = mMapDocument->map()->drawMargins();
+    foreach (const QRect &r, region.rects()) {
+        const QRect rect = repaintRect(r);
+        invalidateTileLayerCaches(rect);
+        update(rect);
+    }
+}
 
+void MapScene::tileLayerCacheEnabledChanged()
+{
+    invalidateTileLayerCaches();
+    update();
+}
+
+/**
+ * Repaints the given \a region, in tile coordinates, where only the tile
+ * layer displayed by \a item has changed.
+ */
+void MapScene::repaintRegion(TileLayerItem *item, const QRegion &region)
+{
     foreach (const QRect &r, region.rects()) {
-        update(renderer->boundingRect(r).adjusted(-margins.left(),
-                                                  -margins.top(),
-                                                  margins.right(),
-                                                  margins.bottom()));
+        const QRect rect = repaintRect(r);
+        item->invalidateCache(rect);
+        update(rect);
     }
 }
 
+/**
+ * Returns the area in scene coordinates that needs to be repainted when the
+ * tiles within \a tileRect change.
+ */
+QRect MapScene::repaintRect(const QRect &tileRect) const
+{
+    const MapRenderer *renderer = mMapDocument->renderer();
+    const QMargins margins = mMapDocument->map()->drawMargins();
+
+    return renderer->boundingRect(tileRect).adjusted(-margins.left(),
+                                                     -margins.top(),
+                                                     margins.right(),
+                                                     margins.bottom());
+}
+
+/**
+ * Drops the cached rendering of all tile layers within the given \a rect.
+ * When no rect is given, the caches are dropped entirely.
+ */
+void MapScene::invalidateTileLayerCaches(const QRectF &rect)
+{
+    foreach (QGraphicsItem *item, mLayerItems)
+        if (TileLayerItem *tli = dynamic_cast<TileLayerItem*>(item))
+            tli->invalidateCache(rect);
+}
+
 void MapScene::enableSelectedTool()
 {
     if (!mSelectedTool || !mMapDocument)
@@ -328,6 +474,8 @@ void MapScene::currentLayerIndexChanged()
  */
 void MapScene::mapChanged()
 {
+    mAnimatedTileRegionsDirty = true;
+
     const QSize mapSize = mMapDocument->renderer()->mapSize();
     setSceneRect(0, 0, mapSize.width(), mapSize.height());
     mDarkRectangle->setRect(0, 0, mapSize.width(), mapSize.height());
@@ -349,12 +497,154 @@ void MapScene::tilesetChanged(Tileset *tileset)
     if (!mMapDocument)
         return;
 
-    if (mMapDocument->map()->tilesets().contains(tileset))
+    if (mMapDocument->map()->tilesets().contains(tileset)) {
+        invalidateTileLayerCaches();
         update();
+    }
+}
+
+/**
+ * Repaints the areas of the map and the tile objects that use the given
+ * animated \a tiles.
+ */
+void MapScene::repaintTiles(Tileset *tileset, const QList<Tile*> &tiles)
+{
+    if (!mMapDocument)
+        return;
+
+    if (!mMapDocument->map()->tilesets().contains(tileset))
+        return;
+
+    if (mAnimatedTileRegionsDirty) {
+        mAnimatedTileRegions.clear();
+        scanAnimatedTiles(QRect(QPoint(), mMapDocument->map()->size()));
+        mAnimatedTileRegionsDirty = false;
+    }
+
+    // Only the layers using the tiles need to be rendered again
+    AnimatedTileRegions::const_iterator it = mAnimatedTileRegions.begin();
+    for (; it != mAnimatedTileRegions.end(); ++it) {
+        QRegion region;
+        foreach (Tile *tile, tiles)
+            region += it.value().value(tile);
+
+        if (!region.isEmpty())
+            repaintRegion(it.key(), region);
+    }
+
+    // Tile objects are not part of the tracked regions
+    const QSet<Tile*> tileSet = tiles.toSet();
+    foreach (MapObjectItem *item, mObjectItems) {
+        const Cell &cell = item->mapObject()->cell();
+        if (cell.tile && tileSet.contains(cell.tile))
+            item->update();
+    }
+}
+
+void MapScene::invalidateAnimatedTileRegions()
+{
+    // Without knowing where the animated tiles were, everything needs to be
+    // repainted
+    if (mAnimatedTileRegionsDirty) {
+        invalidateTileLayerCaches();
+        update();
+        return;
+    }
+
+    // A tile may have started or stopped being animated, so repaint where
+    // animated tiles are used both before and after scanning the map again
+    const AnimatedTileRegions previous = mAnimatedTileRegions;
+    mAnimatedTileRegions.clear();
+    scanAnimatedTiles(QRect(QPoint(), mMapDocument->map()->size()));
+
+    repaintAnimatedTileRegions(previous);
+    repaintAnimatedTileRegions(mAnimatedTileRegions);
+}
+
+void MapScene::repaintAnimatedTileRegions(const AnimatedTileRegions &regions)
+{
+    AnimatedTileRegions::const_iterator it = regions.begin();
+    for (; it != regions.end(); ++it) {
+        QRegion region;
+        foreach (const QRegion &tileRegion, it.value())
+            region += tileRegion;
+
+        repaintRegion(it.key(), region);
+    }
+}
+
+void MapScene::updateAnimatedTileRegions(const QRegion &region)
+{
+    if (mAnimatedTileRegionsDirty)
+        return;
+
+    AnimatedTileRegions::iterator layerIt = mAnimatedTileRegions.begin();
+    while (layerIt != mAnimatedTileRegions.end()) {
+        QHash<Tile*, QRegion> &tileRegions = layerIt.value();
+
+        QHash<Tile*, QRegion>::iterator it = tileRegions.begin();
+        while (it != tileRegions.end()) {
+            it.value() -= region;
+            if (it.value().isEmpty())
+                it = tileRegions.erase(it);
+            else
+                ++it;
+        }
+
+        if (tileRegions.isEmpty())
+            layerIt = mAnimatedTileRegions.erase(layerIt);
+        else
+            ++layerIt;
+    }
+
+    scanAnimatedTiles(region);
+}
+
+/**
+ * Adds the animated tiles found within \a region to mAnimatedTileRegions.
+ */
+void MapScene::scanAnimatedTiles(const QRegion &region)
+{
+    foreach (QGraphicsItem *item, mLayerItems) {
+        TileLayerItem *tileLayerItem = dynamic_cast<TileLayerItem*>(item);
+        if (!tileLayerItem)
+            continue;
+
+        const TileLayer *tileLayer = tileLayerItem->tileLayer();
+
+        const QRegion layerRegion = region & tileLayer->bounds();
+
+        foreach (const QRect &rect, layerRegion.rects()) {
+            for (int y = rect.top(); y <= rect.bottom(); ++y) {
+                int x = rect.left();
+                while (x <= rect.right()) {
+                    Tile *tile = tileLayer->cellAt(x - tileLayer->x(),
+                                                   y - tileLayer->y()).tile;
+                    if (!tile || !tile->isAnimated()) {
+                        ++x;
+                        continue;
+                    }
+
+                    // Add runs of the same tile at once
+                    int end = x + 1;
+                    while (end <= rect.right() &&
+                           tileLayer->cellAt(end - tileLayer->x(),
+                                             y - tileLayer->y()).tile == tile)
+                        ++end;
+
+                    mAnimatedTileRegions[tileLayerItem][tile] +=
+                            QRect(x, y, end - x, 1);
+                    x = end;
+                }
+            }
+        }
+    }
 }
 
 void MapScene::layerAdded(int index)
 {
+    mAnimatedTileRegionsDirty = true;
+
     Layer *layer = mMapDocument->map()->layerAt(index);
     QGraphicsItem *layerItem = createLayerItem(layer);
     addItem(layerItem);
@@ -367,6 +657,8 @@ void MapScene::layerAdded(int index)
 
 void MapScene::layerRemoved(int index)
 {
+    mAnimatedTileRegionsDirty = true;
+
     delete mLayerItems.at(index);
     mLayerItems.remove(index);
 }
@@ -26,7 +26,9 @@
 
 #include <QColor>
 #include <QGraphicsScene>
+#include <QHash>
 #include <QMap>
+#include <QRegion>
 #include <QSet>
 
 namespace Tiled {
@@ -35,6 +37,7 @@ class ImageLayer;
 class Layer;
 class MapObject;
 class ObjectGroup;
+class Tile;
 class Tileset;
 
 namespace Internal {
@@ -44,6 +47,7 @@ class MapDocument;
 class MapObjectItem;
 class MapScene;
 class ObjectGroupItem;
+class TileLayerItem;
 
 /**
  * A graphics scene that represents the contents of a map.
@@ -96,6 +100,26 @@ public:
     MapObjectItem *itemForObject(MapObject *object) const
     { return mObjectItems.value(object); }
 
+    /**
+     * Returns the items of the visible map objects whose shape intersects the
+     * given \a rect in scene coordinates, ordered from top to bottom.
+     *
+     * Uses the spatial index of the object groups, so that it does not need
+     * to look at every object.
+     */
+    QList<MapObjectItem*> objectItemsIntersecting(const QRectF &rect) const;
+
+    /**
+     * Returns the items of the visible map objects whose shape contains the
+     * given \a pos in scene coordinates, ordered from top to bottom.
+     */
+    QList<MapObjectItem*> objectItemsAt(const QPointF &pos) const;
+
+    /**
+     * Returns the number of tile layers that are currently shown.
+     */
+    int visibleTileLayerCount() const;
+
     /**
      * Enables the selected tool at this map scene.
      * Therefore it tells that tool, that this is the active map scene.
@@ -148,11 +172,15 @@ private slots:
      * Repaints the specified region. The region is in tile coordinates.
      */
     void repaintRegion(const QRegion &region);
+    void tileLayerCacheEnabledChanged();
 
     void currentLayerIndexChanged();
 
     void mapChanged();
     void tilesetChanged(Tileset *tileset);
+    void repaintTiles(Tileset *tileset, const QList<Tile*> &tiles);
+    void invalidateAnimatedTileRegions();
+    void updateAnimatedTileRegions(const QRegion &region);
 
     void layerAdded(int index);
     void layerRemoved(int index);
@@ -176,6 +204,22 @@ private:
 
     void updateCurrentLayerHighlight();
 
+    /**
+     * Where each animated tile is used in the map, in tile coordinates, per
+     * tile layer item.
+     */
+    typedef QHash<TileLayerItem*, QHash<Tile*, QRegion> > AnimatedTileRegions;
+
+    void repaintRegion(TileLayerItem *item, const QRegion &region);
+    QRect repaintRect(const QRect &tileRect) const;
+
+    void scanAnimatedTiles(const QRegion &region);
+    void repaintAnimatedTileRegions(const AnimatedTileRegions &regions);
+
+    QList<MapObjectItem*> objectItemCandidates(const QRectF &rect) const;
+
+    void invalidateTileLayerCaches(const QRectF &rect = QRectF());
+
     bool eventFilter(QObject *object, QEvent *event);
 
     MapDocument *mMapDocument;
@@ -195,6 +239,14 @@ private:
     typedef QMap<MapObject*, MapObjectItem*> ObjectItems;
     ObjectItems mObjectItems;
     QSet<MapObjectItem*> mSelectedObjectItems;
+
+    /**
+     * Where the animated tiles are used. Rebuilt when
+     * mAnimatedTileRegionsDirty is set, and otherwise kept up to date as
+     * regions of the map change.
+     */
+    AnimatedTileRegions mAnimatedTileRegions;
+    bool mAnimatedTileRegionsDirty;
 };
 
 } // namespace Internal
@@ -38,7 +38,6 @@
 #include <QPainter>
 #include <QResizeEvent>
 #include <QScrollBar>
-#include <QUndoStack>
 
 using namespace Tiled;
 using namespace Tiled::Internal;
@@ -49,6 +48,7 @@ MiniMap::MiniMap(QWidget *parent)
     , mDragging(false)
     , mMouseMoveCursorState(false)
     , mRedrawMapImage(false)
+    , mFullRedraw(true)
     , mRenderFlags(DrawTiles | DrawObjects | DrawImages | IgnoreInvisibleLayer)
 {
     setFrameStyle(QFrame::StyledPanel | QFrame::Sunken);
@@ -79,7 +79,37 @@ void MiniMap::setMapDocument(MapDocument *map)
     mMapDocument = map;
 
     if (mMapDocument) {
-        connect(mMapDocument->undoStack(), SIGNAL(indexChanged(int)),
+        // Tile changes only need the affected region to be redrawn
+        connect(mMapDocument, SIGNAL(regionChanged(QRegion)),
+                this, SLOT(scheduleMapRegionUpdate(QRegion)));
+
+        connect(mMapDocument, SIGNAL(mapChanged()),
+                this, SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(layerAdded(int)),
+                this, SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(layerRemoved(int)),
+                this, SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(layerChanged(int)),
+                this, SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(imageLayerChanged(ImageLayer*)),
+                this, SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(objectGroupChanged(ObjectGroup*)),
+                this, SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(objectsAdded(QList<MapObject*>)),
+                this, SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(objectsRemoved(QList<MapObject*>)),
+                this, SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(objectsChanged(QList<MapObject*>)),
+                this, SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(objectsIndexChanged(ObjectGroup*,int,int)),
+                this, SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(tilesetAdded(int,Tileset*)),
+                this, SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(tilesetRemoved(Tileset*)),
+                this, SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(tilesetChanged(Tileset*)),
+                this, SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(tilesetTileOffsetChanged(Tileset*)),
                 this, SLOT(scheduleMapImageUpdate()));
 
         if (MapView *mapView = dm->viewForDocument(mMapDocument)) {
@@ -99,9 +129,21 @@ QSize MiniMap::sizeHint() const
 
 void MiniMap::scheduleMapImageUpdate()
 {
+    mFullRedraw = true;
+    mDirtyRegion = QRegion();
     mMapImageUpdateTimer.start(100);
 }
 
+void MiniMap::scheduleMapRegionUpdate(const QRegion &region)
+{
+    if (mFullRedraw)
+        return;
+
+    mDirtyRegion += region;
+    if (!mMapImageUpdateTimer.isActive())
+        mMapImageUpdateTimer.start(100);
+}
+
 void MiniMap::paintEvent(QPaintEvent *pe)
 {
     QFrame::paintEvent(pe);
@@ -173,6 +215,7 @@ void MiniMap::renderMapToImage()
 {
     if (!mMapDocument) {
         mMapImage = QImage();
+        mFullRedraw = true;
         return;
     }
 
@@ -182,6 +225,7 @@ void MiniMap::renderMapToImage()
 
     if (mapSize.isEmpty()) {
         mMapImage = QImage();
+        mFullRedraw = true;
         return;
     }
 
@@ -194,11 +238,41 @@ void MiniMap::renderMapToImage()
     if (mMapImage.size() != imageSize) {
         mMapImage = QImage(imageSize, QImage::Format_ARGB32_Premultiplied);
         updateImageRect();
+        mFullRedraw = true;
     }
 
     if (imageSize.isEmpty())
         return;
 
+    // Unless a full redraw is needed, only redraw the changed tiles, taking
+    // into account that tiles may extend beyond their cell
+    QRectF exposed;
+    if (!mFullRedraw) {
+        if (mDirtyRegion.isEmpty())
+            return;
+
+        const QMargins margins = mMapDocument->map()->drawMargins();
+        QRect dirtyRect;
+        foreach (const QRect &rect, mDirtyRegion.rects()) {
+            dirtyRect |= renderer->boundingRect(rect).adjusted(-margins.left(),
+                                                               -margins.top(),
+                                                               margins.right(),
+                                                               margins.bottom());
+        }
+        mDirtyRegion = QRegion();
+
+        // Align the exposed area to whole pixels of the image
+        const QRect imageRect = QRectF(QPointF(dirtyRect.topLeft()) * scale,
+                                       QSizeF(dirtyRect.size()) * scale)
+                .toAlignedRect().adjusted(-1, -1, 1, 1) & mMapImage.rect();
+        if (imageRect.isEmpty())
+            return;
+
+        exposed = QRectF(QPointF(imageRect.topLeft()) / scale,
+                         QSizeF(imageRect.size()) / scale);
+    }
+    mFullRedraw = false;
+
     bool drawObjects = mRenderFlags.testFlag(DrawObjects);
     bool drawTiles = mRenderFlags.testFlag(DrawTiles);
     bool drawImages = mRenderFlags.testFlag(DrawImages);
@@ -209,13 +283,22 @@ void MiniMap::renderMapToImage()
     const Tiled::RenderFlags renderFlags = renderer->flags();
     renderer->setFlag(ShowTileObjectOutlines, false);
 
-    mMapImage.fill(Qt::transparent);
+    if (exposed.isNull())
+        mMapImage.fill(Qt::transparent);
+
     QPainter painter(&mMapImage);
     painter.setRenderHints(QPainter::SmoothPixmapTransform |
                            QPainter::HighQualityAntialiasing);
     painter.setTransform(QTransform::fromScale(scale, scale));
     renderer->setPainterScale(scale);
 
+    if (!exposed.isNull()) {
+        painter.setClipRect(exposed);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.fillRect(exposed, Qt::transparent);
+        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    }
+
     foreach (const Layer *layer, mMapDocument->map()->layers()) {
         if (visibleLayersOnly && !layer->isVisible())
             continue;
@@ -227,7 +310,7 @@ void MiniMap::renderMapToImage()
         const ImageLayer *imageLayer = dynamic_cast<const ImageLayer*>(layer);
 
         if (tileLayer && drawTiles) {
-            renderer->drawTileLayer(&painter, tileLayer);
+            renderer->drawTileLayer(&painter, tileLayer, exposed);
         } else if (objGroup && drawObjects) {
             QList<MapObject*> objects = objGroup->objects();
 
@@ -235,6 +318,10 @@ void MiniMap::renderMapToImage()
                 qStableSort(objects.begin(), objects.end(), objectLessThan);
 
             foreach (const MapObject *object, objects) {
+                if (!exposed.isNull() &&
+                        !renderer->boundingRect(object).intersects(exposed))
+                    continue;
+
                 if (object->isVisible()) {
                     const QColor color = MapObjectItem::objectColor(object);
                     renderer->drawMapObject(&painter, object, color);
@@ -247,8 +334,10 @@ void MiniMap::renderMapToImage()
 
     if (drawTileGrid) {
         Preferences *prefs = Preferences::instance();
-        renderer->drawGrid(&painter, QRectF(QPointF(), renderer->mapSize()),
-                           prefs->gridColor());
+        const QRectF gridRect = exposed.isNull()
+                ? QRectF(QPointF(), renderer->mapSize())
+                : exposed;
+        renderer->drawGrid(&painter, gridRect, prefs->gridColor());
     }
 
     renderer->setFlags(renderFlags);
@@ -24,6 +24,7 @@
 
 #include <QFrame>
 #include <QImage>
+#include <QRegion>
 #include <QTimer>
 
 namespace Tiled {
@@ -58,6 +59,12 @@ public slots:
     /** Schedules a redraw of the minimap image. */
     void scheduleMapImageUpdate();
 
+    /**
+     * Schedules a redraw of the part of the minimap image showing the given
+     * \a region, in tile coordinates.
+     */
+    void scheduleMapRegionUpdate(const QRegion &region);
+
 protected:
     void paintEvent(QPaintEvent *);
     void resizeEvent(QResizeEvent *);
@@ -78,6 +85,8 @@ private:
     QPoint mDragOffset;
     bool mMouseMoveCursorState;
     bool mRedrawMapImage;
+    bool mFullRedraw;
+    QRegion mDirtyRegion;
     MiniMapRenderFlags mRenderFlags;
 
     QRect viewportRect() const;
@@ -492,10 +492,9 @@ void ObjectSelectionTool::updateSelection(const QPointF &pos,
 
     QSet<MapObjectItem*> selectedItems;
 
-    foreach (QGraphicsItem *item, mapScene()->items(rect)) {
-        MapObjectItem *mapObjectItem = dynamic_cast<MapObjectItem*>(item);
-        if (mapObjectItem)
-            selectedItems.insert(mapObjectItem);
+    foreach (MapObjectItem *mapObjectItem,
+             mapScene()->objectItemsIntersecting(rect)) {
+        selectedItems.insert(mapObjectItem);
     }
 
     if (modifiers & (Qt::ControlModifier | Qt::ShiftModifier))
@@ -41,6 +41,7 @@ OffsetLayer::OffsetLayer(MapDocument *mapDocument,
                          bool wrapY)
     : QUndoCommand(QCoreApplication::translate("Undo Commands",
                                                "Offset Layer"))
+    , MemoryConsumingCommand(mapDocument)
     , mMapDocument(mapDocument)
     , mIndex(index)
     , mOriginalLayer(0)
@@ -66,6 +67,8 @@ OffsetLayer::OffsetLayer(MapDocument *mapDocument,
         // Nothing done for the image layer at the moment
         break;
     }
+
+    updateMemoryUsage();
 }
 
 OffsetLayer::~OffsetLayer()
@@ -79,6 +82,7 @@ void OffsetLayer::undo()
     Q_ASSERT(!mOffsetLayer);
     mOffsetLayer = swapLayer(mOriginalLayer);
     mOriginalLayer = 0;
+    updateMemoryUsage();
 }
 
 void OffsetLayer::redo()
@@ -86,6 +90,13 @@ void OffsetLayer::redo()
     Q_ASSERT(!mOriginalLayer);
     mOriginalLayer = swapLayer(mOffsetLayer);
     mOffsetLayer = 0;
+    updateMemoryUsage();
+}
+
+qint64 OffsetLayer::computeMemoryUsage() const
+{
+    const Layer *layer = mOriginalLayer ? mOriginalLayer : mOffsetLayer;
+    return sizeof(*this) + layerMemoryUsage(layer);
 }
 
 Layer *OffsetLayer::swapLayer(Layer *layer)
@@ -22,6 +22,8 @@
 #ifndef OFFSETLAYER_H
 #define OFFSETLAYER_H
 
+#include "undocommands.h"
+
 #include <QRect>
 #include <QPoint>
 #include <QUndoCommand>
@@ -37,7 +39,7 @@ class MapDocument;
 /**
  * Undo command that offsets a map layer.
  */
-class OffsetLayer : public QUndoCommand
+class OffsetLayer : public QUndoCommand, public MemoryConsumingCommand
 {
 public:
     /**
@@ -56,6 +58,9 @@ public:
     void undo();
     void redo();
 
+protected:
+    qint64 computeMemoryUsage() const;
+
 private:
     Layer *swapLayer(Layer *layer);
 
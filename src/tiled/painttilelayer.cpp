@@ -35,36 +35,43 @@ PaintTileLayer::PaintTileLayer(MapDocument *mapDocument,
                                int x,
                                int y,
                                const TileLayer *source):
+    MemoryConsumingCommand(mapDocument),
     mMapDocument(mapDocument),
     mTarget(target),
-    mSource(static_cast<TileLayer*>(source->clone())),
-    mX(x),
-    mY(y),
     mPaintedRegion(x, y, source->width(), source->height()),
     mMergeable(false)
 {
-    mErased = mTarget->copy(mX - mTarget->x(),
-                            mY - mTarget->y(),
-                            mSource->width(), mSource->height());
+    mSource.record(source,
+                   QRegion(0, 0, source->width(), source->height()),
+                   QPoint(x, y));
+    mErased.record(mTarget,
+                   mPaintedRegion.translated(-mTarget->x(), -mTarget->y()),
+                   mTarget->position());
     setText(QCoreApplication::translate("Undo Commands", "Paint"));
-}
 
-PaintTileLayer::~PaintTileLayer()
-{
-    delete mSource;
-    delete mErased;
+    updateMemoryUsage();
 }
 
 void PaintTileLayer::undo()
 {
+    const QRect bounds = mPaintedRegion.boundingRect();
+    TileLayer *erased = mErased.toTileLayer(bounds);
+
     TilePainter painter(mMapDocument, mTarget);
-    painter.setCells(mX, mY, mErased, mPaintedRegion);
+    painter.setCells(bounds.x(), bounds.y(), erased, mPaintedRegion);
+
+    delete erased;
 }
 
 void PaintTileLayer::redo()
 {
+    const QRect bounds = mPaintedRegion.boundingRect();
+    TileLayer *source = mSource.toTileLayer(bounds);
+
     TilePainter painter(mMapDocument, mTarget);
-    painter.drawCells(mX, mY, mSource);
+    painter.drawCells(bounds.x(), bounds.y(), source);
+
+    delete source;
 }
 
 bool PaintTileLayer::mergeWith(const QUndoCommand *other)
@@ -75,33 +82,29 @@ bool PaintTileLayer::mergeWith(const QUndoCommand *other)
           o->mMergeable))
         return false;
 
+    // Only the cells that were not painted before were erased by the other
+    // command, the rest were already painted by this command.
     const QRegion newRegion = o->mPaintedRegion.subtracted(mPaintedRegion);
-    const QRegion combinedRegion = mPaintedRegion.united(o->mPaintedRegion);
-    const QRect bounds = QRect(mX, mY, mSource->width(), mSource->height());
-    const QRect combinedBounds = combinedRegion.boundingRect();
-
-    // Resize the erased tiles and source layers when necessary
-    if (bounds != combinedBounds) {
-        const QPoint shift = bounds.topLeft() - combinedBounds.topLeft();
-        mErased->resize(combinedBounds.size(), shift);
-        mSource->resize(combinedBounds.size(), shift);
-    }
-
-    mX = combinedBounds.left();
-    mY = combinedBounds.top();
-    mPaintedRegion = combinedRegion;
-
-    // Copy the painted tiles from the other command over
-    const QPoint pos = QPoint(o->mX, o->mY) - combinedBounds.topLeft();
-    mSource->merge(pos, o->mSource);
-
-    // Copy the newly erased tiles from the other command over
-    foreach (const QRect &rect, newRegion.rects())
-        for (int y = rect.top(); y <= rect.bottom(); ++y)
-            for (int x = rect.left(); x <= rect.right(); ++x)
-                mErased->setCell(x - mX,
-                                 y - mY,
-                                 o->mErased->cellAt(x - o->mX, y - o->mY));
+    mErased.append(o->mErased, newRegion);
+    mSource.append(o->mSource, o->mPaintedRegion);
+
+    mPaintedRegion = mPaintedRegion.united(o->mPaintedRegion);
 
+    updateMemoryUsage();
     return true;
 }
+
+qint64 PaintTileLayer::computeMemoryUsage() const
+{
+    return sizeof(*this) +
+            mPaintedRegion.rectCount() * sizeof(QRect) +
+            mSource.memoryUsage() + mErased.memoryUsage();
+}
+
+void PaintTileLayer::compress()
+{
+    mSource.compress();
+    mErased.compress();
+
+    updateMemoryUsage();
+}
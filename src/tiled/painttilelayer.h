@@ -21,6 +21,7 @@
 #ifndef PAINTTILELAYER_H
 #define PAINTTILELAYER_H
 
+#include "tilelayerdelta.h"
 #include "undocommands.h"
 
 #include <QRegion>
@@ -36,8 +37,11 @@ class MapDocument;
 
 /**
  * A command that paints one tile layer on top of another tile layer.
+ *
+ * Only the painted cells and the cells they replaced are remembered, so
+ * that long merged strokes stay cheap.
  */
-class PaintTileLayer : public QUndoCommand
+class PaintTileLayer : public QUndoCommand, public MemoryConsumingCommand
 {
 public:
     /**
@@ -54,8 +58,6 @@ public:
                    int x, int y,
                    const TileLayer *source);
 
-    ~PaintTileLayer();
-
     /**
      * Sets whether this undo command can be merged with an existing command.
      */
@@ -68,12 +70,17 @@ public:
     int id() const { return Cmd_PaintTileLayer; }
     bool mergeWith(const QUndoCommand *other);
 
+    // MemoryConsumingCommand
+    void compress();
+
+protected:
+    qint64 computeMemoryUsage() const;
+
 private:
     MapDocument *mMapDocument;
     TileLayer *mTarget;
-    TileLayer *mSource;
-    TileLayer *mErased;
-    int mX, mY;
+    TileLayerDelta mSource;
+    TileLayerDelta mErased;
     QRegion mPaintedRegion;
     bool mMergeable;
 };
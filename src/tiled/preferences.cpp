@@ -76,10 +76,12 @@ Preferences::Preferences()
     mGridColor = colorValue("GridColor", Qt::black);
     mGridFine = intValue("GridFine", 4);
     mObjectLineWidth = realValue("ObjectLineWidth", 2);
+    mUndoMemoryBudget = intValue("UndoMemoryBudget", 256);
     mHighlightCurrentLayer = boolValue("HighlightCurrentLayer");
     mShowTilesetGrid = boolValue("ShowTilesetGrid", true);
     mLanguage = stringValue("Language");
     mUseOpenGL = boolValue("OpenGL");
+    mTileLayerCacheEnabled = boolValue("TileLayerCache");
     mSettings->endGroup();
 
     // Retrieve defined object types
@@ -186,6 +188,16 @@ void Preferences::setGridFine(int gridFine)
     emit gridFineChanged(mGridFine);
 }
 
+void Preferences::setUndoMemoryBudget(int megabytes)
+{
+    if (mUndoMemoryBudget == megabytes)
+        return;
+    mUndoMemoryBudget = megabytes;
+    mSettings->setValue(QLatin1String("Interface/UndoMemoryBudget"),
+                        mUndoMemoryBudget);
+    emit undoMemoryBudgetChanged(mUndoMemoryBudget);
+}
+
 void Preferences::setObjectLineWidth(qreal lineWidth)
 {
     if (mObjectLineWidth == lineWidth)
@@ -304,6 +316,18 @@ void Preferences::setUseOpenGL(bool useOpenGL)
     emit useOpenGLChanged(mUseOpenGL);
 }
 
+void Preferences::setTileLayerCacheEnabled(bool enabled)
+{
+    if (mTileLayerCacheEnabled == enabled)
+        return;
+
+    mTileLayerCacheEnabled = enabled;
+    mSettings->setValue(QLatin1String("Interface/TileLayerCache"),
+                        mTileLayerCacheEnabled);
+
+    emit tileLayerCacheEnabledChanged(mTileLayerCacheEnabled);
+}
+
 void Preferences::setObjectTypes(const ObjectTypes &objectTypes)
 {
     mObjectTypes = objectTypes;
@@ -53,6 +53,12 @@ public:
     int gridFine() const { return mGridFine; }
     qreal objectLineWidth() const { return mObjectLineWidth; }
 
+    /**
+     * Returns the amount of memory in megabytes that the undo history of
+     * each map may use before its oldest commands are compressed.
+     */
+    int undoMemoryBudget() const { return mUndoMemoryBudget; }
+
     bool highlightCurrentLayer() const { return mHighlightCurrentLayer; }
     bool showTilesetGrid() const { return mShowTilesetGrid; }
 
@@ -74,6 +80,8 @@ public:
     bool useOpenGL() const { return mUseOpenGL; }
     void setUseOpenGL(bool useOpenGL);
 
+    bool tileLayerCacheEnabled() const { return mTileLayerCacheEnabled; }
+
     const ObjectTypes &objectTypes() const { return mObjectTypes; }
     void setObjectTypes(const ObjectTypes &objectTypes);
 
@@ -107,8 +115,10 @@ public slots:
     void setGridColor(QColor gridColor);
     void setGridFine(int gridFine);
     void setObjectLineWidth(qreal lineWidth);
+    void setUndoMemoryBudget(int megabytes);
     void setHighlightCurrentLayer(bool highlight);
     void setShowTilesetGrid(bool showTilesetGrid);
+    void setTileLayerCacheEnabled(bool enabled);
 
 signals:
     void showGridChanged(bool showGrid);
@@ -119,10 +129,12 @@ signals:
     void gridColorChanged(QColor gridColor);
     void gridFineChanged(int gridFine);
     void objectLineWidthChanged(qreal lineWidth);
+    void undoMemoryBudgetChanged(int megabytes);
     void highlightCurrentLayerChanged(bool highlight);
     void showTilesetGridChanged(bool showTilesetGrid);
 
     void useOpenGLChanged(bool useOpenGL);
+    void tileLayerCacheEnabledChanged(bool enabled);
 
     void objectTypesChanged();
 
@@ -148,6 +160,7 @@ private:
     QColor mGridColor;
     int mGridFine;
     qreal mObjectLineWidth;
+    int mUndoMemoryBudget;
     bool mHighlightCurrentLayer;
     bool mShowTilesetGrid;
 
@@ -157,6 +170,7 @@ private:
     QString mLanguage;
     bool mReloadTilesetsOnChange;
     bool mUseOpenGL;
+    bool mTileLayerCacheEnabled;
     ObjectTypes mObjectTypes;
 
     bool mAutoMapDrawing;
@@ -144,6 +144,10 @@ PreferencesDialog::PreferencesDialog(QWidget *parent) :
             Preferences::instance(), SLOT(setGridFine(int)));
     connect(mUi->objectLineWidth, SIGNAL(valueChanged(double)),
             SLOT(objectLineWidthChanged(double)));
+    connect(mUi->undoMemoryBudget, SIGNAL(valueChanged(int)),
+            Preferences::instance(), SLOT(setUndoMemoryBudget(int)));
+    connect(mUi->tileLayerCache, SIGNAL(toggled(bool)),
+            Preferences::instance(), SLOT(setTileLayerCacheEnabled(bool)));
 
     connect(mUi->objectTypesTable->selectionModel(),
             SIGNAL(selectionChanged(QItemSelection,QItemSelection)),
@@ -314,6 +318,8 @@ void PreferencesDialog::fromPreferences()
     mUi->gridColor->setColor(prefs->gridColor());
     mUi->gridFine->setValue(prefs->gridFine());
     mUi->objectLineWidth->setValue(prefs->objectLineWidth());
+    mUi->undoMemoryBudget->setValue(prefs->undoMemoryBudget());
+    mUi->tileLayerCache->setChecked(prefs->tileLayerCacheEnabled());
     mUi->autoMapWhileDrawing->setChecked(prefs->automappingDrawing());
     mObjectTypesModel->setObjectTypes(prefs->objectTypes());
 }
@@ -36,6 +36,7 @@ ResizeTileLayer::ResizeTileLayer(MapDocument *mapDocument,
                                  const QPoint &offset)
     : QUndoCommand(QCoreApplication::translate("Undo Commands",
                                                "Resize Layer"))
+    , MemoryConsumingCommand(mapDocument)
     , mMapDocument(mapDocument)
     , mIndex(mapDocument->map()->layers().indexOf(layer))
     , mOriginalLayer(0)
@@ -45,6 +46,8 @@ ResizeTileLayer::ResizeTileLayer(MapDocument *mapDocument,
     // Create the resized layer (once)
     mResizedLayer = static_cast<TileLayer*>(layer->clone());
     mResizedLayer->resize(size, offset);
+
+    updateMemoryUsage();
 }
 
 ResizeTileLayer::~ResizeTileLayer()
@@ -58,6 +61,7 @@ void ResizeTileLayer::undo()
     Q_ASSERT(!mResizedLayer);
     mResizedLayer = static_cast<TileLayer*>(swapLayer(mOriginalLayer));
     mOriginalLayer = 0;
+    updateMemoryUsage();
 }
 
 void ResizeTileLayer::redo()
@@ -65,6 +69,13 @@ void ResizeTileLayer::redo()
     Q_ASSERT(!mOriginalLayer);
     mOriginalLayer = static_cast<TileLayer*>(swapLayer(mResizedLayer));
     mResizedLayer = 0;
+    updateMemoryUsage();
+}
+
+qint64 ResizeTileLayer::computeMemoryUsage() const
+{
+    const Layer *layer = mOriginalLayer ? mOriginalLayer : mResizedLayer;
+    return sizeof(*this) + layerMemoryUsage(layer);
 }
 
 Layer *ResizeTileLayer::swapLayer(Layer *layer)
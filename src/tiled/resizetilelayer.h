@@ -21,6 +21,8 @@
 #ifndef RESIZELAYER_H
 #define RESIZELAYER_H
 
+#include "undocommands.h"
+
 #include <QPoint>
 #include <QSize>
 #include <QUndoCommand>
@@ -37,7 +39,7 @@ class MapDocument;
 /**
  * Undo command that resizes a map layer.
  */
-class ResizeTileLayer : public QUndoCommand
+class ResizeTileLayer : public QUndoCommand, public MemoryConsumingCommand
 {
 public:
     /**
@@ -54,6 +56,9 @@ public:
     void undo();
     void redo();
 
+protected:
+    qint64 computeMemoryUsage() const;
+
 private:
     Layer *swapLayer(Layer *layer);
 
@@ -35,7 +35,6 @@
 
 #include <math.h>
 #include <QVector>
-#include <climits>
 
 using namespace Tiled;
 using namespace Tiled::Internal;
@@ -260,34 +259,8 @@ static Tile *findBestTile(Tileset *tileset, unsigned terrain, unsigned considera
     if (terrain == 0xFFFFFFFF)
         return NULL;
 
-    QList<Tile*> matches;
-    int penalty = INT_MAX;
-
-    // TODO: this is a slow linear search, perhaps we could use a better find algorithm...
-    foreach (Tile *t, tileset->tiles()) {
-        if ((t->terrain() & considerationMask) != (terrain & considerationMask))
-            continue;
-
-        // calculate the tile transition penalty based on shortest distance to target terrain type
-        int tr = tileset->terrainTransitionPenalty(t->terrain() >> 24, terrain >> 24);
-        int tl = tileset->terrainTransitionPenalty((t->terrain() >> 16) & 0xFF, (terrain >> 16) & 0xFF);
-        int br = tileset->terrainTransitionPenalty((t->terrain() >> 8) & 0xFF, (terrain >> 8) & 0xFF);
-        int bl = tileset->terrainTransitionPenalty(t->terrain() & 0xFF, terrain & 0xFF);
-
-        // if there is no path to the destination terrain, this isn't a useful transition
-        if (tr < 0 || tl < 0 || br < 0 || bl < 0)
-            continue;
-
-        // add tile to the candidate list
-        int transitionPenalty = tr + tl + br + bl;
-        if (transitionPenalty <= penalty) {
-            if (transitionPenalty < penalty)
-                matches.clear();
-            penalty = transitionPenalty;
-
-            matches.push_back(t);
-        }
-    }
+    const QList<Tile*> matches = tileset->bestTerrainMatches(terrain,
+                                                             considerationMask);
 
     // choose a candidate at random, with consideration for terrain probability
     if (!matches.isEmpty()) {
@@ -36,6 +36,7 @@
 #include "tile.h"
 #include "tilelayer.h"
 #include "tileset.h"
+#include "tilesetmanager.h"
 #include "toolmanager.h"
 #include "utils.h"
 #include "zoomable.h"
@@ -299,8 +300,11 @@ void TileCollisionEditor::paste()
         return;
 
     // Clean up the tilesets, we're not interested in them (would make sense
-    // to avoid loading them in the first place).
-    qDeleteAll(map->tilesets());
+    // to avoid loading them in the first place). They may be shared with the
+    // clipboard, so they are released through the TilesetManager.
+    TilesetManager *tilesetManager = TilesetManager::instance();
+    tilesetManager->addReferences(map->tilesets());
+    tilesetManager->removeReferences(map->tilesets());
 
     // We can currently only handle maps with a single layer
     if (map->layerCount() != 1)
@@ -13,7 +13,7 @@ win32 {
 }
 
 greaterThan(QT_MAJOR_VERSION, 4) {
-    QT += widgets
+    QT += widgets concurrent
 }
 contains(QT_CONFIG, opengl): QT += opengl
 
@@ -93,6 +93,7 @@ SOURCES += aboutdialog.cpp \
     mainwindow.cpp \
     mapdocumentactionhandler.cpp \
     mapdocument.cpp \
+    maploader.cpp \
     mapobjectitem.cpp \
     mapobjectmodel.cpp \
     mapscene.cpp \
@@ -141,6 +142,7 @@ SOURCES += aboutdialog.cpp \
     tileanimationeditor.cpp \
     tilecollisioneditor.cpp \
     tiledapplication.cpp \
+    tilelayerdelta.cpp \
     tilelayeritem.cpp \
     tilepainter.cpp \
     tileselectionitem.cpp \
@@ -153,6 +155,7 @@ SOURCES += aboutdialog.cpp \
     tmxmapreader.cpp \
     tmxmapwriter.cpp \
     toolmanager.cpp \
+    undocommands.cpp \
     undodock.cpp \
     utils.cpp \
     varianteditorfactory.cpp \
@@ -214,6 +217,7 @@ HEADERS += aboutdialog.h \
     mainwindow.h \
     mapdocumentactionhandler.h \
     mapdocument.h \
+    maploader.h \
     mapobjectitem.h \
     mapobjectmodel.h \
     mapscene.h \
@@ -263,6 +267,7 @@ HEADERS += aboutdialog.h \
     tileanimationeditor.h \
     tilecollisioneditor.h \
     tiledapplication.h \
+    tilelayerdelta.h \
     tilelayeritem.h \
     tilepainter.h \
     tileselectionitem.h \
@@ -0,0 +1,273 @@
+/*
+ * tilelayerdelta.cpp
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tilelayerdelta.h"
+
+#include <QHash>
+#include <QPair>
+
+#include <cstring>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+namespace {
+
+typedef QPair<Tile*, int> CellKey;
+typedef QHash<CellKey, int> CellIndices;
+
+CellKey cellKey(const Cell &cell)
+{
+    return CellKey(cell.tile, (cell.flippedHorizontally ? 1 : 0) |
+                              (cell.flippedVertically ? 2 : 0) |
+                              (cell.flippedAntiDiagonally ? 4 : 0));
+}
+
+/**
+ * Returns the index of \a cell in the \a cells table, adding it when it is
+ * not there yet.
+ */
+int indexOfCell(QVector<Cell> &cells, CellIndices &indices, const Cell &cell)
+{
+    const CellKey key = cellKey(cell);
+    CellIndices::const_iterator it = indices.constFind(key);
+    if (it != indices.constEnd())
+        return it.value();
+
+    const int index = cells.size();
+    cells.append(cell);
+    indices.insert(key, index);
+    return index;
+}
+
+CellIndices indicesOf(const QVector<Cell> &cells)
+{
+    CellIndices indices;
+    for (int i = 0; i < cells.size(); ++i)
+        indices.insert(cellKey(cells.at(i)), i);
+    return indices;
+}
+
+} // anonymous namespace
+
+TileLayerDelta::TileLayerDelta()
+    : mCompactedRunCount(0)
+{
+}
+
+void TileLayerDelta::record(const TileLayer *layer, const QRegion &region,
+                            const QPoint &offset)
+{
+    decompress();
+    recordRuns(layer, region, offset);
+
+    if (mRuns.size() > 2 * mCompactedRunCount + 256)
+        compact();
+}
+
+void TileLayerDelta::append(const TileLayerDelta &other, const QRegion &region)
+{
+    decompress();
+
+    QVector<Run> otherRuns = other.mRuns;
+    QVector<Cell> otherCells = other.mCells;
+    if (other.isCompressed())
+        decode(other.mCompressed, otherRuns, otherCells);
+
+    CellIndices indices = indicesOf(mCells);
+    QVector<int> cellMapping(otherCells.size(), -1);
+
+    // Avoid clipping each run when the region covers all of the other cells
+    const bool clip = !QRegion(other.bounds()).subtracted(region).isEmpty();
+    const QVector<QRect> rects = region.rects();
+
+    foreach (const Run &run, otherRuns) {
+        int &cell = cellMapping[run.cell];
+        if (cell == -1)
+            cell = indexOfCell(mCells, indices, otherCells.at(run.cell));
+
+        if (!clip) {
+            const Run mapped = { run.x, run.y, run.length, cell };
+            mRuns.append(mapped);
+            mBounds |= QRect(run.x, run.y, run.length, 1);
+            continue;
+        }
+
+        const int runRight = run.x + run.length - 1;
+
+        foreach (const QRect &rect, rects) {
+            if (run.y < rect.top() || run.y > rect.bottom())
+                continue;
+
+            const int left = qMax(run.x, rect.left());
+            const int right = qMin(runRight, rect.right());
+            if (left > right)
+                continue;
+
+            const Run clipped = { left, run.y, right - left + 1, cell };
+            mRuns.append(clipped);
+            mBounds |= QRect(clipped.x, clipped.y, clipped.length, 1);
+        }
+    }
+
+    if (mRuns.size() > 2 * mCompactedRunCount + 256)
+        compact();
+}
+
+TileLayer *TileLayerDelta::toTileLayer(const QRect &rect) const
+{
+    TileLayer *layer = new TileLayer(QString(), 0, 0,
+                                     rect.width(), rect.height());
+
+    QVector<Run> runs = mRuns;
+    QVector<Cell> cells = mCells;
+    if (isCompressed())
+        decode(mCompressed, runs, cells);
+
+    foreach (const Run &run, runs) {
+        if (run.y < rect.top() || run.y > rect.bottom())
+            continue;
+
+        const int left = qMax(run.x, rect.left());
+        const int right = qMin(run.x + run.length - 1, rect.right());
+        const Cell &cell = cells.at(run.cell);
+
+        for (int x = left; x <= right; ++x)
+            layer->setCell(x - rect.x(), run.y - rect.y(), cell);
+    }
+
+    return layer;
+}
+
+void TileLayerDelta::compress()
+{
+    if (isCompressed() || mRuns.isEmpty())
+        return;
+
+    const int runCount = mRuns.size();
+    const int cellCount = mCells.size();
+    const int runBytes = runCount * sizeof(Run);
+    const int cellBytes = cellCount * sizeof(Cell);
+
+    QByteArray data;
+    data.resize(2 * sizeof(int) + runBytes + cellBytes);
+    char *out = data.data();
+    std::memcpy(out, &runCount, sizeof(int));
+    std::memcpy(out + sizeof(int), &cellCount, sizeof(int));
+    std::memcpy(out + 2 * sizeof(int), mRuns.constData(), runBytes);
+    std::memcpy(out + 2 * sizeof(int) + runBytes, mCells.constData(), cellBytes);
+
+    mCompressed = qCompress(data);
+    mRuns = QVector<Run>();
+    mCells = QVector<Cell>();
+}
+
+qint64 TileLayerDelta::memoryUsage() const
+{
+    return qint64(mRuns.capacity()) * sizeof(Run) +
+            qint64(mCells.capacity()) * sizeof(Cell) +
+            mCompressed.capacity();
+}
+
+void TileLayerDelta::decompress()
+{
+    if (!isCompressed())
+        return;
+
+    decode(mCompressed, mRuns, mCells);
+    mCompressed.clear();
+}
+
+/**
+ * Rebuilds the runs from the cells they describe, dropping cells that have
+ * been overwritten by later runs and joining neighboring runs.
+ */
+void TileLayerDelta::compact()
+{
+    const QRect bounds = mBounds;
+    TileLayer *layer = toTileLayer(bounds);
+
+    mRuns.clear();
+    mCells.clear();
+    mBounds = QRect();
+
+    recordRuns(layer, QRegion(0, 0, layer->width(), layer->height()),
+               bounds.topLeft());
+    mCompactedRunCount = mRuns.size();
+
+    mRuns.squeeze();
+    mCells.squeeze();
+
+    delete layer;
+}
+
+void TileLayerDelta::recordRuns(const TileLayer *layer, const QRegion &region,
+                                const QPoint &offset)
+{
+    CellIndices indices = indicesOf(mCells);
+    const QRect layerRect(0, 0, layer->width(), layer->height());
+
+    foreach (const QRect &r, region.rects()) {
+        const QRect rect = r & layerRect;
+
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            int x = rect.left();
+
+            while (x <= rect.right()) {
+                const Cell cell = layer->cellAt(x, y);
+                if (cell.isEmpty()) {
+                    ++x;
+                    continue;
+                }
+
+                const int start = x;
+                for (++x; x <= rect.right() && layer->cellAt(x, y) == cell; ++x)
+                    ;
+
+                const Run run = {
+                    start + offset.x(), y + offset.y(),
+                    x - start, indexOfCell(mCells, indices, cell)
+                };
+                mRuns.append(run);
+                mBounds |= QRect(run.x, run.y, run.length, 1);
+            }
+        }
+    }
+}
+
+void TileLayerDelta::decode(const QByteArray &compressed,
+                            QVector<Run> &runs, QVector<Cell> &cells)
+{
+    const QByteArray data = qUncompress(compressed);
+    const char *in = data.constData();
+
+    int runCount;
+    int cellCount;
+    std::memcpy(&runCount, in, sizeof(int));
+    std::memcpy(&cellCount, in + sizeof(int), sizeof(int));
+
+    runs.resize(runCount);
+    cells.resize(cellCount);
+
+    const int runBytes = runCount * sizeof(Run);
+    std::memcpy(runs.data(), in + 2 * sizeof(int), runBytes);
+    std::memcpy(cells.data(), in + 2 * sizeof(int) + runBytes,
+                cellCount * sizeof(Cell));
+}
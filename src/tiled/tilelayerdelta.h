@@ -0,0 +1,120 @@
+/*
+ * tilelayerdelta.h
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TILELAYERDELTA_H
+#define TILELAYERDELTA_H
+
+#include "tilelayer.h"
+
+#include <QByteArray>
+#include <QRect>
+#include <QRegion>
+#include <QVector>
+
+namespace Tiled {
+namespace Internal {
+
+/**
+ * A compact record of cells, used by the undo commands to remember the tiles
+ * they painted or replaced.
+ *
+ * Only non-empty cells are stored, as horizontal runs of equal cells. This
+ * keeps the size proportional to the number of changed cells instead of
+ * their bounding rectangle, and makes large areas of the same tile cheap.
+ *
+ * When cells are recorded more than once, the most recently recorded cell
+ * wins. The record can be compressed to save memory while it is not being
+ * used, in which case it is decompressed on demand.
+ */
+class TileLayerDelta
+{
+public:
+    TileLayerDelta();
+
+    /**
+     * Records the non-empty cells of \a layer within \a region. The region
+     * is in the local coordinates of the layer, and the cells are stored at
+     * their local position plus \a offset.
+     */
+    void record(const TileLayer *layer, const QRegion &region,
+                const QPoint &offset = QPoint());
+
+    /**
+     * Adds the cells of \a other that fall within \a region. The added cells
+     * take precedence over the ones already recorded.
+     */
+    void append(const TileLayerDelta &other, const QRegion &region);
+
+    /**
+     * Returns the bounding rectangle of the recorded cells.
+     */
+    QRect bounds() const { return mBounds; }
+
+    /**
+     * Returns a new tile layer with the size of \a rect, containing the
+     * recorded cells that fall within it. The caller takes ownership.
+     */
+    TileLayer *toTileLayer(const QRect &rect) const;
+
+    /**
+     * Compresses the recorded cells. They are decompressed automatically
+     * when needed.
+     */
+    void compress();
+    bool isCompressed() const { return !mCompressed.isEmpty(); }
+
+    /**
+     * Returns the approximate number of bytes allocated by this record, not
+     * counting the size of the object itself.
+     */
+    qint64 memoryUsage() const;
+
+private:
+    /**
+     * A horizontal run of \a length equal cells, starting at (x, y). The
+     * cell is an index into the cell table.
+     */
+    struct Run
+    {
+        int x;
+        int y;
+        int length;
+        int cell;
+    };
+
+    void recordRuns(const TileLayer *layer, const QRegion &region,
+                    const QPoint &offset);
+    void decompress();
+    void compact();
+
+    static void decode(const QByteArray &compressed,
+                       QVector<Run> &runs, QVector<Cell> &cells);
+
+    QVector<Run> mRuns;
+    QVector<Cell> mCells;
+    QRect mBounds;
+    int mCompactedRunCount;
+    QByteArray mCompressed;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // TILELAYERDELTA_H
@@ -24,16 +24,67 @@
 #include "tilelayer.h"
 #include "map.h"
 #include "maprenderer.h"
+#include "mapscene.h"
+#include "preferences.h"
 
+#include <QCache>
 #include <QPainter>
+#include <QPaintDevice>
 #include <QStyleOptionGraphicsItem>
+#include <QtCore/qmath.h>
 
 using namespace Tiled;
 using namespace Tiled::Internal;
 
+namespace {
+
+/**
+ * Identifies a chunk of a tile layer item in the shared chunk cache.
+ */
+struct ChunkKey
+{
+    ChunkKey(const TileLayerItem *item, int x, int y)
+        : item(item), x(x), y(y)
+    {}
+
+    bool operator==(const ChunkKey &other) const
+    { return item == other.item && x == other.x && y == other.y; }
+
+    const TileLayerItem *item;
+    int x;
+    int y;
+};
+
+inline uint qHash(const ChunkKey &key)
+{
+    return ::qHash(key.item) ^ ::qHash((key.x << 16) ^ key.y);
+}
+
+} // anonymous namespace
+
+static const int ChunkSize = 512;
+
+/**
+ * The cost of a single chunk in the cache, in kilobytes.
+ */
+static const int ChunkCost = ChunkSize * ChunkSize * 4 / 1024;
+
+/**
+ * The most memory the chunks of all tile layer items together may use, in
+ * kilobytes.
+ */
+static const int MaxCacheCost = 128 * 1024;
+
+static QCache<ChunkKey, QPixmap> &chunkCache()
+{
+    static QCache<ChunkKey, QPixmap> cache(MaxCacheCost);
+    return cache;
+}
+
 TileLayerItem::TileLayerItem(TileLayer *layer, MapRenderer *renderer)
     : mLayer(layer)
     , mRenderer(renderer)
+    , mChunkScale(0)
 {
     setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
 
@@ -41,10 +92,63 @@ TileLayerItem::TileLayerItem(TileLayer *layer, MapRenderer *renderer)
     setOpacity(mLayer->opacity());
 }
 
+TileLayerItem::~TileLayerItem()
+{
+    // Another item may later be allocated at the same address
+    removeAllChunks();
+}
+
 void TileLayerItem::syncWithTileLayer()
 {
     prepareGeometryChange();
     mBoundingRect = mRenderer->boundingRect(mLayer->bounds());
+    removeAllChunks();
+}
+
+void TileLayerItem::invalidateCache(const QRectF &rect)
+{
+    if (rect.isNull() || mChunkScale == 0) {
+        removeAllChunks();
+        return;
+    }
+
+    const qreal chunkSize = ChunkSize / mChunkScale;
+    removeChunks(qFloor(rect.left() / chunkSize),
+                 qFloor(rect.top() / chunkSize),
+                 qFloor(rect.right() / chunkSize),
+                 qFloor(rect.bottom() / chunkSize));
+}
+
+/**
+ * Removes the chunks of this item from the cache that lie within the given
+ * range of chunk indexes.
+ */
+void TileLayerItem::removeChunks(int startX, int startY, int endX, int endY)
+{
+    QCache<ChunkKey, QPixmap> &cache = chunkCache();
+
+    QSet<ChunkIndex>::iterator it = mCachedChunks.begin();
+    while (it != mCachedChunks.end()) {
+        const int x = it->first;
+        const int y = it->second;
+
+        if (x >= startX && x <= endX && y >= startY && y <= endY) {
+            cache.remove(ChunkKey(this, x, y));
+            it = mCachedChunks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TileLayerItem::removeAllChunks()
+{
+    QCache<ChunkKey, QPixmap> &cache = chunkCache();
+
+    foreach (const ChunkIndex &index, mCachedChunks)
+        cache.remove(ChunkKey(this, index.first, index.second));
+
+    mCachedChunks.clear();
 }
 
 QRectF TileLayerItem::boundingRect() const
@@ -57,5 +161,91 @@ void TileLayerItem::paint(QPainter *painter,
                           QWidget *)
 {
     // TODO: Display a border around the layer when selected
-    mRenderer->drawTileLayer(painter, mLayer, option->exposedRect);
+
+    // The cache is only used when the layer is displayed without rotation or
+    // shearing, since otherwise the chunks would not line up with pixels
+    const QTransform transform = painter->worldTransform();
+    const qreal scale = transform.m11();
+    if (!Preferences::instance()->tileLayerCacheEnabled() ||
+            transform.type() > QTransform::TxScale || scale <= 0 ||
+            transform.m22() != scale) {
+        mRenderer->drawTileLayer(painter, mLayer, option->exposedRect);
+        return;
+    }
+
+    // Keep room for twice the chunks covering the device for each tile layer
+    // shown in the scene. Since this follows the device size, the cache also
+    // shrinks again when the view does. When the budget doesn't allow for
+    // that, the least recently painted chunks are evicted.
+    const QPaintDevice *device = painter->device();
+    const int visibleChunks = (device->width() / ChunkSize + 2) *
+                              (device->height() / ChunkSize + 2);
+    int tileLayerCount = 1;
+    if (const MapScene *mapScene = qobject_cast<MapScene*>(scene()))
+        tileLayerCount = qMax(1, mapScene->visibleTileLayerCount());
+
+    const qint64 visibleCost = qint64(visibleChunks) * ChunkCost *
+                               tileLayerCount;
+
+    QCache<ChunkKey, QPixmap> &cache = chunkCache();
+    cache.setMaxCost(int(qMin(visibleCost * 2, qint64(MaxCacheCost))));
+
+    if (scale != mChunkScale) {
+        removeAllChunks();
+        mChunkScale = scale;
+    }
+
+    const QRectF exposed = option->exposedRect & mBoundingRect;
+    if (exposed.isEmpty())
+        return;
+
+    const int startX = qFloor(exposed.left() * scale / ChunkSize);
+    const int startY = qFloor(exposed.top() * scale / ChunkSize);
+    const int endX = qCeil(exposed.right() * scale / ChunkSize);
+    const int endY = qCeil(exposed.bottom() * scale / ChunkSize);
+
+    // Draw the chunks unscaled, aligned to device pixels
+    painter->save();
+    painter->setWorldTransform(QTransform::fromTranslate(qRound(transform.dx()),
+                                                         qRound(transform.dy())));
+
+    for (int y = startY; y < endY; ++y) {
+        for (int x = startX; x < endX; ++x) {
+            const ChunkKey key(this, x, y);
+            if (QPixmap *chunk = cache.object(key)) {
+                painter->drawPixmap(x * ChunkSize, y * ChunkSize, *chunk);
+                continue;
+            }
+
+            // Draw before inserting, since the cache may delete the chunk
+            QPixmap *chunk = renderChunk(x, y, painter->renderHints());
+            painter->drawPixmap(x * ChunkSize, y * ChunkSize, *chunk);
+            cache.insert(key, chunk, ChunkCost);
+            mCachedChunks.insert(ChunkIndex(x, y));
+        }
+    }
+
+    painter->restore();
+}
+
+/**
+ * Renders the part of the layer covered by the chunk at \a x, \a y, at the
+ * current chunk scale.
+ */
+QPixmap *TileLayerItem::renderChunk(int x, int y,
+                                    QPainter::RenderHints renderHints) const
+{
+    const qreal chunkSize = ChunkSize / mChunkScale;
+    const QRectF rect(x * chunkSize, y * chunkSize, chunkSize, chunkSize);
+
+    QPixmap *chunk = new QPixmap(ChunkSize, ChunkSize);
+    chunk->fill(Qt::transparent);
+
+    QPainter painter(chunk);
+    painter.setRenderHints(renderHints);
+    painter.scale(mChunkScale, mChunkScale);
+    painter.translate(-rect.topLeft());
+    mRenderer->drawTileLayer(&painter, mLayer, rect);
+
+    return chunk;
 }
@@ -22,6 +22,10 @@
 #define TILELAYERITEM_H
 
 #include <QGraphicsItem>
+#include <QPainter>
+#include <QPair>
+#include <QPixmap>
+#include <QSet>
 
 namespace Tiled {
 
@@ -43,6 +47,9 @@ public:
      * @param renderer the map renderer to use to render the layer
      */
     TileLayerItem(TileLayer *layer, MapRenderer *renderer);
+    ~TileLayerItem();
+
+    TileLayer *tileLayer() const { return mLayer; }
 
     /**
      * Updates the size and position of this item. Should be called when the
@@ -54,6 +61,14 @@ public:
      */
     void syncWithTileLayer();
 
+    /**
+     * Drops the cached rendering of the layer within the given \a rect, in
+     * scene coordinates. When no rect is given, the whole cache is dropped.
+     *
+     * Should be called whenever the contents of the layer change.
+     */
+    void invalidateCache(const QRectF &rect = QRectF());
+
     // QGraphicsItem
     QRectF boundingRect() const;
     void paint(QPainter *painter,
@@ -61,9 +76,32 @@ public:
                QWidget *widget = 0);
 
 private:
+    typedef QPair<int, int> ChunkIndex;
+
+    QPixmap *renderChunk(int x, int y,
+                         QPainter::RenderHints renderHints) const;
+
+    void removeChunks(int startX, int startY, int endX, int endY);
+    void removeAllChunks();
+
     TileLayer *mLayer;
     MapRenderer *mRenderer;
     QRectF mBoundingRect;
+
+    /**
+     * When the tile layer cache is enabled in the preferences, the layer is
+     * cached in chunks of a fixed size in device pixels, for the scale at
+     * which it was last painted. The chunks of all tile layer items share
+     * one cache with a global budget, which may evict them at any time.
+     */
+    qreal mChunkScale;
+
+    /**
+     * The chunks this item has put into the shared cache, so that they can
+     * be removed without looking at the chunks of other items. May still
+     * contain chunks that the cache has evicted since.
+     */
+    QSet<ChunkIndex> mCachedChunks;
 };
 
 } // namespace Internal
@@ -150,108 +150,186 @@ void TilePainter::erase(const QRegion &region)
     mMapDocument->emitRegionChanged(paintable);
 }
 
-QRegion TilePainter::computeFillRegion(const QPoint &fillOrigin) const
+namespace {
+
+/**
+ * A horizontal run of cells on a single row.
+ */
+struct Span
 {
-    // Create that region that will hold the fill
-    QRegion fillRegion;
+    Span() : y(0), left(0), right(0) {}
+    Span(int y, int left, int right) : y(y), left(left), right(right) {}
+
+    bool operator<(const Span &other) const
+    {
+        return y < other.y || (y == other.y && left < other.left);
+    }
+
+    int y;
+    int left;
+    int right;
+};
 
+/**
+ * Determines which cells are part of a fill. Coordinates are relative to the
+ * map origin.
+ */
+class FillMatcher
+{
+public:
+    FillMatcher(const TileLayer *layer, const QRect &bounds,
+                const Cell &matchCell, const QRegion &selection)
+        : mLayer(layer)
+        , mBounds(bounds)
+        , mMatchCell(matchCell)
+        , mSelection(selection)
+        , mUseSelection(!selection.isEmpty())
+    {}
+
+    /**
+     * Returns the index of the given cell in an array covering the bounds.
+     */
+    int index(int x, int y) const
+    {
+        return (y - mBounds.top()) * mBounds.width() + x - mBounds.left();
+    }
+
+    bool matches(int x, int y) const
+    {
+        return mBounds.contains(x, y) &&
+                mLayer->cellAt(x - mLayer->x(), y - mLayer->y()) == mMatchCell &&
+                (!mUseSelection || mSelection.contains(QPoint(x, y)));
+    }
+
+private:
+    const TileLayer *mLayer;
+    const QRect mBounds;
+    const Cell mMatchCell;
+    const QRegion &mSelection;
+    const bool mUseSelection;
+};
+
+} // anonymous namespace
+
+/**
+ * Converts a list of non-overlapping spans into a region in one go, instead
+ * of uniting them one by one. Rows with the same spans are merged into
+ * bands, the same way QRegion stores them internally.
+ */
+static QRegion regionFromSpans(QVector<Span> &spans)
+{
+    QRegion region;
+    if (spans.isEmpty())
+        return region;
+
+    qSort(spans.begin(), spans.end());
+
+    QVector<QRect> rects;
+    rects.reserve(spans.size());
+
+    int bandStart = 0;      // index of the first rect of the current band
+    int i = 0;
+
+    while (i < spans.size()) {
+        // Collect the spans of this row
+        const int y = spans.at(i).y;
+        int rowEnd = i;
+        while (rowEnd < spans.size() && spans.at(rowEnd).y == y)
+            ++rowEnd;
+
+        // Try to extend the previous band when this row has the same spans
+        const int bandSize = rects.size() - bandStart;
+        bool extend = bandSize == rowEnd - i &&
+                bandSize > 0 && rects.at(bandStart).bottom() == y - 1;
+
+        for (int j = 0; extend && j < bandSize; ++j) {
+            const QRect &rect = rects.at(bandStart + j);
+            const Span &span = spans.at(i + j);
+            extend = rect.left() == span.left && rect.right() == span.right;
+        }
+
+        if (extend) {
+            for (int j = bandStart; j < rects.size(); ++j)
+                rects[j].setBottom(y);
+        } else {
+            bandStart = rects.size();
+            for (int j = i; j < rowEnd; ++j) {
+                const Span &span = spans.at(j);
+                rects.append(QRect(QPoint(span.left, y),
+                                   QPoint(span.right, y)));
+            }
+        }
+
+        i = rowEnd;
+    }
+
+    region.setRects(rects.constData(), rects.size());
+    return region;
+}
+
+QRegion TilePainter::computeFillRegion(const QPoint &fillOrigin) const
+{
     // Silently quit if parameters are unsatisfactory
     if (!isDrawable(fillOrigin.x(), fillOrigin.y()))
-        return fillRegion;
-
-    // Cache cell that we will match other cells against
-    const Cell matchCell = cellAt(fillOrigin.x(), fillOrigin.y());
-
-    // Grab map dimensions for later use.
-    const int mapWidth = mMapDocument->map()->width();
-    const int mapHeight = mMapDocument->map()->height();
-    const int mapSize = mapWidth * mapHeight;
-
-    // Create a queue to hold cells that need filling
-    QList<QPoint> fillPositions;
-    fillPositions.append(fillOrigin);
-
-    // Create an array that will store which cells have been processed
-    // This is faster than checking if a given cell is in the region/list
-    QVector<quint8> processedCellsVec(mapSize);
-    quint8 *processedCells = processedCellsVec.data();
-
-    // Loop through queued positions and fill them, while at the same time
-    // checking adjacent positions to see if they should be added
-    while (!fillPositions.empty()) {
-        const QPoint currentPoint = fillPositions.takeFirst();
-        const int startOfLine = currentPoint.y() * mapWidth;
-
-        // Seek as far left as we can
-        int left = currentPoint.x();
-        while (cellAt(left - 1, currentPoint.y()) == matchCell &&
-               isDrawable(left - 1, currentPoint.y()))
+        return QRegion();
+
+    // The fill is limited to the part of the layer within the map
+    const Map *map = mMapDocument->map();
+    const QRect bounds = mTileLayer->bounds() & QRect(0, 0, map->width(),
+                                                      map->height());
+    if (!bounds.contains(fillOrigin))
+        return QRegion();
+
+    FillMatcher matcher(mTileLayer, bounds,
+                        cellAt(fillOrigin.x(), fillOrigin.y()),
+                        mMapDocument->selectedArea());
+
+    // Keeps track of the cells that have been filled, relative to the bounds
+    QVector<quint8> filledCells(bounds.width() * bounds.height());
+
+    // The spans of the fill are collected and only turned into a region at
+    // the end. Positions that still need to be looked at are kept on a stack.
+    QVector<Span> spans;
+    QVector<QPoint> seeds;
+    seeds.append(fillOrigin);
+
+    while (!seeds.isEmpty()) {
+        const QPoint seed = seeds.last();
+        seeds.pop_back();
+
+        const int y = seed.y();
+        if (filledCells.at(matcher.index(seed.x(), y)))
+            continue;
+
+        // Seek as far left and right as we can
+        int left = seed.x();
+        while (matcher.matches(left - 1, y))
             --left;
 
-        // Seek as far right as we can
-        int right = currentPoint.x();
-        while (cellAt(right + 1, currentPoint.y()) == matchCell &&
-               isDrawable(right + 1, currentPoint.y()))
+        int right = seed.x();
+        while (matcher.matches(right + 1, y))
             ++right;
 
-        // Add cells between left and right to the region
-        fillRegion += QRegion(left, currentPoint.y(), right - left + 1, 1);
-
-        // Add cell strip to processed cells
-        memset(&processedCells[startOfLine + left],
-               1,
-               right - left);
-
-        // These variables cache whether the last cell was added to the queue
-        // or not as an optimization, since adjacent cells on the x axis
-        // do not need to be added to the queue.
-        bool lastAboveCell = false;
-        bool lastBelowCell = false;
-
-        // Loop between left and right and check if cells above or
-        // below need to be added to the queue
-        for (int x = left; x <= right; ++x) {
-            const QPoint fillPoint(x, currentPoint.y());
-
-            // Check cell above
-            if (fillPoint.y() > 0) {
-                QPoint aboveCell(fillPoint.x(), fillPoint.y() - 1);
-                if (!processedCells[aboveCell.y()*mapWidth + aboveCell.x()] &&
-                    cellAt(aboveCell.x(), aboveCell.y()) == matchCell &&
-                    isDrawable(aboveCell.x(), aboveCell.y()))
-                {
-                    // Do not add the above cell to the queue if its
-                    // x-adjacent cell was added.
-                    if (!lastAboveCell)
-                        fillPositions.append(aboveCell);
-
-                    lastAboveCell = true;
-                } else lastAboveCell = false;
-
-                processedCells[aboveCell.y() * mapWidth + aboveCell.x()] = 1;
-            }
-
-            // Check cell below
-            if (fillPoint.y() + 1 < mapHeight) {
-                QPoint belowCell(fillPoint.x(), fillPoint.y() + 1);
-                if (!processedCells[belowCell.y()*mapWidth + belowCell.x()] &&
-                    cellAt(belowCell.x(), belowCell.y()) == matchCell &&
-                    isDrawable(belowCell.x(), belowCell.y()))
-                {
-                    // Do not add the below cell to the queue if its
-                    // x-adjacent cell was added.
-                    if (!lastBelowCell)
-                        fillPositions.append(belowCell);
-
-                    lastBelowCell = true;
-                } else lastBelowCell = false;
-
-                processedCells[belowCell.y() * mapWidth + belowCell.x()] = 1;
+        spans.append(Span(y, left, right));
+        memset(filledCells.data() + matcher.index(left, y), 1, right - left + 1);
+
+        // Queue the start of each run of matching cells above and below
+        for (int ny = y - 1; ny <= y + 1; ny += 2) {
+            if (ny < bounds.top() || ny > bounds.bottom())
+                continue;
+
+            bool inRun = false;
+            for (int x = left; x <= right; ++x) {
+                const bool matches = !filledCells.at(matcher.index(x, ny)) &&
+                        matcher.matches(x, ny);
+                if (matches && !inRun)
+                    seeds.append(QPoint(x, ny));
+                inRun = matches;
             }
         }
     }
 
-    return fillRegion;
+    return regionFromSpans(spans);
 }
 
 bool TilePainter::isDrawable(int x, int y) const
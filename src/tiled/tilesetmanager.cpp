@@ -22,12 +22,19 @@
 #include "tilesetmanager.h"
 
 #include "filesystemwatcher.h"
+#include "imagecache.h"
 #include "tileanimationdriver.h"
 #include "tile.h"
 #include "tileset.h"
 
 #include <QImage>
 
+#if QT_VERSION >= 0x050000
+#include <QtConcurrent/QtConcurrentRun>
+#else
+#include <QtCore/QtConcurrentRun>
+#endif
+
 using namespace Tiled;
 using namespace Tiled::Internal;
 
@@ -105,6 +112,8 @@ void TilesetManager::addReference(Tileset *tileset)
         mTilesets.insert(tileset, 1);
         if (!tileset->imageSource().isEmpty())
             mWatcher->addPath(tileset->imageSource());
+        if (tileset->isImagePending())
+            loadTilesetImage(tileset);
     }
 }
 
@@ -118,7 +127,16 @@ void TilesetManager::removeReference(Tileset *tileset)
         if (!tileset->imageSource().isEmpty())
             mWatcher->removePath(tileset->imageSource());
 
+        // The result of a background load is no longer needed
+        delete mImageLoaders.take(tileset);
+
+        const QString imageSource = tileset->imageSource();
         delete tileset;
+
+        // The tilesets keep their image as a pixmap, so the cached image
+        // would only be a copy of it
+        if (!imageSource.isEmpty() && !usesImage(imageSource))
+            ImageCache::remove(imageSource);
     }
 }
 
@@ -185,6 +203,9 @@ void TilesetManager::fileChanged(const QString &path)
 
 void TilesetManager::fileChangedTimeout()
 {
+    foreach (const QString &fileName, mChangedFiles)
+        ImageCache::remove(fileName);
+
     foreach (Tileset *tileset, tilesets()) {
         QString fileName = tileset->imageSource();
         if (mChangedFiles.contains(fileName))
@@ -195,17 +216,67 @@ void TilesetManager::fileChangedTimeout()
     mChangedFiles.clear();
 }
 
-void TilesetManager::advanceTileAnimations(int ms)
+/**
+ * Starts decoding the image of a tileset that was loaded with a pending
+ * image on the global thread pool. Until it finishes, the tiles of the
+ * tileset are drawn as placeholders.
+ */
+void TilesetManager::loadTilesetImage(Tileset *tileset)
 {
-    // TODO: This could be more optimal by keeping track of the list of
-    // actually animated tiles
-    foreach (Tileset *tileset, tilesets()) {
-        bool imageChanged = false;
+    QFutureWatcher<QImage> *watcher = new QFutureWatcher<QImage>(this);
+    connect(watcher, SIGNAL(finished()), this, SLOT(tilesetImageLoaded()));
+
+    mImageLoaders.insert(tileset, watcher);
+    watcher->setFuture(QtConcurrent::run(ImageCache::loadImage, tileset->imageSource()));
+}
+
+void TilesetManager::tilesetImageLoaded()
+{
+    QFutureWatcher<QImage> *watcher =
+            static_cast<QFutureWatcher<QImage>*>(sender());
+    Tileset *tileset = mImageLoaders.key(watcher);
+    watcher->deleteLater();
+
+    if (!tileset)
+        return;
 
-        foreach (Tile *tile, tileset->tiles())
-            imageChanged |= tile->advanceAnimation(ms);
+    mImageLoaders.remove(tileset);
 
-        if (imageChanged)
-            emit repaintTileset(tileset);
+    // The image may have been reloaded in the meantime
+    if (!tileset->isImagePending())
+        return;
+
+    if (tileset->loadFromImage(watcher->result(), tileset->imageSource()))
+        emit tilesetChanged(tileset);
+}
+
+/**
+ * Returns whether any of the tilesets uses the image \a imageSource.
+ */
+bool TilesetManager::usesImage(const QString &imageSource) const
+{
+    QMap<Tileset*, int>::const_iterator it = mTilesets.constBegin();
+    QMap<Tileset*, int>::const_iterator it_end = mTilesets.constEnd();
+    for (; it != it_end; ++it)
+        if (it.key()->imageSource() == imageSource)
+            return true;
+
+    return false;
+}
+
+void TilesetManager::advanceTileAnimations(int ms)
+{
+    QMap<Tileset*, int>::const_iterator it = mTilesets.constBegin();
+    QMap<Tileset*, int>::const_iterator it_end = mTilesets.constEnd();
+    for (; it != it_end; ++it) {
+        Tileset *tileset = it.key();
+        QList<Tile*> changedTiles;
+
+        foreach (Tile *tile, tileset->animatedTiles())
+            if (tile->advanceAnimation(ms))
+                changedTiles.append(tile);
+
+        if (!changedTiles.isEmpty())
+            emit repaintTiles(tileset, changedTiles);
     }
 }
@@ -23,6 +23,9 @@
 #define TILESETMANAGER_H
 
 #include <QObject>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QImage>
 #include <QList>
 #include <QMap>
 #include <QString>
@@ -31,6 +34,7 @@
 
 namespace Tiled {
 
+class Tile;
 class Tileset;
 
 namespace Internal {
@@ -138,11 +142,11 @@ signals:
     void tilesetChanged(Tileset *tileset);
 
     /**
-     * Emitted when any images of the tiles in the given \a tileset have
-     * changed. This is used to trigger repaints for displaying tile
+     * Emitted when the images of the given animated \a tiles of \a tileset
+     * have changed. This is used to trigger repaints for displaying tile
      * animations.
      */
-    void repaintTileset(Tileset *tileset);
+    void repaintTiles(Tileset *tileset, const QList<Tile*> &tiles);
 
 private slots:
     void fileChanged(const QString &path);
@@ -150,6 +154,8 @@ private slots:
 
     void advanceTileAnimations(int ms);
 
+    void tilesetImageLoaded();
+
 private:
     Q_DISABLE_COPY(TilesetManager)
 
@@ -163,12 +169,21 @@ private:
      */
     ~TilesetManager();
 
+    void loadTilesetImage(Tileset *tileset);
+    bool usesImage(const QString &imageSource) const;
+
     static TilesetManager *mInstance;
 
     /**
      * Stores the tilesets and maps them to the number of references.
      */
     QMap<Tileset*, int> mTilesets;
+
+    /**
+     * The tileset images that are being loaded in the background.
+     */
+    QHash<Tileset*, QFutureWatcher<QImage>*> mImageLoaders;
+
     FileSystemWatcher *mWatcher;
     TileAnimationDriver *mAnimationDriver;
     QSet<QString> mChangedFiles;
@@ -37,6 +37,13 @@ namespace {
 
 class EditorMapReader : public MapReader
 {
+public:
+    EditorMapReader()
+    {
+        // Speeds up loading maps with many or large tile layers
+        setParallelLayerDecoding(true);
+    }
+
 protected:
     /**
      * Overridden to make sure the resolved reference is a clean path.
@@ -71,7 +78,9 @@ Map *TmxMapReader::read(const QString &fileName)
 {
     mError.clear();
 
+    // The tileset images are loaded in the background by the TilesetManager
     EditorMapReader reader;
+    reader.setTilesetImageLoadingDeferred(true);
     Map *map = reader.readMap(fileName);
     if (!map)
         mError = reader.errorString();
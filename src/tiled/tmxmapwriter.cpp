@@ -37,6 +37,7 @@ bool TmxMapWriter::write(const Map *map, const QString &fileName)
     writer.setLayerDataFormat(map->layerDataFormat());
     writer.setMapRenderOrder(map->renderOrder());
     writer.setDtdEnabled(prefs->dtdEnabled());
+    writer.setParallelLayerEncoding(true);
 
     bool result = writer.writeMap(map, fileName);
     if (!result)
@@ -0,0 +1,90 @@
+/*
+ * undocommands.cpp
+ * Copyright 2026, agent <agent@local>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "undocommands.h"
+
+#include "imagelayer.h"
+#include "mapdocument.h"
+#include "mapobject.h"
+#include "objectgroup.h"
+#include "tilelayer.h"
+
+#include <QUndoCommand>
+
+namespace Tiled {
+namespace Internal {
+
+MemoryConsumingCommand::MemoryConsumingCommand(MapDocument *mapDocument)
+    : mUndoMemoryDocument(mapDocument)
+    , mMemoryUsage(0)
+{
+}
+
+MemoryConsumingCommand::~MemoryConsumingCommand()
+{
+    mUndoMemoryDocument->adjustUndoMemoryUsage(-mMemoryUsage);
+}
+
+void MemoryConsumingCommand::updateMemoryUsage()
+{
+    const qint64 usage = computeMemoryUsage();
+    mUndoMemoryDocument->adjustUndoMemoryUsage(usage - mMemoryUsage);
+    mMemoryUsage = usage;
+}
+
+void compressUndoCommand(const QUndoCommand *command)
+{
+    // QUndoStack only gives const access to its commands
+    QUndoCommand *c = const_cast<QUndoCommand*>(command);
+
+    if (MemoryConsumingCommand *m = dynamic_cast<MemoryConsumingCommand*>(c))
+        m->compress();
+
+    for (int i = 0; i < c->childCount(); ++i)
+        compressUndoCommand(c->child(i));
+}
+
+qint64 layerMemoryUsage(const Layer *layer)
+{
+    switch (layer->layerType()) {
+    case Layer::TileLayerType: {
+        const TileLayer *tileLayer = static_cast<const TileLayer*>(layer);
+        const int cellsPerChunk = TileLayer::ChunkSize * TileLayer::ChunkSize;
+        return sizeof(TileLayer) + qint64(tileLayer->allocatedChunkCount()) *
+                cellsPerChunk * sizeof(quint32);
+    }
+    case Layer::ObjectGroupType: {
+        const ObjectGroup *objectGroup = static_cast<const ObjectGroup*>(layer);
+        return sizeof(ObjectGroup) +
+                qint64(objectGroup->objectCount()) * sizeof(MapObject);
+    }
+    case Layer::ImageLayerType: {
+        const ImageLayer *imageLayer = static_cast<const ImageLayer*>(layer);
+        const QPixmap &image = imageLayer->image();
+        return sizeof(ImageLayer) +
+                qint64(image.width()) * image.height() * image.depth() / 8;
+    }
+    }
+
+    return 0;
+}
+
+} // namespace Internal
+} // namespace Tiled
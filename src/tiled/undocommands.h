@@ -21,6 +21,10 @@
 #ifndef UNDOCOMMANDS_H
 #define UNDOCOMMANDS_H
 
+#include <QtGlobal>
+
+class QUndoCommand;
+
 /**
  * These undo command IDs are used by Qt to determine whether two undo commands
  * can be merged.
@@ -34,4 +38,69 @@ enum UndoCommands {
     Cmd_ChangeTilesetTileOffset
 };
 
+namespace Tiled {
+
+class Layer;
+
+namespace Internal {
+
+class MapDocument;
+
+/**
+ * Base class for undo commands that hold on to a significant amount of data,
+ * so that it can be taken into account by the undo history memory budget.
+ *
+ * Each command reports changes in the amount of memory it uses to its map
+ * document, which keeps a running total for its undo stack.
+ */
+class MemoryConsumingCommand
+{
+public:
+    explicit MemoryConsumingCommand(MapDocument *mapDocument);
+    virtual ~MemoryConsumingCommand();
+
+    /**
+     * Returns the approximate number of bytes used by the command, as last
+     * reported to the map document.
+     */
+    qint64 memoryUsage() const { return mMemoryUsage; }
+
+    /**
+     * Reduces the memory used by the command, for example by compressing its
+     * data. Called for old commands when the undo history uses more memory
+     * than allowed. Does nothing by default.
+     */
+    virtual void compress() {}
+
+protected:
+    /**
+     * Returns the approximate number of bytes currently used by the command.
+     */
+    virtual qint64 computeMemoryUsage() const = 0;
+
+    /**
+     * Reports the memory used by the command to the map document. Needs to be
+     * called whenever the data held by the command changed, starting at the
+     * end of the constructor.
+     */
+    void updateMemoryUsage();
+
+private:
+    MapDocument *mUndoMemoryDocument;
+    qint64 mMemoryUsage;
+};
+
+/**
+ * Compresses the given \a command and its children.
+ */
+void compressUndoCommand(const QUndoCommand *command);
+
+/**
+ * Returns the approximate number of bytes used by the given \a layer.
+ */
+qint64 layerMemoryUsage(const Layer *layer);
+
+} // namespace Internal
+} // namespace Tiled
+
 #endif // UNDOCOMMANDS_H
@@ -21,7 +21,12 @@
 
 #include "undodock.h"
 
+#include "documentmanager.h"
+#include "mapdocument.h"
+
 #include <QEvent>
+#include <QLabel>
+#include <QUndoGroup>
 #include <QUndoView>
 #include <QVBoxLayout>
 
@@ -39,10 +44,18 @@ UndoDock::UndoDock(QUndoGroup *undoGroup, QWidget *parent)
     mUndoView->setUniformItemSizes(true);
     mUndoView->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
 
+    mMemoryUsageLabel = new QLabel;
+
     QWidget *widget = new QWidget(this);
     QVBoxLayout *layout = new QVBoxLayout(widget);
     layout->setMargin(5);
     layout->addWidget(mUndoView);
+    layout->addWidget(mMemoryUsageLabel);
+
+    connect(undoGroup, SIGNAL(activeStackChanged(QUndoStack*)),
+            SLOT(updateMemoryUsage()));
+    connect(undoGroup, SIGNAL(indexChanged(int)),
+            SLOT(updateMemoryUsage()));
 
     setWidget(widget);
     retranslateUi();
@@ -60,8 +73,21 @@ void UndoDock::changeEvent(QEvent *e)
     }
 }
 
+void UndoDock::updateMemoryUsage()
+{
+    // The active undo stack is the one of the current map document
+    qint64 usage = 0;
+    if (MapDocument *mapDocument = DocumentManager::instance()->currentDocument())
+        usage = mapDocument->undoMemoryUsage();
+
+    const double megabytes = usage / (1024.0 * 1024.0);
+    mMemoryUsageLabel->setText(tr("Memory usage: %1 MB")
+                               .arg(megabytes, 0, 'f', 1));
+}
+
 void UndoDock::retranslateUi()
 {
     setWindowTitle(tr("History"));
     mUndoView->setEmptyLabel(tr("<empty>"));
+    updateMemoryUsage();
 }
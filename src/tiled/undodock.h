@@ -24,6 +24,7 @@
 
 #include <QDockWidget>
 
+class QLabel;
 class QUndoGroup;
 class QUndoView;
 
@@ -32,7 +33,7 @@ namespace Internal {
 
 /**
  * A dock widget showing the undo stack. Mainly for debugging, but can also be
- * useful for the user.
+ * useful for the user. Also shows the amount of memory used by the undo stack.
  */
 class UndoDock : public QDockWidget
 {
@@ -44,9 +45,13 @@ public:
 protected:
     void changeEvent(QEvent *e);
 
+private slots:
+    void updateMemoryUsage();
+
 private:
     void retranslateUi();
     QUndoView *mUndoView;
+    QLabel *mMemoryUsageLabel;
 };
 
 } // namespace Internal
@@ -42,6 +42,8 @@ struct CommandLineOptions {
         , tileSize(0)
         , useAntiAliasing(false)
         , ignoreVisibility(false)
+        , pieceSize(0)
+        , split(false)
     {}
 
     bool showHelp;
@@ -52,6 +54,8 @@ struct CommandLineOptions {
     int tileSize;
     bool useAntiAliasing;
     bool ignoreVisibility;
+    int pieceSize;
+    bool split;
     QStringList layersToHide;
 };
 
@@ -74,7 +78,10 @@ static void showHelp()
             "     --ignore-visibility  : Ignore all layer visibility flags in the map file, and render all\n"
             "                            layers in the output (default is to omit invisible layers)\n"
             "     --hide-layer         : Specifies a layer to omit from the output image\n"
-            "                            Can be repeated to hide multiple layers\n";
+            "                            Can be repeated to hide multiple layers\n"
+            "     --piece-size SIZE    : Render the image in pieces of SIZE x SIZE pixels, in parallel\n"
+            "     --split              : Save each piece to a separate file, named after the output\n"
+            "                            file with the column and row of the piece appended\n";
 }
 
 static void showVersion()
@@ -127,6 +134,20 @@ static void parseCommandLineArguments(CommandLineOptions &options)
             } else {
                 options.layersToHide.append(arguments.at(i));
             }
+        } else if (arg == QLatin1String("--piece-size")) {
+            i++;
+            if (i >= arguments.size()) {
+                options.showHelp = true;
+            } else {
+                bool pieceSizeIsInt;
+                options.pieceSize = arguments.at(i).toInt(&pieceSizeIsInt);
+                if (!pieceSizeIsInt || options.pieceSize <= 0) {
+                    qWarning() << arguments.at(i) << ": the specified piece size is not a positive integer.";
+                    options.showHelp = true;
+                }
+            }
+        } else if (arg == QLatin1String("--split")) {
+            options.split = true;
         } else if (arg == QLatin1String("--anti-aliasing")
                 || arg == QLatin1String("-a")) {
             options.useAntiAliasing = true;
@@ -176,6 +197,8 @@ int main(int argc, char *argv[])
     w.setAntiAliasing(options.useAntiAliasing);
     w.setIgnoreVisibility(options.ignoreVisibility);
     w.setLayersToHide(options.layersToHide);
+    w.setPieceSize(options.pieceSize);
+    w.setSplitOutput(options.split);
 
 
     if (options.tileSize > 0) {
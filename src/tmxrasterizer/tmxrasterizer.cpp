@@ -37,8 +37,15 @@
 #include "staggeredrenderer.h"
 #include "tilelayer.h"
 
-
 #include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+
+#if QT_VERSION >= 0x050000
+#include <QtConcurrent/QtConcurrentMap>
+#include <private/qguiapplication_p.h>
+#include <qpa/qplatformintegration.h>
+#endif
 
 using namespace Tiled;
 
@@ -46,7 +53,9 @@ TmxRasterizer::TmxRasterizer():
     mScale(1.0),
     mTileSize(0),
     mUseAntiAliasing(true),
-    mIgnoreVisibility(false)
+    mIgnoreVisibility(false),
+    mPieceSize(0),
+    mSplitOutput(false)
 {
 }
 
@@ -54,7 +63,7 @@ TmxRasterizer::~TmxRasterizer()
 {
 }
 
-bool TmxRasterizer::shouldDrawLayer(Layer *layer)
+bool TmxRasterizer::shouldDrawLayer(Layer *layer) const
 {
     if (layer->isObjectGroup())
         return false;
@@ -68,12 +77,178 @@ bool TmxRasterizer::shouldDrawLayer(Layer *layer)
     return layer->isVisible();
 }
 
+/**
+ * Draws the part of the map that ends up at \a rect in the output image.
+ */
+void TmxRasterizer::drawMap(QPainter *painter, const Map *map,
+                            const MapRenderer *renderer,
+                            qreal xScale, qreal yScale,
+                            const QRect &rect) const
+{
+    if (xScale != qreal(1) || yScale != qreal(1)) {
+        if (mUseAntiAliasing) {
+            painter->setRenderHints(QPainter::SmoothPixmapTransform |
+                                    QPainter::Antialiasing);
+        }
+    }
+
+    QTransform transform = QTransform::fromTranslate(-rect.x(), -rect.y());
+    transform.scale(xScale, yScale);
+    painter->setTransform(transform);
+
+    const QRectF exposed(rect.x() / xScale, rect.y() / yScale,
+                         rect.width() / xScale, rect.height() / yScale);
+
+    // Perform a similar rendering than found in saveasimagedialog.cpp
+    foreach (Layer *layer, map->layers()) {
+
+        if (!shouldDrawLayer(layer)) 
+            continue;
+
+
+        painter->setOpacity(layer->opacity());
+
+        const TileLayer *tileLayer = dynamic_cast<const TileLayer*>(layer);
+        const ImageLayer *imageLayer = dynamic_cast<const ImageLayer*>(layer);
+
+        if (tileLayer) {
+            renderer->drawTileLayer(painter, tileLayer, exposed);
+        } else if (imageLayer) {
+            renderer->drawImageLayer(painter, imageLayer);
+        }
+    }
+}
+
+/**
+ * Renders a single piece of the output image. When no target image is given,
+ * the piece is rendered into its own image and saved to a separate file.
+ *
+ * The pieces don't overlap, so they can be painted into the target image
+ * from multiple threads.
+ */
+class PieceRenderer
+{
+public:
+    typedef void result_type;
+
+    PieceRenderer(const TmxRasterizer *rasterizer,
+                  const Map *map, const MapRenderer *renderer,
+                  qreal xScale, qreal yScale,
+                  QImage *target, const QString &imageFileName)
+        : mRasterizer(rasterizer)
+        , mMap(map)
+        , mRenderer(renderer)
+        , mXScale(xScale)
+        , mYScale(yScale)
+        , mTargetBits(target ? target->bits() : 0)
+        , mTargetBytesPerLine(target ? target->bytesPerLine() : 0)
+        , mTargetFormat(target ? target->format() : QImage::Format_ARGB32)
+        , mImageFileName(imageFileName)
+    {}
+
+    void operator()(const QRect &piece) const
+    {
+        if (mTargetBits) {
+            // Paint directly into the piece's part of the target image
+            uchar *bits = mTargetBits +
+                    piece.y() * mTargetBytesPerLine +
+                    piece.x() * 4;
+            QImage image(bits, piece.width(), piece.height(),
+                         mTargetBytesPerLine, mTargetFormat);
+            QPainter painter(&image);
+            mRasterizer->drawMap(&painter, mMap, mRenderer,
+                                 mXScale, mYScale, piece);
+        } else {
+            QImage image(piece.size(), QImage::Format_ARGB32);
+            image.fill(Qt::transparent);
+            QPainter painter(&image);
+            mRasterizer->drawMap(&painter, mMap, mRenderer,
+                                 mXScale, mYScale, piece);
+            painter.end();
+
+            const int column = piece.x() / mRasterizer->mPieceSize;
+            const int row = piece.y() / mRasterizer->mPieceSize;
+            const QFileInfo fileInfo(mImageFileName);
+            const QString fileName = QString(QLatin1String("%1_%2_%3.%4"))
+                    .arg(fileInfo.completeBaseName())
+                    .arg(column).arg(row)
+                    .arg(fileInfo.suffix());
+
+            if (!image.save(fileInfo.dir().filePath(fileName)))
+                qWarning().nospace() << "Error while saving " << fileName;
+        }
+    }
+
+private:
+    const TmxRasterizer *mRasterizer;
+    const Map *mMap;
+    const MapRenderer *mRenderer;
+    qreal mXScale;
+    qreal mYScale;
+    uchar *mTargetBits;
+    int mTargetBytesPerLine;
+    QImage::Format mTargetFormat;
+    QString mImageFileName;
+};
+
+/**
+ * Renders the map in pieces of mPieceSize pixels, in parallel when possible.
+ */
+void TmxRasterizer::renderPieces(const Map *map, const MapRenderer *renderer,
+                                 qreal xScale, qreal yScale,
+                                 const QSize &imageSize,
+                                 const QString &imageFileName) const
+{
+    const int pieceSize = mPieceSize > 0 ? mPieceSize : 1024;
+
+    QList<QRect> pieces;
+    for (int y = 0; y < imageSize.height(); y += pieceSize)
+        for (int x = 0; x < imageSize.width(); x += pieceSize)
+            pieces.append(QRect(x, y, pieceSize, pieceSize) &
+                          QRect(QPoint(), imageSize));
+
+    QImage image;
+    if (!mSplitOutput) {
+        image = QImage(imageSize, QImage::Format_ARGB32);
+        image.fill(Qt::transparent);
+    }
+
+    const PieceRenderer pieceRenderer(this, map, renderer, xScale, yScale,
+                                      mSplitOutput ? 0 : &image,
+                                      imageFileName);
+
+    // The tileset images are pixmaps, which can only be drawn outside of the
+    // GUI thread when the platform supports it. This is never the case with
+    // Qt 4.
+    bool threadedPixmaps = false;
+#if QT_VERSION >= 0x050000
+    if (QPlatformIntegration *integration =
+            QGuiApplicationPrivate::platformIntegration()) {
+        threadedPixmaps =
+                integration->hasCapability(QPlatformIntegration::ThreadedPixmaps);
+    }
+#endif
+
+    if (threadedPixmaps) {
+#if QT_VERSION >= 0x050000
+        QtConcurrent::blockingMap(pieces, pieceRenderer);
+#endif
+    } else {
+        foreach (const QRect &piece, pieces)
+            pieceRenderer(piece);
+    }
+
+    if (!mSplitOutput)
+        image.save(imageFileName);
+}
+
 int TmxRasterizer::render(const QString &mapFileName,
                           const QString &imageFileName)
 {
     Map *map;
     MapRenderer *renderer;
     MapReader reader;
+    reader.setParallelLayerDecoding(true);
     map = reader.readMap(mapFileName);
     if (!map) {
         qWarning().nospace() << "Error while reading " << mapFileName << ":\n"
@@ -107,39 +282,21 @@ int TmxRasterizer::render(const QString &mapFileName,
     mapSize.rwidth() *= xScale;
     mapSize.rheight() *= yScale;
 
-    QImage image(mapSize, QImage::Format_ARGB32);
-    image.fill(Qt::transparent);
-    QPainter painter(&image);
-
-    if (xScale != qreal(1) || yScale != qreal(1)) {
-        if (mUseAntiAliasing) {
-            painter.setRenderHints(QPainter::SmoothPixmapTransform |
-                                   QPainter::Antialiasing);
-        }
-        painter.setTransform(QTransform::fromScale(xScale, yScale));
-    }
-    // Perform a similar rendering than found in saveasimagedialog.cpp
-    foreach (Layer *layer, map->layers()) {
-
-        if (!shouldDrawLayer(layer)) 
-            continue;
-
-
-        painter.setOpacity(layer->opacity());
+    if (mPieceSize > 0 || mSplitOutput) {
+        renderPieces(map, renderer, xScale, yScale, mapSize, imageFileName);
+    } else {
+        QImage image(mapSize, QImage::Format_ARGB32);
+        image.fill(Qt::transparent);
+        QPainter painter(&image);
 
-        const TileLayer *tileLayer = dynamic_cast<const TileLayer*>(layer);
-        const ImageLayer *imageLayer = dynamic_cast<const ImageLayer*>(layer);
+        drawMap(&painter, map, renderer, xScale, yScale,
+                QRect(QPoint(), mapSize));
 
-        if (tileLayer) {
-            renderer->drawTileLayer(&painter, tileLayer);
-        } else if (imageLayer) {
-            renderer->drawImageLayer(&painter, imageLayer);
-        }
+        // Save image
+        painter.end();
+        image.save(imageFileName);
     }
 
-    // Save image
-    image.save(imageFileName);
-
     delete renderer;
     qDeleteAll(map->tilesets());
     delete map;
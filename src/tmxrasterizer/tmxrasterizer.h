@@ -31,9 +31,17 @@
 
 #include "layer.h"
 
+#include <QRect>
 #include <QString>
 #include <QStringList>
 
+namespace Tiled {
+class Map;
+class MapRenderer;
+}
+
+class QPainter;
+
 using namespace Tiled;
 
 class TmxRasterizer
@@ -47,12 +55,28 @@ public:
     int tileSize() const { return mTileSize; }
     bool useAntiAliasing() const { return mUseAntiAliasing; }
     bool IgnoreVisibility() const { return mIgnoreVisibility; }
+    int pieceSize() const { return mPieceSize; }
+    bool splitOutput() const { return mSplitOutput; }
 
     void setScale(qreal scale) { mScale = scale; }
     void setTileSize(int tileSize) { mTileSize = tileSize; }
     void setAntiAliasing(bool useAntiAliasing) { mUseAntiAliasing = useAntiAliasing; }
     void setIgnoreVisibility(bool IgnoreVisibility) { mIgnoreVisibility = IgnoreVisibility; }
 
+    /**
+     * Sets the size in pixels of the square pieces in which the output image
+     * is rendered. The pieces are rendered in parallel, each with its own
+     * painter. A size of 0 renders the whole image in one go.
+     */
+    void setPieceSize(int pieceSize) { mPieceSize = pieceSize; }
+
+    /**
+     * Sets whether each piece is saved to its own file instead of being
+     * stitched into a single image. This keeps the memory use independent
+     * of the size of the map.
+     */
+    void setSplitOutput(bool splitOutput) { mSplitOutput = splitOutput; }
+
     void setLayersToHide(QStringList layersToHide) { mLayersToHide = layersToHide; }
 
     int render(const QString &mapFileName, const QString &imageFileName);
@@ -62,9 +86,21 @@ private:
     int mTileSize;
     bool mUseAntiAliasing;
     bool mIgnoreVisibility;
+    int mPieceSize;
+    bool mSplitOutput;
     QStringList mLayersToHide;
 
-    bool shouldDrawLayer(Layer *layer);
+    bool shouldDrawLayer(Layer *layer) const;
+    void drawMap(QPainter *painter, const Map *map,
+                 const MapRenderer *renderer,
+                 qreal xScale, qreal yScale,
+                 const QRect &rect) const;
+    void renderPieces(const Map *map, const MapRenderer *renderer,
+                      qreal xScale, qreal yScale,
+                      const QSize &imageSize,
+                      const QString &imageFileName) const;
+
+    friend class PieceRenderer;
 
 };
 
@@ -8,7 +8,7 @@ INSTALLS += target
 TEMPLATE = app
 
 greaterThan(QT_MAJOR_VERSION, 4) {
-    QT += widgets
+    QT += widgets concurrent gui-private
 }
 
 win32 {
@@ -0,0 +1,182 @@
+/*
+ * Checks that finding the matches of the automapping rules in parallel gives
+ * the same result as applying the rules one match at a time, using the sewers
+ * example that comes with Tiled.
+ */
+
+#include "automapper.h"
+#include "map.h"
+#include "mapdocument.h"
+#include "mapobject.h"
+#include "mapreader.h"
+#include "objectgroup.h"
+#include "tile.h"
+#include "tilelayer.h"
+#include "tileset.h"
+#include "tilesetmanager.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+static const char *mapFileName = "../../examples/sewers.tmx";
+static const char *rulesFileName = "../../examples/sewer_automap/rules.txt";
+
+class test_AutoMapper : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void sewers();
+
+private:
+    MapDocument *autoMapSewers(bool parallel);
+};
+
+/**
+ * Returns the rule files listed in \a fileName, in the order in which they
+ * are applied.
+ */
+static QStringList readRuleFiles(const QString &fileName)
+{
+    QStringList ruleFiles;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return ruleFiles;
+
+    const QDir dir = QFileInfo(fileName).dir();
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        if (line.isEmpty()
+                || line.startsWith(QLatin1Char('#'))
+                || line.startsWith(QLatin1String("//")))
+            continue;
+
+        ruleFiles.append(QDir::cleanPath(dir.filePath(line)));
+    }
+
+    return ruleFiles;
+}
+
+/**
+ * Identifies the tile of \a cell independently of the map it was loaded in.
+ */
+static QString tileName(const Cell &cell)
+{
+    if (cell.isEmpty())
+        return QString();
+
+    return QString(QLatin1String("%1:%2:%3%4%5"))
+            .arg(cell.tile->tileset()->name())
+            .arg(cell.tile->id())
+            .arg(cell.flippedHorizontally)
+            .arg(cell.flippedVertically)
+            .arg(cell.flippedAntiDiagonally);
+}
+
+static void compareLayers(const Map *actual, const Map *expected)
+{
+    QCOMPARE(actual->layerCount(), expected->layerCount());
+
+    for (int i = 0; i < actual->layerCount(); ++i) {
+        const Layer *actualLayer = actual->layerAt(i);
+        const Layer *expectedLayer = expected->layerAt(i);
+
+        QCOMPARE(actualLayer->name(), expectedLayer->name());
+        QCOMPARE(actualLayer->layerType(), expectedLayer->layerType());
+
+        if (const TileLayer *actualTiles = actualLayer->asTileLayer()) {
+            const TileLayer *expectedTiles = expectedLayer->asTileLayer();
+            QCOMPARE(actualTiles->size(), expectedTiles->size());
+
+            for (int y = 0; y < actualTiles->height(); ++y)
+                for (int x = 0; x < actualTiles->width(); ++x)
+                    QCOMPARE(tileName(actualTiles->cellAt(x, y)),
+                             tileName(expectedTiles->cellAt(x, y)));
+        } else if (const ObjectGroup *actualObjects = actualLayer->asObjectGroup()) {
+            const ObjectGroup *expectedObjects = expectedLayer->asObjectGroup();
+            QCOMPARE(actualObjects->objectCount(),
+                     expectedObjects->objectCount());
+
+            for (int j = 0; j < actualObjects->objectCount(); ++j) {
+                const MapObject *a = actualObjects->objectAt(j);
+                const MapObject *b = expectedObjects->objectAt(j);
+                QCOMPARE(a->name(), b->name());
+                QCOMPARE(a->type(), b->type());
+                QCOMPARE(a->position(), b->position());
+                QCOMPARE(a->size(), b->size());
+                QCOMPARE(tileName(a->cell()), tileName(b->cell()));
+            }
+        }
+    }
+}
+
+/**
+ * Loads the sewers map and applies each of its rule files to the whole map,
+ * like the AutomappingManager does.
+ */
+MapDocument *test_AutoMapper::autoMapSewers(bool parallel)
+{
+    MapReader reader;
+    Map *map = reader.readMap(QLatin1String(mapFileName));
+    if (!map) {
+        qWarning("%s", qPrintable(reader.errorString()));
+        return 0;
+    }
+
+    // The map document takes ownership of the map and its tilesets
+    MapDocument *mapDocument = new MapDocument(map);
+    const QRegion mapRegion(0, 0, map->width(), map->height());
+
+    foreach (const QString &ruleFile,
+             readRuleFiles(QLatin1String(rulesFileName))) {
+        Map *rules = reader.readMap(ruleFile);
+        if (!rules) {
+            qWarning("%s", qPrintable(reader.errorString()));
+            delete mapDocument;
+            return 0;
+        }
+
+        // The AutoMapper takes ownership of the rules, and releases the
+        // references to their tilesets
+        TilesetManager::instance()->addReferences(rules->tilesets());
+
+        AutoMapper autoMapper(mapDocument, rules, ruleFile);
+        autoMapper.setParallelMatching(parallel);
+        if (!autoMapper.prepareAutoMap()) {
+            qWarning("%s", qPrintable(autoMapper.errorString()));
+            delete mapDocument;
+            return 0;
+        }
+
+        QRegion where = mapRegion;
+        autoMapper.autoMap(&where);
+        autoMapper.cleanAll();
+    }
+
+    return mapDocument;
+}
+
+void test_AutoMapper::sewers()
+{
+    QScopedPointer<MapDocument> serial(autoMapSewers(false));
+    QVERIFY(!serial.isNull());
+
+    QScopedPointer<MapDocument> parallel(autoMapSewers(true));
+    QVERIFY(!parallel.isNull());
+
+    // The first rule file fills the Ground layer
+    const Map *map = serial->map();
+    const int ground = map->indexOfLayer(QLatin1String("Ground"),
+                                         Layer::TileLayerType);
+    QVERIFY(ground != -1);
+    QVERIFY(!map->layerAt(ground)->asTileLayer()->isEmpty());
+
+    compareLayers(parallel->map(), map);
+}
+
+QTEST_MAIN(test_AutoMapper)
+#include "test_automapper.moc"
@@ -0,0 +1,29 @@
+include(../../src/libtiled/libtiled.pri)
+include(../editor.pri)
+
+CONFIG += qtestlib
+TEMPLATE = app
+
+DEFINES += QT_NO_CAST_FROM_ASCII \
+    QT_NO_CAST_TO_ASCII
+
+macx {
+    LIBS += -L$$OUT_PWD/../../bin/Tiled.app/Contents/Frameworks
+} else {
+    LIBS += -L$$OUT_PWD/../../lib
+}
+
+!win32:!macx {
+    QMAKE_RPATHDIR += \$\$ORIGIN/../../lib
+
+    # It is not possible to use ORIGIN in QMAKE_RPATHDIR, so a bit manually
+    QMAKE_LFLAGS += -Wl,-z,origin \'-Wl,-rpath,$$join(QMAKE_RPATHDIR, ":")\'
+    QMAKE_RPATHDIR =
+}
+
+INCLUDEPATH += ..
+
+# Input
+SOURCES += test_benchmarks.cpp
+
+HEADERS += ../testmapreader.h
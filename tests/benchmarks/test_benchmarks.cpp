@@ -0,0 +1,402 @@
+/*
+ * Benchmarks for the performance sensitive parts of libtiled, as well as the
+ * fill and automapping code of the editor.
+ *
+ * The synthetic map used by these benchmarks can be configured using the
+ * following environment variables:
+ *
+ *   TILED_BENCHMARK_MAP_SIZE  width and height of the map in tiles (256)
+ *   TILED_BENCHMARK_LAYERS    number of tile layers (4)
+ *   TILED_BENCHMARK_DENSITY   fraction of cells that contain a tile (0.75)
+ *   TILED_BENCHMARK_RULES     number of automapping rules (64)
+ *
+ * To get results that can be compared between builds, use one of the
+ * machine-readable output formats of QTestLib, for example:
+ *
+ *   ./benchmarks -xml -o results.xml
+ */
+
+#include "automapper.h"
+#include "isometricrenderer.h"
+#include "map.h"
+#include "mapdocument.h"
+#include "mapwriter.h"
+#include "orthogonalrenderer.h"
+#include "staggeredrenderer.h"
+#include "testmapreader.h"
+#include "tilelayer.h"
+#include "tilepainter.h"
+#include "tileset.h"
+#include "tilesetmanager.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+class test_Benchmarks : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void readMap_data();
+    void readMap();
+
+    void writeMap_data();
+    void writeMap();
+
+    void drawTileLayer_data();
+    void drawTileLayer();
+
+    void region();
+    void computeDiffRegion();
+
+    void computeFillRegion_data();
+    void computeFillRegion();
+
+    void autoMap_data();
+    void autoMap();
+
+private:
+    Map *createMap(Map::Orientation orientation) const;
+    Map *createRulesMap(Tileset *tileset) const;
+    QByteArray writeMap(const Map *map, Map::LayerDataFormat format) const;
+
+    int mMapSize;
+    int mLayerCount;
+    qreal mDensity;
+    int mRuleCount;
+
+    QImage mTilesetImage;
+    Map *mMap;
+};
+
+static int environmentInt(const char *name, int defaultValue)
+{
+    bool ok;
+    const int value = qgetenv(name).toInt(&ok);
+    return ok && value > 0 ? value : defaultValue;
+}
+
+static qreal environmentReal(const char *name, qreal defaultValue)
+{
+    bool ok;
+    const qreal value = qgetenv(name).toDouble(&ok);
+    return ok && value >= 0 && value <= 1 ? value : defaultValue;
+}
+
+void test_Benchmarks::initTestCase()
+{
+    mMapSize = environmentInt("TILED_BENCHMARK_MAP_SIZE", 256);
+    mLayerCount = environmentInt("TILED_BENCHMARK_LAYERS", 4);
+    mDensity = environmentReal("TILED_BENCHMARK_DENSITY", 0.75);
+    mRuleCount = environmentInt("TILED_BENCHMARK_RULES", 64);
+
+    // A tileset image of 16x16 tiles, each with its own color
+    mTilesetImage = QImage(256, 256, QImage::Format_ARGB32);
+    QPainter painter(&mTilesetImage);
+    for (int y = 0; y < 16; ++y) {
+        for (int x = 0; x < 16; ++x) {
+            painter.fillRect(x * 16, y * 16, 16, 16,
+                             QColor::fromHsv((x * 16 + y) % 360, 200, 200));
+        }
+    }
+    painter.end();
+
+    mMap = createMap(Map::Orthogonal);
+}
+
+void test_Benchmarks::cleanupTestCase()
+{
+    qDeleteAll(mMap->tilesets());
+    delete mMap;
+    mMap = 0;
+}
+
+/**
+ * Creates a map filled according to the configured size, layer count and
+ * density. The same map is generated on each call.
+ */
+Map *test_Benchmarks::createMap(Map::Orientation orientation) const
+{
+    Map *map = new Map(orientation, mMapSize, mMapSize, 16, 16);
+
+    Tileset *tileset = new Tileset(QLatin1String("tiles"), 16, 16);
+    tileset->loadFromImage(mTilesetImage, QLatin1String("tiles.png"));
+    map->addTileset(tileset);
+
+    const int threshold = qRound(mDensity * 1000);
+    qsrand(1);
+
+    for (int i = 0; i < mLayerCount; ++i) {
+        TileLayer *layer = new TileLayer(QString::number(i), 0, 0,
+                                         mMapSize, mMapSize);
+
+        for (int y = 0; y < mMapSize; ++y) {
+            for (int x = 0; x < mMapSize; ++x) {
+                if (qrand() % 1000 >= threshold)
+                    continue;
+
+                Cell cell(tileset->tileAt(qrand() % tileset->tileCount()));
+                cell.flippedHorizontally = qrand() % 8 == 0;
+                layer->setCell(x, y, cell);
+            }
+        }
+
+        map->addLayer(layer);
+    }
+
+    return map;
+}
+
+/**
+ * Creates a rule map with the configured number of rules, using the given
+ * \a tileset. Each rule matches a pair of tiles on the first layer and
+ * places them in swapped order on the "out" layer. Since the input layer is
+ * not changed, applying the rules again takes the same amount of work.
+ */
+Map *test_Benchmarks::createRulesMap(Tileset *tileset) const
+{
+    // Each rule is two tiles wide, with an empty column in between
+    const int width = mRuleCount * 3;
+    Map *rules = new Map(Map::Orthogonal, width, 1, 16, 16);
+    rules->addTileset(tileset);
+
+    TileLayer *regions = new TileLayer(QLatin1String("regions"),
+                                       0, 0, width, 1);
+    TileLayer *input = new TileLayer(QLatin1String("input_0"),
+                                     0, 0, width, 1);
+    TileLayer *output = new TileLayer(QLatin1String("output_out"),
+                                      0, 0, width, 1);
+
+    const int tileCount = tileset->tileCount();
+    const Cell region(tileset->tileAt(0));
+
+    for (int i = 0; i < mRuleCount; ++i) {
+        const int x = i * 3;
+        const Cell first(tileset->tileAt(i % tileCount));
+        const Cell second(tileset->tileAt((i + 1) % tileCount));
+
+        regions->setCell(x, 0, region);
+        regions->setCell(x + 1, 0, region);
+        input->setCell(x, 0, first);
+        input->setCell(x + 1, 0, second);
+        output->setCell(x, 0, second);
+        output->setCell(x + 1, 0, first);
+    }
+
+    rules->addLayer(regions);
+    rules->addLayer(input);
+    rules->addLayer(output);
+
+    return rules;
+}
+
+QByteArray test_Benchmarks::writeMap(const Map *map,
+                                     Map::LayerDataFormat format) const
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+
+    MapWriter writer;
+    writer.setLayerDataFormat(format);
+    writer.writeMap(map, &buffer, QDir::tempPath());
+
+    return data;
+}
+
+static void addLayerDataFormatRows()
+{
+    QTest::addColumn<int>("format");
+
+    QTest::newRow("XML") << int(Map::XML);
+    QTest::newRow("CSV") << int(Map::CSV);
+    QTest::newRow("Base64") << int(Map::Base64);
+    QTest::newRow("Base64Zlib") << int(Map::Base64Zlib);
+    QTest::newRow("Base64Gzip") << int(Map::Base64Gzip);
+}
+
+void test_Benchmarks::readMap_data()
+{
+    addLayerDataFormatRows();
+}
+
+void test_Benchmarks::readMap()
+{
+    QFETCH(int, format);
+
+    QByteArray data = writeMap(mMap, Map::LayerDataFormat(format));
+    TestMapReader reader(mTilesetImage);
+
+    QBENCHMARK {
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+
+        Map *map = reader.readMap(&buffer, QDir::tempPath());
+        QVERIFY(map);
+        QCOMPARE(map->layerCount(), mLayerCount);
+
+        qDeleteAll(map->tilesets());
+        delete map;
+    }
+}
+
+void test_Benchmarks::writeMap_data()
+{
+    addLayerDataFormatRows();
+}
+
+void test_Benchmarks::writeMap()
+{
+    QFETCH(int, format);
+
+    QBENCHMARK {
+        const QByteArray data = writeMap(mMap, Map::LayerDataFormat(format));
+        QVERIFY(!data.isEmpty());
+    }
+}
+
+void test_Benchmarks::drawTileLayer_data()
+{
+    QTest::addColumn<int>("orientation");
+
+    QTest::newRow("orthogonal") << int(Map::Orthogonal);
+    QTest::newRow("isometric") << int(Map::Isometric);
+    QTest::newRow("staggered") << int(Map::Staggered);
+}
+
+void test_Benchmarks::drawTileLayer()
+{
+    QFETCH(int, orientation);
+
+    Map *map = createMap(Map::Orientation(orientation));
+
+    MapRenderer *renderer = 0;
+    switch (map->orientation()) {
+    case Map::Isometric:
+        renderer = new IsometricRenderer(map);
+        break;
+    case Map::Staggered:
+        renderer = new StaggeredRenderer(map);
+        break;
+    default:
+        renderer = new OrthogonalRenderer(map);
+        break;
+    }
+
+    // Draw the part of the map that would fit on a large screen
+    const QRect exposed(QPoint(), QSize(1920, 1080));
+    QImage image(exposed.size(), QImage::Format_ARGB32_Premultiplied);
+
+    QBENCHMARK {
+        image.fill(Qt::transparent);
+        QPainter painter(&image);
+
+        foreach (Layer *layer, map->layers())
+            renderer->drawTileLayer(&painter, layer->asTileLayer(), exposed);
+    }
+
+    delete renderer;
+    qDeleteAll(map->tilesets());
+    delete map;
+}
+
+void test_Benchmarks::region()
+{
+    const TileLayer *layer = mMap->layerAt(0)->asTileLayer();
+
+    QBENCHMARK {
+        layer->region();
+    }
+}
+
+void test_Benchmarks::computeDiffRegion()
+{
+    const TileLayer *layer = mMap->layerAt(0)->asTileLayer();
+
+    TileLayer *changed = static_cast<TileLayer*>(layer->clone());
+    const Cell cell = changed->cellAt(0, 0);
+    for (int i = 0; i < mMapSize; ++i)
+        changed->setCell(i, i, cell);
+
+    QBENCHMARK {
+        layer->computeDiffRegion(changed);
+    }
+
+    delete changed;
+}
+
+void test_Benchmarks::computeFillRegion_data()
+{
+    QTest::addColumn<bool>("empty");
+
+    // Filling an empty layer covers the whole map, while the random tiles
+    // of a filled layer only form small regions
+    QTest::newRow("empty") << true;
+    QTest::newRow("filled") << false;
+}
+
+void test_Benchmarks::computeFillRegion()
+{
+    QFETCH(bool, empty);
+
+    Map *map = createMap(Map::Orthogonal);
+    map->addLayer(new TileLayer(QLatin1String("empty"), 0, 0,
+                                mMapSize, mMapSize));
+
+    // The map document takes ownership of the map and its tilesets
+    MapDocument mapDocument(map);
+    TileLayer *layer = map->layerAt(empty ? map->layerCount() - 1 : 0)
+            ->asTileLayer();
+
+    TilePainter painter(&mapDocument, layer);
+    const QPoint fillOrigin(mMapSize / 2, mMapSize / 2);
+
+    QBENCHMARK {
+        const QRegion region = painter.computeFillRegion(fillOrigin);
+        QVERIFY(!region.isEmpty());
+    }
+}
+
+void test_Benchmarks::autoMap_data()
+{
+    QTest::addColumn<bool>("parallel");
+
+    QTest::newRow("serial") << false;
+    QTest::newRow("parallel") << true;
+}
+
+void test_Benchmarks::autoMap()
+{
+    QFETCH(bool, parallel);
+
+    // The map document takes ownership of the map and its tilesets
+    Map *map = createMap(Map::Orthogonal);
+    MapDocument mapDocument(map);
+
+    // The AutoMapper takes ownership of the rules, and releases the
+    // references to their tilesets, like the AutomappingManager expects
+    Map *rules = createRulesMap(map->tilesetAt(0));
+    TilesetManager::instance()->addReferences(rules->tilesets());
+
+    AutoMapper autoMapper(&mapDocument, rules, QLatin1String("rules.tmx"));
+    autoMapper.setParallelMatching(parallel);
+    QVERIFY2(autoMapper.prepareAutoMap(),
+             qPrintable(autoMapper.errorString()));
+
+    const QRegion mapRegion(0, 0, mMapSize, mMapSize);
+
+    QBENCHMARK {
+        QRegion where = mapRegion;
+        autoMapper.autoMap(&where);
+    }
+
+    autoMapper.cleanAll();
+}
+
+QTEST_MAIN(test_Benchmarks)
+#include "test_benchmarks.moc"
@@ -0,0 +1,29 @@
+include(../../src/libtiled/libtiled.pri)
+
+CONFIG += qtestlib
+TEMPLATE = app
+
+macx {
+    LIBS += -L$$OUT_PWD/../../bin/Tiled.app/Contents/Frameworks
+} else {
+    LIBS += -L$$OUT_PWD/../../lib
+}
+
+!win32:!macx {
+    QMAKE_RPATHDIR += \$\$ORIGIN/../../lib
+
+    # It is not possible to use ORIGIN in QMAKE_RPATHDIR, so a bit manually
+    QMAKE_LFLAGS += -Wl,-z,origin \'-Wl,-rpath,$$join(QMAKE_RPATHDIR, ":")\'
+    QMAKE_RPATHDIR =
+}
+
+INCLUDEPATH += ../../src/plugins/binary
+
+# Input
+SOURCES += test_binarymap.cpp \
+    ../../src/plugins/binary/binarymapreader.cpp \
+    ../../src/plugins/binary/binarymapwriter.cpp
+
+HEADERS += ../../src/plugins/binary/binarymapformat.h \
+    ../../src/plugins/binary/binarymapreader.h \
+    ../../src/plugins/binary/binarymapwriter.h
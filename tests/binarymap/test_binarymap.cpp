@@ -0,0 +1,402 @@
+#include "binarymapreader.h"
+#include "binarymapwriter.h"
+
+#include "imagelayer.h"
+#include "map.h"
+#include "mapobject.h"
+#include "objectgroup.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+
+#include <QBuffer>
+#include <QFile>
+#include <QImage>
+#include <QtEndian>
+
+using namespace Tiled;
+using namespace Binary;
+
+// Positions of the fields in the header of a binary map file
+static const int DataOffsetPosition = 8;
+static const int WidthPosition = 20;
+static const int HeightPosition = 24;
+static const int TileWidthPosition = 28;
+static const int TileHeightPosition = 32;
+
+class test_BinaryMap : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void roundTrip_data();
+    void roundTrip();
+    void truncatedInput_data();
+    void truncatedInput();
+    void negativeHeaderValue_data();
+    void negativeHeaderValue();
+    void corruptLayerData_data();
+    void corruptLayerData();
+
+private:
+    Map *createMap() const;
+    QByteArray writeMap(const Map *map, bool compressed) const;
+    Map *readFile(const QByteArray &data, bool lazy, QString *error = 0);
+    Map *readData(const QByteArray &data, QString *error = 0) const;
+    void compareMaps(const Map *a, const Map *b) const;
+
+    QDir mDir;
+    QString mImageFileName;
+    QString mMapFileName;
+};
+
+static void deleteMap(Map *map)
+{
+    if (map) {
+        qDeleteAll(map->tilesets());
+        delete map;
+    }
+}
+
+void test_BinaryMap::initTestCase()
+{
+    mDir = QDir(QDir::temp().absoluteFilePath(QLatin1String("tiled_test_binarymap")));
+    QVERIFY(QDir().mkpath(mDir.path()));
+
+    mImageFileName = mDir.absoluteFilePath(QLatin1String("tiles.png"));
+    mMapFileName = mDir.absoluteFilePath(QLatin1String("map.tmb"));
+
+    QImage image(32, 16, QImage::Format_ARGB32);
+    image.fill(0xff00ff00);
+    QVERIFY(image.save(mImageFileName));
+}
+
+void test_BinaryMap::cleanupTestCase()
+{
+    QFile::remove(mImageFileName);
+    QFile::remove(mMapFileName);
+    mDir.rmdir(mDir.path());
+}
+
+/**
+ * Creates a map with a layer of each type. The tile layer is higher than a
+ * single chunk and uses all combinations of flags.
+ */
+Map *test_BinaryMap::createMap() const
+{
+    Map *map = new Map(Map::Orthogonal, 40, 80, 16, 16);
+    map->setProperty(QLatin1String("name"), QLatin1String("value"));
+
+    Tileset *tileset = new Tileset(QLatin1String("tiles"), 16, 16);
+    tileset->loadFromImage(QImage(mImageFileName), mImageFileName);
+    map->addTileset(tileset);
+
+    TileLayer *tileLayer = new TileLayer(QLatin1String("tiles"), 0, 0, 40, 80);
+    for (int y = 0; y < 80; ++y) {
+        for (int x = 0; x < 40; ++x) {
+            if ((x + y) % 3 == 0)
+                continue;
+
+            Cell cell(tileset->tileAt((x + y) % 2));
+            cell.flippedHorizontally = x & 1;
+            cell.flippedVertically = x & 2;
+            cell.flippedAntiDiagonally = x & 4;
+            tileLayer->setCell(x, y, cell);
+        }
+    }
+    tileLayer->setOpacity(0.5);
+    map->addLayer(tileLayer);
+
+    ObjectGroup *objectGroup = new ObjectGroup(QLatin1String("objects"),
+                                               0, 0, 40, 80);
+    objectGroup->setColor(Qt::red);
+
+    MapObject *rectangle = new MapObject(QLatin1String("rectangle"),
+                                         QLatin1String("type"),
+                                         QPointF(1, 2), QSizeF(3, 4));
+    rectangle->setRotation(45);
+    objectGroup->addObject(rectangle);
+
+    MapObject *polygon = new MapObject(QLatin1String("polygon"), QString(),
+                                       QPointF(5, 6), QSizeF());
+    polygon->setShape(MapObject::Polygon);
+    polygon->setPolygon(QPolygonF() << QPointF(0, 0) << QPointF(2, 0)
+                        << QPointF(1, 3));
+    objectGroup->addObject(polygon);
+
+    MapObject *tileObject = new MapObject(QLatin1String("tile"), QString(),
+                                          QPointF(7, 8), QSizeF(16, 16));
+    Cell cell(tileset->tileAt(1));
+    cell.flippedVertically = true;
+    tileObject->setCell(cell);
+    tileObject->setVisible(false);
+    objectGroup->addObject(tileObject);
+    map->addLayer(objectGroup);
+
+    ImageLayer *imageLayer = new ImageLayer(QLatin1String("image"),
+                                            0, 0, 40, 80);
+    imageLayer->loadFromImage(QImage(mImageFileName), mImageFileName);
+    imageLayer->setVisible(false);
+    map->addLayer(imageLayer);
+
+    return map;
+}
+
+QByteArray test_BinaryMap::writeMap(const Map *map, bool compressed) const
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+
+    BinaryMapWriter writer;
+    writer.setCompressionEnabled(compressed);
+    if (!writer.write(map, &buffer, mDir))
+        qWarning("%s", qPrintable(writer.errorString()));
+
+    return data;
+}
+
+/**
+ * Reads the map from a file holding the given \a data, which allows the tile
+ * layers to be loaded lazily.
+ */
+Map *test_BinaryMap::readFile(const QByteArray &data, bool lazy,
+                              QString *error)
+{
+    QFile file(mMapFileName);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size())
+        return 0;
+    file.close();
+
+    BinaryMapReader reader;
+    reader.setLazyLoadingEnabled(lazy);
+    Map *map = reader.read(mMapFileName);
+    if (error)
+        *error = reader.errorString();
+    return map;
+}
+
+Map *test_BinaryMap::readData(const QByteArray &data, QString *error) const
+{
+    BinaryMapReader reader;
+    Map *map = reader.read(reinterpret_cast<const uchar*>(data.constData()),
+                           data.size(), mDir);
+    if (error)
+        *error = reader.errorString();
+    return map;
+}
+
+static int tileId(const Cell &cell)
+{
+    return cell.tile ? cell.tile->id() : -1;
+}
+
+void test_BinaryMap::compareMaps(const Map *a, const Map *b) const
+{
+    QCOMPARE(b->orientation(), a->orientation());
+    QCOMPARE(b->size(), a->size());
+    QCOMPARE(b->tileWidth(), a->tileWidth());
+    QCOMPARE(b->tileHeight(), a->tileHeight());
+    QCOMPARE(b->properties(), a->properties());
+    QCOMPARE(b->tilesetCount(), a->tilesetCount());
+    QCOMPARE(b->layerCount(), a->layerCount());
+
+    for (int i = 0; i < a->layerCount(); ++i) {
+        const Layer *layerA = a->layerAt(i);
+        const Layer *layerB = b->layerAt(i);
+
+        QCOMPARE(layerB->layerType(), layerA->layerType());
+        QCOMPARE(layerB->name(), layerA->name());
+        QCOMPARE(layerB->bounds(), layerA->bounds());
+        QCOMPARE(layerB->opacity(), layerA->opacity());
+        QCOMPARE(layerB->isVisible(), layerA->isVisible());
+
+        if (layerA->isTileLayer()) {
+            const TileLayer *tilesA = static_cast<const TileLayer*>(layerA);
+            const TileLayer *tilesB = static_cast<const TileLayer*>(layerB);
+
+            for (int y = 0; y < tilesA->height(); ++y) {
+                for (int x = 0; x < tilesA->width(); ++x) {
+                    const Cell cellA = tilesA->cellAt(x, y);
+                    const Cell cellB = tilesB->cellAt(x, y);
+                    QCOMPARE(tileId(cellB), tileId(cellA));
+                    QCOMPARE(cellB.flippedHorizontally, cellA.flippedHorizontally);
+                    QCOMPARE(cellB.flippedVertically, cellA.flippedVertically);
+                    QCOMPARE(cellB.flippedAntiDiagonally, cellA.flippedAntiDiagonally);
+                }
+            }
+
+            QCOMPARE(tilesB->drawMargins(), tilesA->drawMargins());
+        } else if (layerA->isObjectGroup()) {
+            const ObjectGroup *groupA = static_cast<const ObjectGroup*>(layerA);
+            const ObjectGroup *groupB = static_cast<const ObjectGroup*>(layerB);
+
+            QCOMPARE(groupB->color(), groupA->color());
+            QCOMPARE(groupB->objectCount(), groupA->objectCount());
+
+            for (int j = 0; j < groupA->objectCount(); ++j) {
+                const MapObject *objectA = groupA->objects().at(j);
+                const MapObject *objectB = groupB->objects().at(j);
+
+                QCOMPARE(objectB->name(), objectA->name());
+                QCOMPARE(objectB->type(), objectA->type());
+                QCOMPARE(objectB->position(), objectA->position());
+                QCOMPARE(objectB->size(), objectA->size());
+                QCOMPARE(objectB->rotation(), objectA->rotation());
+                QCOMPARE(objectB->isVisible(), objectA->isVisible());
+                QCOMPARE(objectB->shape(), objectA->shape());
+                QCOMPARE(objectB->polygon(), objectA->polygon());
+                QCOMPARE(tileId(objectB->cell()), tileId(objectA->cell()));
+                QCOMPARE(objectB->cell().flippedVertically,
+                         objectA->cell().flippedVertically);
+            }
+        } else if (layerA->isImageLayer()) {
+            const ImageLayer *imageA = static_cast<const ImageLayer*>(layerA);
+            const ImageLayer *imageB = static_cast<const ImageLayer*>(layerB);
+
+            QCOMPARE(imageB->imageSource(), imageA->imageSource());
+        }
+    }
+}
+
+void test_BinaryMap::roundTrip_data()
+{
+    QTest::addColumn<bool>("compressed");
+    QTest::addColumn<bool>("lazy");
+
+    QTest::newRow("uncompressed") << false << false;
+    QTest::newRow("compressed") << true << false;
+    QTest::newRow("uncompressed, lazy") << false << true;
+    QTest::newRow("compressed, lazy") << true << true;
+}
+
+void test_BinaryMap::roundTrip()
+{
+    QFETCH(bool, compressed);
+    QFETCH(bool, lazy);
+
+    Map *map = createMap();
+    QString error;
+    Map *read = readFile(writeMap(map, compressed), lazy, &error);
+    QVERIFY2(read, qPrintable(error));
+
+    QCOMPARE(read->layerDataFormat(), compressed ? Map::Base64Zlib
+                                                 : Map::Base64);
+
+    const TileLayer *tileLayer = read->layerAt(0)->asTileLayer();
+    QCOMPARE(tileLayer->hasPendingCells(), lazy);
+
+    compareMaps(map, read);
+    QVERIFY(!tileLayer->hasPendingCells());
+
+    deleteMap(read);
+    deleteMap(map);
+}
+
+void test_BinaryMap::truncatedInput_data()
+{
+    QTest::addColumn<bool>("compressed");
+
+    QTest::newRow("uncompressed") << false;
+    QTest::newRow("compressed") << true;
+}
+
+void test_BinaryMap::truncatedInput()
+{
+    QFETCH(bool, compressed);
+
+    Map *map = createMap();
+    const QByteArray data = writeMap(map, compressed);
+    deleteMap(map);
+
+    const int step = qMax(1, data.size() / 200);
+
+    for (int size = 0; size < data.size(); size += step) {
+        QString error;
+        Map *read = readData(data.left(size), &error);
+        QVERIFY2(!read, qPrintable(QString::number(size)));
+        QVERIFY(!error.isEmpty());
+    }
+
+    // Only the last chunk is missing a byte
+    QString error;
+    QVERIFY(!readData(data.left(data.size() - 1), &error));
+    QVERIFY(!error.isEmpty());
+}
+
+void test_BinaryMap::negativeHeaderValue_data()
+{
+    QTest::addColumn<int>("position");
+
+    QTest::newRow("width") << WidthPosition;
+    QTest::newRow("height") << HeightPosition;
+    QTest::newRow("tile width") << TileWidthPosition;
+    QTest::newRow("tile height") << TileHeightPosition;
+}
+
+void test_BinaryMap::negativeHeaderValue()
+{
+    QFETCH(int, position);
+
+    Map *map = createMap();
+    QByteArray data = writeMap(map, true);
+    deleteMap(map);
+
+    qToLittleEndian<qint32>(-1, reinterpret_cast<uchar*>(data.data() + position));
+
+    QString error;
+    QVERIFY(!readData(data, &error));
+    QVERIFY(!error.isEmpty());
+}
+
+void test_BinaryMap::corruptLayerData_data()
+{
+    QTest::addColumn<bool>("compressed");
+    QTest::addColumn<QString>("expectedError");
+
+    QTest::newRow("invalid gid") << false << QString::fromLatin1("Invalid tile: 255");
+    QTest::newRow("corrupt zlib stream")
+            << true << QString::fromLatin1("Corrupt layer data for layer 'tiles'");
+}
+
+/**
+ * Corrupts the data of the first chunk. This is only noticed while decoding,
+ * so reading fails when decoding right away, while a lazily loaded layer
+ * prints a warning and keeps the cells decoded so far.
+ */
+void test_BinaryMap::corruptLayerData()
+{
+    QFETCH(bool, compressed);
+    QFETCH(QString, expectedError);
+
+    Map *map = createMap();
+    QByteArray data = writeMap(map, compressed);
+    deleteMap(map);
+
+    // The first chunk is at the start of the data section
+    const quint64 dataOffset = qFromLittleEndian<quint64>(
+                reinterpret_cast<const uchar*>(data.constData() +
+                                               DataOffsetPosition));
+    uchar *chunk = reinterpret_cast<uchar*>(data.data() + dataOffset);
+    qToLittleEndian<quint32>(255, chunk);
+
+    QString error;
+    QVERIFY(!readData(data, &error));
+    QCOMPARE(error, expectedError);
+
+    Map *read = readFile(data, true, &error);
+    QVERIFY2(read, qPrintable(error));
+
+    const TileLayer *tileLayer = read->layerAt(0)->asTileLayer();
+    QTest::ignoreMessage(QtWarningMsg, qPrintable(expectedError));
+    QVERIFY(tileLayer->isEmpty());
+
+    deleteMap(read);
+}
+
+QTEST_MAIN(test_BinaryMap)
+#include "test_binarymap.moc"
@@ -0,0 +1,110 @@
+# The parts of the editor needed by the tests that depend on the MapDocument,
+# like filling and automapping
+greaterThan(QT_MAJOR_VERSION, 4) {
+    QT += widgets concurrent
+}
+contains(QT_CONFIG, opengl): QT += opengl
+
+TILED_SOURCES = $$PWD/../src/tiled
+INCLUDEPATH += $$TILED_SOURCES
+DEPENDPATH += $$TILED_SOURCES
+
+SOURCES += $$TILED_SOURCES/abstracttool.cpp \
+    $$TILED_SOURCES/addremovelayer.cpp \
+    $$TILED_SOURCES/addremovemapobject.cpp \
+    $$TILED_SOURCES/addremovetileset.cpp \
+    $$TILED_SOURCES/automapper.cpp \
+    $$TILED_SOURCES/automappingutils.cpp \
+    $$TILED_SOURCES/changelayer.cpp \
+    $$TILED_SOURCES/changemapobject.cpp \
+    $$TILED_SOURCES/changeproperties.cpp \
+    $$TILED_SOURCES/changeselectedarea.cpp \
+    $$TILED_SOURCES/documentmanager.cpp \
+    $$TILED_SOURCES/filesystemwatcher.cpp \
+    $$TILED_SOURCES/flipmapobjects.cpp \
+    $$TILED_SOURCES/geometry.cpp \
+    $$TILED_SOURCES/imagelayeritem.cpp \
+    $$TILED_SOURCES/languagemanager.cpp \
+    $$TILED_SOURCES/layermodel.cpp \
+    $$TILED_SOURCES/mapdocument.cpp \
+    $$TILED_SOURCES/mapobjectitem.cpp \
+    $$TILED_SOURCES/mapobjectmodel.cpp \
+    $$TILED_SOURCES/mapscene.cpp \
+    $$TILED_SOURCES/mapview.cpp \
+    $$TILED_SOURCES/movabletabwidget.cpp \
+    $$TILED_SOURCES/movelayer.cpp \
+    $$TILED_SOURCES/movemapobject.cpp \
+    $$TILED_SOURCES/movemapobjecttogroup.cpp \
+    $$TILED_SOURCES/objectgroupitem.cpp \
+    $$TILED_SOURCES/objecttypes.cpp \
+    $$TILED_SOURCES/offsetlayer.cpp \
+    $$TILED_SOURCES/painttilelayer.cpp \
+    $$TILED_SOURCES/pluginmanager.cpp \
+    $$TILED_SOURCES/preferences.cpp \
+    $$TILED_SOURCES/renamelayer.cpp \
+    $$TILED_SOURCES/renameterrain.cpp \
+    $$TILED_SOURCES/resizemap.cpp \
+    $$TILED_SOURCES/resizemapobject.cpp \
+    $$TILED_SOURCES/resizetilelayer.cpp \
+    $$TILED_SOURCES/rotatemapobject.cpp \
+    $$TILED_SOURCES/terrainmodel.cpp \
+    $$TILED_SOURCES/tileanimationdriver.cpp \
+    $$TILED_SOURCES/tilelayerdelta.cpp \
+    $$TILED_SOURCES/tilelayeritem.cpp \
+    $$TILED_SOURCES/tilepainter.cpp \
+    $$TILED_SOURCES/tileselectionitem.cpp \
+    $$TILED_SOURCES/tilesetmanager.cpp \
+    $$TILED_SOURCES/tmxmapwriter.cpp \
+    $$TILED_SOURCES/toolmanager.cpp \
+    $$TILED_SOURCES/undocommands.cpp \
+    $$TILED_SOURCES/zoomable.cpp
+
+HEADERS += $$TILED_SOURCES/abstracttool.h \
+    $$TILED_SOURCES/addremovelayer.h \
+    $$TILED_SOURCES/addremovemapobject.h \
+    $$TILED_SOURCES/addremovetileset.h \
+    $$TILED_SOURCES/automapper.h \
+    $$TILED_SOURCES/automappingutils.h \
+    $$TILED_SOURCES/changelayer.h \
+    $$TILED_SOURCES/changemapobject.h \
+    $$TILED_SOURCES/changeproperties.h \
+    $$TILED_SOURCES/changeselectedarea.h \
+    $$TILED_SOURCES/documentmanager.h \
+    $$TILED_SOURCES/filesystemwatcher.h \
+    $$TILED_SOURCES/flipmapobjects.h \
+    $$TILED_SOURCES/geometry.h \
+    $$TILED_SOURCES/imagelayeritem.h \
+    $$TILED_SOURCES/languagemanager.h \
+    $$TILED_SOURCES/layermodel.h \
+    $$TILED_SOURCES/mapdocument.h \
+    $$TILED_SOURCES/mapobjectitem.h \
+    $$TILED_SOURCES/mapobjectmodel.h \
+    $$TILED_SOURCES/mapscene.h \
+    $$TILED_SOURCES/mapview.h \
+    $$TILED_SOURCES/movabletabwidget.h \
+    $$TILED_SOURCES/movelayer.h \
+    $$TILED_SOURCES/movemapobject.h \
+    $$TILED_SOURCES/movemapobjecttogroup.h \
+    $$TILED_SOURCES/objectgroupitem.h \
+    $$TILED_SOURCES/objecttypes.h \
+    $$TILED_SOURCES/offsetlayer.h \
+    $$TILED_SOURCES/painttilelayer.h \
+    $$TILED_SOURCES/pluginmanager.h \
+    $$TILED_SOURCES/preferences.h \
+    $$TILED_SOURCES/renamelayer.h \
+    $$TILED_SOURCES/renameterrain.h \
+    $$TILED_SOURCES/resizemap.h \
+    $$TILED_SOURCES/resizemapobject.h \
+    $$TILED_SOURCES/resizetilelayer.h \
+    $$TILED_SOURCES/rotatemapobject.h \
+    $$TILED_SOURCES/terrainmodel.h \
+    $$TILED_SOURCES/tileanimationdriver.h \
+    $$TILED_SOURCES/tilelayerdelta.h \
+    $$TILED_SOURCES/tilelayeritem.h \
+    $$TILED_SOURCES/tilepainter.h \
+    $$TILED_SOURCES/tileselectionitem.h \
+    $$TILED_SOURCES/tilesetmanager.h \
+    $$TILED_SOURCES/tmxmapwriter.h \
+    $$TILED_SOURCES/toolmanager.h \
+    $$TILED_SOURCES/undocommands.h \
+    $$TILED_SOURCES/zoomable.h
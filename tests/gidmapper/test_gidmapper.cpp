@@ -0,0 +1,151 @@
+#include "gidmapper.h"
+#include "tile.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_GidMapper : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void roundTrip();
+    void flags();
+    void invalidGids();
+    void changedTilesetWidth();
+    void bulkConversion();
+
+private:
+    Tileset *mFirst;
+    Tileset *mSecond;
+};
+
+static Tileset *createTileset(const QString &name, int columns, int rows)
+{
+    Tileset *tileset = new Tileset(name, 16, 16);
+    QImage image(columns * 16, rows * 16, QImage::Format_ARGB32);
+    image.fill(Qt::white);
+    tileset->loadFromImage(image, name + QLatin1String(".png"));
+    return tileset;
+}
+
+void test_GidMapper::initTestCase()
+{
+    mFirst = createTileset(QLatin1String("first"), 4, 4);
+    mSecond = createTileset(QLatin1String("second"), 2, 2);
+}
+
+void test_GidMapper::cleanupTestCase()
+{
+    delete mFirst;
+    delete mSecond;
+}
+
+void test_GidMapper::roundTrip()
+{
+    GidMapper gidMapper(QList<Tileset*>() << mFirst << mSecond);
+
+    QCOMPARE(gidMapper.cellToGid(Cell()), 0u);
+    QCOMPARE(gidMapper.cellToGid(Cell(mFirst->tileAt(0))), 1u);
+    QCOMPARE(gidMapper.cellToGid(Cell(mFirst->tileAt(15))), 16u);
+    QCOMPARE(gidMapper.cellToGid(Cell(mSecond->tileAt(0))), 17u);
+
+    for (unsigned gid = 1; gid <= 20; ++gid) {
+        bool ok;
+        const Cell cell = gidMapper.gidToCell(gid, ok);
+        QVERIFY(ok);
+        QVERIFY(!cell.isEmpty());
+        QCOMPARE(gidMapper.cellToGid(cell), gid);
+    }
+
+    // Gids past the last tile give empty cells
+    bool ok;
+    QVERIFY(gidMapper.gidToCell(21, ok).isEmpty());
+    QVERIFY(ok);
+}
+
+void test_GidMapper::flags()
+{
+    GidMapper gidMapper(QList<Tileset*>() << mFirst);
+
+    Cell cell(mFirst->tileAt(3));
+    cell.flippedHorizontally = true;
+    cell.flippedAntiDiagonally = true;
+
+    const unsigned gid = gidMapper.cellToGid(cell);
+    QCOMPARE(gid, 0xA0000004u);
+
+    bool ok;
+    QVERIFY(gidMapper.gidToCell(gid, ok) == cell);
+    QVERIFY(ok);
+}
+
+void test_GidMapper::invalidGids()
+{
+    GidMapper gidMapper;
+
+    bool ok;
+    QVERIFY(gidMapper.gidToCell(0, ok).isEmpty());
+    QVERIFY(ok);
+
+    gidMapper.gidToCell(1, ok);
+    QVERIFY(!ok);
+
+    gidMapper.insert(10, mFirst);
+    gidMapper.gidToCell(5, ok);
+    QVERIFY(!ok);
+
+    QCOMPARE(gidMapper.gidToCell(10, ok).tile, mFirst->tileAt(0));
+    QVERIFY(ok);
+
+    // Unknown tilesets map to 0
+    QCOMPARE(gidMapper.cellToGid(Cell(mSecond->tileAt(0))), 0u);
+}
+
+void test_GidMapper::changedTilesetWidth()
+{
+    GidMapper gidMapper;
+
+    // The tileset had two columns when the map was saved
+    gidMapper.setTilesetWidth(mFirst, 32);
+    gidMapper.insert(1, mFirst);
+
+    bool ok;
+    QCOMPARE(gidMapper.gidToCell(3, ok).tile, mFirst->tileAt(4));
+    QCOMPARE(gidMapper.gidToCell(4, ok).tile, mFirst->tileAt(5));
+}
+
+void test_GidMapper::bulkConversion()
+{
+    GidMapper gidMapper(QList<Tileset*>() << mFirst << mSecond);
+
+    const unsigned gids[] = { 0, 1, 0x80000011, 20, 16 };
+    const int count = sizeof(gids) / sizeof(gids[0]);
+
+    Cell cells[count];
+    QCOMPARE(gidMapper.gidsToCells(gids, cells, count), count);
+
+    for (int i = 0; i < count; ++i) {
+        bool ok;
+        QVERIFY(cells[i] == gidMapper.gidToCell(gids[i], ok));
+    }
+
+    unsigned result[count];
+    gidMapper.cellsToGids(cells, result, count);
+    for (int i = 0; i < count; ++i)
+        QCOMPARE(result[i], gids[i]);
+
+    // Conversion stops at the first invalid gid
+    GidMapper offsetMapper;
+    offsetMapper.insert(5, mFirst);
+    const unsigned invalid[] = { 5, 0, 3, 6 };
+    QCOMPARE(offsetMapper.gidsToCells(invalid, cells, 4), 2);
+}
+
+QTEST_MAIN(test_GidMapper)
+#include "test_gidmapper.moc"
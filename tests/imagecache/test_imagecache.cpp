@@ -0,0 +1,136 @@
+#include "imagecache.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_ImageCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+
+    void sharedImage();
+    void pathsAreCanonical();
+    void changedFile();
+    void remove();
+    void missingFile();
+    void maxCost();
+    void atlasFits();
+
+private:
+    QString mFileName;
+};
+
+static bool saveImage(const QString &fileName, const QSize &size)
+{
+    QImage image(size, QImage::Format_ARGB32);
+    image.fill(Qt::red);
+    return image.save(fileName);
+}
+
+void test_ImageCache::initTestCase()
+{
+    mFileName = QDir::tempPath() + QLatin1String("/test_imagecache.png");
+    QVERIFY(saveImage(mFileName, QSize(32, 16)));
+}
+
+void test_ImageCache::cleanupTestCase()
+{
+    QFile::remove(mFileName);
+}
+
+void test_ImageCache::init()
+{
+    ImageCache::clear();
+}
+
+void test_ImageCache::sharedImage()
+{
+    const QImage first = ImageCache::loadImage(mFileName);
+    QCOMPARE(first.size(), QSize(32, 16));
+
+    // The second load should share the data of the first one
+    const QImage second = ImageCache::loadImage(mFileName);
+    QCOMPARE(second.cacheKey(), first.cacheKey());
+
+    ImageCache::clear();
+    const QImage third = ImageCache::loadImage(mFileName);
+    QVERIFY(third.cacheKey() != first.cacheKey());
+    QCOMPARE(third, first);
+}
+
+void test_ImageCache::pathsAreCanonical()
+{
+    const QImage image = ImageCache::loadImage(mFileName);
+
+    const QFileInfo fileInfo(mFileName);
+    const QString otherPath = fileInfo.absolutePath()
+            + QLatin1String("/./")
+            + fileInfo.fileName();
+
+    QCOMPARE(ImageCache::loadImage(otherPath).cacheKey(), image.cacheKey());
+}
+
+/**
+ * A file that is overwritten right after loading may keep its modification
+ * time, but it is still noticed when its size changed.
+ */
+void test_ImageCache::changedFile()
+{
+    QCOMPARE(ImageCache::loadImage(mFileName).size(), QSize(32, 16));
+
+    QVERIFY(saveImage(mFileName, QSize(64, 48)));
+    QCOMPARE(ImageCache::loadImage(mFileName).size(), QSize(64, 48));
+
+    QVERIFY(saveImage(mFileName, QSize(32, 16)));
+    QCOMPARE(ImageCache::loadImage(mFileName).size(), QSize(32, 16));
+}
+
+void test_ImageCache::remove()
+{
+    const QImage first = ImageCache::loadImage(mFileName);
+
+    ImageCache::remove(mFileName + QLatin1String(".missing"));
+    QCOMPARE(ImageCache::loadImage(mFileName).cacheKey(), first.cacheKey());
+
+    ImageCache::remove(mFileName);
+    const QImage second = ImageCache::loadImage(mFileName);
+    QVERIFY(second.cacheKey() != first.cacheKey());
+    QCOMPARE(second, first);
+}
+
+void test_ImageCache::missingFile()
+{
+    QVERIFY(ImageCache::loadImage(mFileName + QLatin1String(".missing")).isNull());
+    QVERIFY(ImageCache::loadImage(QString()).isNull());
+}
+
+void test_ImageCache::maxCost()
+{
+    const int oldMaxCost = ImageCache::maxCost();
+
+    // Images that don't fit in the cache are still loaded, but not shared
+    ImageCache::setMaxCost(0);
+    const QImage first = ImageCache::loadImage(mFileName);
+    const QImage second = ImageCache::loadImage(mFileName);
+    QVERIFY(!first.isNull());
+    QVERIFY(second.cacheKey() != first.cacheKey());
+
+    ImageCache::setMaxCost(oldMaxCost);
+}
+
+/**
+ * The default cache size leaves room for a 4096x4096 atlas at 32 bits per
+ * pixel, which would otherwise never be cached.
+ */
+void test_ImageCache::atlasFits()
+{
+    QVERIFY(ImageCache::maxCost() >= 4096 * 4096 * 4 / 1024);
+}
+
+QTEST_MAIN(test_ImageCache)
+#include "test_imagecache.moc"
@@ -0,0 +1,36 @@
+include(../../src/libtiled/libtiled.pri)
+
+CONFIG += qtestlib
+TEMPLATE = app
+
+macx {
+    LIBS += -L$$OUT_PWD/../../bin/Tiled.app/Contents/Frameworks
+} else {
+    LIBS += -L$$OUT_PWD/../../lib
+}
+
+!win32:!macx {
+    QMAKE_RPATHDIR += \$\$ORIGIN/../../lib
+
+    # It is not possible to use ORIGIN in QMAKE_RPATHDIR, so a bit manually
+    QMAKE_LFLAGS += -Wl,-z,origin \'-Wl,-rpath,$$join(QMAKE_RPATHDIR, ":")\'
+    QMAKE_RPATHDIR =
+}
+
+DEFINES += JSON_LIBRARY
+INCLUDEPATH += ../../src/plugins/json
+
+# Input
+SOURCES += test_jsonplugin.cpp \
+    ../../src/plugins/json/jsonplugin.cpp \
+    ../../src/plugins/json/jsonstream.cpp \
+    ../../src/plugins/json/qjsonparser/json.cpp \
+    ../../src/plugins/json/varianttomapconverter.cpp \
+    ../../src/plugins/json/maptovariantconverter.cpp
+
+HEADERS += ../../src/plugins/json/jsonplugin.h \
+    ../../src/plugins/json/json_global.h \
+    ../../src/plugins/json/jsonstream.h \
+    ../../src/plugins/json/qjsonparser/json.h \
+    ../../src/plugins/json/varianttomapconverter.h \
+    ../../src/plugins/json/maptovariantconverter.h
@@ -0,0 +1,319 @@
+#include "jsonplugin.h"
+#include "jsonstream.h"
+#include "maptovariantconverter.h"
+#include "qjsonparser/json.h"
+
+#include "map.h"
+#include "mapreader.h"
+#include "tile.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+#include <QTextCodec>
+
+using namespace Tiled;
+using namespace Json;
+
+class test_JsonPlugin : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void writeMatchesJsonWriter();
+    void roundTrip();
+    void javaScriptFile();
+    void utf16();
+    void parseErrors_data();
+    void parseErrors();
+    void unsupportedType();
+
+private:
+    QByteArray readFile(const QString &fileName) const;
+    bool writeFile(const QString &fileName, const QByteArray &data) const;
+    QByteArray referenceOutput(const QString &fileName) const;
+
+    Map *mMap;
+    QString mJsonFileName;
+    QString mJsFileName;
+    QByteArray mJson;
+};
+
+static void deleteMap(Map *map)
+{
+    qDeleteAll(map->tilesets());
+    delete map;
+}
+
+/**
+ * Replaces the GidArrays in \a variant by lists of numbers, which is how
+ * the tile layer data was stored before it was streamed.
+ */
+static QVariant boxGidArrays(const QVariant &variant)
+{
+    if (variant.userType() == qMetaTypeId<GidArray>()) {
+        QVariantList list;
+        foreach (unsigned gid, variant.value<GidArray>().gids)
+            list.append(gid);
+        return list;
+    } else if (variant.type() == QVariant::List) {
+        QVariantList list;
+        foreach (const QVariant &element, variant.toList())
+            list.append(boxGidArrays(element));
+        return list;
+    } else if (variant.type() == QVariant::Map) {
+        QVariantMap map = variant.toMap();
+        QVariantMap::iterator it = map.begin();
+        for (; it != map.end(); ++it)
+            it.value() = boxGidArrays(it.value());
+        return map;
+    }
+    return variant;
+}
+
+/**
+ * Returns whether all tile layers of \a a and \a b have the same cells.
+ */
+static bool sameTileLayers(const Map *a, const Map *b)
+{
+    if (a->layerCount() != b->layerCount())
+        return false;
+
+    for (int i = 0; i < a->layerCount(); ++i) {
+        const TileLayer *layerA = a->layerAt(i)->asTileLayer();
+        const TileLayer *layerB = b->layerAt(i)->asTileLayer();
+
+        if (!layerA || !layerB || layerA->name() != layerB->name()
+                || layerA->size() != layerB->size())
+            return false;
+
+        for (int y = 0; y < layerA->height(); ++y) {
+            for (int x = 0; x < layerA->width(); ++x) {
+                const Cell cellA = layerA->cellAt(x, y);
+                const Cell cellB = layerB->cellAt(x, y);
+
+                if ((cellA.tile ? cellA.tile->id() : -1) !=
+                        (cellB.tile ? cellB.tile->id() : -1)
+                        || cellA.flippedHorizontally != cellB.flippedHorizontally
+                        || cellA.flippedVertically != cellB.flippedVertically
+                        || cellA.flippedAntiDiagonally != cellB.flippedAntiDiagonally)
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void test_JsonPlugin::initTestCase()
+{
+    MapReader reader;
+    mMap = reader.readMap("../data/encodings.tmx");
+    QVERIFY2(mMap, qPrintable(reader.errorString()));
+
+    mJsonFileName = QDir::tempPath() + QLatin1String("/test_jsonplugin.json");
+    mJsFileName = QDir::tempPath() + QLatin1String("/test_jsonplugin.js");
+
+    JsonPlugin plugin;
+    QVERIFY2(plugin.write(mMap, mJsonFileName), qPrintable(plugin.errorString()));
+    mJson = readFile(mJsonFileName);
+    QVERIFY(!mJson.isEmpty());
+}
+
+void test_JsonPlugin::cleanupTestCase()
+{
+    deleteMap(mMap);
+    mMap = 0;
+
+    QFile::remove(mJsonFileName);
+    QFile::remove(mJsFileName);
+}
+
+QByteArray test_JsonPlugin::readFile(const QString &fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return QByteArray();
+    return file.readAll();
+}
+
+bool test_JsonPlugin::writeFile(const QString &fileName,
+                                const QByteArray &data) const
+{
+    QFile file(fileName);
+    return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+/**
+ * Returns the map written by the JsonWriter, as it was written before the
+ * JsonStreamWriter was introduced.
+ */
+QByteArray test_JsonPlugin::referenceOutput(const QString &fileName) const
+{
+    MapToVariantConverter converter;
+    const QVariant variant = converter.toVariant(mMap, QFileInfo(fileName).dir());
+
+    JsonWriter writer;
+    writer.setAutoFormatting(true);
+    if (!writer.stringify(boxGidArrays(variant)))
+        return QByteArray();
+
+    return writer.result().toLatin1();
+}
+
+void test_JsonPlugin::writeMatchesJsonWriter()
+{
+    const QByteArray reference = referenceOutput(mJsonFileName);
+    QVERIFY(!reference.isEmpty());
+    QCOMPARE(mJson, reference);
+}
+
+void test_JsonPlugin::roundTrip()
+{
+    JsonPlugin plugin;
+    Map *map = plugin.read(mJsonFileName);
+    QVERIFY2(map, qPrintable(plugin.errorString()));
+
+    QCOMPARE(map->size(), mMap->size());
+    QCOMPARE(map->tilesetCount(), 1);
+    QCOMPARE(map->tilesets().first()->tileCount(),
+             mMap->tilesets().first()->tileCount());
+    QVERIFY(sameTileLayers(map, mMap));
+
+    deleteMap(map);
+}
+
+/**
+ * JavaScript files wrap the map in a function call, which is skipped when
+ * reading.
+ */
+void test_JsonPlugin::javaScriptFile()
+{
+    JsonPlugin plugin;
+    QVERIFY2(plugin.write(mMap, mJsFileName), qPrintable(plugin.errorString()));
+
+    const QByteArray contents = readFile(mJsFileName);
+    QVERIFY(contents.startsWith("(function(name,data){\n"));
+    QVERIFY(contents.contains(" }})(\"test_jsonplugin\",\n"));
+    QVERIFY(contents.endsWith(referenceOutput(mJsFileName) + ");"));
+
+    Map *map = plugin.read(mJsFileName);
+    QVERIFY2(map, qPrintable(plugin.errorString()));
+    QVERIFY(sameTileLayers(map, mMap));
+    deleteMap(map);
+}
+
+/**
+ * Files in UTF-16 are left to the bundled parser.
+ */
+void test_JsonPlugin::utf16()
+{
+    QTextCodec *codec = QTextCodec::codecForName("UTF-16LE");
+    QVERIFY(codec);
+
+    const QByteArray utf16 = "\xFF\xFE" +
+            codec->fromUnicode(QString::fromLatin1(mJson));
+    QVERIFY(writeFile(mJsonFileName, utf16));
+
+    JsonPlugin plugin;
+    Map *map = plugin.read(mJsonFileName);
+    QVERIFY(writeFile(mJsonFileName, mJson));
+
+    QVERIFY2(map, qPrintable(plugin.errorString()));
+    QVERIFY(sameTileLayers(map, mMap));
+    deleteMap(map);
+}
+
+void test_JsonPlugin::parseErrors_data()
+{
+    QTest::addColumn<QByteArray>("data");
+    QTest::addColumn<QString>("suffix");
+
+    const QString json = QLatin1String(".json");
+    QByteArray data;
+
+    QTest::newRow("empty") << QByteArray() << json;
+    QTest::newRow("truncated") << mJson.left(mJson.size() / 2) << json;
+    QTest::newRow("truncated string") << mJson.left(mJson.indexOf("orthogonal")) << json;
+    QTest::newRow("trailing data") << mJson + "{}" << json;
+
+    data = mJson;
+    QTest::newRow("bad number") << data.replace("\"width\":20", "\"width\":2.0.0") << json;
+
+    data = mJson;
+    QTest::newRow("negative gid") << data.replace("\"data\":[0,", "\"data\":[-1,") << json;
+
+    data = mJson;
+    QTest::newRow("fractional gid") << data.replace("\"data\":[0,", "\"data\":[1.5,") << json;
+
+    data = mJson;
+    QTest::newRow("gid overflow") << data.replace("\"data\":[0,", "\"data\":[4294967296,") << json;
+
+    data = mJson;
+    QTest::newRow("gid before tileset") << data.replace("\"firstgid\":1,", "\"firstgid\":10,") << json;
+
+    data = mJson;
+    QTest::newRow("missing gid") << data.replace("\"data\":[0,", "\"data\":[") << json;
+
+    QTest::newRow("bad jsonp") << "loadMap(" + mJson + ");" << QString(QLatin1String(".js"));
+
+    QTextCodec *codec = QTextCodec::codecForName("UTF-16LE");
+    const QByteArray utf16 = codec->fromUnicode(QString::fromLatin1(mJson));
+    QTest::newRow("truncated utf-16") << "\xFF\xFE" + utf16.left(utf16.size() / 2) << json;
+}
+
+void test_JsonPlugin::parseErrors()
+{
+    QFETCH(QByteArray, data);
+    QFETCH(QString, suffix);
+
+    const QString fileName = QDir::tempPath()
+            + QLatin1String("/test_jsonplugin_error") + suffix;
+    QVERIFY(writeFile(fileName, data));
+
+    JsonPlugin plugin;
+    Map *map = plugin.read(fileName);
+    QFile::remove(fileName);
+
+    if (map)
+        deleteMap(map);
+
+    QVERIFY(!map);
+    QVERIFY(!plugin.errorString().isEmpty());
+}
+
+/**
+ * Nothing is written when the variant contains an unsupported type, even
+ * when it comes after enough data to fill the write buffer.
+ */
+void test_JsonPlugin::unsupportedType()
+{
+    QVariantList numbers;
+    for (int i = 0; i < 100000; ++i)
+        numbers.append(i);
+
+    QVariantMap map;
+    map.insert(QLatin1String("a"), numbers);
+    map.insert(QLatin1String("b"), QRect(0, 0, 1, 1));
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+
+    JsonStreamWriter writer(&buffer);
+    QVERIFY(!writer.write(map));
+    writer.flush();
+
+    QVERIFY(buffer.data().isEmpty());
+    QVERIFY(writer.errorString().contains(QLatin1String("QRect")));
+
+    map.remove(QLatin1String("b"));
+    QVERIFY(writer.write(map));
+    writer.flush();
+    QVERIFY(buffer.data().startsWith("{\"a\":[0,1,2,"));
+}
+
+QTEST_MAIN(test_JsonPlugin)
+#include "test_jsonplugin.moc"
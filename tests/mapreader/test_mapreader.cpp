@@ -1,24 +1,107 @@
 #include "map.h"
 #include "mapobject.h"
 #include "objectgroup.h"
+#include "tile.h"
 #include "tilelayer.h"
+#include "tileset.h"
 #include "mapreader.h"
 
 #include <QtTest/QtTest>
 
 using namespace Tiled;
 
+namespace {
+
+/**
+ * Records the reported progress and cancels after a given number of layers.
+ */
+class ProgressMapReader : public MapReader
+{
+public:
+    explicit ProgressMapReader(int cancelAtLayer = -1)
+        : mCancelAtLayer(cancelAtLayer)
+        , mBytesRead(0)
+        , mBytesTotal(0)
+        , mLayerCount(0)
+        , mCalls(0)
+    {}
+
+    int mCancelAtLayer;
+    qint64 mBytesRead;
+    qint64 mBytesTotal;
+    int mLayerCount;
+    int mCalls;
+
+protected:
+    bool reportProgress(qint64 bytesRead, qint64 bytesTotal, int layerCount)
+    {
+        // Progress should never go backwards
+        if (bytesRead < mBytesRead || layerCount < mLayerCount)
+            return false;
+
+        mBytesRead = bytesRead;
+        mBytesTotal = bytesTotal;
+        mLayerCount = layerCount;
+        ++mCalls;
+
+        return layerCount != mCancelAtLayer;
+    }
+};
+
+/**
+ * Returns the cell stored at (x, y) in each layer of encodings.tmx, given
+ * the tileset of that map. The same formula was used to generate the map.
+ */
+Cell expectedCell(Tileset *tileset, int x, int y)
+{
+    if ((x + 2 * y) % 5 == 0)
+        return Cell();
+
+    const int flags = (x + y) % 8;
+
+    Cell cell(tileset->tileAt((x * y + x) % 4));
+    cell.flippedHorizontally = flags & 1;
+    cell.flippedVertically = flags & 2;
+    cell.flippedAntiDiagonally = flags & 4;
+    return cell;
+}
+
+void deleteMap(Map *map)
+{
+    qDeleteAll(map->tilesets());
+    delete map;
+}
+
+} // anonymous namespace
+
 class test_MapReader : public QObject
 {
     Q_OBJECT
 
 private slots:
+    void loadMap_data();
     void loadMap();
+    void layerDataEncodings_data();
+    void layerDataEncodings();
+    void parallelMatchesSerial();
+    void reportProgress();
+    void cancelLoading();
 };
 
+void test_MapReader::loadMap_data()
+{
+    QTest::addColumn<bool>("parallelLayerDecoding");
+
+    QTest::newRow("serial") << false;
+    QTest::newRow("parallel") << true;
+}
+
 void test_MapReader::loadMap()
 {
+    QFETCH(bool, parallelLayerDecoding);
+
     MapReader reader;
+    reader.setParallelLayerDecoding(parallelLayerDecoding);
     Map *map = reader.readMap("../data/mapobject.tmx");
 
     // TODO: Also test tilesets (internal and external), properties and tile
@@ -36,6 +119,7 @@ void test_MapReader::loadMap()
     QVERIFY(tileLayer);
     QCOMPARE(tileLayer->width(), 100);
     QCOMPARE(tileLayer->height(), 80);
+    QVERIFY(tileLayer->isEmpty());
 
     ObjectGroup *objectGroup = dynamic_cast<ObjectGroup*>(map->layerAt(1));
 
@@ -53,5 +137,119 @@ void test_MapReader::loadMap()
     QCOMPARE(mapObject->height(), qreal(64));
 }
 
+void test_MapReader::layerDataEncodings_data()
+{
+    loadMap_data();
+}
+
+/**
+ * Checks every cell of a map with a layer in each of the supported layer data
+ * encodings: XML, CSV, base64, and base64 with zlib or gzip compression.
+ */
+void test_MapReader::layerDataEncodings()
+{
+    QFETCH(bool, parallelLayerDecoding);
+
+    MapReader reader;
+    reader.setParallelLayerDecoding(parallelLayerDecoding);
+    Map *map = reader.readMap("../data/encodings.tmx");
+
+    QVERIFY2(map, qPrintable(reader.errorString()));
+    QCOMPARE(map->tilesetCount(), 1);
+    QCOMPARE(map->layerCount(), 5);
+
+    Tileset *tileset = map->tilesets().first();
+    QCOMPARE(tileset->tileCount(), 4);
+
+    const char *names[] = { "xml", "csv", "base64", "zlib", "gzip" };
+
+    for (int i = 0; i < map->layerCount(); ++i) {
+        TileLayer *tileLayer = map->layerAt(i)->asTileLayer();
+
+        QVERIFY(tileLayer);
+        QCOMPARE(tileLayer->name(), QLatin1String(names[i]));
+        QCOMPARE(tileLayer->size(), map->size());
+
+        for (int y = 0; y < tileLayer->height(); ++y) {
+            for (int x = 0; x < tileLayer->width(); ++x) {
+                if (tileLayer->cellAt(x, y) != expectedCell(tileset, x, y)) {
+                    QFAIL(qPrintable(QString(QLatin1String("Layer '%1' differs at %2,%3"))
+                                     .arg(tileLayer->name()).arg(x).arg(y)));
+                }
+            }
+        }
+    }
+
+    deleteMap(map);
+}
+
+/**
+ * Compares the cells decoded in parallel with the ones decoded while parsing.
+ */
+void test_MapReader::parallelMatchesSerial()
+{
+    MapReader serialReader;
+    Map *serial = serialReader.readMap("../data/encodings.tmx");
+    QVERIFY(serial);
+
+    MapReader parallelReader;
+    parallelReader.setParallelLayerDecoding(true);
+    Map *parallel = parallelReader.readMap("../data/encodings.tmx");
+    QVERIFY(parallel);
+
+    QCOMPARE(parallel->layerCount(), serial->layerCount());
+
+    for (int i = 0; i < serial->layerCount(); ++i) {
+        const TileLayer *a = serial->layerAt(i)->asTileLayer();
+        const TileLayer *b = parallel->layerAt(i)->asTileLayer();
+
+        QVERIFY(a && b);
+        QVERIFY(!a->isEmpty());
+        QCOMPARE(b->size(), a->size());
+        QCOMPARE(b->drawMargins(), a->drawMargins());
+
+        for (int y = 0; y < a->height(); ++y) {
+            for (int x = 0; x < a->width(); ++x) {
+                const Cell cellA = a->cellAt(x, y);
+                const Cell cellB = b->cellAt(x, y);
+
+                QCOMPARE(cellB.tile ? cellB.tile->id() : -1,
+                         cellA.tile ? cellA.tile->id() : -1);
+                QCOMPARE(cellB.flippedHorizontally, cellA.flippedHorizontally);
+                QCOMPARE(cellB.flippedVertically, cellA.flippedVertically);
+                QCOMPARE(cellB.flippedAntiDiagonally, cellA.flippedAntiDiagonally);
+            }
+        }
+    }
+
+    deleteMap(parallel);
+    deleteMap(serial);
+}
+
+void test_MapReader::reportProgress()
+{
+    ProgressMapReader reader;
+    Map *map = reader.readMap("../data/mapobject.tmx");
+
+    QVERIFY(map);
+    QVERIFY(reader.mCalls > 0);
+    QCOMPARE(reader.mLayerCount, 2);
+    QVERIFY(reader.mBytesTotal > 0);
+    QVERIFY(reader.mBytesRead <= reader.mBytesTotal);
+
+    qDeleteAll(map->tilesets());
+    delete map;
+}
+
+void test_MapReader::cancelLoading()
+{
+    ProgressMapReader reader(1);
+    Map *map = reader.readMap("../data/mapobject.tmx");
+
+    QVERIFY(!map);
+    QCOMPARE(reader.mLayerCount, 1);
+    QCOMPARE(reader.errorString(), QLatin1String("Loading was cancelled."));
+}
+
 QTEST_MAIN(test_MapReader)
 #include "test_mapreader.moc"
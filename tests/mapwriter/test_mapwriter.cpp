@@ -0,0 +1,212 @@
+#include "map.h"
+#include "mapobject.h"
+#include "mapwriter.h"
+#include "objectgroup.h"
+#include "testmapreader.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_MapWriter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void parallelLayerEncoding_data();
+    void parallelLayerEncoding();
+    void baselineOutput_data();
+    void baselineOutput();
+
+private:
+    QByteArray writeMap(Map::LayerDataFormat format, bool parallel) const;
+    static QByteArray writeMap(const Map *map, Map::LayerDataFormat format,
+                               bool parallel);
+
+    QImage mTilesetImage;
+    Map *mMap;
+};
+
+void test_MapWriter::initTestCase()
+{
+    mMap = new Map(Map::Orthogonal, 50, 40, 16, 16);
+
+    mTilesetImage = QImage(64, 32, QImage::Format_ARGB32);
+    mTilesetImage.fill(Qt::white);
+
+    Tileset *tileset = new Tileset(QLatin1String("tiles"), 16, 16);
+    tileset->loadFromImage(mTilesetImage, QLatin1String("tiles.png"));
+    mMap->addTileset(tileset);
+
+    qsrand(3);
+    for (int i = 0; i < 4; ++i) {
+        TileLayer *layer = new TileLayer(QString::number(i), 0, 0, 50, 40);
+        for (int y = 0; y < layer->height(); ++y) {
+            for (int x = 0; x < layer->width(); ++x) {
+                if (qrand() % 3 == 0)
+                    continue;
+
+                Cell cell(tileset->tileAt(qrand() % tileset->tileCount()));
+                cell.flippedVertically = qrand() % 5 == 0;
+                layer->setCell(x, y, cell);
+            }
+        }
+        mMap->addLayer(layer);
+
+        // Interleave object groups with the tile layers
+        ObjectGroup *objectGroup = new ObjectGroup(QLatin1String("objects"),
+                                                   0, 0, 50, 40);
+        objectGroup->addObject(new MapObject(QLatin1String("object"),
+                                             QString(),
+                                             QPointF(i * 10, i * 20),
+                                             QSizeF(16, 16)));
+        mMap->addLayer(objectGroup);
+    }
+}
+
+void test_MapWriter::cleanupTestCase()
+{
+    qDeleteAll(mMap->tilesets());
+    delete mMap;
+    mMap = 0;
+}
+
+QByteArray test_MapWriter::writeMap(Map::LayerDataFormat format,
+                                    bool parallel) const
+{
+    return writeMap(mMap, format, parallel);
+}
+
+QByteArray test_MapWriter::writeMap(const Map *map,
+                                    Map::LayerDataFormat format,
+                                    bool parallel)
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+
+    MapWriter writer;
+    writer.setLayerDataFormat(format);
+    writer.setParallelLayerEncoding(parallel);
+    writer.writeMap(map, &buffer, QDir::tempPath());
+
+    return data;
+}
+
+void test_MapWriter::parallelLayerEncoding_data()
+{
+    QTest::addColumn<int>("format");
+
+    QTest::newRow("XML") << int(Map::XML);
+    QTest::newRow("CSV") << int(Map::CSV);
+    QTest::newRow("Base64") << int(Map::Base64);
+    QTest::newRow("Base64Zlib") << int(Map::Base64Zlib);
+    QTest::newRow("Base64Gzip") << int(Map::Base64Gzip);
+}
+
+void test_MapWriter::parallelLayerEncoding()
+{
+    QFETCH(int, format);
+
+    const QByteArray serial = writeMap(Map::LayerDataFormat(format), false);
+    const QByteArray parallel = writeMap(Map::LayerDataFormat(format), true);
+
+    QVERIFY(!serial.isEmpty());
+    QCOMPARE(parallel, serial);
+
+    // Make sure the written layer data reads back correctly
+    QBuffer buffer;
+    buffer.setData(parallel);
+    buffer.open(QIODevice::ReadOnly);
+
+    TestMapReader reader(mTilesetImage);
+    Map *map = reader.readMap(&buffer, QDir::tempPath());
+    QVERIFY(map);
+    QCOMPARE(map->layerCount(), mMap->layerCount());
+
+    for (int i = 0; i < map->layerCount(); ++i) {
+        const TileLayer *expected = mMap->layerAt(i)->asTileLayer();
+        const TileLayer *actual = map->layerAt(i)->asTileLayer();
+        if (!expected)
+            continue;
+
+        QVERIFY(actual);
+        for (int y = 0; y < expected->height(); ++y) {
+            for (int x = 0; x < expected->width(); ++x) {
+                const Cell a = actual->cellAt(x, y);
+                const Cell e = expected->cellAt(x, y);
+                QCOMPARE(a.isEmpty(), e.isEmpty());
+                if (e.isEmpty())
+                    continue;
+                QCOMPARE(a.tile->id(), e.tile->id());
+                QCOMPARE(a.flippedVertically, e.flippedVertically);
+            }
+        }
+    }
+
+    qDeleteAll(map->tilesets());
+    delete map;
+}
+
+void test_MapWriter::baselineOutput_data()
+{
+    QTest::addColumn<int>("format");
+    QTest::addColumn<QString>("fileName");
+    QTest::addColumn<bool>("parallel");
+
+    QTest::newRow("XML") << int(Map::XML) << QString::fromLatin1("../data/mapwriter-xml.tmx") << false;
+    QTest::newRow("CSV") << int(Map::CSV) << QString::fromLatin1("../data/mapwriter-csv.tmx") << false;
+    QTest::newRow("CSV parallel") << int(Map::CSV) << QString::fromLatin1("../data/mapwriter-csv.tmx") << true;
+    QTest::newRow("Base64") << int(Map::Base64) << QString::fromLatin1("../data/mapwriter-base64.tmx") << false;
+    QTest::newRow("Base64 parallel") << int(Map::Base64) << QString::fromLatin1("../data/mapwriter-base64.tmx") << true;
+}
+
+/**
+ * Compares the output against files written by the MapWriter before the
+ * layer data was encoded separately. The compressed formats are left out,
+ * since their output depends on the version of zlib.
+ */
+void test_MapWriter::baselineOutput()
+{
+    QFETCH(int, format);
+    QFETCH(QString, fileName);
+    QFETCH(bool, parallel);
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray expected = file.readAll();
+
+    Map map(Map::Orthogonal, 4, 3, 16, 16);
+
+    Tileset *tileset = new Tileset(QLatin1String("tiles"), 16, 16);
+    tileset->loadFromImage(mTilesetImage, QLatin1String("tiles.png"));
+    map.addTileset(tileset);
+
+    TileLayer *layer = new TileLayer(QLatin1String("layer"), 0, 0, 4, 3);
+    for (int y = 0; y < layer->height(); ++y) {
+        for (int x = 0; x < layer->width(); ++x) {
+            if ((x + y) % 3 == 0)
+                continue;
+
+            Cell cell(tileset->tileAt((x + 2 * y) % 8));
+            cell.flippedHorizontally = x == 1;
+            cell.flippedVertically = y == 2;
+            layer->setCell(x, y, cell);
+        }
+    }
+    map.addLayer(layer);
+
+    const QByteArray actual = writeMap(&map, Map::LayerDataFormat(format),
+                                       parallel);
+    delete tileset;
+
+    QCOMPARE(QString::fromLatin1(actual), QString::fromLatin1(expected));
+}
+
+QTEST_MAIN(test_MapWriter)
+#include "test_mapwriter.moc"
@@ -0,0 +1,188 @@
+#include "mapobject.h"
+#include "objectgroup.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_ObjectGroup : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void emptyGroup();
+    void queryRect();
+    void queryPoint();
+    void movedObject();
+    void removedObject();
+    void largeObject();
+    void polygonAndRotation();
+    void matchesLinearScan();
+};
+
+static MapObject *newObject(qreal x, qreal y, qreal width, qreal height)
+{
+    return new MapObject(QString(), QString(),
+                         QPointF(x, y), QSizeF(width, height));
+}
+
+void test_ObjectGroup::emptyGroup()
+{
+    ObjectGroup group;
+    QVERIFY(group.objectsIntersecting(QRectF(-1000, -1000, 2000, 2000)).isEmpty());
+    QVERIFY(group.objectsAt(QPointF(0, 0)).isEmpty());
+}
+
+void test_ObjectGroup::queryRect()
+{
+    ObjectGroup group;
+    MapObject *a = newObject(10, 10, 20, 20);
+    MapObject *b = newObject(1000, 1000, 20, 20);
+    MapObject *c = newObject(15, 15, 0, 0);
+    group.addObject(a);
+    group.addObject(b);
+    group.addObject(c);
+
+    QList<MapObject*> found = group.objectsIntersecting(QRectF(0, 0, 50, 50));
+    QCOMPARE(found.size(), 2);
+    QVERIFY(found.at(0) == a);
+    QVERIFY(found.at(1) == c);
+
+    found = group.objectsIntersecting(QRectF(990, 990, 5, 5));
+    QVERIFY(found.isEmpty());
+
+    // Touching the border counts
+    found = group.objectsIntersecting(QRectF(1020, 1020, 5, 5));
+    QCOMPARE(found.size(), 1);
+    QVERIFY(found.first() == b);
+}
+
+void test_ObjectGroup::queryPoint()
+{
+    ObjectGroup group;
+    MapObject *a = newObject(0, 0, 100, 100);
+    MapObject *b = newObject(50, 50, 100, 100);
+    group.addObject(a);
+    group.addObject(b);
+
+    QCOMPARE(group.objectsAt(QPointF(10, 10)).size(), 1);
+    QCOMPARE(group.objectsAt(QPointF(75, 75)).size(), 2);
+    QVERIFY(group.objectsAt(QPointF(200, 10)).isEmpty());
+}
+
+void test_ObjectGroup::movedObject()
+{
+    ObjectGroup group;
+    MapObject *a = newObject(0, 0, 10, 10);
+    group.addObject(a);
+
+    QCOMPARE(group.objectsAt(QPointF(5, 5)).size(), 1);
+
+    a->setPosition(QPointF(5000, 5000));
+    QVERIFY(group.objectsAt(QPointF(5, 5)).isEmpty());
+    QCOMPARE(group.objectsAt(QPointF(5005, 5005)).size(), 1);
+
+    a->setSize(QSizeF(100, 100));
+    QCOMPARE(group.objectsAt(QPointF(5090, 5090)).size(), 1);
+}
+
+void test_ObjectGroup::removedObject()
+{
+    ObjectGroup group;
+    MapObject *a = newObject(0, 0, 10, 10);
+    MapObject *b = newObject(0, 0, 10, 10);
+    group.addObject(a);
+    group.addObject(b);
+
+    QCOMPARE(group.objectsAt(QPointF(5, 5)).size(), 2);
+
+    group.removeObject(a);
+    QList<MapObject*> found = group.objectsAt(QPointF(5, 5));
+    QCOMPARE(found.size(), 1);
+    QVERIFY(found.first() == b);
+
+    // Changing a removed object should not affect the group
+    a->setPosition(QPointF(100, 100));
+    QVERIFY(group.objectsAt(QPointF(105, 105)).isEmpty());
+
+    // Re-inserting keeps the stored order
+    group.insertObject(0, a);
+    found = group.objectsIntersecting(QRectF(0, 0, 200, 200));
+    QCOMPARE(found.size(), 2);
+    QVERIFY(found.at(0) == a);
+    QVERIFY(found.at(1) == b);
+
+    group.removeObjectAt(0);
+    delete a;
+    QCOMPARE(group.objectsIntersecting(QRectF(0, 0, 200, 200)).size(), 1);
+}
+
+void test_ObjectGroup::largeObject()
+{
+    ObjectGroup group;
+    MapObject *big = newObject(-100000, -100000, 200000, 200000);
+    MapObject *small = newObject(20, 20, 4, 4);
+    group.addObject(big);
+    group.addObject(small);
+
+    QList<MapObject*> found = group.objectsAt(QPointF(22, 22));
+    QCOMPARE(found.size(), 2);
+    QVERIFY(found.at(0) == big);
+
+    found = group.objectsAt(QPointF(50000, -50000));
+    QCOMPARE(found.size(), 1);
+    QVERIFY(found.first() == big);
+}
+
+void test_ObjectGroup::polygonAndRotation()
+{
+    ObjectGroup group;
+
+    MapObject *polygon = newObject(100, 100, 0, 0);
+    polygon->setShape(MapObject::Polygon);
+    group.addObject(polygon);
+    polygon->setPolygon(QPolygonF() << QPointF(0, 0)
+                                    << QPointF(300, 0)
+                                    << QPointF(300, 300));
+
+    QCOMPARE(group.objectsAt(QPointF(390, 390)).size(), 1);
+
+    MapObject *rotated = newObject(1000, 1000, 100, 10);
+    group.addObject(rotated);
+    QVERIFY(group.objectsAt(QPointF(1005, 1090)).isEmpty());
+
+    rotated->setRotation(90);
+    QCOMPARE(group.objectsAt(QPointF(995, 1090)).size(), 1);
+}
+
+void test_ObjectGroup::matchesLinearScan()
+{
+    ObjectGroup group;
+    qsrand(42);
+    for (int i = 0; i < 2000; ++i) {
+        group.addObject(newObject(qrand() % 20000 - 10000,
+                                  qrand() % 20000 - 10000,
+                                  qrand() % 300,
+                                  qrand() % 300));
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        const QRectF rect(qrand() % 20000 - 10000,
+                          qrand() % 20000 - 10000,
+                          qrand() % 2000,
+                          qrand() % 2000);
+
+        QList<MapObject*> expected;
+        foreach (MapObject *object, group.objects()) {
+            const QRectF bounds = object->bounds();
+            if (bounds.left() <= rect.right() && rect.left() <= bounds.right() &&
+                    bounds.top() <= rect.bottom() && rect.top() <= bounds.bottom())
+                expected.append(object);
+        }
+
+        QCOMPARE(group.objectsIntersecting(rect), expected);
+    }
+}
+
+QTEST_MAIN(test_ObjectGroup)
+#include "test_objectgroup.moc"
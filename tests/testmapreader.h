@@ -0,0 +1,31 @@
+#ifndef TESTMAPREADER_H
+#define TESTMAPREADER_H
+
+#include "mapreader.h"
+
+#include <QImage>
+
+namespace Tiled {
+
+/**
+ * A map reader for the tests, which provides the given tileset image
+ * instead of loading it from disk.
+ */
+class TestMapReader : public MapReader
+{
+public:
+    explicit TestMapReader(const QImage &tilesetImage)
+        : mTilesetImage(tilesetImage)
+    {}
+
+protected:
+    QImage readExternalImage(const QString &)
+    { return mTilesetImage; }
+
+private:
+    QImage mTilesetImage;
+};
+
+} // namespace Tiled
+
+#endif // TESTMAPREADER_H
@@ -1,4 +1,14 @@
 TEMPLATE=subdirs
 SUBDIRS = \
+    automapper \
+    benchmarks \
+    binarymap \
+    gidmapper \
+    imagecache \
+    jsonplugin \
     mapreader \
-    staggeredrenderer
+    mapwriter \
+    objectgroup \
+    staggeredrenderer \
+    tilelayer \
+    tilelayerdelta
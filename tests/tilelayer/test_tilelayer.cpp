@@ -0,0 +1,252 @@
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_TileLayer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void emptyLayer();
+    void setCellAllocatesChunk();
+    void regionSpansChunks();
+    void copyAndMerge();
+    void eraseReleasesChunks();
+    void resizeAndRotate();
+    void computeDiffRegion();
+    void packedFlags();
+    void replaceTileset();
+    void deletedTileset();
+
+private:
+    Tileset *mTileset;
+};
+
+void test_TileLayer::initTestCase()
+{
+    mTileset = new Tileset(QLatin1String("tiles"), 16, 16);
+    mTileset->addTile(QPixmap(16, 16));
+    mTileset->addTile(QPixmap(16, 16));
+}
+
+void test_TileLayer::cleanupTestCase()
+{
+    delete mTileset;
+    mTileset = 0;
+}
+
+void test_TileLayer::emptyLayer()
+{
+    TileLayer layer(QString(), 0, 0, 1000, 1000);
+
+    QVERIFY(layer.isEmpty());
+    QVERIFY(layer.region().isEmpty());
+    QCOMPARE(layer.allocatedChunkCount(), 0);
+    QVERIFY(layer.cellAt(999, 999).isEmpty());
+
+    // Setting an empty cell should not allocate anything
+    layer.setCell(10, 10, Cell());
+    QCOMPARE(layer.allocatedChunkCount(), 0);
+}
+
+void test_TileLayer::setCellAllocatesChunk()
+{
+    TileLayer layer(QString(), 0, 0, 100, 100);
+    Cell cell(mTileset->tileAt(0));
+    cell.flippedVertically = true;
+
+    layer.setCell(50, 60, cell);
+
+    QCOMPARE(layer.allocatedChunkCount(), 1);
+    QVERIFY(!layer.isEmpty());
+    QVERIFY(layer.cellAt(50, 60) == cell);
+    QVERIFY(layer.cellAt(51, 60).isEmpty());
+    QCOMPARE(layer.usedTilesets().size(), 1);
+    QVERIFY(layer.referencesTileset(mTileset));
+}
+
+void test_TileLayer::regionSpansChunks()
+{
+    TileLayer layer(QString(), 5, 7, 100, 100);
+    const Cell cell(mTileset->tileAt(0));
+
+    for (int x = 10; x < 40; ++x)
+        layer.setCell(x, 20, cell);
+    layer.setCell(99, 99, cell);
+
+    QRegion expected = QRect(15, 27, 30, 1);
+    expected += QRect(104, 106, 1, 1);
+
+    QCOMPARE(layer.region(), expected);
+    QCOMPARE(layer.allocatedChunkCount(), 4);
+}
+
+void test_TileLayer::copyAndMerge()
+{
+    TileLayer layer(QString(), 0, 0, 64, 64);
+    const Cell first(mTileset->tileAt(0));
+    const Cell second(mTileset->tileAt(1));
+
+    layer.setCell(15, 15, first);
+    layer.setCell(16, 16, second);
+
+    TileLayer *copied = layer.copy(QRect(14, 14, 4, 4));
+    QCOMPARE(copied->size(), QSize(4, 4));
+    QVERIFY(copied->cellAt(1, 1) == first);
+    QVERIFY(copied->cellAt(2, 2) == second);
+    QVERIFY(copied->cellAt(0, 0).isEmpty());
+
+    TileLayer target(QString(), 0, 0, 64, 64);
+    target.setCell(40, 40, second);
+    target.merge(QPoint(30, 30), copied);
+
+    QVERIFY(target.cellAt(31, 31) == first);
+    QVERIFY(target.cellAt(32, 32) == second);
+    QVERIFY(target.cellAt(40, 40) == second);
+    QCOMPARE(target.region(), QRegion(31, 31, 1, 1) +
+                              QRegion(32, 32, 1, 1) +
+                              QRegion(40, 40, 1, 1));
+
+    delete copied;
+}
+
+void test_TileLayer::eraseReleasesChunks()
+{
+    TileLayer layer(QString(), 0, 0, 64, 64);
+    const Cell cell(mTileset->tileAt(0));
+
+    layer.setCell(1, 1, cell);
+    layer.setCell(40, 40, cell);
+    QCOMPARE(layer.allocatedChunkCount(), 2);
+
+    layer.erase(QRect(0, 0, 8, 8));
+    QCOMPARE(layer.allocatedChunkCount(), 1);
+    QVERIFY(layer.cellAt(1, 1).isEmpty());
+    QVERIFY(layer.cellAt(40, 40) == cell);
+
+    layer.removeReferencesToTileset(mTileset);
+    QVERIFY(layer.isEmpty());
+    QCOMPARE(layer.allocatedChunkCount(), 0);
+}
+
+void test_TileLayer::resizeAndRotate()
+{
+    TileLayer layer(QString(), 0, 0, 20, 10);
+    const Cell cell(mTileset->tileAt(0));
+
+    layer.setCell(18, 2, cell);
+
+    layer.resize(QSize(40, 30), QPoint(3, 17));
+    QCOMPARE(layer.size(), QSize(40, 30));
+    QVERIFY(layer.cellAt(21, 19).tile == cell.tile);
+    QCOMPARE(layer.region(), QRegion(21, 19, 1, 1));
+
+    layer.rotate(RotateRight);
+    QCOMPARE(layer.size(), QSize(30, 40));
+    QVERIFY(layer.cellAt(30 - 19 - 1, 21).tile == cell.tile);
+    QCOMPARE(layer.region(), QRegion(10, 21, 1, 1));
+
+    layer.flip(FlipHorizontally);
+    QVERIFY(layer.cellAt(19, 21).tile == cell.tile);
+    QCOMPARE(layer.region(), QRegion(19, 21, 1, 1));
+}
+
+void test_TileLayer::computeDiffRegion()
+{
+    TileLayer a(QString(), 0, 0, 50, 50);
+    TileLayer b(QString(), 3, 3, 50, 50);
+    const Cell cell(mTileset->tileAt(0));
+
+    a.setCell(20, 20, cell);
+    b.setCell(17, 17, cell);
+    QVERIFY(a.computeDiffRegion(&b).isEmpty());
+
+    b.setCell(30, 31, cell);
+    QCOMPARE(a.computeDiffRegion(&b), QRegion(33, 34, 1, 1));
+}
+
+void test_TileLayer::packedFlags()
+{
+    TileLayer layer(QString(), 0, 0, 10, 10);
+    Cell cell(mTileset->tileAt(1));
+    cell.flippedHorizontally = true;
+    cell.flippedAntiDiagonally = true;
+
+    layer.setCell(2, 3, cell);
+    QVERIFY(layer.cellAt(2, 3) == cell);
+
+    layer.flip(FlipHorizontally);
+    const Cell flipped = layer.cellAt(7, 3);
+    QVERIFY(flipped.tile == cell.tile);
+    QVERIFY(!flipped.flippedHorizontally);
+    QVERIFY(!flipped.flippedVertically);
+    QVERIFY(flipped.flippedAntiDiagonally);
+
+    layer.rotate(RotateLeft);
+    const Cell rotated = layer.cellAt(3, 2);
+    QVERIFY(rotated.tile == cell.tile);
+    QVERIFY(!rotated.flippedHorizontally);
+    QVERIFY(rotated.flippedVertically);
+    QVERIFY(!rotated.flippedAntiDiagonally);
+}
+
+void test_TileLayer::replaceTileset()
+{
+    Tileset other(QLatin1String("other"), 16, 16);
+    other.addTile(QPixmap(16, 16));
+
+    TileLayer layer(QString(), 0, 0, 10, 10);
+    layer.setCell(1, 1, Cell(mTileset->tileAt(0)));
+    layer.setCell(2, 2, Cell(mTileset->tileAt(1)));
+
+    layer.replaceReferencesToTileset(mTileset, &other);
+    QVERIFY(layer.cellAt(1, 1).tile == other.tileAt(0));
+    QVERIFY(layer.cellAt(2, 2).tile == 0);
+    QVERIFY(!layer.referencesTileset(mTileset));
+    QVERIFY(layer.referencesTileset(&other));
+    QCOMPARE(layer.region(), QRegion(1, 1, 1, 1));
+}
+
+/**
+ * The tile table keeps entries for tiles that are no longer used by any
+ * cell. These must not be accessed once their tileset has been deleted.
+ */
+void test_TileLayer::deletedTileset()
+{
+    Tileset *removed = new Tileset(QLatin1String("removed"), 16, 16);
+    removed->addTile(QPixmap(16, 16));
+
+    Tileset replacement(QLatin1String("replacement"), 16, 16);
+    replacement.addTile(QPixmap(16, 16));
+
+    TileLayer layer(QString(), 0, 0, 10, 10);
+    layer.setCell(1, 1, Cell(mTileset->tileAt(0)));
+    layer.setCell(2, 2, Cell(removed->tileAt(0)));
+
+    // Clear the cell before deleting its tileset, as the editor does
+    layer.setCell(2, 2, Cell());
+    delete removed;
+
+    QCOMPARE(layer.usedTilesets(), QSet<Tileset*>() << mTileset);
+    QVERIFY(layer.referencesTileset(mTileset));
+    QVERIFY(!layer.referencesTileset(&replacement));
+
+    layer.removeReferencesToTileset(&replacement);
+    layer.replaceReferencesToTileset(mTileset, &replacement);
+    QVERIFY(layer.cellAt(1, 1).tile == replacement.tileAt(0));
+    QCOMPARE(layer.usedTilesets(), QSet<Tileset*>() << &replacement);
+
+    // New tiles may reuse the address of a deleted one
+    layer.setCell(3, 3, Cell(mTileset->tileAt(1)));
+    QCOMPARE(layer.usedTilesets(),
+             QSet<Tileset*>() << &replacement << mTileset);
+}
+
+QTEST_MAIN(test_TileLayer)
+#include "test_tilelayer.moc"
@@ -0,0 +1,253 @@
+#include "tilelayerdelta.h"
+
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+class test_TileLayerDelta : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void recordAndRestore();
+    void recordOverrides();
+    void appendOverrides_data();
+    void appendOverrides();
+    void compactKeepsLatestCells();
+    void compressRoundTrip();
+
+private:
+    Cell cell(int tile, int flags = 0) const;
+    TileLayer *filledLayer(const QRect &rect, const Cell &cell) const;
+
+    Tileset *mTileset;
+};
+
+/**
+ * Returns whether \a a and \a b have the same size and equal cells.
+ */
+static bool sameCells(const TileLayer *a, const TileLayer *b)
+{
+    if (a->size() != b->size())
+        return false;
+
+    for (int y = 0; y < a->height(); ++y)
+        for (int x = 0; x < a->width(); ++x)
+            if (a->cellAt(x, y) != b->cellAt(x, y))
+                return false;
+
+    return true;
+}
+
+void test_TileLayerDelta::initTestCase()
+{
+    mTileset = new Tileset(QLatin1String("tiles"), 16, 16);
+    for (int i = 0; i < 3; ++i)
+        mTileset->addTile(QPixmap(16, 16));
+}
+
+void test_TileLayerDelta::cleanupTestCase()
+{
+    delete mTileset;
+    mTileset = 0;
+}
+
+Cell test_TileLayerDelta::cell(int tile, int flags) const
+{
+    Cell cell(mTileset->tileAt(tile));
+    cell.flippedHorizontally = flags & 1;
+    cell.flippedVertically = flags & 2;
+    cell.flippedAntiDiagonally = flags & 4;
+    return cell;
+}
+
+/**
+ * Returns a 20x20 layer with \a cell placed within \a rect.
+ */
+TileLayer *test_TileLayerDelta::filledLayer(const QRect &rect,
+                                            const Cell &cell) const
+{
+    TileLayer *layer = new TileLayer(QString(), 0, 0, 20, 20);
+    for (int y = rect.top(); y <= rect.bottom(); ++y)
+        for (int x = rect.left(); x <= rect.right(); ++x)
+            layer->setCell(x, y, cell);
+    return layer;
+}
+
+void test_TileLayerDelta::recordAndRestore()
+{
+    TileLayer source(QString(), 0, 0, 20, 10);
+    for (int y = 0; y < 10; ++y)
+        for (int x = 0; x < 20; ++x)
+            if ((x * y) % 5 != 0)
+                source.setCell(x, y, cell((x + y) % 3, x % 8));
+
+    const QRegion region = QRegion(2, 1, 10, 5) + QRegion(15, 6, 3, 3);
+    const QPoint offset(100, 50);
+
+    TileLayerDelta delta;
+    delta.record(&source, region, offset);
+
+    QVERIFY(QRect(offset, source.size()).contains(delta.bounds()));
+    QVERIFY(region.translated(offset).boundingRect().contains(delta.bounds()));
+
+    TileLayer expected(QString(), 0, 0, 20, 10);
+    foreach (const QRect &rect, region.rects())
+        for (int y = rect.top(); y <= rect.bottom(); ++y)
+            for (int x = rect.left(); x <= rect.right(); ++x)
+                expected.setCell(x, y, source.cellAt(x, y));
+
+    QScopedPointer<TileLayer> restored(
+                delta.toTileLayer(QRect(offset, source.size())));
+    QVERIFY(sameCells(restored.data(), &expected));
+
+    // Only part of the cells is restored for a smaller rectangle
+    QScopedPointer<TileLayer> part(
+                delta.toTileLayer(QRect(offset + QPoint(5, 2), QSize(4, 4))));
+    QScopedPointer<TileLayer> expectedPart(expected.copy(5, 2, 4, 4));
+    QVERIFY(sameCells(part.data(), expectedPart.data()));
+}
+
+void test_TileLayerDelta::recordOverrides()
+{
+    QScopedPointer<TileLayer> first(filledLayer(QRect(0, 0, 10, 10), cell(0)));
+    QScopedPointer<TileLayer> second(filledLayer(QRect(5, 5, 10, 10), cell(1, 2)));
+
+    TileLayerDelta delta;
+    delta.record(first.data(), QRegion(0, 0, 20, 20));
+    delta.record(second.data(), QRegion(0, 0, 20, 20));
+
+    // Later recorded cells win, empty cells don't clear earlier ones
+    QScopedPointer<TileLayer> expected(filledLayer(QRect(0, 0, 10, 10), cell(0)));
+    for (int y = 5; y < 15; ++y)
+        for (int x = 5; x < 15; ++x)
+            expected->setCell(x, y, cell(1, 2));
+
+    QScopedPointer<TileLayer> restored(delta.toTileLayer(QRect(0, 0, 20, 20)));
+    QVERIFY(sameCells(restored.data(), expected.data()));
+    QCOMPARE(delta.bounds(), QRect(0, 0, 15, 15));
+}
+
+void test_TileLayerDelta::appendOverrides_data()
+{
+    QTest::addColumn<bool>("compressTarget");
+    QTest::addColumn<bool>("compressSource");
+
+    QTest::newRow("uncompressed") << false << false;
+    QTest::newRow("compressed target") << true << false;
+    QTest::newRow("compressed source") << false << true;
+    QTest::newRow("both compressed") << true << true;
+}
+
+/**
+ * The appended cells within the region take precedence over the recorded
+ * ones. Empty cells are not recorded, so they don't override anything.
+ */
+void test_TileLayerDelta::appendOverrides()
+{
+    QFETCH(bool, compressTarget);
+    QFETCH(bool, compressSource);
+
+    QScopedPointer<TileLayer> base(filledLayer(QRect(0, 0, 8, 8), cell(0)));
+    QScopedPointer<TileLayer> overlay(filledLayer(QRect(2, 2, 4, 4), cell(1, 5)));
+    overlay->setCell(3, 3, Cell());
+
+    TileLayerDelta target;
+    target.record(base.data(), QRegion(0, 0, 20, 20));
+    TileLayerDelta source;
+    source.record(overlay.data(), QRegion(0, 0, 20, 20));
+
+    if (compressTarget) {
+        target.compress();
+        QVERIFY(target.isCompressed());
+    }
+    if (compressSource) {
+        source.compress();
+        QVERIFY(source.isCompressed());
+    }
+
+    // Only the left half of the overlay is appended
+    target.append(source, QRegion(0, 0, 4, 20));
+    QVERIFY(!target.isCompressed());
+    QCOMPARE(source.isCompressed(), compressSource);
+
+    QScopedPointer<TileLayer> expected(filledLayer(QRect(0, 0, 8, 8), cell(0)));
+    for (int y = 2; y < 6; ++y)
+        for (int x = 2; x < 4; ++x)
+            if (x != 3 || y != 3)
+                expected->setCell(x, y, cell(1, 5));
+
+    QScopedPointer<TileLayer> restored(target.toTileLayer(QRect(0, 0, 20, 20)));
+    QVERIFY(sameCells(restored.data(), expected.data()));
+}
+
+/**
+ * Appending many overlapping records triggers compaction, which should keep
+ * the most recently appended cells and bound the memory usage.
+ */
+void test_TileLayerDelta::compactKeepsLatestCells()
+{
+    const int appendCount = 1000;
+
+    TileLayerDelta delta;
+    TileLayer expected(QString(), 0, 0, 20, 20);
+
+    for (int i = 0; i < appendCount; ++i) {
+        const QPoint pos(i % 10, (i / 10) % 3);
+        const Cell c = cell(i % 3, i % 8);
+
+        TileLayer layer(QString(), 0, 0, 20, 20);
+        layer.setCell(pos.x(), pos.y(), c);
+        expected.setCell(pos.x(), pos.y(), c);
+
+        TileLayerDelta step;
+        step.record(&layer, QRegion(0, 0, 20, 20));
+        delta.append(step, QRegion(0, 0, 20, 20));
+    }
+
+    QScopedPointer<TileLayer> restored(delta.toTileLayer(QRect(0, 0, 20, 20)));
+    QVERIFY(sameCells(restored.data(), &expected));
+
+    // Without compaction, each append would have added a run of 16 bytes
+    QVERIFY(delta.memoryUsage() < appendCount * 16);
+}
+
+void test_TileLayerDelta::compressRoundTrip()
+{
+    TileLayer source(QString(), 0, 0, 200, 200);
+    for (int y = 0; y < 200; ++y)
+        for (int x = 0; x < 200; ++x)
+            source.setCell(x, y, cell((x / 3 + y) % 3, (x / 7) % 8));
+
+    TileLayerDelta delta;
+    delta.record(&source, QRegion(0, 0, 200, 200), QPoint(-10, -20));
+
+    const QRect bounds = delta.bounds();
+    QCOMPARE(bounds, QRect(-10, -20, 200, 200));
+
+    const qint64 uncompressedUsage = delta.memoryUsage();
+    delta.compress();
+    QVERIFY(delta.isCompressed());
+    QVERIFY(delta.memoryUsage() < uncompressedUsage);
+    QCOMPARE(delta.bounds(), bounds);
+
+    // Restoring doesn't decompress the record itself
+    QScopedPointer<TileLayer> restored(delta.toTileLayer(bounds));
+    QVERIFY(delta.isCompressed());
+    QVERIFY(sameCells(restored.data(), &source));
+
+    // Compressing twice has no effect
+    delta.compress();
+    QScopedPointer<TileLayer> restoredAgain(delta.toTileLayer(bounds));
+    QVERIFY(sameCells(restoredAgain.data(), &source));
+}
+
+QTEST_MAIN(test_TileLayerDelta)
+#include "test_tilelayerdelta.moc"